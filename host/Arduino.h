@@ -0,0 +1,255 @@
+#pragma once
+/**
+ * Host (native) stand-in for the ESP32 Arduino core
+ *
+ * Just enough of String / Print / Stream / Serial / ESP / FreeRTOS for
+ * src/ to compile and run on Linux or macOS. Time is virtual: millis()
+ * only moves when delay() is called or a fake peripheral charges time for
+ * blocking work (HTTP latency), so an hour of polling runs in well under a
+ * second and every run is reproducible. See host/host_main.cpp.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+using std::isnan;
+using std::min;
+using std::max;
+
+typedef uint8_t byte;
+
+#define HIGH    1
+#define LOW     0
+#define OUTPUT  1
+#define INPUT   0
+#define PROGMEM
+#define F(s)    (s)
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ===== VIRTUAL CLOCK =====
+
+namespace HostClock {
+    // Time charged by the main (loop) thread; fakes on other threads do not move it
+    void advance(uint32_t ms);
+    void set(uint32_t ms);
+    bool onMainThread();
+}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+inline void delayMicroseconds(unsigned int) {}
+inline void yield() {}
+
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return HIGH; }
+inline void analogWrite(int, int) {}
+inline long random(long hi) { return hi > 0 ? rand() % hi : 0; }
+inline long random(long lo, long hi) { return hi > lo ? lo + rand() % (hi - lo) : lo; }
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+inline void configTime(long, int, const char*, const char* = nullptr, const char* = nullptr) {}
+
+// ===== STRING =====
+
+class String {
+public:
+    String(const char* s = "") : _s(s ? s : "") {}
+    String(const std::string& s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int v) : _s(std::to_string(v)) {}
+    String(unsigned int v) : _s(std::to_string(v)) {}
+    String(long v) : _s(std::to_string(v)) {}
+    String(unsigned long v) : _s(std::to_string(v)) {}
+    String(float v, unsigned decimals = 2) { _fmt(v, decimals); }
+    String(double v, unsigned decimals = 2) { _fmt(v, decimals); }
+    String& operator=(const char* s) { _s = s ? s : ""; return *this; }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned length() const { return _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned n) { _s.reserve(n); return true; }
+
+    bool concat(const char* s) { if (s) _s += s; return true; }
+    bool concat(const char* s, unsigned n) { if (s) _s.append(s, n); return true; }
+    bool concat(const String& s) { _s += s._s; return true; }
+    bool concat(char c) { _s += c; return true; }
+    String& operator+=(const String& o) { _s += o._s; return *this; }
+    String& operator+=(const char* o) { if (o) _s += o; return *this; }
+    String& operator+=(char c) { _s += c; return *this; }
+    String operator+(const String& o) const { return String(_s + o._s); }
+    String operator+(const char* o) const { return String(_s + (o ? o : "")); }
+    friend String operator+(const char* a, const String& b) { return String(std::string(a ? a : "") + b._s); }
+
+    bool operator==(const char* o) const { return _s == (o ? o : ""); }
+    bool operator==(const String& o) const { return _s == o._s; }
+    bool operator!=(const char* o) const { return !(*this == o); }
+    bool operator!=(const String& o) const { return _s != o._s; }
+    bool operator<(const String& o) const { return _s < o._s; }
+    char operator[](unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+    char charAt(unsigned i) const { return (*this)[i]; }
+
+    int indexOf(char c, unsigned from = 0) const { size_t p = _s.find(c, from); return p == std::string::npos ? -1 : (int)p; }
+    int indexOf(const char* s, unsigned from = 0) const { size_t p = _s.find(s, from); return p == std::string::npos ? -1 : (int)p; }
+    int lastIndexOf(char c) const { size_t p = _s.rfind(c); return p == std::string::npos ? -1 : (int)p; }
+    String substring(unsigned from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned from, unsigned to) const {
+        if (from > to) std::swap(from, to);
+        return from < _s.size() ? String(_s.substr(from, to - from)) : String();
+    }
+    bool startsWith(const char* x) const { return _s.compare(0, strlen(x), x) == 0; }
+    bool endsWith(const char* x) const { size_t n = strlen(x); return _s.size() >= n && _s.compare(_s.size() - n, n, x) == 0; }
+    bool equalsIgnoreCase(const String& o) const {
+        if (_s.size() != o._s.size()) return false;
+        for (size_t i = 0; i < _s.size(); i++) if (tolower((unsigned char)_s[i]) != tolower((unsigned char)o._s[i])) return false;
+        return true;
+    }
+
+    void replace(const String& a, const String& b) { replace(a.c_str(), b.c_str()); }
+    void replace(const char* a, const char* b) {
+        std::string from(a), to(b);
+        if (from.empty()) return;
+        for (size_t p = 0; (p = _s.find(from, p)) != std::string::npos; p += to.size()) _s.replace(p, from.size(), to);
+    }
+    void remove(unsigned i) { if (i < _s.size()) _s.erase(i); }
+    void remove(unsigned i, unsigned n) { if (i < _s.size()) _s.erase(i, n); }
+    void trim() {
+        while (!_s.empty() && isspace((unsigned char)_s.back())) _s.pop_back();
+        size_t i = 0;
+        while (i < _s.size() && isspace((unsigned char)_s[i])) i++;
+        _s.erase(0, i);
+    }
+    void toLowerCase() { for (auto& c : _s) c = tolower((unsigned char)c); }
+    void toUpperCase() { for (auto& c : _s) c = toupper((unsigned char)c); }
+    void toCharArray(char* buf, unsigned n) const { if (!n) return; strncpy(buf, _s.c_str(), n - 1); buf[n - 1] = '\0'; }
+    long toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return (float)atof(_s.c_str()); }
+    double toDouble() const { return atof(_s.c_str()); }
+
+private:
+    std::string _s;
+
+    void _fmt(double v, unsigned decimals) {
+        char b[48];
+        snprintf(b, sizeof(b), "%.*f", (int)decimals, v);
+        _s = b;
+    }
+};
+
+// ArduinoJson's Arduino string adapters name this type
+class StringSumHelper : public String {
+public:
+    using String::String;
+};
+
+// ===== PRINT / STREAM =====
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* b, size_t n) { for (size_t i = 0; i < n; i++) write(b[i]); return n; }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t write(const char* s, size_t n) { return write((const uint8_t*)s, n); }
+
+    size_t print(const char* s) { return write(s); }
+    size_t print(const String& s) { return write(s.c_str(), s.length()); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int v) { return printf("%d", v); }
+    size_t print(unsigned int v) { return printf("%u", v); }
+    size_t print(long v) { return printf("%ld", v); }
+    size_t print(unsigned long v) { return printf("%lu", v); }
+    size_t print(double v, int decimals = 2) { return printf("%.*f", decimals, v); }
+    template <typename T> size_t println(const T& v) { return print(v) + print("\r\n"); }
+    size_t println() { return print("\r\n"); }
+
+    size_t printf(const char* fmt, ...) __attribute__((format(printf, 2, 3))) {
+        char b[512];
+        va_list a;
+        va_start(a, fmt);
+        int n = vsnprintf(b, sizeof(b), fmt, a);
+        va_end(a);
+        return n > 0 ? write((const uint8_t*)b, min((size_t)n, sizeof(b) - 1)) : 0;
+    }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual void setTimeout(unsigned long) {}
+    size_t readBytes(char* buf, size_t n) {
+        size_t i = 0;
+        for (int c; i < n && (c = read()) >= 0; ) buf[i++] = (char)c;
+        return i;
+    }
+    size_t readBytes(uint8_t* buf, size_t n) { return readBytes((char*)buf, n); }
+    // Up to n bytes before terminator, which is consumed and not stored
+    size_t readBytesUntil(char terminator, char* buf, size_t n) {
+        size_t i = 0;
+        for (int c; i < n && (c = read()) >= 0 && c != terminator; ) buf[i++] = (char)c;
+        return i;
+    }
+};
+
+// Serial goes to stdout unless the host runner silences it
+class HardwareSerial : public Stream {
+public:
+    bool quiet = false;
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return quiet ? 1 : (fputc(c, stdout) == EOF ? 0 : 1); }
+    size_t write(const uint8_t* b, size_t n) override { return quiet ? n : fwrite(b, 1, n, stdout); }
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+};
+extern HardwareSerial Serial;
+
+// ===== ESP =====
+
+class EspClass {
+public:
+    void restart();
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 150000; }
+    uint32_t getMaxAllocHeap() { return 110000; }
+    uint32_t getHeapSize() { return 320000; }
+    uint32_t getCycleCount() { return (uint32_t)(micros() * 240); }
+    uint32_t getCpuFreqMHz() { return 240; }
+};
+extern EspClass ESP;
+
+// ===== FREERTOS =====
+// Tasks are real threads and queues are locked FIFOs. Tasks run in wall-clock
+// time; only the loop thread moves the virtual clock.
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef struct HostQueue* QueueHandle_t;
+typedef void* TaskHandle_t;
+
+#define pdTRUE          1
+#define pdFALSE         0
+#define pdPASS          1
+#define portMAX_DELAY   0xFFFFFFFFu
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+QueueHandle_t xQueueCreate(size_t length, size_t itemSize);
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t wait);
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait);
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char* name, uint32_t stack, void* arg,
+                                   int prio, TaskHandle_t* handle, int core);
+void vTaskDelay(TickType_t ticks);
+TaskHandle_t xTaskGetCurrentTaskHandle();
+uint32_t uxTaskGetStackHighWaterMark(TaskHandle_t task);      // always 0: threads have no stack accounting
@@ -0,0 +1,87 @@
+#pragma once
+/**
+ * Host stand-in for the Arduino FS API, backed by a directory on disk
+ * ($HOST_FS_ROOT, default ./host_fs).
+ */
+
+#include <Arduino.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#define FILE_READ   "r"
+#define FILE_WRITE  "w"
+#define FILE_APPEND "a"
+
+namespace fs {
+
+// Bytes the fake flash still takes before writes come up short (full LittleFS), -1 = no limit
+inline long& hostSpaceLeft() { static long n = -1; return n; }
+
+class File : public Stream {
+public:
+    File() {}
+    File(FILE* f, const std::string& path) : _f(std::make_shared<_Handle>(f)), _path(path) {}
+    File(const std::vector<std::string>& entries, const std::string& path)
+        : _dir(std::make_shared<std::vector<std::string>>(entries)), _path(path) {}
+
+    explicit operator bool() const { return (_f && _f->f) || _dir; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* b, size_t n) override {
+        if (!_f || !_f->f) return 0;
+        long& left = hostSpaceLeft();
+        if (left >= 0 && (long)n > left) n = left;
+        if (left >= 0) left -= n;
+        return fwrite(b, 1, n, _f->f);
+    }
+    using Print::write;
+    size_t read(uint8_t* b, size_t n) { return _f && _f->f ? fread(b, 1, n, _f->f) : 0; }
+    int read() override { uint8_t c; return read(&c, 1) == 1 ? c : -1; }
+    int available() override { return (int)(size() - position()); }
+    bool seek(uint32_t pos) { return _f && _f->f && fseek(_f->f, pos, SEEK_SET) == 0; }
+    size_t position() const { return _f && _f->f ? ftell(_f->f) : 0; }
+    size_t size() const {
+        if (!_f || !_f->f) return 0;
+        long p = ftell(_f->f);
+        fseek(_f->f, 0, SEEK_END);
+        long e = ftell(_f->f);
+        fseek(_f->f, p, SEEK_SET);
+        return e;
+    }
+    void flush() { if (_f && _f->f) fflush(_f->f); }
+    void close() { _f.reset(); _dir.reset(); }
+    const char* name() const { size_t s = _path.rfind('/'); return _path.c_str() + (s == std::string::npos ? 0 : s + 1); }
+    const char* path() const { return _path.c_str(); }
+    bool isDirectory() const { return (bool)_dir; }
+    File openNextFile();
+
+private:
+    struct _Handle {
+        FILE* f;
+        explicit _Handle(FILE* x) : f(x) {}
+        ~_Handle() { if (f) fclose(f); }
+    };
+    std::shared_ptr<_Handle> _f;
+    std::shared_ptr<std::vector<std::string>> _dir;
+    size_t _dirPos = 0;
+    std::string _path;
+};
+
+class FS {
+public:
+    bool begin(bool = false) { return true; }
+    File open(const char* path, const char* mode = FILE_READ);
+    File open(const String& path, const char* mode = FILE_READ) { return open(path.c_str(), mode); }
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+    bool mkdir(const char* path);
+    bool rmdir(const char* path) { return remove(path); }
+    size_t totalBytes() { return 1408 * 1024; }
+    size_t usedBytes();
+};
+
+}  // namespace fs
+
+using fs::File;
+using fs::FS;
@@ -0,0 +1,110 @@
+#pragma once
+/**
+ * Simulated AxeOS miner for the host build
+ *
+ * Answers GET /api/system/info with the fields fetchDeviceData() reads,
+ * accepts PATCH /api/system (frequency, coreVoltage, fanspeed) and
+ * POST /api/system/restart. Hashrate follows frequency with a little
+ * deterministic jitter, temperature follows power and fan, shares arrive in
+ * proportion to hashrate; everything is driven by the virtual clock, so two
+ * runs with the same seed see the same miner.
+ */
+
+#include <Arduino.h>
+#include "HostHttp.h"
+
+class FakeAxeOS {
+public:
+    uint32_t latencyMs = 40;
+    bool dead = false;             // requests fail like an unplugged miner
+
+    FakeAxeOS(int index, uint32_t seed) : _index(index), _rng(seed * 2654435761u + 1) {
+        _bootAt = millis();
+        _lastAt = millis();
+    }
+
+    HostResponse handle(const HostRequest& req) {
+        HostResponse r;
+        r.latencyMs = latencyMs;
+        if (dead) { r.code = -1; return r; }
+        _advance();
+        r.code = 200;
+        if (req.url.find("/api/system/info") != std::string::npos) {
+            r.body = _info();
+        } else if (req.url.find("/api/system/restart") != std::string::npos) {
+            _bootAt = millis();
+            _accepted = _rejected = 0;
+            r.body = "System will restart shortly.";
+        } else if (req.url.find("/api/system") != std::string::npos && strcmp(req.method, "PATCH") == 0) {
+            _patch(req.body);
+        } else {
+            r.code = 404;
+        }
+        return r;
+    }
+
+private:
+    int _index;
+    uint32_t _rng;
+    uint32_t _bootAt, _lastAt;
+    int _frequency = 525;
+    int _coreVoltage = 1150;
+    int _fan = 60;
+    float _temp = 55;
+    float _shareCarry = 0;
+    uint32_t _accepted = 0, _rejected = 0;
+    double _bestDiff = 0;
+
+    float _jitter(float span) {
+        _rng = _rng * 1664525u + 1013904223u;
+        return ((_rng >> 8) / 16777216.0f - 0.5f) * span;
+    }
+
+    float _hashrate() const { return _frequency * 2.04f; }                 // BM1370-ish GH/s per MHz
+    float _power() const { return 3.5f + _frequency * _coreVoltage * 2.6e-5f; }
+
+    void _advance() {
+        float dt = (millis() - _lastAt) / 1000.0f;
+        _lastAt = millis();
+        if (dt <= 0) return;
+        float target = 28 + _power() * 2.1f - _fan * 0.12f;
+        _temp += (target - _temp) * min(1.0f, dt / 60.0f);
+        // Shares at difficulty 1000: 3600 / (1000 * 2^32) per GH-second, ~0.84 per GH/s-hour
+        _shareCarry += _hashrate() * dt / 3600.0f * 0.838f;
+        while (_shareCarry >= 1) {
+            _shareCarry -= 1;
+            if ((++_accepted % 200) == 0) _rejected++;
+            double d = 1000.0 / (0.0001 + fabs(_jitter(1.0f)));
+            if (d > _bestDiff) _bestDiff = d;
+        }
+    }
+
+    static int _field(const std::string& body, const char* key, int fallback) {
+        size_t k = body.find(std::string("\"") + key + "\"");
+        if (k == std::string::npos) return fallback;
+        size_t c = body.find(':', k);
+        return c == std::string::npos ? fallback : atoi(body.c_str() + c + 1);
+    }
+
+    void _patch(const std::string& body) {
+        _frequency = _field(body, "frequency", _frequency);
+        _coreVoltage = _field(body, "coreVoltage", _coreVoltage);
+        _fan = _field(body, "fanspeed", _fan);
+    }
+
+    std::string _info() {
+        char b[1024];
+        uint32_t up = (millis() - _bootAt) / 1000;
+        float hr = _hashrate() * (1.0f + _jitter(0.06f));
+        snprintf(b, sizeof(b),
+                 "{\"hashRate\":%.2f,\"hashRate_1h\":%.2f,\"temp\":%.1f,\"vrTemp\":%.1f,\"power\":%.2f,"
+                 "\"voltage\":%d,\"coreVoltage\":%d,\"frequency\":%d,\"fanrpm\":%d,\"fanspeed\":%d,"
+                 "\"sharesAccepted\":%u,\"sharesRejected\":%u,\"bestDiff\":%.0f,\"bestSessionDiff\":%.0f,"
+                 "\"hostname\":\"bitaxe-%02d\",\"deviceModel\":\"Gamma\",\"ASICModel\":\"BM1370\","
+                 "\"stratumURL\":\"public-pool.io\",\"stratumPort\":21496,\"stratumUser\":\"bc1qexample.%02d\","
+                 "\"uptimeSeconds\":%u,\"wifiRSSI\":%d,\"poolDifficulty\":1000}",
+                 hr, _hashrate(), _temp, _temp + 8, _power(), 5100, _coreVoltage, _frequency, 2000 + _fan * 40, _fan,
+                 _accepted, _rejected, _bestDiff, _bestDiff, _index, _index, up, -50 - (_index % 20));
+        return b;
+    }
+};
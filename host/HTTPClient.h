@@ -0,0 +1,90 @@
+#pragma once
+/**
+ * Host stand-in for HTTPClient, answered by HostHttp routes
+ */
+
+#include <WiFi.h>
+#include "HostHttp.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED  (-1)
+#define HTTPC_ERROR_READ_TIMEOUT        (-11)
+
+// Response body as a Stream, for deserializeJson(doc, http.getStream())
+class HostBodyStream : public Stream {
+public:
+    void reset(const std::string* s) { _s = s; _pos = 0; }
+    int available() override { return _s ? (int)(_s->size() - _pos) : 0; }
+    int read() override { return available() > 0 ? (uint8_t)(*_s)[_pos++] : -1; }
+    int peek() override { return available() > 0 ? (uint8_t)(*_s)[_pos] : -1; }
+    size_t write(uint8_t) override { return 0; }
+    using Print::write;
+
+private:
+    const std::string* _s = nullptr;
+    size_t _pos = 0;
+};
+
+class HTTPClient {
+public:
+    void setTimeout(uint16_t ms) { _timeout = ms; }
+    void setConnectTimeout(int32_t) {}
+    void setReuse(bool) {}
+    bool begin(const String& url) { _url = url.c_str(); return true; }
+    bool begin(WiFiClient&, const String& url) { return begin(url); }
+    void addHeader(const String&, const String&) {}
+    // Only Transfer-Encoding is ever answered
+    void collectHeaders(const char* keys[], size_t n) {
+        _te = false;
+        for (size_t k = 0; k < n; k++) _te |= strcasecmp(keys[k], "Transfer-Encoding") == 0;
+    }
+    String header(const char* name) {
+        return _te && _res.chunked && strcasecmp(name, "Transfer-Encoding") == 0 ? "chunked" : "";
+    }
+    bool connected() { return false; }
+    void end() { _res = HostResponse(); }
+
+    int GET() { return _send("GET", ""); }
+    int POST(const String& body) { return _send("POST", body.c_str()); }
+    int POST(const uint8_t* body, size_t n) { return _send("POST", std::string((const char*)body, n)); }
+    int PATCH(const String& body) { return _send("PATCH", body.c_str()); }
+    int sendRequest(const char* method, const String& body) { return _send(method, body.c_str()); }
+
+    String getString() { return String(_res.chunked ? _unchunked() : _res.body); }
+    Stream& getStream() { _stream.reset(&_res.body); return _stream; }
+    WiFiClient* getStreamPtr() { return nullptr; }
+    int getSize() { return _res.code > 0 && !_res.chunked ? (int)_res.body.size() : -1; }
+
+private:
+    std::string _url;
+    uint16_t _timeout = 5000;
+    bool _te = false;              // Transfer-Encoding among the collected headers
+    HostResponse _res;
+    HostBodyStream _stream;
+
+    // What getString() makes of a chunked body
+    std::string _unchunked() const {
+        std::string out;
+        for (size_t p = 0; p < _res.body.size(); ) {
+            size_t n = strtoul(_res.body.c_str() + p, nullptr, 16);
+            size_t data = _res.body.find("\r\n", p);
+            if (n == 0 || data == std::string::npos || data + 2 + n > _res.body.size()) break;
+            out.append(_res.body, data + 2, n);
+            p = data + 2 + n + 2;
+        }
+        return out;
+    }
+
+    int _send(const char* method, const std::string& body) {
+        HostNetworkScope scope;
+        _res = HostHttp::request({method, _url, body, _timeout});
+        // A request that outlives the timeout fails the way HTTPClient does
+        if (_res.latencyMs > _timeout) {
+            if (HostClock::onMainThread()) HostClock::advance(_timeout);
+            _res = HostResponse();
+            _res.code = HTTPC_ERROR_READ_TIMEOUT;
+        } else if (HostClock::onMainThread()) {
+            HostClock::advance(_res.latencyMs);
+        }
+        return _res.code;
+    }
+};
@@ -0,0 +1,64 @@
+#pragma once
+/**
+ * Scripted HTTP for the host build
+ *
+ * HTTPClient calls are answered by handlers registered against URL
+ * prefixes (longest prefix wins). A handler returns the status, body and the
+ * latency the request should cost; on the loop thread that latency is added
+ * to the virtual clock, just as a blocking HTTPClient call holds loop() up
+ * on the device. Unrouted URLs fail like an unreachable host (-1) — unless
+ * network(true) was called, in which case unrouted http://<IPv4>[:port]/
+ * URLs go out over a real socket (host/fleet_sim.py) and cost the wall-clock
+ * time they took.
+ *
+ * Every request is counted per route so a run can report what it fetched;
+ * real requests also keep their latency.
+ */
+
+#include <Arduino.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct HostResponse {
+    int code = -1;                 // HTTP status, < 0 = connection error
+    std::string body;              // as sent: still framed when chunked
+    bool chunked = false;          // Transfer-Encoding: chunked
+    uint32_t latencyMs = 0;
+};
+
+struct HostRequest {
+    const char* method;            // "GET", "POST", "PATCH"
+    std::string url;
+    std::string body;
+    uint32_t timeoutMs = 5000;
+};
+
+struct HostNetStats {
+    uint32_t requests = 0;
+    uint32_t failures = 0;         // refused, timed out or no status line
+    std::vector<uint32_t> latencyMs;
+};
+
+typedef std::function<HostResponse(const HostRequest&)> HostHandler;
+
+// While one is in scope the calling thread is not "itself" to xTaskGetCurrentTaskHandle(): what the
+// fakes do for a request stands in for lwIP and the WiFi driver, which run in tasks of their own
+struct HostNetworkScope {
+    HostNetworkScope();
+    ~HostNetworkScope();
+};
+
+namespace HostHttp {
+    void route(const std::string& urlPrefix, HostHandler handler);
+    void clear();
+    HostResponse request(const HostRequest& req);
+
+    // Requests answered by the route registered under urlPrefix, and the rest
+    uint32_t count(const std::string& urlPrefix);
+    uint32_t unrouted();
+
+    // Send unrouted http:// requests over real sockets
+    void network(bool on);
+    HostNetStats netStats();
+}
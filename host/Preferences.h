@@ -0,0 +1,69 @@
+#pragma once
+/**
+ * Host stand-in for Preferences: every namespace lives in memory for the
+ * life of the process. putX() counts as one flash write in writes().
+ */
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+#include <vector>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) { _ns = &_store()[name]; _readOnly = readOnly; return true; }
+    void end() { _ns = nullptr; }
+    bool clear() { if (_ns) _ns->clear(); return true; }
+    bool isKey(const char* key) { return _ns && _ns->count(key); }
+    bool remove(const char* key) { return _ns && _ns->erase(key); }
+
+    int getInt(const char* key, int d = 0) { return _get(key, d); }
+    unsigned getUInt(const char* key, unsigned d = 0) { return _get(key, d); }
+    float getFloat(const char* key, float d = 0) { return _get(key, d); }
+    bool getBool(const char* key, bool d = false) { return _get(key, d); }
+    String getString(const char* key, const String& d = String()) {
+        if (!isKey(key)) return d;
+        const auto& v = (*_ns)[key];
+        return String(std::string(v.begin(), v.end()));
+    }
+    size_t getBytesLength(const char* key) { return isKey(key) ? (*_ns)[key].size() : 0; }
+    size_t getBytes(const char* key, void* buf, size_t n) {
+        if (!isKey(key)) return 0;
+        const auto& v = (*_ns)[key];
+        if (v.size() > n) return 0;
+        memcpy(buf, v.data(), v.size());
+        return v.size();
+    }
+
+    size_t putInt(const char* key, int v) { return _put(key, &v, sizeof(v)); }
+    size_t putUInt(const char* key, unsigned v) { return _put(key, &v, sizeof(v)); }
+    size_t putFloat(const char* key, float v) { return _put(key, &v, sizeof(v)); }
+    size_t putBool(const char* key, bool v) { uint8_t b = v; return _put(key, &b, 1); }
+    size_t putString(const char* key, const String& v) { return _put(key, v.c_str(), v.length()); }
+    size_t putBytes(const char* key, const void* v, size_t n) { return _put(key, v, n); }
+
+    static uint32_t& writes() { static uint32_t n = 0; return n; }
+
+private:
+    typedef std::map<std::string, std::vector<uint8_t>> _Namespace;
+    _Namespace* _ns = nullptr;
+    bool _readOnly = false;
+
+    static std::map<std::string, _Namespace>& _store() { static std::map<std::string, _Namespace> s; return s; }
+
+    template <typename T> T _get(const char* key, T d) {
+        if (!isKey(key)) return d;
+        const auto& v = (*_ns)[key];
+        T out = d;
+        if (v.size() == sizeof(T)) memcpy(&out, v.data(), sizeof(T));
+        else if (v.size() == 1) out = (T)v[0];
+        return out;
+    }
+
+    size_t _put(const char* key, const void* v, size_t n) {
+        if (!_ns || _readOnly) return 0;
+        (*_ns)[key].assign((const uint8_t*)v, (const uint8_t*)v + n);
+        writes()++;
+        return n ? n : 1;
+    }
+};
@@ -0,0 +1,284 @@
+#pragma once
+/**
+ * Host stand-in for TFT_eSPI with a recording framebuffer
+ *
+ * Same drawing API as the parts of TFT_eSPI that src/ uses. The panel
+ * instance rasterises into an RGB565 framebuffer and counts what the real
+ * driver would put on the SPI bus:
+ *
+ *   calls     drawing API calls (one print / printf is one call)
+ *   windows   address windows set — CASET + RASET + RAMWR, 11 bytes each
+ *   pixels    pixels written, overdraw included — 2 bytes each
+ *   touched   distinct pixels written since the last hostReset()
+ *
+ * Shapes are split into one window per horizontal run, the way TFT_eSPI
+ * fills spans. Glyph bitmaps are not carried: a GLCD character is a 6x8
+ * cell (times the text size), opaque text is one window for the cell and
+ * transparent text lights about a third of the cell one dot at a time.
+ * Free fonts are scaled from their yAdvance. The numbers are an estimate of
+ * bus traffic, good for comparing layouts and catching regressions, not a
+ * cycle-exact model.
+ *
+ * Sprites draw into RAM and cost nothing until pushSprite(), which is one
+ * window of w x h pixels on the panel. Touch reports "not pressed".
+ */
+
+#include <Arduino.h>
+#include <vector>
+
+#define TFT_BLACK   0x0000
+#define TFT_WHITE   0xFFFF
+
+#define TFT_WINDOW_BYTES 11
+
+struct GFXfont { uint8_t yAdvance; };
+extern const GFXfont Satisfy_24;
+
+struct TftStats {
+    uint32_t calls = 0;
+    uint32_t windows = 0;
+    uint64_t pixels = 0;
+    uint64_t touched = 0;
+
+    uint64_t spiBytes() const { return (uint64_t)windows * TFT_WINDOW_BYTES + pixels * 2; }
+    // Time the bytes take on a bus clocked at hz; command/data switching is not counted
+    double busMs(uint32_t hz) const { return hz ? spiBytes() * 8000.0 / hz : 0; }
+};
+
+class TFT_eSPI : public Print {
+public:
+    TFT_eSPI(int16_t w = SCR_W, int16_t h = SCR_H) : _w(w), _h(h) {}
+
+    void init() { _bus = true; _fb.assign((size_t)_w * _h, 0); _seen.assign(_fb.size(), 0); _mask.assign(_fb.size(), 0); }
+    void setRotation(uint8_t) {}
+    int16_t width() const { return _w; }
+    int16_t height() const { return _h; }
+
+    void fillScreen(uint32_t c) { _call(); _fill(0, 0, _w, _h, c); }
+    void drawPixel(int32_t x, int32_t y, uint32_t c) { _call(); _fill(x, y, 1, 1, c); }
+    void drawFastHLine(int32_t x, int32_t y, int32_t w, uint32_t c) { _call(); _fill(x, y, w, 1, c); }
+    void drawFastVLine(int32_t x, int32_t y, int32_t h, uint32_t c) { _call(); _fill(x, y, 1, h, c); }
+    void fillRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t c) { _call(); _fill(x, y, w, h, c); }
+
+    void drawRect(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t c) {
+        _call();
+        _fill(x, y, w, 1, c);
+        _fill(x, y + h - 1, w, 1, c);
+        _fill(x, y + 1, 1, h - 2, c);
+        _fill(x + w - 1, y + 1, 1, h - 2, c);
+    }
+
+    void drawLine(int32_t x0, int32_t y0, int32_t x1, int32_t y1, uint32_t c) {
+        _call();
+        int32_t dx = abs(x1 - x0), dy = -abs(y1 - y0), sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1, err = dx + dy;
+        for (;;) {
+            _mark(x0, y0);
+            if (x0 == x1 && y0 == y1) break;
+            int32_t e2 = 2 * err;
+            if (e2 >= dy) { err += dy; x0 += sx; }
+            if (e2 <= dx) { err += dx; y0 += sy; }
+        }
+        _flush(c);
+    }
+
+    void drawCircle(int32_t x, int32_t y, int32_t r, uint32_t c) { _call(); _ring(x, y, r + 0.5f, r - 0.5f, 0, 360); _flush(c); }
+    void fillCircle(int32_t x, int32_t y, int32_t r, uint32_t c) { _call(); _ring(x, y, r + 0.5f, -1, 0, 360); _flush(c); }
+    void drawSmoothCircle(int32_t x, int32_t y, int32_t r, uint32_t fg, uint32_t) { _call(); _ring(x, y, r + 1, r - 1, 0, 360); _flush(fg); }
+
+    // Angles as TFT_eSPI: degrees clockwise from 6 o'clock, wrapping when start > end
+    void drawArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t start, uint32_t end, uint32_t fg, uint32_t, bool = true) {
+        _call(); _ring(x, y, r, ir, start, end); _flush(fg);
+    }
+    void drawSmoothArc(int32_t x, int32_t y, int32_t r, int32_t ir, uint32_t start, uint32_t end, uint32_t fg, uint32_t, bool = false) {
+        _call(); _ring(x, y, r + 0.5f, ir - 0.5f, start, end); _flush(fg);
+    }
+
+    void drawRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t c) {
+        _call(); _roundRect(x, y, w, h, r, false); _flush(c);
+    }
+    void fillRoundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, uint32_t c) {
+        _call(); _roundRect(x, y, w, h, r, true); _flush(c);
+    }
+
+    void fillTriangle(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t c) {
+        _call();
+        int32_t top = min(y0, min(y1, y2)), bottom = max(y0, max(y1, y2));
+        for (int32_t y = top; y <= bottom; y++) {
+            float lo = 1e9f, hi = -1e9f;
+            _edge(x0, y0, x1, y1, y, lo, hi);
+            _edge(x1, y1, x2, y2, y, lo, hi);
+            _edge(x2, y2, x0, y0, y, lo, hi);
+            for (int32_t x = (int32_t)lroundf(lo); x <= (int32_t)lroundf(hi); x++) _mark(x, y);
+        }
+        _flush(c);
+    }
+
+    void setCursor(int16_t x, int16_t y) { _cx = x; _cy = y; }
+    int16_t getCursorX() const { return _cx; }
+    int16_t getCursorY() const { return _cy; }
+    void setTextColor(uint16_t c) { _fg = _bg = c; }
+    void setTextColor(uint16_t fg, uint16_t bg) { _fg = fg; _bg = bg; }
+    void setTextSize(uint8_t s) { _size = s ? s : 1; }
+    void setFreeFont(const GFXfont* f) { _font = f; }
+
+    size_t write(const uint8_t* b, size_t n) override {
+        _call();
+        for (size_t i = 0; i < n; i++) _char(b[i]);
+        return n;
+    }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    using Print::write;
+
+    void setTouch(uint16_t*) {}
+    void calibrateTouch(uint16_t* data, uint32_t, uint32_t, uint8_t) { memset(data, 0, 5 * sizeof(uint16_t)); }
+    uint8_t getTouch(uint16_t*, uint16_t*, uint16_t = 600) { return 0; }
+
+    // ===== Host-only: counters and framebuffer =====
+
+    const TftStats& hostStats() const { return _stats; }
+    void hostReset() { _stats = TftStats(); std::fill(_seen.begin(), _seen.end(), 0); }
+    void hostRecord(bool on) { _recording = on; }
+    uint16_t hostPixel(int32_t x, int32_t y) const { return _inside(x, y) && _bus ? _fb[y * _w + x] : 0; }
+
+    // One window of w x h pixels, as pushImage / pushSprite send it
+    void hostPush(int32_t x, int32_t y, int32_t w, int32_t h) { _call(); _fill(x, y, w, h, TFT_WHITE); }
+
+    bool hostSavePPM(const char* path) const {
+        FILE* f = fopen(path, "wb");
+        if (!f) return false;
+        fprintf(f, "P6\n%d %d\n255\n", _w, _h);
+        for (uint16_t p : _fb) {
+            uint8_t rgb[3] = {(uint8_t)((p >> 8) & 0xF8), (uint8_t)((p >> 3) & 0xFC), (uint8_t)(p << 3)};
+            fwrite(rgb, 1, 3, f);
+        }
+        return fclose(f) == 0;
+    }
+
+protected:
+    int16_t _w, _h;
+    int16_t _cx = 0, _cy = 0;
+    uint16_t _fg = TFT_WHITE, _bg = TFT_BLACK;
+    uint8_t _size = 1;
+    const GFXfont* _font = nullptr;
+    bool _bus = false;             // the panel; sprites stay in RAM
+    bool _recording = true;
+    TftStats _stats;
+    std::vector<uint16_t> _fb;
+    std::vector<uint8_t> _seen;    // written since hostReset()
+    std::vector<uint8_t> _mask;    // pixels of the shape being drawn
+
+    bool _inside(int32_t x, int32_t y) const { return x >= 0 && y >= 0 && x < _w && y < _h; }
+    bool _live() const { return _bus && _recording; }
+    void _call() { if (_live()) _stats.calls++; }
+
+    void _fill(int32_t x, int32_t y, int32_t w, int32_t h, uint32_t c) {
+        if (!_bus) return;
+        int32_t x0 = max<int32_t>(x, 0), y0 = max<int32_t>(y, 0);
+        int32_t x1 = min<int32_t>(x + w, _w), y1 = min<int32_t>(y + h, _h);
+        if (x0 >= x1 || y0 >= y1) return;
+        for (int32_t yy = y0; yy < y1; yy++) {
+            for (int32_t xx = x0; xx < x1; xx++) {
+                size_t k = (size_t)yy * _w + xx;
+                _fb[k] = (uint16_t)c;
+                if (_recording && !_seen[k]) { _seen[k] = 1; _stats.touched++; }
+            }
+        }
+        if (!_recording) return;
+        _stats.windows++;
+        _stats.pixels += (uint64_t)(x1 - x0) * (y1 - y0);
+    }
+
+    void _mark(int32_t x, int32_t y) { if (_bus && _inside(x, y)) _mask[(size_t)y * _w + x] = 1; }
+
+    // Send the marked shape as one window per horizontal run
+    void _flush(uint32_t c) {
+        if (!_bus) return;
+        for (int32_t y = 0; y < _h; y++) {
+            uint8_t* row = &_mask[(size_t)y * _w];
+            for (int32_t x = 0; x < _w; x++) {
+                if (!row[x]) continue;
+                int32_t run = x;
+                while (run < _w && row[run]) row[run++] = 0;
+                _fill(x, y, run - x, 1, c);
+                x = run;
+            }
+        }
+    }
+
+    static bool _inArc(float a, uint32_t start, uint32_t end) {
+        if (start == end || (start == 0 && end == 360)) return true;
+        return start < end ? (a >= start && a <= end) : (a >= start || a <= end);
+    }
+
+    // Pixels with ir < distance <= r within the arc; ir < 0 fills the disc
+    void _ring(int32_t cx, int32_t cy, float r, float ir, uint32_t start, uint32_t end) {
+        int32_t R = (int32_t)ceilf(r);
+        for (int32_t dy = -R; dy <= R; dy++) {
+            for (int32_t dx = -R; dx <= R; dx++) {
+                float d = sqrtf((float)(dx * dx + dy * dy));
+                if (d > r || d <= ir) continue;
+                float a = atan2f((float)-dx, (float)dy) * 57.29578f;
+                if (a < 0) a += 360;
+                if (_inArc(a, start, end)) _mark(cx + dx, cy + dy);
+            }
+        }
+    }
+
+    void _roundRect(int32_t x, int32_t y, int32_t w, int32_t h, int32_t r, bool fill) {
+        r = min(r, min(w, h) / 2);
+        for (int32_t yy = y; yy < y + h; yy++) {
+            for (int32_t xx = x; xx < x + w; xx++) {
+                int32_t ex = xx < x + r ? x + r - xx : (xx >= x + w - r ? xx - (x + w - r - 1) : 0);
+                int32_t ey = yy < y + r ? y + r - yy : (yy >= y + h - r ? yy - (y + h - r - 1) : 0);
+                float d = sqrtf((float)(ex * ex + ey * ey));
+                bool edge = yy == y || yy == y + h - 1 || xx == x || xx == x + w - 1 || (ex && ey && d > r - 1);
+                if ((ex && ey && d > r + 0.5f) || (!fill && !edge)) continue;
+                _mark(xx, yy);
+            }
+        }
+    }
+
+    static void _edge(int32_t x0, int32_t y0, int32_t x1, int32_t y1, int32_t y, float& lo, float& hi) {
+        if ((y < y0 && y < y1) || (y > y0 && y > y1)) return;
+        float x = y0 == y1 ? (float)x0 : x0 + (float)(y - y0) * (x1 - x0) / (y1 - y0);
+        if (y0 == y1) { lo = min(lo, (float)min(x0, x1)); hi = max(hi, (float)max(x0, x1)); return; }
+        lo = min(lo, x);
+        hi = max(hi, x);
+    }
+
+    void _char(uint8_t ch) {
+        int32_t cw = 6 * _size, chh = 8 * _size, dot = _size;
+        if (_font) { chh = _font->yAdvance; cw = chh * 3 / 5; dot = 1; }
+        if (ch == '\n') { _cx = 0; _cy += chh; return; }
+        if (ch == '\r') return;
+        if (_fg != _bg && !_font) {
+            _fill(_cx, _cy, cw, chh, _bg);
+        } else if (ch != ' ') {
+            // About a third of the cell is ink, sent a dot at a time
+            for (int32_t row = 0; row < chh / dot; row++) {
+                for (int32_t col = 0; col < cw / dot - (_font ? 0 : 1); col++) {
+                    if ((col * 7 + row * 5 + ch) % 3 == 0) _fill(_cx + col * dot, _cy + row * dot, dot, dot, _fg);
+                }
+            }
+        }
+        _cx += cw;
+    }
+};
+
+class TFT_eSprite : public TFT_eSPI {
+public:
+    explicit TFT_eSprite(TFT_eSPI* tft) : TFT_eSPI(0, 0), _tft(tft) {}
+
+    void* createSprite(int16_t w, int16_t h) { _w = w; _h = h; _created = true; return this; }
+    void deleteSprite() { _created = false; }
+    bool created() const { return _created; }
+    void setColorDepth(int8_t) {}
+    void fillSprite(uint32_t) {}
+    void setScrollRect(int32_t, int32_t, int32_t, int32_t, uint16_t = TFT_BLACK) {}
+    void scroll(int16_t, int16_t = 0) {}
+    void pushSprite(int32_t x, int32_t y) { if (_created) _tft->hostPush(x, y, _w, _h); }
+
+private:
+    TFT_eSPI* _tft;
+    bool _created = false;
+};
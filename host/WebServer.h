@@ -0,0 +1,119 @@
+#pragma once
+/**
+ * Host stand-in for the ESP32 WebServer
+ *
+ * Nothing listens. Handlers registered with on() are called by request(),
+ * which parses the query string into args and returns what the handler
+ * sent, so the host runner can exercise the web API in-process.
+ */
+
+#include <WiFi.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t)-1)
+
+struct HostWebResponse {
+    int code = 404;
+    std::string type;
+    std::string body;
+};
+
+class WebServer {
+public:
+    typedef std::function<void()> THandlerFunction;
+
+    explicit WebServer(int port = 80) : _port(port) {}
+
+    void begin() {}
+    void handleClient() {}
+    void on(const char* uri, HTTPMethod method, THandlerFunction fn) { _routes.push_back({uri, method, fn}); }
+    void on(const char* uri, THandlerFunction fn) { on(uri, HTTP_ANY, fn); }
+    void onNotFound(THandlerFunction fn) { _notFound = fn; }
+
+    bool hasArg(const char* name) const { return _args.count(name) > 0; }
+    String arg(const char* name) const { auto it = _args.find(name); return it == _args.end() ? String() : String(it->second); }
+    String uri() const { return String(_uri); }
+    HTTPMethod method() const { return _method; }
+
+    void send(int code, const char* type = nullptr, const String& body = String()) {
+        _res.code = code;
+        _res.type = type ? type : "";
+        _res.body = body.c_str();
+    }
+    void send(int code, const char* type, const char* body) { send(code, type, String(body)); }
+    void send_P(int code, const char* type, const char* body, size_t n) {
+        _res.code = code;
+        _res.type = type ? type : "";
+        _res.body.assign(body, n);
+    }
+    void sendHeader(const String&, const String&, bool = false) {}
+    void setContentLength(size_t) {}
+    void sendContent(const String& s) { _res.body += s.c_str(); }
+    template <typename File> size_t streamFile(File& file, const String& type) {
+        _res.code = 200;
+        _res.type = type.c_str();
+        _res.body.clear();
+        uint8_t buf[512];
+        for (size_t n; (n = file.read(buf, sizeof(buf))) > 0; ) _res.body.append((const char*)buf, n);
+        return _res.body.size();
+    }
+    WiFiClient client() { return WiFiClient(); }
+
+    // Run the handler for `method uri?query` and return its response
+    HostWebResponse request(HTTPMethod method, const std::string& target) {
+        size_t q = target.find('?');
+        _uri = target.substr(0, q);
+        _method = method;
+        _args.clear();
+        if (q != std::string::npos) _parseQuery(target.substr(q + 1));
+        _res = HostWebResponse();
+        for (auto& r : _routes) {
+            if (r.uri == _uri && (r.method == HTTP_ANY || r.method == method)) { r.fn(); return _res; }
+        }
+        if (_notFound) _notFound();
+        return _res;
+    }
+
+private:
+    struct _Route { std::string uri; HTTPMethod method; THandlerFunction fn; };
+
+    int _port;
+    std::vector<_Route> _routes;
+    THandlerFunction _notFound;
+    std::map<std::string, std::string> _args;
+    std::string _uri;
+    HTTPMethod _method = HTTP_GET;
+    HostWebResponse _res;
+
+    static int _hex(char c) { return isdigit((unsigned char)c) ? c - '0' : (tolower((unsigned char)c) - 'a' + 10) & 15; }
+
+    static std::string _decode(const std::string& s) {
+        std::string out;
+        for (size_t i = 0; i < s.size(); i++) {
+            if (s[i] == '+') out += ' ';
+            else if (s[i] == '%' && i + 2 < s.size()) { out += (char)(_hex(s[i + 1]) * 16 + _hex(s[i + 2])); i += 2; }
+            else out += s[i];
+        }
+        return out;
+    }
+
+    void _parseQuery(const std::string& q) {
+        size_t start = 0;
+        while (start <= q.size()) {
+            size_t end = q.find('&', start);
+            if (end == std::string::npos) end = q.size();
+            std::string kv = q.substr(start, end - start);
+            if (!kv.empty()) {
+                size_t eq = kv.find('=');
+                _args[_decode(kv.substr(0, eq))] = eq == std::string::npos ? "" : _decode(kv.substr(eq + 1));
+            }
+            start = end + 1;
+        }
+    }
+};
@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * Host stand-in for the ESP32 WiFi library: always connected, no sockets.
+ * HTTP traffic is faked one level up, in HTTPClient (see HostHttp.h).
+ */
+
+#include <Arduino.h>
+#include <string>
+
+#define WL_CONNECTED 3
+
+class IPAddress {
+public:
+    IPAddress(uint8_t a = 192, uint8_t b = 168, uint8_t c = 1, uint8_t d = 99) : _b{a, b, c, d} {}
+    uint8_t operator[](int i) const { return _b[i]; }
+    String toString() const {
+        char s[16];
+        snprintf(s, sizeof(s), "%u.%u.%u.%u", _b[0], _b[1], _b[2], _b[3]);
+        return String(s);
+    }
+
+private:
+    uint8_t _b[4];
+};
+
+class WiFiClient : public Stream {
+public:
+    // Always "connects": whether the request then succeeds is up to HostHttp
+    bool connect(const char*, uint16_t, int32_t = 0) { return true; }
+    bool connected() { return hostSink != nullptr; }
+    void stop() {}
+    void setInsecure() {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* p, size_t n) override {
+        if (hostSink) hostSink->append((const char*)p, n);
+        return n;
+    }
+    using Print::write;
+
+    // A client handed to a streaming handler: connected while set, and keeps what was written
+    std::string* hostSink = nullptr;
+};
+
+struct WiFiClass {
+    int status() { return WL_CONNECTED; }
+    IPAddress localIP() { return IPAddress(); }
+    int RSSI() { return -55; }
+    int hostByName(const char*, IPAddress& ip) { ip = IPAddress(10, 0, 0, 1); return 1; }
+};
+extern WiFiClass WiFi;
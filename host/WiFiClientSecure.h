@@ -0,0 +1,4 @@
+#pragma once
+#include <WiFi.h>
+
+typedef WiFiClient WiFiClientSecure;
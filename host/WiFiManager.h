@@ -0,0 +1,29 @@
+#pragma once
+/**
+ * Host stand-in for WiFiManager: already connected, the portal never opens.
+ */
+
+#include <Arduino.h>
+#include <functional>
+
+class WiFiManagerParameter {
+public:
+    WiFiManagerParameter(const char*, const char*, const char* value, int) : _value(value) {}
+    const char* getValue() const { return _value; }
+
+private:
+    const char* _value;
+};
+
+class WiFiManager {
+public:
+    void setDebugOutput(bool) {}
+    void setCustomHeadElement(const char*) {}
+    void setTitle(const char*) {}
+    void addParameter(WiFiManagerParameter*) {}
+    void setConfigPortalTimeout(unsigned long) {}
+    void setSaveParamsCallback(std::function<void()>) {}
+    bool startConfigPortal(const char*, const char*) { return true; }
+    bool autoConnect(const char*, const char*) { return true; }
+    void resetSettings() {}
+};
@@ -0,0 +1,294 @@
+#!/usr/bin/env python3
+"""
+BitAxe fleet simulator: N AxeOS miners on localhost ports
+
+    python3 host/fleet_sim.py --devices 64 --base-port 4000 --latency 40 --jitter 20
+                              [--loss 0.02] [--dead 2] [--hang 1] [--chunked] [--report 10]
+
+Device i listens on base-port + i and answers
+
+    GET   /api/system/info       the fields fetchDeviceData() reads
+    PATCH /api/system            frequency, coreVoltage, fanspeed
+    POST  /api/system/restart    uptime and share counters start over
+
+with the same miner model as host/FakeAxeOS.h, on the wall clock: hashrate
+follows frequency with jitter, temperature drifts toward what power and fan
+allow, shares arrive in proportion to hashrate.
+
+Faults, per request or per device:
+    --latency/--jitter   delay before every answer, ms (uniform +/- jitter)
+    --loss               fraction of requests whose connection is closed unanswered
+    --dead K             the last K devices do not listen (connection refused)
+    --hang K             the K devices before them accept and never answer
+    --reboot S           after a restart the device drops requests for S seconds
+    --chunked            send /api/system/info with Transfer-Encoding: chunked
+
+Give the display (or the host build: --sim PORT) the list this prints. A
+table of requests, failures and served latency per kind goes to stdout every
+--report seconds and on Ctrl-C; --json writes the same as JSON on exit.
+Standard library only.
+"""
+
+import argparse
+import asyncio
+import json
+import random
+import signal
+import time
+
+KINDS = ("info", "patch", "restart", "other")
+CHUNK = 256                                             # --chunked piece size, bytes
+
+
+class Miner:
+    def __init__(self, index, seed):
+        self.index = index
+        self.rng = random.Random(seed * 2654435761 + 1)
+        self.boot_at = self.last_at = time.monotonic()
+        self.frequency = 525
+        self.core_voltage = 1150
+        self.fan = 60
+        self.temp = 55.0
+        self.share_carry = 0.0
+        self.accepted = self.rejected = 0
+        self.best_diff = 0.0
+        self.rebooting_until = 0.0
+
+    def hashrate(self):
+        return self.frequency * 2.04                    # BM1370-ish GH/s per MHz
+
+    def power(self):
+        return 3.5 + self.frequency * self.core_voltage * 2.6e-5
+
+    def advance(self):
+        now = time.monotonic()
+        dt = now - self.last_at
+        self.last_at = now
+        if dt <= 0:
+            return
+        target = 28 + self.power() * 2.1 - self.fan * 0.12
+        self.temp += (target - self.temp) * min(1.0, dt / 60.0)
+        # Shares at difficulty 1000, ~0.84 per GH/s-hour
+        self.share_carry += self.hashrate() * dt / 3600.0 * 0.838
+        while self.share_carry >= 1:
+            self.share_carry -= 1
+            self.accepted += 1
+            if self.accepted % 200 == 0:
+                self.rejected += 1
+            d = 1000.0 / (0.0001 + abs(self.rng.random() - 0.5))
+            self.best_diff = max(self.best_diff, d)
+
+    def info(self):
+        self.advance()
+        return {
+            "hashRate": round(self.hashrate() * (1 + (self.rng.random() - 0.5) * 0.06), 2),
+            "hashRate_1h": round(self.hashrate(), 2),
+            "temp": round(self.temp, 1),
+            "vrTemp": round(self.temp + 8, 1),
+            "power": round(self.power(), 2),
+            "voltage": 5100,
+            "coreVoltage": self.core_voltage,
+            "frequency": self.frequency,
+            "fanrpm": 2000 + self.fan * 40,
+            "fanspeed": self.fan,
+            "sharesAccepted": self.accepted,
+            "sharesRejected": self.rejected,
+            "bestDiff": round(self.best_diff),
+            "bestSessionDiff": round(self.best_diff),
+            "hostname": "bitaxe-%02d" % self.index,
+            "deviceModel": "Gamma",
+            "ASICModel": "BM1370",
+            "stratumURL": "public-pool.io",
+            "stratumPort": 21496,
+            "stratumUser": "bc1qexample.%02d" % self.index,
+            "uptimeSeconds": int(time.monotonic() - self.boot_at),
+            "wifiRSSI": -50 - self.index % 20,
+            "poolDifficulty": 1000,
+        }
+
+    def patch(self, body):
+        self.advance()
+        self.frequency = int(body.get("frequency", self.frequency))
+        self.core_voltage = int(body.get("coreVoltage", self.core_voltage))
+        self.fan = int(body.get("fanspeed", self.fan))
+
+    def restart(self, reboot_s):
+        self.boot_at = self.last_at = time.monotonic()
+        self.accepted = self.rejected = 0
+        self.rebooting_until = self.boot_at + reboot_s
+
+
+class Stats:
+    def __init__(self, devices):
+        self.started = time.monotonic()
+        self.served = {k: [] for k in KINDS}            # ms from request read to answer written
+        self.per_device = [0] * devices
+        self.dropped = 0
+        self.bad = 0
+        self.connections = 0
+
+    @staticmethod
+    def percentile(values, p):
+        if not values:
+            return 0.0
+        s = sorted(values)
+        return s[min(len(s) - 1, int(p / 100.0 * len(s)))]
+
+    def summary(self):
+        elapsed = max(1e-6, time.monotonic() - self.started)
+        out = {"elapsedS": round(elapsed, 1), "connections": self.connections,
+               "dropped": self.dropped, "badRequests": self.bad, "kinds": {}}
+        for k in KINDS:
+            v = self.served[k]
+            if not v:
+                continue
+            out["kinds"][k] = {"count": len(v), "perS": round(len(v) / elapsed, 2),
+                               "p50": round(self.percentile(v, 50), 1), "p95": round(self.percentile(v, 95), 1),
+                               "max": round(max(v), 1)}
+        busy = [c for c in self.per_device if c]
+        out["devicesPolled"] = len(busy)
+        out["requestsPerDevice"] = {"min": min(busy) if busy else 0, "max": max(busy) if busy else 0}
+        return out
+
+    def print(self):
+        s = self.summary()
+        print("sim: %.0f s, %d connections, %d dropped, %d bad, %d devices polled (%d-%d requests each)"
+              % (s["elapsedS"], s["connections"], s["dropped"], s["badRequests"], s["devicesPolled"],
+                 s["requestsPerDevice"]["min"], s["requestsPerDevice"]["max"]))
+        for k, v in s["kinds"].items():
+            print("sim:   %-8s %6d  %7.2f/s  p50 %6.1f ms  p95 %6.1f ms  max %6.1f ms"
+                  % (k, v["count"], v["perS"], v["p50"], v["p95"], v["max"]))
+
+
+class Fleet:
+    def __init__(self, args):
+        self.args = args
+        self.rng = random.Random(args.seed)
+        self.miners = [Miner(i, args.seed + i + 1) for i in range(args.devices)]
+        self.stats = Stats(args.devices)
+        first_dead = args.devices - args.dead
+        self.hung = set(range(max(0, first_dead - args.hang), first_dead))
+
+    async def handle(self, index, reader, writer):
+        self.stats.connections += 1
+        try:
+            while True:
+                line = await reader.readline()
+                if not line:
+                    return
+                t0 = time.monotonic()
+                try:
+                    method, target, _ = line.decode("latin-1").split(" ", 2)
+                except ValueError:
+                    self.stats.bad += 1
+                    return
+                headers = {}
+                while True:
+                    h = await reader.readline()
+                    if h in (b"\r\n", b"\n", b""):
+                        break
+                    name, _, value = h.decode("latin-1").partition(":")
+                    headers[name.strip().lower()] = value.strip()
+                length = int(headers.get("content-length", "0") or 0)
+                body = await reader.readexactly(length) if length else b""
+
+                if index in self.hung:
+                    await reader.read()             # until the client gives up
+                    return
+                miner = self.miners[index]
+                if self.rng.random() < self.args.loss or time.monotonic() < miner.rebooting_until:
+                    self.stats.dropped += 1
+                    return
+                delay = self.args.latency + (self.rng.random() * 2 - 1) * self.args.jitter
+                if delay > 0:
+                    await asyncio.sleep(delay / 1000.0)
+
+                kind, code, payload = self.dispatch(miner, method, target.split("?")[0], body)
+                data = payload.encode()
+                keep = headers.get("connection", "").lower() == "keep-alive"
+                if self.args.chunked and kind == "info":
+                    framing = "Transfer-Encoding: chunked"
+                    data = b"".join(b"%x\r\n%s\r\n" % (len(data[k:k + CHUNK]), data[k:k + CHUNK])
+                                    for k in range(0, len(data), CHUNK)) + b"0\r\n\r\n"
+                else:
+                    framing = "Content-Length: %d" % len(data)
+                writer.write(("HTTP/1.1 %d %s\r\nContent-Type: %s\r\n%s\r\nConnection: %s\r\n\r\n"
+                              % (code, "OK" if code == 200 else "Error",
+                                 "application/json" if payload.startswith("{") else "text/plain",
+                                 framing, "keep-alive" if keep else "close")).encode() + data)
+                await writer.drain()
+                self.stats.served[kind].append((time.monotonic() - t0) * 1000.0)
+                self.stats.per_device[index] += 1
+                if not keep:
+                    return
+        except (ConnectionError, asyncio.IncompleteReadError, asyncio.CancelledError):
+            pass
+        finally:
+            writer.close()
+
+    def dispatch(self, miner, method, path, body):
+        if method == "GET" and path == "/api/system/info":
+            return "info", 200, json.dumps(miner.info(), separators=(",", ":"))
+        if method == "PATCH" and path == "/api/system":
+            try:
+                miner.patch(json.loads(body or b"{}"))
+            except (ValueError, TypeError):
+                return "patch", 400, "Bad JSON"
+            return "patch", 200, ""
+        if method == "POST" and path == "/api/system/restart":
+            miner.restart(self.args.reboot)
+            return "restart", 200, "System will restart shortly."
+        return "other", 404, "Not found"
+
+    async def run(self):
+        servers = []
+        for i in range(self.args.devices - self.args.dead):
+            servers.append(await asyncio.start_server(
+                lambda r, w, i=i: self.handle(i, r, w), self.args.host, self.args.base_port + i, backlog=32))
+        ips = ",".join("%s:%d" % (self.args.host, self.args.base_port + i) for i in range(self.args.devices))
+        print("sim: %d devices on %s:%d-%d (%d hung, %d dead)" % (
+            self.args.devices, self.args.host, self.args.base_port, self.args.base_port + self.args.devices - 1,
+            len(self.hung), self.args.dead))
+        print("sim: device list: %s" % ips, flush=True)
+
+        stop = asyncio.Event()
+        loop = asyncio.get_running_loop()
+        for sig in (signal.SIGINT, signal.SIGTERM):
+            loop.add_signal_handler(sig, stop.set)
+        while not stop.is_set():
+            try:
+                await asyncio.wait_for(stop.wait(), timeout=self.args.report or None)
+            except asyncio.TimeoutError:
+                self.stats.print()
+                print(flush=True)
+        for s in servers:
+            s.close()
+        self.stats.print()
+        if self.args.json:
+            with open(self.args.json, "w") as f:
+                json.dump(self.stats.summary(), f, indent=1)
+
+
+def main():
+    p = argparse.ArgumentParser(description="Simulate N AxeOS miners on localhost ports")
+    p.add_argument("--devices", type=int, default=8)
+    p.add_argument("--host", default="127.0.0.1")
+    p.add_argument("--base-port", type=int, default=4000)
+    p.add_argument("--latency", type=float, default=40, help="ms before each answer")
+    p.add_argument("--jitter", type=float, default=10, help="+/- ms around --latency")
+    p.add_argument("--loss", type=float, default=0.0, help="fraction of requests dropped unanswered")
+    p.add_argument("--dead", type=int, default=0, help="last K devices refuse connections")
+    p.add_argument("--hang", type=int, default=0, help="K devices before the dead ones never answer")
+    p.add_argument("--reboot", type=float, default=15, help="s a restarted device stays unreachable")
+    p.add_argument("--chunked", action="store_true", help="answer /api/system/info chunked")
+    p.add_argument("--seed", type=int, default=1)
+    p.add_argument("--report", type=float, default=10, help="s between stats tables, 0 = on exit only")
+    p.add_argument("--json", help="write the final stats to this file")
+    args = p.parse_args()
+    if args.devices < 1 or args.dead + args.hang > args.devices:
+        p.error("need at least one device and --dead + --hang <= --devices")
+    asyncio.run(Fleet(args).run())
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,336 @@
+/**
+ * Host build: globals and out-of-line parts of the fakes in this directory
+ */
+
+#include <Arduino.h>
+#include <ESPmDNS.h>
+#include <HTTPClient.h>
+#include <LittleFS.h>
+#include <TFT_eSPI.h>
+#include <WiFi.h>
+#include <lwip/sockets.h>
+#include <poll.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <future>
+#include <map>
+#include <new>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+HardwareSerial Serial;
+
+// C++ allocations through malloc, so a build linked with --wrap=malloc (src/heap_telemetry.h)
+// counts them; libstdc++'s own operator new calls malloc from a shared library the wrap cannot see.
+// The pair stays out of line: inlined, GCC sees new'd pointers reach free() (-Wmismatched-new-delete).
+__attribute__((noinline)) static void* hostNew(size_t n) {
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) static void hostDelete(void* p) { free(p); }
+
+void* operator new(size_t n) { return hostNew(n); }
+void* operator new[](size_t n) { return hostNew(n); }
+void operator delete(void* p) noexcept { hostDelete(p); }
+void operator delete[](void* p) noexcept { hostDelete(p); }
+void operator delete(void* p, size_t) noexcept { hostDelete(p); }
+void operator delete[](void* p, size_t) noexcept { hostDelete(p); }
+EspClass ESP;
+WiFiClass WiFi;
+MDNSResponder MDNS;
+fs::FS LittleFS;
+const GFXfont Satisfy_24 = {24};
+
+// ===== VIRTUAL CLOCK =====
+
+static std::atomic<uint32_t> hostNowMs{0};
+static const std::thread::id hostMainThread = std::this_thread::get_id();
+
+namespace HostClock {
+    void advance(uint32_t ms) { hostNowMs += ms; }
+    void set(uint32_t ms) { hostNowMs = ms; }
+    bool onMainThread() { return std::this_thread::get_id() == hostMainThread; }
+}
+
+unsigned long millis() { return hostNowMs; }
+unsigned long micros() { return (unsigned long)hostNowMs * 1000UL; }
+
+void delay(unsigned long ms) {
+    if (HostClock::onMainThread()) HostClock::advance(ms);
+    else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+}
+
+void EspClass::restart() {
+    Serial.println("HOST: ESP.restart() requested, exiting");
+    fflush(stdout);
+    exit(0);
+}
+
+// ===== FREERTOS =====
+
+struct HostQueue {
+    size_t itemSize, length;
+    std::deque<std::vector<uint8_t>> items;
+    std::mutex m;
+    std::condition_variable cv;
+};
+
+QueueHandle_t xQueueCreate(size_t length, size_t itemSize) {
+    HostQueue* q = new HostQueue();
+    q->itemSize = itemSize;
+    q->length = length;
+    return q;
+}
+
+// Senders never wait: a full queue fails straight away
+BaseType_t xQueueSend(QueueHandle_t q, const void* item, TickType_t) {
+    if (!q) return pdFALSE;
+    std::lock_guard<std::mutex> lock(q->m);
+    if (q->items.size() >= q->length) return pdFALSE;
+    q->items.emplace_back((const uint8_t*)item, (const uint8_t*)item + q->itemSize);
+    q->cv.notify_one();
+    return pdTRUE;
+}
+
+// Only portMAX_DELAY blocks; any other wait polls
+BaseType_t xQueueReceive(QueueHandle_t q, void* item, TickType_t wait) {
+    if (!q) return pdFALSE;
+    std::unique_lock<std::mutex> lock(q->m);
+    if (wait == portMAX_DELAY) q->cv.wait(lock, [q] { return !q->items.empty(); });
+    if (q->items.empty()) return pdFALSE;
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    return pdTRUE;
+}
+
+// A thread's handle is the address of its own thread_local; the creator waits for the new one's.
+// Inside a HostNetworkScope it is hostNetworkTask instead.
+static thread_local char hostTaskSelf;
+static thread_local int hostInNetwork = 0;
+static char hostNetworkTask;
+
+HostNetworkScope::HostNetworkScope() { hostInNetwork++; }
+HostNetworkScope::~HostNetworkScope() { hostInNetwork--; }
+
+BaseType_t xTaskCreatePinnedToCore(void (*fn)(void*), const char*, uint32_t, void* arg, int, TaskHandle_t* handle, int) {
+    std::promise<TaskHandle_t> started;
+    std::future<TaskHandle_t> self = started.get_future();
+    std::thread([fn, arg, &started]() {
+        started.set_value(xTaskGetCurrentTaskHandle());
+        fn(arg);
+    }).detach();
+    TaskHandle_t h = self.get();
+    if (handle) *handle = h;
+    return pdPASS;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    return hostInNetwork ? (TaskHandle_t)&hostNetworkTask : (TaskHandle_t)&hostTaskSelf;
+}
+
+uint32_t uxTaskGetStackHighWaterMark(TaskHandle_t) {
+    return 0;
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks ? 1 : 0));
+}
+
+// ===== HTTP ROUTES =====
+
+namespace {
+    struct HostRoute {
+        HostHandler handler;
+        uint32_t count = 0;
+    };
+    std::mutex hostHttpLock;
+    std::map<std::string, HostRoute> hostRoutes;
+    uint32_t hostUnrouted = 0;
+    bool hostNetwork = false;
+    HostNetStats hostNet;
+
+    int waitFd(int fd, short events, int64_t deadline) {
+        int64_t left = deadline - (int64_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                           std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (left <= 0) return 0;
+        pollfd p = {fd, events, 0};
+        return poll(&p, 1, (int)left);
+    }
+
+    // One HTTP/1.1 request with Connection: close; codes follow HTTPClient (-1 refused, -11 timeout)
+    HostResponse netRequest(const HostRequest& req) {
+        HostResponse r;
+        unsigned a, b, c, d, port = 80;
+        char path[512] = "/";
+        if (sscanf(req.url.c_str(), "http://%u.%u.%u.%u:%u%511s", &a, &b, &c, &d, &port, path) < 5 &&
+            sscanf(req.url.c_str(), "http://%u.%u.%u.%u%511s", &a, &b, &c, &d, path) < 4) return r;
+        auto t0 = std::chrono::steady_clock::now();
+        int64_t deadline = std::chrono::duration_cast<std::chrono::milliseconds>(t0.time_since_epoch()).count() + req.timeoutMs;
+
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return r;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        sockaddr_in sa = {};
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(port);
+        sa.sin_addr.s_addr = htonl((a << 24) | (b << 16) | (c << 8) | d);
+        int err = 0;
+        socklen_t len = sizeof(err);
+        if (connect(fd, (sockaddr*)&sa, sizeof(sa)) != 0) {
+            if (errno != EINPROGRESS || waitFd(fd, POLLOUT, deadline) <= 0) err = ETIMEDOUT;
+            else getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len);
+        }
+        std::string msg = std::string(req.method) + " " + path + " HTTP/1.1\r\nHost: " + req.url.substr(7, req.url.find('/', 7) - 7) +
+                          "\r\nConnection: close\r\nContent-Type: application/json\r\nContent-Length: " +
+                          std::to_string(req.body.size()) + "\r\n\r\n" + req.body;
+        for (size_t sent = 0; !err && sent < msg.size(); ) {
+            if (waitFd(fd, POLLOUT, deadline) <= 0) { err = ETIMEDOUT; break; }
+            ssize_t k = send(fd, msg.data() + sent, msg.size() - sent, MSG_NOSIGNAL);
+            if (k < 0 && errno != EAGAIN) err = errno;
+            else if (k > 0) sent += k;
+        }
+        std::string in;
+        char buf[4096];
+        while (!err) {
+            if (waitFd(fd, POLLIN, deadline) <= 0) { err = ETIMEDOUT; break; }
+            ssize_t k = recv(fd, buf, sizeof(buf), 0);
+            if (k == 0) break;
+            if (k < 0 && errno != EAGAIN) err = errno;
+            else if (k > 0) in.append(buf, k);
+        }
+        close(fd);
+
+        r.latencyMs = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - t0).count();
+        size_t head = in.find("\r\n\r\n");
+        if (err == ETIMEDOUT) r.code = -11;
+        else if (!err && in.compare(0, 5, "HTTP/") == 0 && head != std::string::npos) {
+            r.code = atoi(in.c_str() + 9);
+            r.body = in.substr(head + 4);
+            std::string h = in.substr(0, head);
+            for (auto& c : h) c = tolower(c);
+            r.chunked = h.find("\r\ntransfer-encoding: chunked") != std::string::npos;
+        }
+        return r;
+    }
+}
+
+namespace HostHttp {
+    void route(const std::string& urlPrefix, HostHandler handler) {
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        hostRoutes[urlPrefix].handler = handler;
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        hostRoutes.clear();
+        hostUnrouted = 0;
+    }
+
+    HostResponse request(const HostRequest& req) {
+        HostNetworkScope scope;
+        HostHandler handler;
+        {
+            std::lock_guard<std::mutex> lock(hostHttpLock);
+            HostRoute* best = nullptr;
+            size_t bestLen = 0;
+            for (auto& r : hostRoutes) {
+                if (req.url.compare(0, r.first.size(), r.first) == 0 && r.first.size() >= bestLen) {
+                    best = &r.second;
+                    bestLen = r.first.size();
+                }
+            }
+            if (best) {
+                best->count++;
+                handler = best->handler;
+            } else if (!hostNetwork || req.url.compare(0, 7, "http://") != 0) {
+                hostUnrouted++;
+                return HostResponse();
+            }
+        }
+        if (handler) return handler(req);
+
+        HostResponse r = netRequest(req);
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        hostNet.requests++;
+        hostNet.failures += r.code <= 0;
+        hostNet.latencyMs.push_back(r.latencyMs);
+        return r;
+    }
+
+    uint32_t count(const std::string& urlPrefix) {
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        auto it = hostRoutes.find(urlPrefix);
+        return it == hostRoutes.end() ? 0 : it->second.count;
+    }
+
+    uint32_t unrouted() {
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        return hostUnrouted;
+    }
+
+    void network(bool on) {
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        hostNetwork = on;
+    }
+
+    HostNetStats netStats() {
+        std::lock_guard<std::mutex> lock(hostHttpLock);
+        return hostNet;
+    }
+}
+
+// ===== FILESYSTEM =====
+
+namespace stdfs = std::filesystem;
+
+static std::string hostFsPath(const char* path) {
+    const char* root = getenv("HOST_FS_ROOT");
+    return std::string(root ? root : "host_fs") + path;
+}
+
+namespace fs {
+
+File FS::open(const char* path, const char* mode) {
+    std::string real = hostFsPath(path);
+    std::error_code ec;
+    if (stdfs::is_directory(real, ec)) {
+        std::vector<std::string> entries;
+        for (auto& e : stdfs::directory_iterator(real, ec)) entries.push_back(e.path().filename().string());
+        return File(entries, path);
+    }
+    if (mode[0] != 'r') stdfs::create_directories(stdfs::path(real).parent_path(), ec);
+    FILE* f = fopen(real.c_str(), mode[0] == 'r' ? "rb" : (mode[0] == 'a' ? "ab" : "wb"));
+    return f ? File(f, path) : File();
+}
+
+File File::openNextFile() {
+    if (!_dir || _dirPos >= _dir->size()) return File();
+    return LittleFS.open((_path + "/" + (*_dir)[_dirPos++]).c_str());
+}
+
+bool FS::exists(const char* path) { std::error_code ec; return stdfs::exists(hostFsPath(path), ec); }
+bool FS::remove(const char* path) { std::error_code ec; return stdfs::remove(hostFsPath(path), ec); }
+bool FS::mkdir(const char* path) { std::error_code ec; stdfs::create_directories(hostFsPath(path), ec); return !ec; }
+
+bool FS::rename(const char* from, const char* to) {
+    std::error_code ec;
+    stdfs::rename(hostFsPath(from), hostFsPath(to), ec);
+    return !ec;
+}
+
+size_t FS::usedBytes() {
+    size_t total = 0;
+    std::error_code ec;
+    for (auto& e : stdfs::recursive_directory_iterator(hostFsPath(""), ec)) {
+        if (e.is_regular_file()) total += e.file_size();
+    }
+    return total;
+}
+
+}  // namespace fs
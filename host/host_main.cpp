@@ -0,0 +1,310 @@
+/**
+ * Host runner: boots src/main.cpp against simulated miners
+ *
+ *   .pio/build/native/program [--devices N] [--minutes M] [--latency MS]
+ *                             [--dead K] [--verbose]
+ *                             [--render-bench] [--dump DIR]
+ *                             [--capture | --replay FILE [--speed S]]
+ *                             [--sim [HOST:]PORT [--bulk]] [--get PATH ...]
+ *                             [--alloc-check] [--layout-bench]
+ *
+ * N fake AxeOS miners (the last K of them unreachable) answer on
+ * 10.0.x.y, CoinGecko and mempool.space are canned. setup() runs once,
+ * then loop() until M minutes of virtual time have passed. The run ends
+ * with request counts, wall-clock cost per loop() and /api/fleet as the
+ * firmware itself reports it.
+ *
+ * --render-bench then measures what each screen costs on the display bus
+ * (render_bench.cpp); --dump also writes each measured frame to DIR as PPM.
+ *
+ * --capture records the run into host_fs/trace through /api/trace;
+ * --replay feeds such a file back instead of polling, at S times real time,
+ * and stops when the trace runs out.
+ *
+ * --sim polls real miners instead — normally host/fleet_sim.py, whose
+ * device i listens on PORT + i — over real sockets; each request costs the
+ * virtual clock what it took on the wall. The run then also reports fetch
+ * latency percentiles and heap use, and --bulk ends it with a fleet-wide
+ * fan step through /api/bulk. Build with -DMAX_DEVICES=256 to go past 8.
+ *
+ * --get prints the display's answer to GET PATH once the run is over
+ * (e.g. --get /debug/perf).
+ *
+ * --layout-bench times fleet passes over FleetStore against the old
+ * array-of-structs DeviceInfo (layout_bench.cpp); build with a larger
+ * -DMAX_DEVICES to see where the layouts part.
+ *
+ * --alloc-check needs a build with the allocator wrapped (env native):
+ * once every device has been polled, it counts what fetching, ingest and
+ * rendering allocate for the rest of the run and exits 1 if that is not zero.
+ * test_allocations in the unit tests makes the same check.
+ *
+ * Left out of `pio test`, whose suite (test/test_native) brings its own main().
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <WebServer.h>
+#include "FakeAxeOS.h"
+#include "HostHttp.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include <sys/resource.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#ifndef PIO_UNIT_TESTING
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+void setup();
+void loop();
+void renderBench(const char* dumpDir);
+void layoutBench();
+extern WebServer webServer;
+
+struct HostOptions {
+    int devices = 4;
+    int minutes = 10;
+    uint32_t latencyMs = 40;
+    int dead = 0;
+    bool verbose = false;
+    bool renderBench = false;
+    const char* dumpDir = nullptr;
+    bool capture = false;
+    const char* replay = nullptr;
+    float speed = 1;
+    std::string simHost;           // empty = FakeAxeOS routes
+    int simPort = 0;
+    bool bulk = false;
+    std::vector<std::string> gets;
+    bool allocCheck = false;
+    bool layoutBench = false;
+};
+
+static bool parseOptions(int argc, char** argv, HostOptions& o) {
+    for (int i = 1; i < argc; i++) {
+        std::string a = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (a == "--devices" && hasValue) o.devices = atoi(argv[++i]);
+        else if (a == "--minutes" && hasValue) o.minutes = atoi(argv[++i]);
+        else if (a == "--latency" && hasValue) o.latencyMs = atoi(argv[++i]);
+        else if (a == "--dead" && hasValue) o.dead = atoi(argv[++i]);
+        else if (a == "--verbose") o.verbose = true;
+        else if (a == "--render-bench") o.renderBench = true;
+        else if (a == "--dump" && hasValue) o.dumpDir = argv[++i];
+        else if (a == "--capture") o.capture = true;
+        else if (a == "--replay" && hasValue) o.replay = argv[++i];
+        else if (a == "--speed" && hasValue) o.speed = atof(argv[++i]);
+        else if (a == "--sim" && hasValue) {
+            std::string v = argv[++i];
+            size_t c = v.find(':');
+            o.simHost = c == std::string::npos ? "127.0.0.1" : v.substr(0, c);
+            o.simPort = atoi(v.c_str() + (c == std::string::npos ? 0 : c + 1));
+        }
+        else if (a == "--bulk") o.bulk = true;
+        else if (a == "--get" && hasValue) o.gets.push_back(argv[++i]);
+        else if (a == "--alloc-check") o.allocCheck = true;
+        else if (a == "--layout-bench") o.layoutBench = true;
+        else return false;
+    }
+    if (o.devices > MAX_DEVICES) {
+        fprintf(stderr, "--devices %d: this build holds %d, rebuild with -DMAX_DEVICES=%d\n", o.devices, MAX_DEVICES, o.devices);
+        return false;
+    }
+    return o.devices >= 0 && o.minutes > 0 && (o.simHost.empty() || o.simPort > 0);
+}
+
+// Bytes the process has allocated right now, 0 where the C library cannot say
+static size_t heapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+static long peakRssKB() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024;
+#else
+    return ru.ru_maxrss;
+#endif
+}
+
+static uint32_t percentile(std::vector<uint32_t> v, int p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, v.size() * p / 100)];
+}
+
+// Allocations /api/heap has counted for one subsystem so far, -1 when the build does not count them
+static long heapAllocs(const char* subsystem) {
+    std::string body = webServer.request(HTTP_GET, "/api/heap").body;
+    std::string key = std::string("\"") + subsystem + "\":{\"count\":";
+    size_t p = body.find(key);
+    return p == std::string::npos ? -1 : atol(body.c_str() + p + key.size());
+}
+
+static std::string deviceIp(int i) {
+    char ip[20];
+    snprintf(ip, sizeof(ip), "10.0.%d.%d", i / 250, i % 250 + 1);
+    return ip;
+}
+
+// CoinGecko: echo whichever coin id was asked for
+static HostResponse coinGecko(const HostRequest& req) {
+    HostResponse r;
+    size_t p = req.url.find("ids=");
+    std::string id = p == std::string::npos ? "bitcoin" : req.url.substr(p + 4, req.url.find('&', p) - p - 4);
+    r.code = 200;
+    r.latencyMs = 350;
+    r.body = "{\"" + id + "\":{\"usd\":97250.5,\"usd_24h_change\":-1.37}}";
+    return r;
+}
+
+static HostResponse mempool(const HostRequest&) {
+    HostResponse r;
+    r.code = 200;
+    r.latencyMs = 420;
+    r.body = "{\"hashrates\":[],\"difficulty\":[],\"currentHashrate\":8.1e20,\"currentDifficulty\":1.1e14}";
+    return r;
+}
+
+int main(int argc, char** argv) {
+    HostOptions opt;
+    if (!parseOptions(argc, argv, opt)) {
+        fprintf(stderr, "usage: %s [--devices N] [--minutes M] [--latency MS] [--dead K] [--verbose]"
+                        " [--render-bench] [--dump DIR] [--capture | --replay FILE [--speed S]]"
+                        " [--sim [HOST:]PORT [--bulk]] [--get PATH ...] [--alloc-check] [--layout-bench]\n", argv[0]);
+        return 2;
+    }
+    Serial.quiet = !opt.verbose;
+
+    std::vector<std::unique_ptr<FakeAxeOS>> miners;
+    std::string ips;
+    for (int i = 0; i < opt.devices && !opt.simHost.empty(); i++) {
+        ips += (i ? "," : "") + opt.simHost + ":" + std::to_string(opt.simPort + i);
+    }
+    HostHttp::network(!opt.simHost.empty());
+    for (int i = 0; i < opt.devices && opt.simHost.empty(); i++) {
+        miners.emplace_back(new FakeAxeOS(i, i + 1));
+        miners.back()->latencyMs = opt.latencyMs;
+        miners.back()->dead = i >= opt.devices - opt.dead;
+        FakeAxeOS* m = miners.back().get();
+        HostHttp::route("http://" + deviceIp(i) + "/", [m](const HostRequest& req) { return m->handle(req); });
+        ips += (i ? "," : "") + deviceIp(i);
+    }
+    HostHttp::route("https://api.coingecko.com/", coinGecko);
+    HostHttp::route("https://mempool.space/", mempool);
+
+    // A configured display: device list saved, touch already calibrated
+    Preferences prefs;
+    prefs.begin("bitaxemon", false);
+    prefs.putString("ips", ips.c_str());
+    uint16_t cal[5] = {642, 2916, 525, 2911, 0};
+    prefs.putBytes("touchCal", cal, sizeof(cal));
+    prefs.end();
+    Preferences::writes() = 0;
+
+    size_t heapBefore = heapInUse();
+    auto t0 = std::chrono::steady_clock::now();
+    setup();
+    size_t heapSetup = heapInUse();
+    if (opt.capture) webServer.request(HTTP_POST, "/api/trace?capture=1&maxKB=1024");
+    if (opt.replay) {
+        std::string q = "/api/trace?replay=" + std::string(opt.replay) + "&speed=" + std::to_string(opt.speed);
+        HostWebResponse r = webServer.request(HTTP_POST, q);
+        if (r.code != 200) {
+            fprintf(stderr, "replay: %d %s\n", r.code, r.body.c_str());
+            return 1;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    uint32_t end = millis() + opt.minutes * 60000u;
+    uint32_t loops = 0;
+    // Steady state: every device polled once and the first price / difficulty in
+    uint32_t warmAt = millis() + std::max(60000u, (opt.devices + 1) * 5000u);
+    long fetchAt = -1, ingestAt = -1, renderAt = -1;
+    while (millis() < end) {
+        loop();
+        loops++;
+        if (opt.allocCheck && ingestAt < 0 && millis() >= warmAt) {
+            fetchAt = heapAllocs("fetch");
+            ingestAt = heapAllocs("ingest");
+            renderAt = heapAllocs("render");
+        }
+        if (opt.replay && webServer.request(HTTP_GET, "/api/trace").body.find("\"active\":true") == std::string::npos) break;
+    }
+    if (opt.capture) webServer.request(HTTP_POST, "/api/trace?capture=0");
+    size_t heapEnd = heapInUse();
+    auto t2 = std::chrono::steady_clock::now();
+
+    double setupMs = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double loopUs = std::chrono::duration<double, std::micro>(t2 - t1).count() / (loops ? loops : 1);
+    HostNetStats net = HostHttp::netStats();
+    uint32_t fetches = net.requests;
+    for (int i = 0; i < opt.devices && opt.simHost.empty(); i++) fetches += HostHttp::count("http://" + deviceIp(i) + "/");
+
+    printf("host: %d devices (%d dead), %d min virtual, %u loops\n", opt.devices, opt.dead, opt.minutes, loops);
+    printf("host: setup %.1f ms, loop %.1f us wall (mean)\n", setupMs, loopUs);
+    printf("host: requests miners %u, coingecko %u, mempool %u, unrouted %u; prefs writes %u\n", fetches,
+           HostHttp::count("https://api.coingecko.com/"), HostHttp::count("https://mempool.space/"),
+           HostHttp::unrouted(), Preferences::writes());
+    HostWebResponse fleet = webServer.request(HTTP_GET, "/api/fleet");
+    printf("host: GET /api/fleet -> %d %s\n", fleet.code, fleet.body.c_str());
+    if (!opt.simHost.empty()) {
+        printf("host: sim %s:%d-%d, %u requests, %u failed; latency p50 %u ms, p95 %u ms, p99 %u ms, max %u ms\n",
+               opt.simHost.c_str(), opt.simPort, opt.simPort + opt.devices - 1, net.requests, net.failures,
+               percentile(net.latencyMs, 50), percentile(net.latencyMs, 95), percentile(net.latencyMs, 99),
+               percentile(net.latencyMs, 100));
+        printf("host: heap in use %zu KB before setup, %zu KB after, %zu KB at end; peak RSS %ld KB (MAX_DEVICES %d)\n",
+               heapBefore / 1024, heapSetup / 1024, heapEnd / 1024, peakRssKB(), MAX_DEVICES);
+    }
+    if (opt.bulk) {
+        auto b0 = std::chrono::steady_clock::now();
+        HostWebResponse bulk = webServer.request(HTTP_POST, "/api/bulk?devices=all&fan=+5");
+        printf("host: POST /api/bulk fan +5 -> %d\n", bulk.code);
+        // The handler only queues it; loop() drives it while GET reports progress
+        for (int k = 0; k < 100000 && bulk.body.find("\"busy\":true") != std::string::npos; k++) {
+            loop();
+            bulk = webServer.request(HTTP_GET, "/api/bulk");
+        }
+        double bulkMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - b0).count();
+        printf("host: GET /api/bulk -> %d after %.0f ms wall %s\n", bulk.code, bulkMs, bulk.body.c_str());
+    }
+    if (opt.capture || opt.replay) {
+        HostWebResponse trace = webServer.request(HTTP_GET, "/api/trace");
+        printf("host: GET /api/trace -> %d %s\n", trace.code, trace.body.c_str());
+    }
+    for (auto& path : opt.gets) {
+        HostWebResponse r = webServer.request(HTTP_GET, path);
+        printf("host: GET %s -> %d %s\n", path.c_str(), r.code, r.body.c_str());
+    }
+    if (opt.renderBench) renderBench(opt.dumpDir);
+    if (opt.layoutBench) layoutBench();
+    if (opt.allocCheck) {
+        if (ingestAt < 0) {
+            printf("host: alloc check: %s\n", heapAllocs("ingest") < 0 ? "this build does not count allocations"
+                                                                       : "run ended before the fleet was polled once");
+            return 1;
+        }
+        long fetch = heapAllocs("fetch") - fetchAt, ingest = heapAllocs("ingest") - ingestAt;
+        long render = heapAllocs("render") - renderAt;
+        bool pass = fetch == 0 && ingest == 0 && render == 0;
+        printf("host: alloc check: %ld fetch, %ld ingest, %ld render allocations in steady state -> %s\n", fetch, ingest,
+               render, pass ? "PASS" : "FAIL");
+        if (!pass) return 1;
+    }
+    return 0;
+}
+
+#endif  // PIO_UNIT_TESTING
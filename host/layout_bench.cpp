@@ -0,0 +1,182 @@
+/**
+ * Fleet passes over the split store vs. the old array of structs
+ *
+ * AosDevice is DeviceInfo as it was before the hot fields moved out into
+ * FleetStore: the same members, the hot ones inline. Two passes run over
+ * both layouts for each fleet size up to MAX_DEVICES:
+ *
+ *   totals  online count, hashrate and power sums, hottest chip, shares —
+ *           what FleetStats recomputes when a leader drops out
+ *   table   online, hashrate, temperature and power per row, as the fleet
+ *           table reads them
+ *
+ * Each is timed warm (the data just touched) and cold (a buffer larger
+ * than the last-level cache walked in between), and the cache lines each
+ * layout has to bring in are printed next to the times. Host caches are not the
+ * ESP32's — internal SRAM there is uncached — so read the line counts as
+ * the portable result and the times as what a cached CPU makes of it.
+ */
+
+#include <Arduino.h>
+#include "fleet_store.h"
+
+#include <chrono>
+#include <vector>
+
+struct AosDevice {
+    bool valid = false;
+    char ip[40] = "";
+    char host[40] = "";
+    uint16_t port = 80;
+    char url[64] = "";
+    char infoUrl[64] = "";
+    char hostname[33] = "";
+    const char* deviceModel = "";
+    const char* asicModel = "";
+    float hashRate = 0;
+    float hashRate_1h = 0;
+    float temperature = 0;
+    float vrTemp = 0;
+    float power = 0;
+    float voltage = 0;
+    int coreVoltage = 1200;
+    int frequency = 0;
+    int fanSpeed = 0;
+    int fanRpm = 0;
+    int sharesAccepted = 0;
+    int sharesRejected = 0;
+    double bestDiff = 0;
+    double bestSessionDiff = 0;
+    const char* stratumURL = "";
+    int stratumPort = 0;
+    char stratumUser[96] = "";
+    int uptimeSeconds = 0;
+    int wifiRSSI = 0;
+    double poolDifficulty = 0;
+};
+
+static const size_t LAYOUT_FLUSH_BYTES = 32u << 20;
+
+static volatile float layoutSink;
+
+struct LayoutTotals {
+    int online;
+    float hash, power, maxTemp;
+    long shares;
+
+    // Every field, so the compiler cannot drop the parts of a pass nobody reads
+    float fold() const { return hash + power + maxTemp + online + shares; }
+};
+
+static LayoutTotals totalsAos(const AosDevice* d, int n) {
+    LayoutTotals t = {};
+    for (int i = 0; i < n; i++) {
+        if (!d[i].valid) continue;
+        t.online++;
+        t.hash += d[i].hashRate;
+        t.power += d[i].power;
+        if (d[i].temperature > t.maxTemp) t.maxTemp = d[i].temperature;
+        t.shares += d[i].sharesAccepted;
+    }
+    return t;
+}
+
+static LayoutTotals totalsSoa(const FleetStore& f, int n) {
+    LayoutTotals t = {};
+    for (int i = 0; i < n; i++) {
+        if (!f.valid[i]) continue;
+        t.online++;
+        t.hash += f.hashRate[i];
+        t.power += f.power[i];
+        if (f.temperature[i] > t.maxTemp) t.maxTemp = f.temperature[i];
+        t.shares += f.sharesAccepted[i];
+    }
+    return t;
+}
+
+static float tableAos(const AosDevice* d, int n) {
+    float acc = 0;
+    for (int i = 0; i < n; i++) {
+        if (!d[i].valid) continue;
+        acc += d[i].hashRate + d[i].temperature + d[i].power;
+    }
+    return acc;
+}
+
+static float tableSoa(const FleetStore& f, int n) {
+    float acc = 0;
+    for (int i = 0; i < n; i++) {
+        if (!f.valid[i]) continue;
+        acc += f.hashRate[i] + f.temperature[i] + f.power[i];
+    }
+    return acc;
+}
+
+// ns per pass; cold passes walk the flush buffer first and do not time it
+template <typename F>
+static double timePass(F pass, bool cold, std::vector<uint8_t>& flush) {
+    const int reps = cold ? 50 : 20000;
+    double ns = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; r++) {
+        if (cold) {
+            for (size_t k = 0; k < flush.size(); k += 64) flush[k]++;
+            t0 = std::chrono::steady_clock::now();
+        }
+        layoutSink = layoutSink + pass();
+        if (cold) ns += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    }
+    if (!cold) ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+    return ns / reps;
+}
+
+static size_t lines(size_t bytes) { return (bytes + 63) / 64; }
+
+// Cache lines a pass over n devices touches: AoS strides whole structs, SoA reads the flags and
+// three float arrays, plus the share counters for the totals
+static size_t linesAos(int n) { return lines(n * sizeof(AosDevice)); }
+static size_t linesSoa(int n, bool shares) {
+    return lines(n * sizeof(bool)) + 3 * lines(n * sizeof(float)) + (shares ? lines(n * sizeof(int)) : 0);
+}
+
+void layoutBench() {
+    static AosDevice aos[MAX_DEVICES];
+    static FleetStore soa;
+    std::vector<uint8_t> flush(LAYOUT_FLUSH_BYTES);
+    uint32_t seed = 12345;
+    auto rnd = [&seed]() { seed = seed * 1664525u + 1013904223u; return (seed >> 8) / 16777216.0f; };
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        bool on = rnd() < 0.9f;
+        float hash = 400 + rnd() * 800, power = 12 + rnd() * 10, temp = 45 + rnd() * 25;
+        int shares = (int)(rnd() * 5000);
+        aos[i].valid = soa.valid[i] = on;
+        aos[i].hashRate = soa.hashRate[i] = hash;
+        aos[i].power = soa.power[i] = power;
+        aos[i].temperature = soa.temperature[i] = temp;
+        aos[i].sharesAccepted = soa.sharesAccepted[i] = shares;
+    }
+
+    printf("layout: AoS %zu bytes per device, SoA hot %zu bytes per device, MAX_DEVICES %d\n", sizeof(AosDevice),
+           sizeof(FleetStore) / MAX_DEVICES, MAX_DEVICES);
+    printf("%-7s %6s %6s %6s %10s %10s %10s %10s\n", "pass", "n", "AoS CL", "SoA CL", "AoS warm", "SoA warm",
+           "AoS cold", "SoA cold");
+    std::vector<int> sizes;
+    for (int n = 8; n < MAX_DEVICES; n *= 4) sizes.push_back(n);
+    sizes.push_back(MAX_DEVICES);
+    for (int n : sizes) {
+        for (int pass = 0; pass < 2; pass++) {
+            double t[4];
+            for (int cold = 0; cold < 2; cold++) {
+                if (pass == 0) {
+                    t[cold * 2] = timePass([&]() { return totalsAos(aos, n).fold(); }, cold, flush);
+                    t[cold * 2 + 1] = timePass([&]() { return totalsSoa(soa, n).fold(); }, cold, flush);
+                } else {
+                    t[cold * 2] = timePass([&]() { return tableAos(aos, n); }, cold, flush);
+                    t[cold * 2 + 1] = timePass([&]() { return tableSoa(soa, n); }, cold, flush);
+                }
+            }
+            printf("%-7s %6d %6zu %6zu %8.0fns %8.0fns %8.0fns %8.0fns\n", pass == 0 ? "totals" : "table", n,
+                   linesAos(n), linesSoa(n, pass == 0), t[0], t[1], t[2], t[3]);
+        }
+    }
+}
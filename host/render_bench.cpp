@@ -0,0 +1,94 @@
+/**
+ * Rendering cost per screen, measured on the recording TFT
+ *
+ * Each full draw runs once on the screen it belongs to. Each update runs
+ * after every device has been fetched again, so it repaints values that
+ * actually moved, and is averaged over several rounds. The fetches go
+ * straight to fetchDeviceData() rather than through loop(), which would
+ * repaint the screen itself before the measured update gets to it.
+ */
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <string>
+
+extern TFT_eSPI tft;
+extern int currentScreen;
+extern int deviceCount;
+void fetchDeviceData(int index);
+void drawMainUI();
+void updateDisplay();
+void drawPoolScreen();
+void updatePoolScreen();
+void drawDeviceScreen(int devIndex);
+void updateDeviceScreen(int devIndex);
+
+static const int RENDER_UPDATE_ROUNDS = 6;
+
+struct RenderCase {
+    const char* name;
+    int screen;
+    bool update;
+    void (*run)();
+};
+
+static void drawDevice0() { drawDeviceScreen(0); }
+static void updateDevice0() { updateDeviceScreen(0); }
+
+static const RenderCase RENDER_CASES[] = {
+    {"drawMainUI",         0, false, drawMainUI},
+    {"updateDisplay",      0, true,  updateDisplay},
+    {"drawPoolScreen",     1, false, drawPoolScreen},
+    {"updatePoolScreen",   1, true,  updatePoolScreen},
+    {"drawDeviceScreen",   2, false, drawDevice0},
+    {"updateDeviceScreen", 2, true,  updateDevice0},
+};
+
+// Fetch every device once more, 5 s apart as the round-robin poll does
+static void pollRound() {
+    tft.hostRecord(false);
+    for (int i = 0; i < deviceCount; i++) {
+        delay(5000);
+        fetchDeviceData(i);
+    }
+    tft.hostRecord(true);
+}
+
+static void printRow(const char* name, const TftStats& s, int rounds, uint32_t spiHz) {
+    printf("%-20s %7.0f %8.0f %9.0f %8.0f %8.1f %8.2f\n", name, (double)s.calls / rounds,
+           (double)s.windows / rounds, (double)s.pixels / rounds, (double)s.touched / rounds,
+           s.spiBytes() / 1024.0 / rounds, s.busMs(spiHz) / rounds);
+}
+
+void renderBench(const char* dumpDir) {
+    uint32_t spiHz = SPI_FREQUENCY;
+    printf("render: %dx%d, SPI %.1f MHz, %d devices\n", SCR_W, SCR_H, spiHz / 1e6, deviceCount);
+    printf("%-20s %7s %8s %9s %8s %8s %8s\n", "case", "calls", "windows", "pixels", "touched", "spi KB", "bus ms");
+    for (const RenderCase& c : RENDER_CASES) {
+        if (c.screen >= 2 && deviceCount == 0) continue;
+        currentScreen = c.screen;
+        TftStats total;
+        int rounds = c.update ? RENDER_UPDATE_ROUNDS : 1;
+        if (c.update) {
+            // The screen the update paints over
+            tft.hostRecord(false);
+            RENDER_CASES[&c - RENDER_CASES - 1].run();
+            tft.hostRecord(true);
+        }
+        for (int r = 0; r < rounds; r++) {
+            if (c.update) pollRound();
+            tft.hostReset();
+            c.run();
+            const TftStats& s = tft.hostStats();
+            total.calls += s.calls;
+            total.windows += s.windows;
+            total.pixels += s.pixels;
+            total.touched += s.touched;
+        }
+        printRow(c.name, total, rounds, spiHz);
+        if (dumpDir) {
+            std::string path = std::string(dumpDir) + "/" + c.name + "_" + std::to_string(SCR_W) + ".ppm";
+            tft.hostSavePPM(path.c_str());
+        }
+    }
+}
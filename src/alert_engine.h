@@ -0,0 +1,335 @@
+#pragma once
+/**
+ * Rule-based alert engine
+ *
+ * Rules are written as text and compiled once into fixed-size AlertRule
+ * records; every ingested sample is then checked against each rule in
+ * O(rules), with no parsing or allocation on the hot path.
+ *
+ *   <metric> [<|> <threshold>] [for N] [hyst H] [cool S] [dev D]
+ *
+ *   metrics   temp, vrtemp, hashrate (GH/s), hashdrop (% below the 1 h
+ *             average), reject (% of the shares since the previous sample),
+ *             vin (V), power (W), fan (%), offline (no operator needed)
+ *   for N     condition must hold for N consecutive samples (default 1)
+ *   hyst H    once raised, the alert clears only H past the threshold
+ *   cool S    seconds before the same rule may fire again on a device
+ *   dev D     restrict to device slot D (0-based); default all devices
+ *
+ *   e.g. "temp > 68 for 3 hyst 3 cool 900; vin < 4.9 for 2 hyst 0.1; offline"
+ *
+ * Raise / clear transitions are appended to a small event ring. The caller
+ * drains it for the webhook (next() / consume()), and reads activeCount()
+ * and banner() for the screen banner and the LED.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define ALERT_MAX_RULES   12
+#define ALERT_QUEUE_SIZE  16
+#define ALERT_ALL_DEVICES 0xFF
+
+enum AlertMetric : uint8_t {
+    AM_TEMP = 0,
+    AM_VRTEMP,
+    AM_HASHRATE,
+    AM_HASHDROP,
+    AM_REJECT,
+    AM_VIN,
+    AM_POWER,
+    AM_FAN,
+    AM_OFFLINE,
+    AM_COUNT
+};
+
+static const char* const ALERT_METRIC_NAMES[AM_COUNT] = {
+    "temp", "vrtemp", "hashrate", "hashdrop", "reject", "vin", "power", "fan", "offline"
+};
+
+// Compiled rule — 16 bytes
+struct AlertRule {
+    uint8_t metric;
+    bool below;                // true: '<', false: '>'
+    uint8_t forN;
+    uint8_t device;            // ALERT_ALL_DEVICES or a slot
+    float threshold;
+    float hyst;
+    uint32_t cooldownSec;
+};
+
+// Raw per-fetch readings; derived metrics are worked out by the engine
+struct AlertSample {
+    bool online;
+    float temperature;
+    float vrTemp;
+    float hashRate;
+    float hashRate1h;
+    float vin;
+    float power;
+    int fanSpeed;
+    uint32_t sharesAccepted;
+    uint32_t sharesRejected;
+};
+
+struct AlertEvent {
+    uint32_t t;                // monotonic s
+    uint8_t rule;
+    uint8_t device;
+    bool raised;               // false = cleared
+    float value;
+};
+
+class AlertEngine {
+public:
+    // Compile a rule list (';' or newline separated). On error nothing changes
+    // and errAt points at the offending text.
+    bool compile(const char* text, const char** errAt = nullptr) {
+        AlertRule rules[ALERT_MAX_RULES];
+        uint8_t n = 0;
+        const char* p = text;
+        while (true) {
+            while (*p == ' ' || *p == ';' || *p == '\n' || *p == '\r' || *p == ',') p++;
+            if (!*p) break;
+            if (n >= ALERT_MAX_RULES || !_parseRule(p, rules[n])) {
+                if (errAt) *errAt = p;
+                return false;
+            }
+            n++;
+        }
+        memcpy(_rules, rules, sizeof(AlertRule) * n);
+        _n = n;
+        reset();
+        return true;
+    }
+
+    void format(char* buf, size_t size) const {
+        size_t len = 0;
+        buf[0] = '\0';
+        for (int r = 0; r < _n && len < size; r++) len += formatRule(r, buf + len, size - len, r > 0);
+    }
+
+    // One rule back in text form; returns the length written
+    size_t formatRule(uint8_t r, char* buf, size_t size, bool sep = false) const {
+        const AlertRule& a = _rules[r];
+        char tmp[96];
+        int len = snprintf(tmp, sizeof(tmp), "%s%s", sep ? "; " : "", ALERT_METRIC_NAMES[a.metric]);
+        if (a.metric != AM_OFFLINE) len += snprintf(tmp + len, sizeof(tmp) - len, " %c %g", a.below ? '<' : '>', a.threshold);
+        if (a.forN > 1) len += snprintf(tmp + len, sizeof(tmp) - len, " for %u", a.forN);
+        if (a.hyst > 0) len += snprintf(tmp + len, sizeof(tmp) - len, " hyst %g", a.hyst);
+        if (a.cooldownSec) len += snprintf(tmp + len, sizeof(tmp) - len, " cool %u", (unsigned)a.cooldownSec);
+        if (a.device != ALERT_ALL_DEVICES) len += snprintf(tmp + len, sizeof(tmp) - len, " dev %u", a.device);
+        strncpy(buf, tmp, size);
+        if (size) buf[size - 1] = '\0';
+        return strlen(buf);
+    }
+
+    uint8_t ruleCount() const { return _n; }
+    const AlertRule& rule(uint8_t r) const { return _rules[r]; }
+
+    // Evaluate every rule against a fresh sample (or an offline transition) of device i
+    void ingest(uint8_t i, const AlertSample& s, uint32_t now) {
+        if (i >= MAX_DEVICES) return;
+        float v[AM_COUNT];
+        _metrics(i, s, v);
+        for (int r = 0; r < _n; r++) {
+            const AlertRule& a = _rules[r];
+            if (a.device != ALERT_ALL_DEVICES && a.device != i) continue;
+            if (!s.online && a.metric != AM_OFFLINE) continue;   // nothing to measure
+            float x = v[a.metric];
+            if (isnan(x)) continue;
+            _State& st = _st[r][i];
+            bool over = a.below ? x < a.threshold : x > a.threshold;
+            if (!st.active) {
+                st.count = over ? min(255, st.count + 1) : 0;
+                if (st.count < a.forN) continue;
+                st.active = true;
+                _active++;
+                _version++;
+                // Cooldown only limits notifications; the alert is still active
+                if (st.fired && now - st.lastFire < a.cooldownSec) continue;
+                st.fired = true;
+                st.lastFire = now;
+                st.notified = true;
+                _push(now, r, i, true, x);
+            } else {
+                bool released = a.below ? x >= a.threshold + a.hyst : x <= a.threshold - a.hyst;
+                if (!released) continue;
+                st.active = false;
+                st.count = 0;
+                _active--;
+                _version++;
+                if (st.notified) _push(now, r, i, false, x);
+                st.notified = false;
+            }
+        }
+    }
+
+    // Device list or rules changed: forget per-device state and old events
+    void reset() {
+        for (int r = 0; r < ALERT_MAX_RULES; r++)
+            for (int i = 0; i < MAX_DEVICES; i++) _st[r][i] = _State();
+        for (int i = 0; i < MAX_DEVICES; i++) _prev[i] = _Prev();
+        _active = 0;
+        _logCount = _pending = 0;      // old events name rules / slots that may not exist now
+        _version++;
+    }
+
+    int activeCount() const { return _active; }
+    bool active(uint8_t r, uint8_t i) const { return r < _n && i < MAX_DEVICES && _st[r][i].active; }
+
+    // Alert for the banner: the newest notified one still active, else any active one
+    bool banner(uint8_t& r, uint8_t& i) const {
+        if (_active == 0) return false;
+        for (int k = 0; k < _logCount; k++) {
+            const AlertEvent& e = logEntry(k);
+            if (e.raised && active(e.rule, e.device)) { r = e.rule; i = e.device; return true; }
+        }
+        for (r = 0; r < _n; r++)
+            for (i = 0; i < MAX_DEVICES; i++)
+                if (_st[r][i].active) return true;
+        return false;
+    }
+    // Bumps whenever an alert is raised or cleared
+    uint32_t version() const { return _version; }
+
+    // Recent transitions, newest first
+    int logCount() const { return _logCount; }
+    const AlertEvent& logEntry(int k) const {
+        return _log[(_logHead + ALERT_QUEUE_SIZE - 1 - k) % ALERT_QUEUE_SIZE];
+    }
+
+    // Webhook queue: oldest undelivered event
+    bool next(AlertEvent& out) const {
+        if (_pending == 0) return false;
+        out = _log[(_logHead + ALERT_QUEUE_SIZE - _pending) % ALERT_QUEUE_SIZE];
+        return true;
+    }
+    void consume() { if (_pending) _pending--; }
+    int pending() const { return _pending; }
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    struct _State {
+        uint8_t count = 0;
+        bool active = false;
+        bool fired = false;
+        bool notified = false;     // the raise went out, so the clear should too
+        uint32_t lastFire = 0;
+    };
+    struct _Prev {
+        bool seen = false;
+        uint32_t acc = 0;
+        uint32_t rej = 0;
+    };
+
+    AlertRule _rules[ALERT_MAX_RULES];
+    uint8_t _n = 0;
+    _State _st[ALERT_MAX_RULES][MAX_DEVICES];
+    _Prev _prev[MAX_DEVICES];
+    int _active = 0;
+    uint32_t _version = 0;
+
+    AlertEvent _log[ALERT_QUEUE_SIZE];
+    uint8_t _logHead = 0;
+    uint8_t _logCount = 0;
+    uint8_t _pending = 0;          // newest _pending entries not yet delivered
+    uint32_t _dropped = 0;
+
+    void _metrics(uint8_t i, const AlertSample& s, float* v) {
+        for (int m = 0; m < AM_COUNT; m++) v[m] = NAN;
+        v[AM_OFFLINE] = s.online ? 0 : 1;
+        if (!s.online) return;
+        v[AM_TEMP] = s.temperature;
+        v[AM_VRTEMP] = s.vrTemp;
+        v[AM_HASHRATE] = s.hashRate;
+        if (s.hashRate1h > 0) v[AM_HASHDROP] = (s.hashRate1h - s.hashRate) * 100.0f / s.hashRate1h;
+        v[AM_VIN] = (s.vin > 0) ? s.vin : NAN;
+        v[AM_POWER] = s.power;
+        v[AM_FAN] = s.fanSpeed;
+        _Prev& p = _prev[i];
+        if (p.seen && s.sharesAccepted >= p.acc && s.sharesRejected >= p.rej) {
+            uint32_t acc = s.sharesAccepted - p.acc, rej = s.sharesRejected - p.rej;
+            // No shares since the last sample says nothing about the reject rate
+            if (acc + rej > 0) v[AM_REJECT] = rej * 100.0f / (acc + rej);
+        }
+        p.seen = true;
+        p.acc = s.sharesAccepted;
+        p.rej = s.sharesRejected;
+    }
+
+    void _push(uint32_t now, uint8_t r, uint8_t i, bool raised, float value) {
+        AlertEvent& e = _log[_logHead];
+        e.t = now;
+        e.rule = r;
+        e.device = i;
+        e.raised = raised;
+        e.value = value;
+        _logHead = (_logHead + 1) % ALERT_QUEUE_SIZE;
+        if (_logCount < ALERT_QUEUE_SIZE) _logCount++;
+        if (_pending < ALERT_QUEUE_SIZE) _pending++;
+        else _dropped++;               // the webhook fell a whole ring behind
+        _version++;
+        Serial.printf("ALERT: device %d %s %s (%.2f)\n", i, ALERT_METRIC_NAMES[_rules[r].metric],
+                      raised ? "raised" : "cleared", value);
+    }
+
+    static bool _word(const char*& p, const char* w) {
+        size_t n = strlen(w);
+        if (strncmp(p, w, n) != 0 || isalnum((unsigned char)p[n])) return false;
+        p += n;
+        return true;
+    }
+
+    static bool _number(const char*& p, float& out) {
+        while (*p == ' ') p++;
+        char* end;
+        out = strtof(p, &end);
+        if (end == p) return false;
+        p = end;
+        return true;
+    }
+
+    static bool _parseRule(const char*& p, AlertRule& a) {
+        a = AlertRule();
+        a.metric = AM_COUNT;
+        for (int m = 0; m < AM_COUNT; m++) {
+            if (_word(p, ALERT_METRIC_NAMES[m])) { a.metric = m; break; }
+        }
+        if (a.metric == AM_COUNT) return false;
+        a.forN = 1;
+        a.device = ALERT_ALL_DEVICES;
+        while (*p == ' ') p++;
+        if (a.metric == AM_OFFLINE) {
+            a.threshold = 0.5f;
+        } else {
+            if (*p != '<' && *p != '>') return false;
+            a.below = *p++ == '<';
+            if (!_number(p, a.threshold)) return false;
+        }
+        while (true) {
+            while (*p == ' ') p++;
+            if (!*p || *p == ';' || *p == '\n' || *p == '\r' || *p == ',') return true;
+            float x;
+            if (_word(p, "for")) {
+                if (!_number(p, x) || x < 1 || x > 255) return false;
+                a.forN = (uint8_t)x;
+            } else if (_word(p, "hyst")) {
+                if (!_number(p, x) || x < 0) return false;
+                a.hyst = x;
+            } else if (_word(p, "cool")) {
+                if (!_number(p, x) || x < 0) return false;
+                a.cooldownSec = (uint32_t)x;
+            } else if (_word(p, "dev")) {
+                if (!_number(p, x) || x < 0 || x >= MAX_DEVICES) return false;
+                a.device = (uint8_t)x;
+            } else {
+                return false;
+            }
+        }
+    }
+};
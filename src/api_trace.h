@@ -0,0 +1,179 @@
+#pragma once
+/**
+ * Capture and replay of the responses the display fetches
+ *
+ * A trace is one LittleFS file:
+ *
+ *   [ApiTraceHeader][device list, header.ipsLen bytes: "ip,ip,..."]
+ *   [ApiTraceRecord][payload, record.len bytes] ...
+ *
+ * One record per /api/system/info, CoinGecko or mempool.space response as
+ * fetched: milliseconds since the capture started, source, device index,
+ * HTTP status, how long the request took and the body exactly as it arrived
+ * (empty when the request failed). Capture stops by itself at the byte
+ * budget; a record that would not fit is not written, so a trace always
+ * ends on a whole record.
+ *
+ * Replay hands records back once (now - start) * speed reaches their
+ * timestamp; the caller feeds them through the same ingest functions a live
+ * fetch uses. Times are millis().
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+
+#define TRACE_DIR           "/trace"
+#define TRACE_MAGIC         0x52544842      // "BHTR"
+#define TRACE_VERSION       2
+#define TRACE_MAX_PAYLOAD   8192            // larger bodies are recorded empty
+#define TRACE_FLUSH_MS      5000
+
+enum TraceSource : uint8_t {
+    TS_DEVICE = 0,             // /api/system/info of `device`
+    TS_PRICE,                  // CoinGecko simple/price
+    TS_DIFFICULTY,             // mempool.space mining/hashrate
+    TS_COUNT
+};
+
+static const char* const TRACE_SOURCE_NAMES[] = {"device", "price", "difficulty"};
+
+struct ApiTraceHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t deviceCount;
+    uint32_t ipsLen;
+    uint32_t startEpoch;       // wall clock at capture start, 0 = not synced
+};
+
+struct ApiTraceRecord {
+    uint32_t t;                // ms since capture start
+    uint8_t source;
+    uint8_t device;
+    int16_t code;              // HTTP status, < 0 = HTTPClient error
+    uint16_t latency;          // ms the request took
+    uint16_t len;              // payload bytes that follow
+};
+
+class ApiTraceWriter {
+public:
+    bool begin(const char* path, const char* ips, uint16_t deviceCount, uint32_t maxBytes,
+               uint32_t epoch, uint32_t nowMs) {
+        end();
+        LittleFS.mkdir(TRACE_DIR);
+        _file = LittleFS.open(path, FILE_WRITE);
+        if (!_file) return false;
+        ApiTraceHeader h = {TRACE_MAGIC, TRACE_VERSION, deviceCount, (uint32_t)strlen(ips), epoch};
+        _bytes = _file.write((const uint8_t*)&h, sizeof(h)) + _file.write((const uint8_t*)ips, h.ipsLen);
+        _max = maxBytes;
+        _start = _lastFlush = nowMs;
+        _records = 0;
+        _full = false;
+        return true;
+    }
+
+    void record(uint8_t source, uint8_t device, int code, uint32_t latencyMs,
+                const char* payload, size_t len, uint32_t nowMs) {
+        if (!_file || _full) return;
+        if (len > TRACE_MAX_PAYLOAD) len = 0;
+        ApiTraceRecord r = {nowMs - _start, source, device, (int16_t)constrain(code, -32768, 32767),
+                            (uint16_t)min<uint32_t>(latencyMs, 65535), (uint16_t)len};
+        if (_bytes + sizeof(r) + len > _max) {
+            _full = true;
+            _file.flush();
+            Serial.printf("TRACE: capture full at %lu bytes, %lu records\n", (unsigned long)_bytes, (unsigned long)_records);
+            return;
+        }
+        _bytes += _file.write((const uint8_t*)&r, sizeof(r));
+        if (len) _bytes += _file.write((const uint8_t*)payload, len);
+        _records++;
+        if (nowMs - _lastFlush >= TRACE_FLUSH_MS) {
+            _file.flush();
+            _lastFlush = nowMs;
+        }
+    }
+
+    void end() {
+        if (_file) _file.close();
+    }
+
+    bool active() const { return (bool)_file && !_full; }
+    bool open() const { return (bool)_file; }
+    uint32_t bytes() const { return _bytes; }
+    uint32_t records() const { return _records; }
+    uint32_t maxBytes() const { return _max; }
+
+private:
+    File _file;
+    uint32_t _bytes = 0;
+    uint32_t _max = 0;
+    uint32_t _records = 0;
+    uint32_t _start = 0;
+    uint32_t _lastFlush = 0;
+    bool _full = false;
+};
+
+class ApiTraceReader {
+public:
+    // Open a trace; ips receives its device list (ipsSize includes the terminator)
+    bool begin(const char* path, float speed, uint32_t nowMs, char* ips, size_t ipsSize) {
+        end();
+        _file = LittleFS.open(path, FILE_READ);
+        ApiTraceHeader h;
+        if (!_file || _file.read((uint8_t*)&h, sizeof(h)) != sizeof(h) ||
+            h.magic != TRACE_MAGIC || h.version != TRACE_VERSION || h.ipsLen >= ipsSize ||
+            _file.read((uint8_t*)ips, h.ipsLen) != h.ipsLen) {
+            end();
+            return false;
+        }
+        ips[h.ipsLen] = '\0';
+        _header = h;
+        _speed = speed > 0 ? speed : 1;
+        _start = nowMs;
+        _records = 0;
+        _pending = _readHead();
+        return true;
+    }
+
+    // Next record due at nowMs; its payload (NUL-terminated) goes to buf
+    bool next(uint32_t nowMs, ApiTraceRecord& out, char* buf, size_t bufSize) {
+        if (!_pending) return false;
+        if ((double)(nowMs - _start) * _speed < _head.t) return false;
+        out = _head;
+        size_t n = min<size_t>(_head.len, bufSize - 1);
+        if (_file.read((uint8_t*)buf, n) != n) { end(); return false; }
+        if (_head.len > n) _file.seek(_file.position() + (_head.len - n));
+        buf[n] = '\0';
+        out.len = n;
+        _records++;
+        _pending = _readHead();
+        return true;
+    }
+
+    void end() {
+        if (_file) _file.close();
+        _pending = false;
+    }
+
+    // Still has records to hand out
+    bool active() const { return _pending; }
+    float speed() const { return _speed; }
+    uint32_t records() const { return _records; }
+    uint32_t traceMs() const { return _head.t; }
+    const ApiTraceHeader& header() const { return _header; }
+
+private:
+    File _file;
+    ApiTraceHeader _header = {};
+    ApiTraceRecord _head = {};
+    bool _pending = false;
+    float _speed = 1;
+    uint32_t _start = 0;
+    uint32_t _records = 0;
+
+    bool _readHead() {
+        if (_file.read((uint8_t*)&_head, sizeof(_head)) == sizeof(_head) && _head.source < TS_COUNT) return true;
+        end();
+        return false;
+    }
+};
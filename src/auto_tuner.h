@@ -0,0 +1,329 @@
+#pragma once
+/**
+ * Closed-loop per-device efficiency auto-tuner
+ *
+ * Walks frequency / core-voltage pairs inside a TuneLimits box and settles on
+ * the most efficient stable point (lowest J/TH). The tuner only decides;
+ * the caller performs the PATCH through postDeviceSetting() and reports the
+ * result with applied().
+ *
+ * Search, per device:
+ *   for f = freqMin .. freqMax (freqStep):
+ *     raise mV from the last stable voltage until f hashes at the expected
+ *     rate (>= minHashRatio x the start-up GH/s per MHz) — the first stable
+ *     voltage is the most efficient point for that f
+ *   a frequency that cannot be stabilised below mvMax ends the climb
+ *
+ * Each point is applied, left to SETTLE for settleSec and then MEASURED for
+ * measureSec. The score is power / hashrate in J/TH; hashrate is the mean of
+ * the samples taken while measuring, or the device's own hashRate_1h once
+ * settle + measure covers a full hour (before that the 1 h average still
+ * mostly reflects the previous point).
+ *
+ * Safety limits (chip temp, VR temp, input voltage) are checked on every
+ * sample in every state. A trip during the search ends the climb and moves
+ * to the best point found so far (or back to the original settings); a trip
+ * while holding restores the original settings and faults.
+ *
+ * Every decision lands in a small audit ring (TUNE_LOG_SIZE entries).
+ * Times are monotonic seconds (millis() / 1000).
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#ifndef TUNE_LOG_SIZE
+#define TUNE_LOG_SIZE 64
+#endif
+
+#define TUNE_MAX_PATCH_FAILS 3
+
+struct TuneLimits {
+    int freqMin = 400;         // MHz
+    int freqMax = 650;
+    int freqStep = 25;
+    int mvMin = 1100;          // core mV
+    int mvMax = 1250;
+    int mvStep = 10;
+    float maxTemp = 65.0f;     // chip C
+    float maxVrTemp = 80.0f;   // VR C
+    float minVin = 4.9f;       // input V
+    uint32_t settleSec = 300;
+    uint32_t measureSec = 600;
+    float minHashRatio = 0.94f;
+};
+
+// What the tuner needs from one device fetch
+struct TuneSample {
+    float hashRate;            // GH/s
+    float hashRate1h;          // GH/s, device side 1 h average
+    float power;               // W
+    float temperature;         // C
+    float vrTemp;              // C
+    float vin;                 // V
+    int frequency;             // MHz
+    int coreVoltage;           // mV
+};
+
+enum TuneState : uint8_t {
+    TUNE_IDLE = 0,
+    TUNE_SETTLING,
+    TUNE_MEASURING,
+    TUNE_HOLD,                 // converged, holding the best point
+    TUNE_FAULT                 // gave up; original settings restored
+};
+
+enum TuneEvent : uint8_t {
+    TEV_START = 0,
+    TEV_APPLY,                 // PATCH accepted
+    TEV_SCORE,                 // stable point measured
+    TEV_UNSTABLE,              // point hashed below the expected rate
+    TEV_LIMIT,                 // safety limit tripped
+    TEV_HOLD,                  // search finished, holding best
+    TEV_STOP,                  // stopped by user / manual override
+    TEV_PATCH_FAIL,
+    TEV_NO_POINT               // nothing stable inside the limits
+};
+
+struct TuneLogEntry {
+    uint32_t t;                // monotonic seconds
+    uint8_t device;
+    uint8_t event;
+    uint16_t frequency;
+    uint16_t coreVoltage;
+    float hashRate;
+    float power;
+    float jth;
+};
+
+static const char* const TUNE_STATE_NAMES[] = {"idle", "settling", "measuring", "hold", "fault"};
+static const char* const TUNE_EVENT_NAMES[] = {"start", "apply", "score", "unstable", "limit",
+                                               "hold", "stop", "patch-fail", "no-point"};
+
+class AutoTuner {
+public:
+    // Begin tuning from the device's current settings. Returns false if they are unusable.
+    bool start(uint8_t dev, const TuneSample& cur, const TuneLimits& lim, uint32_t now) {
+        if (dev >= MAX_DEVICES || cur.frequency <= 0) return false;
+        if (lim.freqMin > lim.freqMax || lim.mvMin > lim.mvMax || lim.freqStep <= 0 || lim.mvStep <= 0) return false;
+        float baseHash = (cur.hashRate1h > 0) ? cur.hashRate1h : cur.hashRate;
+        if (baseHash <= 0) return false;
+
+        _Dev& d = _dev[dev];
+        d = _Dev();
+        d.lim = lim;
+        d.origF = cur.frequency;
+        d.origMv = cur.coreVoltage;
+        d.hashPerMHz = baseHash / cur.frequency;
+        d.floorMv = lim.mvMin;
+        d.state = TUNE_SETTLING;
+        _log(now, dev, TEV_START, cur.frequency, cur.coreVoltage, baseHash, cur.power);
+        _goto(d, lim.freqMin, lim.mvMin);
+        return true;
+    }
+
+    // Stop tuning. Mid-search the original settings are restored (returned via freq / mv
+    // with true); a converged device keeps its best point.
+    bool stop(uint8_t dev, uint32_t now, int& freq, int& mv) {
+        if (!active(dev)) return false;
+        _Dev& d = _dev[dev];
+        _log(now, dev, TEV_STOP, d.f, d.mv, 0, 0);
+        bool restore = d.state != TUNE_HOLD;
+        d.state = TUNE_IDLE;
+        d.pending = false;
+        freq = d.origF;
+        mv = d.origMv;
+        return restore;
+    }
+
+    // Feed a fresh sample. Returns true with the setpoint to PATCH when one is due.
+    bool update(uint8_t dev, const TuneSample& s, uint32_t now, int& freq, int& mv) {
+        if (!active(dev)) return false;
+        _Dev& d = _dev[dev];
+
+        // Right after retreating to the best point the device gets one settle period to cool down
+        bool grace = d.state == TUNE_HOLD && (d.pending || now - d.phaseStart < d.lim.settleSec);
+        if (d.state != TUNE_FAULT && !grace && _unsafe(d.lim, s)) {
+            _log(now, dev, TEV_LIMIT, d.f, d.mv, s.hashRate, s.power);
+            if (d.state == TUNE_HOLD || !d.hasBest) {
+                _fault(d, dev, now);
+            } else {
+                _hold(d, dev, now);
+            }
+        } else if (!d.pending) {
+            _step(d, dev, s, now);
+        }
+
+        if (!d.pending) return false;
+        freq = d.f;
+        mv = d.mv;
+        return true;
+    }
+
+    // Result of the PATCH issued for the last update()
+    void applied(uint8_t dev, bool ok, uint32_t now) {
+        if (dev >= MAX_DEVICES || !_dev[dev].pending) return;
+        _Dev& d = _dev[dev];
+        if (ok) {
+            d.pending = false;
+            d.patchFails = 0;
+            d.phaseStart = now;
+            _log(now, dev, TEV_APPLY, d.f, d.mv, 0, 0);
+            return;
+        }
+        if (++d.patchFails >= TUNE_MAX_PATCH_FAILS) {
+            _log(now, dev, TEV_PATCH_FAIL, d.f, d.mv, 0, 0);
+            d.pending = false;
+            d.state = TUNE_FAULT;
+        }
+    }
+
+    bool active(uint8_t dev) const {
+        if (dev >= MAX_DEVICES) return false;
+        // A fault stays active only until the restoring PATCH went through
+        TuneState st = _dev[dev].state;
+        return st == TUNE_SETTLING || st == TUNE_MEASURING || st == TUNE_HOLD ||
+               (st == TUNE_FAULT && _dev[dev].pending);
+    }
+
+    TuneState state(uint8_t dev) const { return dev < MAX_DEVICES ? _dev[dev].state : TUNE_IDLE; }
+    int pointFreq(uint8_t dev) const { return _dev[dev].f; }
+    int pointMv(uint8_t dev) const { return _dev[dev].mv; }
+    bool hasBest(uint8_t dev) const { return _dev[dev].hasBest; }
+    int bestFreq(uint8_t dev) const { return _dev[dev].bestF; }
+    int bestMv(uint8_t dev) const { return _dev[dev].bestMv; }
+    float bestJth(uint8_t dev) const { return _dev[dev].bestJth; }
+    uint16_t pointsTried(uint8_t dev) const { return _dev[dev].points; }
+
+    // Audit log, oldest first
+    int logCount() const { return _logCount; }
+    const TuneLogEntry& logEntry(int i) const {
+        int first = (_logHead - _logCount + TUNE_LOG_SIZE) % TUNE_LOG_SIZE;
+        return _logRing[(first + i) % TUNE_LOG_SIZE];
+    }
+
+private:
+    struct _Dev {
+        TuneState state = TUNE_IDLE;
+        TuneLimits lim;
+        int origF = 0, origMv = 0;
+        int f = 0, mv = 0;             // point under test / held
+        int floorMv = 0;               // lowest voltage worth trying at the next frequency
+        bool pending = false;          // setpoint waiting for a successful PATCH
+        uint8_t patchFails = 0;
+        uint32_t phaseStart = 0;
+        float hashPerMHz = 0;          // stability reference from the starting point
+        double hashSum = 0, powerSum = 0;
+        uint16_t samples = 0;
+        uint16_t points = 0;
+        bool hasBest = false;
+        int bestF = 0, bestMv = 0;
+        float bestJth = 0;
+    };
+
+    _Dev _dev[MAX_DEVICES];
+    TuneLogEntry _logRing[TUNE_LOG_SIZE];
+    int _logHead = 0;
+    int _logCount = 0;
+
+    static bool _unsafe(const TuneLimits& lim, const TuneSample& s) {
+        return s.temperature > lim.maxTemp || s.vrTemp > lim.maxVrTemp || (s.vin > 0 && s.vin < lim.minVin);
+    }
+
+    static void _goto(_Dev& d, int f, int mv) {
+        d.f = f;
+        d.mv = mv;
+        d.pending = true;
+        d.hashSum = d.powerSum = 0;
+        d.samples = 0;
+    }
+
+    void _step(_Dev& d, uint8_t dev, const TuneSample& s, uint32_t now) {
+        uint32_t elapsed = now - d.phaseStart;
+        switch (d.state) {
+            case TUNE_SETTLING:
+                if (elapsed < d.lim.settleSec) return;
+                d.state = TUNE_MEASURING;
+                d.phaseStart = now;
+                d.hashSum = d.powerSum = 0;
+                d.samples = 0;
+                return;
+            case TUNE_MEASURING:
+                d.hashSum += s.hashRate;
+                d.powerSum += s.power;
+                d.samples++;
+                if (elapsed < d.lim.measureSec) return;
+                _evaluate(d, dev, s, now);
+                return;
+            default:
+                return;
+        }
+    }
+
+    void _evaluate(_Dev& d, uint8_t dev, const TuneSample& s, uint32_t now) {
+        d.points++;
+        bool fullHour = d.lim.settleSec + d.lim.measureSec >= 3600 && s.hashRate1h > 0;
+        float hash = fullHour ? s.hashRate1h : (float)(d.hashSum / d.samples);
+        float power = (float)(d.powerSum / d.samples);
+        bool stable = hash >= d.lim.minHashRatio * d.hashPerMHz * d.f;
+
+        if (stable && hash > 0) {
+            float jth = power / (hash / 1000.0f);
+            _log(now, dev, TEV_SCORE, d.f, d.mv, hash, power, jth);
+            if (!d.hasBest || jth < d.bestJth) {
+                d.hasBest = true;
+                d.bestF = d.f;
+                d.bestMv = d.mv;
+                d.bestJth = jth;
+            }
+            d.floorMv = d.mv;
+            int nextF = d.f + d.lim.freqStep;
+            if (nextF > d.lim.freqMax) { _hold(d, dev, now); return; }
+            d.state = TUNE_SETTLING;
+            _goto(d, nextF, d.floorMv);
+            return;
+        }
+
+        _log(now, dev, TEV_UNSTABLE, d.f, d.mv, hash, power);
+        int nextMv = d.mv + d.lim.mvStep;
+        if (nextMv > d.lim.mvMax) {
+            // This frequency cannot be stabilised; higher ones will not be either
+            if (d.hasBest) _hold(d, dev, now);
+            else _fault(d, dev, now);
+            return;
+        }
+        d.state = TUNE_SETTLING;
+        _goto(d, d.f, nextMv);
+    }
+
+    void _hold(_Dev& d, uint8_t dev, uint32_t now) {
+        d.state = TUNE_HOLD;
+        _log(now, dev, TEV_HOLD, d.bestF, d.bestMv, 0, 0, d.bestJth);
+        _goto(d, d.bestF, d.bestMv);
+    }
+
+    void _fault(_Dev& d, uint8_t dev, uint32_t now) {
+        if (!d.hasBest) _log(now, dev, TEV_NO_POINT, d.f, d.mv, 0, 0);
+        d.state = TUNE_FAULT;
+        _goto(d, d.origF, d.origMv);
+    }
+
+    void _log(uint32_t now, uint8_t dev, TuneEvent ev, int f, int mv, float hash, float power, float jth = 0) {
+        TuneLogEntry& e = _logRing[_logHead];
+        e.t = now;
+        e.device = dev;
+        e.event = ev;
+        e.frequency = (uint16_t)f;
+        e.coreVoltage = (uint16_t)mv;
+        e.hashRate = hash;
+        e.power = power;
+        e.jth = jth;
+        _logHead = (_logHead + 1) % TUNE_LOG_SIZE;
+        if (_logCount < TUNE_LOG_SIZE) _logCount++;
+        Serial.printf("TUNE %d: %s %dMHz %dmV %.0fGH/s %.1fW %.2fJ/TH\n",
+                      dev, TUNE_EVENT_NAMES[ev], f, mv, hash, power, jth);
+    }
+};
@@ -0,0 +1,302 @@
+#pragma once
+/**
+ * Frequency x core-voltage sweep benchmark
+ *
+ * One job at a time walks a grid of frequency (rows) x coreVoltage (columns)
+ * points on a single device. Like the AutoTuner it only decides — the caller
+ * PATCHes the setpoint and reports back with applied().
+ *
+ * Per point:  SETTLING (settleSec)  ->  MEASURING (measureSec)
+ *   the cell then stores mean hashrate / power / chip temp and the reject
+ *   rate of the shares submitted while measuring.
+ *
+ * Safety limits are checked on every sample; a trip marks the cell UNSAFE,
+ * skips the rest of that frequency row (more voltage only runs hotter) and
+ * moves to the next frequency. When the grid is done, or the job is aborted,
+ * the device goes back to the settings it had when the job started.
+ *
+ * Results stay in RAM until the next job; version() bumps on every cell
+ * change so views can redraw only when something moved.
+ */
+
+#include <Arduino.h>
+
+#ifndef BENCH_MAX_FREQS
+#define BENCH_MAX_FREQS 12
+#endif
+#ifndef BENCH_MAX_VOLTS
+#define BENCH_MAX_VOLTS 12
+#endif
+
+#define BENCH_MAX_PATCH_FAILS 3
+
+struct BenchConfig {
+    uint8_t device = 0;
+    int freqMin = 400;
+    int freqMax = 600;
+    int freqStep = 25;
+    int mvMin = 1100;
+    int mvMax = 1250;
+    int mvStep = 25;
+    uint32_t settleSec = 180;
+    uint32_t measureSec = 300;
+    float maxTemp = 65.0f;             // below the thermal governor's throttle point
+    float maxVrTemp = 85.0f;
+    float minVin = 4.8f;
+};
+
+// What the benchmark needs from one device fetch
+struct BenchSample {
+    float hashRate;
+    float power;
+    float temperature;
+    float vrTemp;
+    float vin;
+    uint32_t sharesAccepted;
+    uint32_t sharesRejected;
+    int frequency;
+    int coreVoltage;
+};
+
+enum BenchCellState : uint8_t {
+    BC_PENDING = 0,
+    BC_DONE,
+    BC_UNSAFE,                 // safety limit tripped at this point
+    BC_SKIPPED,                // not run: an earlier point in the row was unsafe
+    BC_FAILED                  // PATCH never went through
+};
+
+struct BenchCell {
+    uint8_t state;
+    float hashRate;
+    float power;
+    float temperature;
+    float errPct;
+
+    float jth() const { return (hashRate > 0) ? power / (hashRate / 1000.0f) : 0; }
+};
+
+enum BenchState : uint8_t {
+    BENCH_IDLE = 0,
+    BENCH_SETTLING,
+    BENCH_MEASURING,
+    BENCH_RESTORING,           // putting the original settings back
+    BENCH_DONE,
+    BENCH_ABORTED
+};
+
+static const char* const BENCH_STATE_NAMES[] = {"idle", "settling", "measuring", "restoring", "done", "aborted"};
+static const char* const BENCH_CELL_NAMES[] = {"pending", "done", "unsafe", "skipped", "failed"};
+
+class Benchmark {
+public:
+    // Validate the grid and start. Returns false if it does not fit or the sample is unusable.
+    bool start(const BenchConfig& cfg, const BenchSample& cur, uint32_t now) {
+        if (running() || cur.frequency <= 0) return false;
+        if (cfg.freqStep <= 0 || cfg.mvStep <= 0 || cfg.freqMin > cfg.freqMax || cfg.mvMin > cfg.mvMax) return false;
+        int rows = (cfg.freqMax - cfg.freqMin) / cfg.freqStep + 1;
+        int cols = (cfg.mvMax - cfg.mvMin) / cfg.mvStep + 1;
+        if (rows > BENCH_MAX_FREQS || cols > BENCH_MAX_VOLTS) return false;
+
+        _cfg = cfg;
+        _rows = rows;
+        _cols = cols;
+        for (int r = 0; r < _rows; r++)
+            for (int c = 0; c < _cols; c++) _cells[r][c] = BenchCell();
+        _origF = cur.frequency;
+        _origMv = cur.coreVoltage;
+        _aborted = false;
+        _patchFails = 0;
+        _startedAt = now;
+        _row = _col = 0;
+        _state = BENCH_SETTLING;
+        _goto(_freqAt(0), _mvAt(0));
+        _version++;
+        Serial.printf("BENCH: device %d, %dx%d grid\n", cfg.device, _rows, _cols);
+        return true;
+    }
+
+    // Stop early. With restore the original settings go back through the usual
+    // update() path; without, the device is left to whoever took it over.
+    void abort(bool restore = true) {
+        if (!running()) return;
+        _aborted = true;
+        if (restore) {
+            if (_state != BENCH_RESTORING) _restore();
+            return;
+        }
+        _pending = false;
+        _state = BENCH_ABORTED;
+        _version++;
+    }
+
+    // Feed a fresh sample of the benchmarked device. Returns true with a setpoint to PATCH.
+    bool update(const BenchSample& s, uint32_t now, int& freq, int& mv) {
+        if (!running()) return false;
+        if (!_pending) _step(s, now);
+        if (!_pending) return false;
+        freq = _f;
+        mv = _mv;
+        return true;
+    }
+
+    void applied(bool ok, uint32_t now) {
+        if (!_pending) return;
+        if (ok) {
+            _pending = false;
+            _patchFails = 0;
+            _phaseStart = now;
+            if (_state == BENCH_RESTORING) {
+                _state = _aborted ? BENCH_ABORTED : BENCH_DONE;
+                _version++;
+                Serial.printf("BENCH: %s\n", BENCH_STATE_NAMES[_state]);
+            }
+            return;
+        }
+        if (++_patchFails < BENCH_MAX_PATCH_FAILS) return;
+        _pending = false;
+        if (_state == BENCH_RESTORING) {
+            _state = BENCH_ABORTED;        // could not even restore; leave it to the user
+        } else {
+            _cells[_row][_col].state = BC_FAILED;
+            _aborted = true;
+            _restore();
+        }
+        _version++;
+    }
+
+    bool running() const {
+        return _state == BENCH_SETTLING || _state == BENCH_MEASURING || _state == BENCH_RESTORING;
+    }
+    bool hasResults() const { return _state != BENCH_IDLE; }
+    BenchState state() const { return _state; }
+    uint8_t device() const { return _cfg.device; }
+    const BenchConfig& config() const { return _cfg; }
+    uint32_t version() const { return _version; }
+    uint32_t startedAt() const { return _startedAt; }
+
+    int rows() const { return _rows; }
+    int cols() const { return _cols; }
+    int freqAt(int r) const { return _freqAt(r); }
+    int mvAt(int c) const { return _mvAt(c); }
+    const BenchCell& cell(int r, int c) const { return _cells[r][c]; }
+    int currentRow() const { return _row; }
+    int currentCol() const { return _col; }
+
+    int pointsDone() const {
+        int n = 0;
+        for (int r = 0; r < _rows; r++)
+            for (int c = 0; c < _cols; c++) n += _cells[r][c].state != BC_PENDING;
+        return n;
+    }
+
+    // Lowest J/TH measured point; false if none yet
+    bool best(int& row, int& col) const {
+        float bestJth = 0;
+        row = col = -1;
+        for (int r = 0; r < _rows; r++) {
+            for (int c = 0; c < _cols; c++) {
+                const BenchCell& cell = _cells[r][c];
+                if (cell.state != BC_DONE || cell.hashRate <= 0) continue;
+                if (row < 0 || cell.jth() < bestJth) { bestJth = cell.jth(); row = r; col = c; }
+            }
+        }
+        return row >= 0;
+    }
+
+private:
+    BenchConfig _cfg;
+    BenchCell _cells[BENCH_MAX_FREQS][BENCH_MAX_VOLTS];
+    int _rows = 0, _cols = 0;
+    int _row = 0, _col = 0;
+    BenchState _state = BENCH_IDLE;
+    bool _aborted = false;
+    bool _pending = false;
+    uint8_t _patchFails = 0;
+    int _f = 0, _mv = 0;
+    int _origF = 0, _origMv = 0;
+    uint32_t _startedAt = 0;
+    uint32_t _phaseStart = 0;
+    uint32_t _version = 0;
+
+    // Measurement accumulators
+    double _hashSum = 0, _powerSum = 0, _tempSum = 0;
+    uint16_t _samples = 0;
+    uint32_t _acc0 = 0, _rej0 = 0;
+
+    int _freqAt(int r) const { return _cfg.freqMin + r * _cfg.freqStep; }
+    int _mvAt(int c) const { return _cfg.mvMin + c * _cfg.mvStep; }
+
+    void _goto(int f, int mv) {
+        _f = f;
+        _mv = mv;
+        _pending = true;
+    }
+
+    void _restore() {
+        _state = BENCH_RESTORING;
+        _goto(_origF, _origMv);
+    }
+
+    bool _unsafe(const BenchSample& s) const {
+        return s.temperature > _cfg.maxTemp || s.vrTemp > _cfg.maxVrTemp || (s.vin > 0 && s.vin < _cfg.minVin);
+    }
+
+    void _step(const BenchSample& s, uint32_t now) {
+        if (_state == BENCH_RESTORING) return;
+        if (_unsafe(s)) {
+            BenchCell& cell = _cells[_row][_col];
+            cell.state = BC_UNSAFE;
+            cell.temperature = s.temperature;
+            for (int c = _col + 1; c < _cols; c++) _cells[_row][c].state = BC_SKIPPED;
+            Serial.printf("BENCH: %dMHz %dmV unsafe (%.1fC)\n", _f, _mv, s.temperature);
+            _col = _cols - 1;
+            _advance();
+            return;
+        }
+        uint32_t elapsed = now - _phaseStart;
+        if (_state == BENCH_SETTLING) {
+            if (elapsed < _cfg.settleSec) return;
+            _state = BENCH_MEASURING;
+            _phaseStart = now;
+            _hashSum = _powerSum = _tempSum = 0;
+            _samples = 0;
+            _acc0 = s.sharesAccepted;
+            _rej0 = s.sharesRejected;
+            return;
+        }
+        _hashSum += s.hashRate;
+        _powerSum += s.power;
+        _tempSum += s.temperature;
+        _samples++;
+        if (elapsed < _cfg.measureSec) return;
+
+        BenchCell& cell = _cells[_row][_col];
+        cell.state = BC_DONE;
+        cell.hashRate = _hashSum / _samples;
+        cell.power = _powerSum / _samples;
+        cell.temperature = _tempSum / _samples;
+        // Counters going backwards means the miner rebooted mid-point
+        uint32_t acc = (s.sharesAccepted >= _acc0) ? s.sharesAccepted - _acc0 : s.sharesAccepted;
+        uint32_t rej = (s.sharesRejected >= _rej0) ? s.sharesRejected - _rej0 : s.sharesRejected;
+        cell.errPct = (acc + rej) ? rej * 100.0f / (acc + rej) : 0;
+        Serial.printf("BENCH: %dMHz %dmV %.0fGH/s %.1fW %.1fC %.2fJ/TH err %.2f%%\n",
+                      _f, _mv, cell.hashRate, cell.power, cell.temperature, cell.jth(), cell.errPct);
+        _advance();
+    }
+
+    void _advance() {
+        _version++;
+        if (++_col >= _cols) {
+            _col = 0;
+            if (++_row >= _rows) {
+                _row = _rows - 1;
+                _col = _cols - 1;
+                _restore();
+                return;
+            }
+        }
+        _state = BENCH_SETTLING;
+        _goto(_freqAt(_row), _mvAt(_col));
+    }
+};
@@ -0,0 +1,270 @@
+#pragma once
+/**
+ * Concurrent fleet-wide HTTP dispatch
+ *
+ * One bulk operation is one request per device — PATCH /api/system with a
+ * settings body, or POST /api/system/restart — all on non-blocking sockets
+ * multiplexed with select(). pump() advances whatever connects, sends and
+ * reads are ready and returns, so a change across the fleet costs about one
+ * round trip instead of one HTTPClient call (and, for a dead miner, one 5 s
+ * timeout) per device in a row.
+ *
+ * At most BULK_MAX_INFLIGHT sockets are open at once: lwIP's socket table is
+ * small and shared with the web server and the fetch loop. Jobs may also be
+ * staggered — each has its own start offset — so a group restart does not
+ * put every miner back on the pool (and the PSU) at the same instant.
+ *
+ * Only the response status line is read; 2xx counts as done. Jobs keep their
+ * outcome and round-trip time until the next operation; version() bumps on
+ * every job state change so views can redraw only when something moved.
+ * Times are millis().
+ */
+
+#include <Arduino.h>
+#include <lwip/sockets.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define BULK_MAX_INFLIGHT   6
+#define BULK_TIMEOUT_MS     5000
+#define BULK_BODY_LEN       96
+
+enum BulkKind : uint8_t {
+    BK_SETTINGS = 0,           // PATCH /api/system
+    BK_RESTART                 // POST /api/system/restart
+};
+
+enum BulkJobState : uint8_t {
+    BJ_QUEUED = 0,             // waiting for its start time or a free socket
+    BJ_CONNECTING,
+    BJ_SENDING,
+    BJ_READING,
+    BJ_OK,
+    BJ_FAILED,                 // refused, HTTP error (status > 0) or bad address
+    BJ_TIMEOUT
+};
+
+static const char* const BULK_KIND_NAMES[] = {"settings", "restart"};
+static const char* const BULK_JOB_NAMES[] = {"queued", "connecting", "sending", "reading", "ok", "failed", "timeout"};
+
+struct BulkJob {
+    uint8_t device;
+    uint8_t state;
+    int16_t status;            // HTTP status once read, -errno / -1 otherwise
+    int fd;
+    uint32_t addr;             // IPv4, network order
+    uint16_t port;
+    uint16_t sent;
+    uint32_t startAt;
+    uint32_t openedAt;
+    uint32_t doneAt;
+    char body[BULK_BODY_LEN];
+    char line[13];             // "HTTP/1.1 200"
+    uint8_t lineLen;
+
+    bool done() const { return state >= BJ_OK; }
+    bool inFlight() const { return state >= BJ_CONNECTING && state <= BJ_READING; }
+    uint32_t rtt() const { return doneAt - openedAt; }
+};
+
+class BulkDispatcher {
+public:
+    // Start collecting a new operation; false while the previous one is still running
+    bool begin(uint8_t kind, uint32_t nowMs) {
+        if (busy()) return false;
+        _n = 0;
+        _kind = kind;
+        _started = nowMs;
+        _id++;
+        _version++;
+        return true;
+    }
+
+    // Queue the request for one device, delayMs after begin(); "ip:port" overrides port
+    bool add(uint8_t device, const char* ip, uint16_t port, const char* body, uint32_t delayMs) {
+        if (_n >= MAX_DEVICES) return false;
+        BulkJob& j = _jobs[_n++];
+        memset(&j, 0, sizeof(j));
+        j.device = device;
+        j.fd = -1;
+        j.port = port;
+        j.startAt = _started + delayMs;
+        if (body) memcpy(j.body, body, strnlen(body, sizeof(j.body) - 1));    // the memset terminates it
+        char host[16] = "";
+        const char* colon = strchr(ip, ':');
+        size_t hostLen = colon ? (size_t)(colon - ip) : strlen(ip);
+        if (colon) j.port = atoi(colon + 1);
+        if (hostLen < sizeof(host)) {
+            memcpy(host, ip, hostLen);
+            host[hostLen] = '\0';
+        }
+        struct in_addr a;
+        if (inet_pton(AF_INET, host, &a) != 1) {
+            _finish(j, BJ_FAILED, -1, _started);
+            return true;
+        }
+        j.addr = a.s_addr;
+        return true;
+    }
+
+    // Advance every job without blocking longer than waitMs
+    void pump(uint32_t nowMs, uint32_t waitMs = 0) {
+        int open = 0;
+        for (int k = 0; k < _n; k++) open += _jobs[k].inFlight();
+        for (int k = 0; k < _n; k++) {
+            BulkJob& j = _jobs[k];
+            if (j.state == BJ_QUEUED && (int32_t)(nowMs - j.startAt) >= 0 && open < BULK_MAX_INFLIGHT) {
+                _open(j, nowMs);
+                open += j.inFlight();
+            } else if (j.inFlight() && nowMs - j.openedAt >= BULK_TIMEOUT_MS) {
+                _finish(j, BJ_TIMEOUT, -1, nowMs);
+                open--;
+            }
+        }
+        if (open == 0) return;
+
+        fd_set rd, wr;
+        FD_ZERO(&rd);
+        FD_ZERO(&wr);
+        int maxFd = -1;
+        for (int k = 0; k < _n; k++) {
+            const BulkJob& j = _jobs[k];
+            if (!j.inFlight()) continue;
+            FD_SET(j.fd, j.state == BJ_READING ? &rd : &wr);
+            if (j.fd > maxFd) maxFd = j.fd;
+        }
+        struct timeval tv = {(long)(waitMs / 1000), (long)(waitMs % 1000) * 1000};
+        if (select(maxFd + 1, &rd, &wr, nullptr, &tv) <= 0) return;
+
+        for (int k = 0; k < _n; k++) {
+            BulkJob& j = _jobs[k];
+            if (!j.inFlight()) continue;
+            if (j.state == BJ_CONNECTING && FD_ISSET(j.fd, &wr)) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(j.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err) { _finish(j, BJ_FAILED, -err, nowMs); continue; }
+                j.state = BJ_SENDING;
+            }
+            if (j.state == BJ_SENDING && FD_ISSET(j.fd, &wr)) _send(j, nowMs);
+            else if (j.state == BJ_READING && FD_ISSET(j.fd, &rd)) _read(j, nowMs);
+        }
+    }
+
+    // Close what is open and drop what has not started
+    void cancel(uint32_t nowMs) {
+        for (int k = 0; k < _n; k++) {
+            if (!_jobs[k].done()) _finish(_jobs[k], BJ_FAILED, -1, nowMs);
+        }
+    }
+
+    bool busy() const {
+        for (int k = 0; k < _n; k++) if (!_jobs[k].done()) return true;
+        return false;
+    }
+
+    // Sockets open right now (the caller may want to poll faster)
+    bool active() const {
+        for (int k = 0; k < _n; k++) if (_jobs[k].inFlight()) return true;
+        return false;
+    }
+
+    uint16_t count() const { return _n; }
+    const BulkJob& job(uint16_t k) const { return _jobs[k]; }
+    uint8_t kind() const { return _kind; }
+    uint32_t id() const { return _id; }
+    uint32_t version() const { return _version; }
+    uint32_t startedAt() const { return _started; }
+
+    uint16_t okCount() const {
+        uint16_t n = 0;
+        for (int k = 0; k < _n; k++) n += _jobs[k].state == BJ_OK;
+        return n;
+    }
+
+    // Job for device d in the current operation, nullptr if it is not part of it
+    const BulkJob* forDevice(uint8_t d) const {
+        for (int k = 0; k < _n; k++) if (_jobs[k].device == d) return &_jobs[k];
+        return nullptr;
+    }
+
+private:
+    BulkJob _jobs[MAX_DEVICES];
+    uint16_t _n = 0;
+    uint8_t _kind = BK_SETTINGS;
+    uint32_t _id = 0;
+    uint32_t _version = 0;
+    uint32_t _started = 0;
+
+    void _open(BulkJob& j, uint32_t nowMs) {
+        j.openedAt = nowMs;
+        j.fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (j.fd < 0) { _finish(j, BJ_FAILED, -errno, nowMs); return; }
+        fcntl(j.fd, F_SETFL, fcntl(j.fd, F_GETFL, 0) | O_NONBLOCK);
+        struct sockaddr_in sa;
+        memset(&sa, 0, sizeof(sa));
+        sa.sin_family = AF_INET;
+        sa.sin_port = htons(j.port);
+        sa.sin_addr.s_addr = j.addr;
+        if (connect(j.fd, (struct sockaddr*)&sa, sizeof(sa)) == 0) j.state = BJ_SENDING;
+        else if (errno == EINPROGRESS) j.state = BJ_CONNECTING;
+        else { _finish(j, BJ_FAILED, -errno, nowMs); return; }
+        _version++;
+    }
+
+    // The request is rebuilt on every call rather than stored per job
+    int _request(const BulkJob& j, char* buf, size_t size) const {
+        const uint8_t* ip = (const uint8_t*)&j.addr;
+        int len = strlen(j.body);
+        return snprintf(buf, size,
+                        "%s HTTP/1.1\r\nHost: %u.%u.%u.%u:%u\r\nContent-Type: application/json\r\n"
+                        "Content-Length: %d\r\nConnection: close\r\n\r\n%s",
+                        _kind == BK_RESTART ? "POST /api/system/restart" : "PATCH /api/system",
+                        ip[0], ip[1], ip[2], ip[3], j.port, len, j.body);
+    }
+
+    void _send(BulkJob& j, uint32_t nowMs) {
+        char buf[256];
+        int len = _request(j, buf, sizeof(buf));
+        int k = send(j.fd, buf + j.sent, len - j.sent, MSG_NOSIGNAL);
+        if (k < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) _finish(j, BJ_FAILED, -errno, nowMs);
+            return;
+        }
+        j.sent += k;
+        if (j.sent >= len) {
+            j.state = BJ_READING;
+            _version++;
+        }
+    }
+
+    void _read(BulkJob& j, uint32_t nowMs) {
+        char buf[64];
+        int k = recv(j.fd, buf, sizeof(buf), 0);
+        if (k < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) _finish(j, BJ_FAILED, -errno, nowMs);
+            return;
+        }
+        if (k == 0) { _finish(j, BJ_FAILED, -1, nowMs); return; }     // closed before a status line
+        for (int c = 0; c < k && j.lineLen < sizeof(j.line) - 1; c++) j.line[j.lineLen++] = buf[c];
+        if (j.lineLen < sizeof(j.line) - 1) return;
+        j.line[j.lineLen] = '\0';
+        int status = (strncmp(j.line, "HTTP/", 5) == 0) ? atoi(j.line + 9) : -1;
+        _finish(j, status >= 200 && status < 300 ? BJ_OK : BJ_FAILED, status, nowMs);
+    }
+
+    void _finish(BulkJob& j, uint8_t state, int status, uint32_t nowMs) {
+        if (j.fd >= 0) close(j.fd);
+        j.fd = -1;
+        j.state = state;
+        j.status = status;
+        j.doneAt = nowMs;
+        _version++;
+    }
+};
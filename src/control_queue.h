@@ -0,0 +1,151 @@
+#pragma once
+/**
+ * Coalescing per-device control queue
+ *
+ * FRQ / mV / FAN taps on a device screen no longer PATCH one by one. A tap
+ * moves the device's target for that field — starting from the value still
+ * collecting, else the one in flight, else what the device last reported —
+ * and the screen shows the target straight away. Once no tap has arrived for
+ * CONTROL_DEBOUNCE_MS every field that moved goes out in a single PATCH; taps
+ * made while it is in flight collect into the next one.
+ *
+ * The sender reads the settings back after the PATCH and hands them to
+ * complete(). Fields that match become what the screen shows; on a mismatch,
+ * a failed PATCH or no answer within CONTROL_INFLIGHT_MS the targets are
+ * dropped, so the screen falls back to the device's own values, and
+ * outcome() reports CQ_REJECTED for a while so the view can say so.
+ *
+ * Times are millis(). Each send carries a sequence number; a late answer to
+ * a send that already timed out is ignored.
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define CONTROL_DEBOUNCE_MS   600
+#define CONTROL_INFLIGHT_MS   15000
+#define CONTROL_FEEDBACK_MS   4000
+
+enum ControlField : uint8_t {
+    CF_FREQ = 0,               // MHz
+    CF_VOLT,                   // core mV
+    CF_FAN,                    // fanspeed %
+    CF_COUNT
+};
+
+enum ControlOutcome : uint8_t {
+    CQ_NONE = 0,
+    CQ_CONFIRMED,              // read back as sent
+    CQ_UNVERIFIED,             // PATCH accepted, read-back failed; the next fetch will tell
+    CQ_REJECTED                // PATCH failed, timed out or read back different
+};
+
+class ControlQueue {
+public:
+    // Move field f of device i by delta within [lo, hi]; returns the new target
+    int nudge(uint8_t i, uint8_t f, int delta, int reported, int lo, int hi, uint32_t nowMs) {
+        if (i >= MAX_DEVICES || f >= CF_COUNT) return reported;
+        _Slot& s = _s[i];
+        int v = constrain(shown(i, f, reported) + delta, lo, hi);
+        s.next[f] = v;
+        s.collecting = true;
+        s.lastTap = nowMs;
+        s.outcome = CQ_NONE;
+        return v;
+    }
+
+    // Targets due for sending: the taps have settled and nothing is in flight
+    bool take(uint8_t i, uint32_t nowMs, int values[CF_COUNT], uint16_t& seq) {
+        if (i >= MAX_DEVICES) return false;
+        _Slot& s = _s[i];
+        if (s.inFlight && nowMs - s.sentAt >= CONTROL_INFLIGHT_MS) _finish(s, CQ_REJECTED, nowMs);
+        if (!s.collecting || s.inFlight || nowMs - s.lastTap < CONTROL_DEBOUNCE_MS) return false;
+        for (int f = 0; f < CF_COUNT; f++) {
+            s.sent[f] = values[f] = s.next[f];
+            s.next[f] = -1;
+        }
+        s.collecting = false;
+        s.inFlight = true;
+        s.sentAt = nowMs;
+        seq = ++s.seq;
+        return true;
+    }
+
+    // Result of send `seq`; readBack holds the device's values when readOk
+    ControlOutcome complete(uint8_t i, uint16_t seq, bool patched, bool readOk,
+                            const int readBack[CF_COUNT], uint32_t nowMs) {
+        if (i >= MAX_DEVICES) return CQ_NONE;
+        _Slot& s = _s[i];
+        if (!s.inFlight || seq != s.seq) return CQ_NONE;
+        ControlOutcome o = CQ_REJECTED;
+        if (patched && !readOk) {
+            o = CQ_UNVERIFIED;
+        } else if (patched) {
+            o = CQ_CONFIRMED;
+            for (int f = 0; f < CF_COUNT; f++) {
+                if (s.sent[f] >= 0 && abs(readBack[f] - s.sent[f]) > (f == CF_FAN ? 1 : 0)) o = CQ_REJECTED;
+            }
+        }
+        _finish(s, o, nowMs);
+        return o;
+    }
+
+    // Value to draw for field f: the newest target, else what the device reported
+    int shown(uint8_t i, uint8_t f, int reported) const {
+        if (i >= MAX_DEVICES || f >= CF_COUNT) return reported;
+        const _Slot& s = _s[i];
+        if (s.next[f] >= 0) return s.next[f];
+        if (s.inFlight && s.sent[f] >= 0) return s.sent[f];
+        return reported;
+    }
+
+    bool pending(uint8_t i) const { return i < MAX_DEVICES && (_s[i].collecting || _s[i].inFlight); }
+
+    bool pending(uint8_t i, uint8_t f) const {
+        if (i >= MAX_DEVICES || f >= CF_COUNT) return false;
+        return _s[i].next[f] >= 0 || (_s[i].inFlight && _s[i].sent[f] >= 0);
+    }
+
+    // Last outcome of device i while it is still worth showing, CQ_NONE otherwise
+    ControlOutcome outcome(uint8_t i, uint32_t nowMs) const {
+        if (i >= MAX_DEVICES || nowMs - _s[i].outcomeAt >= CONTROL_FEEDBACK_MS) return CQ_NONE;
+        return (ControlOutcome)_s[i].outcome;
+    }
+
+    // Device list changed; answers still in flight are ignored through the sequence number
+    void reset() {
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            uint16_t seq = _s[i].seq;
+            _s[i] = _Slot();
+            _s[i].seq = seq;
+        }
+    }
+
+private:
+    struct _Slot {
+        int next[CF_COUNT] = {-1, -1, -1};     // collecting, -1 = untouched
+        int sent[CF_COUNT] = {-1, -1, -1};     // in flight, -1 = not part of it
+        bool collecting = false;
+        bool inFlight = false;
+        uint8_t outcome = CQ_NONE;
+        uint16_t seq = 0;
+        uint32_t lastTap = 0;
+        uint32_t sentAt = 0;
+        uint32_t outcomeAt = 0;
+    };
+
+    _Slot _s[MAX_DEVICES];
+
+    void _finish(_Slot& s, ControlOutcome o, uint32_t nowMs) {
+        for (int f = 0; f < CF_COUNT; f++) s.sent[f] = -1;
+        s.inFlight = false;
+        s.outcome = o;
+        s.outcomeAt = nowMs;
+        if (o != CQ_CONFIRMED) {
+            Serial.printf("CONTROL: send %u %s\n", s.seq, o == CQ_UNVERIFIED ? "not verified" : "rejected");
+        }
+    }
+};
@@ -0,0 +1,288 @@
+#pragma once
+/**
+ * Time-of-use electricity tariff, energy meter and scheduled performance profiles
+ *
+ * TariffSchedule — up to TARIFF_MAX_WINDOWS local-time windows, each with a
+ *   rate and a frequency profile (percent of each device's base frequency).
+ *   Outside every window the base rate (the pool screen's +/- rate) applies
+ *   at 100 %. Text form, comma separated:
+ *
+ *     HH:MM-HH:MM[/days]=rate[@pct]      e.g. "22:00-07:00=0.08@110,17:00-21:00/12345=0.35@85"
+ *
+ *   days are ISO weekday digits (1 = Mon .. 7 = Sun) of the day the window
+ *   starts; a window may wrap past midnight. The first matching window wins.
+ *
+ * EnergyMeter — trapezoidal integration of sampled fleet power into kWh and
+ *   cost at the rate in force, with today / yesterday buckets keyed on the
+ *   local calendar day. Gaps longer than ENERGY_MAX_GAP_SEC are not bridged.
+ *
+ * ProfileScheduler — per-device frequency target
+ *     base * pct / 100 - (governor cuts)
+ *   The base is the device's own setting when first seen, or re-learned after
+ *   a manual change. PATCHes only when the reported frequency is off target;
+ *   when disabled, devices are walked back to 100 % once and then left alone.
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define TARIFF_MAX_WINDOWS   8
+#define ENERGY_MAX_GAP_SEC   120
+#define PROFILE_MIN_PCT      50
+#define PROFILE_MAX_PCT      125
+
+struct TariffWindow {
+    uint16_t start;            // minute of day, local
+    uint16_t end;              // exclusive; < start wraps past midnight
+    uint8_t days;              // bit per tm_wday (0 = Sun), 0x7F = every day
+    float rate;                // per kWh
+    uint8_t freqPct;           // profile, percent of base frequency
+};
+
+class TariffSchedule {
+public:
+    float baseRate = 0.12f;
+
+    uint8_t count() const { return _n; }
+    const TariffWindow& window(uint8_t k) const { return _w[k]; }
+
+    // Index of the window in force at (tm_wday, minute of day), -1 = none
+    int windowAt(int wday, int minute) const {
+        for (int k = 0; k < _n; k++) {
+            const TariffWindow& w = _w[k];
+            if (w.start <= w.end) {
+                if (minute >= w.start && minute < w.end && _onDay(w, wday)) return k;
+            } else {
+                // Wrapping window: the early-morning part belongs to the previous day's window
+                if (minute >= w.start && _onDay(w, wday)) return k;
+                if (minute < w.end && _onDay(w, (wday + 6) % 7)) return k;
+            }
+        }
+        return -1;
+    }
+
+    float rateAt(int wday, int minute) const {
+        int k = windowAt(wday, minute);
+        return (k >= 0) ? _w[k].rate : baseRate;
+    }
+
+    uint8_t pctAt(int wday, int minute) const {
+        int k = windowAt(wday, minute);
+        return (k >= 0) ? _w[k].freqPct : 100;
+    }
+
+    // Sum of the rate over one day in rate-hours: kW x this = cost of running a whole day
+    float dailyRateHours(int wday) const {
+        if (_n == 0) return baseRate * 24.0f;
+        float sum = 0;
+        for (int m = 0; m < 1440; m++) sum += rateAt(wday, m);
+        return sum / 60.0f;
+    }
+
+    bool parse(const char* text) {
+        TariffSchedule s;
+        s.baseRate = baseRate;
+        const char* p = text;
+        while (*p == ' ') p++;
+        while (*p && s._n < TARIFF_MAX_WINDOWS) {
+            TariffWindow w;
+            int start, end;
+            if (!_parseTime(p, start) || *p++ != '-' || !_parseTime(p, end)) return false;
+            w.start = start;
+            w.end = end;
+            w.days = 0x7F;
+            if (*p == '/') {
+                p++;
+                w.days = 0;
+                while (*p >= '1' && *p <= '7') w.days |= 1 << ((*p++ - '0') % 7);
+                if (w.days == 0) return false;
+            }
+            if (*p++ != '=') return false;
+            char* stop;
+            w.rate = strtof(p, &stop);
+            if (stop == p || w.rate < 0) return false;
+            p = stop;
+            w.freqPct = 100;
+            if (*p == '@') {
+                p++;
+                long pct = strtol(p, &stop, 10);
+                if (stop == p || pct < PROFILE_MIN_PCT || pct > PROFILE_MAX_PCT) return false;
+                w.freqPct = (uint8_t)pct;
+                p = stop;
+            }
+            if (w.start == w.end) return false;
+            s._w[s._n++] = w;
+            while (*p == ',' || *p == ' ') p++;
+        }
+        if (*p) return false;
+        *this = s;
+        return true;
+    }
+
+    void format(char* buf, size_t size) const {
+        size_t len = 0;
+        buf[0] = '\0';
+        for (int k = 0; k < _n && len < size; k++) {
+            const TariffWindow& w = _w[k];
+            len += snprintf(buf + len, size - len, "%s%02u:%02u-%02u:%02u", k ? "," : "",
+                            w.start / 60, w.start % 60, w.end / 60, w.end % 60);
+            if (w.days != 0x7F && len < size) {
+                len += snprintf(buf + len, size - len, "/");
+                for (int d = 1; d <= 7 && len < size; d++) {
+                    if (w.days & (1 << (d % 7))) len += snprintf(buf + len, size - len, "%d", d);
+                }
+            }
+            if (len < size) len += snprintf(buf + len, size - len, "=%.4g", w.rate);
+            if (w.freqPct != 100 && len < size) len += snprintf(buf + len, size - len, "@%u", w.freqPct);
+        }
+    }
+
+private:
+    TariffWindow _w[TARIFF_MAX_WINDOWS];
+    uint8_t _n = 0;
+
+    static bool _onDay(const TariffWindow& w, int wday) { return w.days & (1 << wday); }
+
+    static bool _parseTime(const char*& p, int& minute) {
+        char* stop;
+        long h = strtol(p, &stop, 10);
+        if (stop == p || *stop != ':' || h < 0 || h > 24) return false;
+        p = stop + 1;
+        long m = strtol(p, &stop, 10);
+        if (stop == p || m < 0 || m > 59 || h * 60 + m > 1440) return false;
+        p = stop;
+        minute = (int)(h * 60 + m) % 1440;
+        return true;
+    }
+};
+
+// Persisted as one blob, so keep it plain
+struct EnergyTotals {
+    double kWh = 0;
+    double cost = 0;
+    double todayKWh = 0;
+    double todayCost = 0;
+    double yesterdayKWh = 0;
+    double yesterdayCost = 0;
+    int32_t day = -1;          // energyDay() of the today bucket, -1 = unknown
+};
+
+// Day number of a local calendar date (tm fields), days since 1970-01-01: consecutive
+// across month and year ends, which tm_year * 366 + tm_yday is not
+inline int32_t energyDay(const struct tm& tm) {
+    int32_t y = tm.tm_year + 1900 - (tm.tm_mon < 2);
+    int32_t era = (y >= 0 ? y : y - 399) / 400;
+    int32_t yoe = y - era * 400;
+    int32_t m = tm.tm_mon + 1;
+    int32_t doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + tm.tm_mday - 1;
+    int32_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+class EnergyMeter {
+public:
+    void restore(const EnergyTotals& t) { _t = t; }
+    void reset() { _t = EnergyTotals(); _dirty = true; }
+    const EnergyTotals& totals() const { return _t; }
+    bool dirty() const { return _dirty; }
+    void saved() { _dirty = false; }
+
+    // Fold in the fleet power measured at `now` (monotonic s); day = energyDay() of local time or -1
+    void add(float watts, float rate, uint32_t now, int32_t day) {
+        if (day >= 0 && day != _t.day) {
+            if (_t.day >= 0) {
+                // A skipped day (device off) leaves nothing for yesterday
+                bool consecutive = day == _t.day + 1;
+                _t.yesterdayKWh = consecutive ? _t.todayKWh : 0;
+                _t.yesterdayCost = consecutive ? _t.todayCost : 0;
+            }
+            _t.todayKWh = _t.todayCost = 0;
+            _t.day = day;
+        }
+        if (_started && now > _last && now - _last <= ENERGY_MAX_GAP_SEC) {
+            double kWh = (watts + _lastW) * 0.5 * (now - _last) / 3600000.0;
+            double cost = kWh * rate;
+            _t.kWh += kWh;
+            _t.cost += cost;
+            _t.todayKWh += kWh;
+            _t.todayCost += cost;
+            _dirty = true;
+        }
+        _started = true;
+        _last = now;
+        _lastW = watts;
+    }
+
+private:
+    EnergyTotals _t;
+    bool _started = false;
+    bool _dirty = false;
+    uint32_t _last = 0;
+    float _lastW = 0;
+};
+
+class ProfileScheduler {
+public:
+    void setEnabled(bool on) { _enabled = on; }
+    bool enabled() const { return _enabled; }
+
+    // Profile in force right now (from the tariff window)
+    void setPct(uint8_t pct) { _pct = constrain(pct, PROFILE_MIN_PCT, PROFILE_MAX_PCT); }
+    uint8_t pct() const { return _enabled ? _pct : 100; }
+    int base(uint8_t i) const { return i < MAX_DEVICES ? _st[i].base : 0; }
+
+    // Someone set the frequency by hand: re-learn the base from the next sample
+    void forget(uint8_t i) {
+        if (i >= MAX_DEVICES) return;
+        _st[i].base = 0;
+        _st[i].learnPct = pct();
+        _st[i].applied = pct();
+    }
+
+    // Fresh sample of device i; cutMHz is what the governors have taken. True with a target to PATCH.
+    bool evaluate(uint8_t i, int reported, int cutMHz, uint32_t now, int& freq) {
+        if (i >= MAX_DEVICES || reported <= 0) return false;
+        _State& st = _st[i];
+        if (st.base <= 0) {
+            st.base = (int)((reported + cutMHz) * 100L / st.learnPct);
+            st.applied = st.learnPct;
+        }
+        uint8_t want = pct();
+        if (!_enabled && st.applied == 100) return false;
+        if (st.acted && now - st.lastTry < _retrySec) return false;
+        int target = (int)((long)st.base * want / 100) - cutMHz;
+        if (abs(reported - target) < 3) {
+            st.applied = want;
+            return false;
+        }
+        freq = target;
+        st.acted = true;
+        st.lastTry = now;
+        st.pending = want;
+        return true;
+    }
+
+    void applied(uint8_t i, int freq, bool ok) {
+        if (i >= MAX_DEVICES || !ok) return;
+        _st[i].applied = _st[i].pending;
+        Serial.printf("PROFILE: device %d -> %dMHz (%u%% of %dMHz)\n", i, freq, _st[i].pending, _st[i].base);
+    }
+
+private:
+    struct _State {
+        int base = 0;              // MHz at 100 %, 0 = not learned yet
+        uint8_t learnPct = 100;    // profile the device was at when the base is learned
+        uint8_t applied = 100;     // profile last PATCHed successfully
+        uint8_t pending = 100;
+        bool acted = false;
+        uint32_t lastTry = 0;
+    };
+
+    bool _enabled = false;
+    uint8_t _pct = 100;
+    uint32_t _retrySec = 30;       // also lets a fresh sample arrive after a PATCH
+    _State _st[MAX_DEVICES];
+};
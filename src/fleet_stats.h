@@ -0,0 +1,251 @@
+#pragma once
+/**
+ * Incremental fleet statistics
+ *
+ * Every successful device fetch is folded in with ingest(), a device that
+ * goes offline is taken out with drop(). The last contribution of each device
+ * is kept, so fleet totals are updated by difference — O(1) per sample instead
+ * of rescanning devices[] on every redraw.
+ *
+ *   totals   — hashrate, power, accepted / rejected shares, online count
+ *   maxima   — best diff, best session diff, hottest chip. Raised in place;
+ *              recomputed from the stored contributions only when the device
+ *              holding a maximum drops below it or goes offline
+ *   EWMAs    — fleet hashrate, power and share rate, weighted by elapsed time
+ *              so uneven fetch spacing does not bias them
+ *   windows  — per-minute ring of fleet snapshots and share deltas, giving
+ *              efficiency and reject rate over the last N minutes (N <= 60)
+ *
+ * Times are seconds from a monotonic clock (millis() / 1000) so an NTP step
+ * never distorts the windows.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define FLEET_WINDOW_MINUTES 60
+#define FLEET_EWMA_TAU       60.0f     // s, hashrate / power
+#define FLEET_SHARE_TAU      600.0f    // s, share rate
+
+// What one device contributes to the fleet figures
+struct FleetSample {
+    float hashRate;            // GH/s
+    float power;               // W
+    float temperature;         // C
+    uint32_t sharesAccepted;
+    uint32_t sharesRejected;
+    double bestDiff;
+    double bestSessionDiff;
+};
+
+class FleetStats {
+public:
+    FleetStats() { reset(); }
+
+    // Forget everything (device list changed)
+    void reset() {
+        for (int i = 0; i < MAX_DEVICES; i++) _dev[i] = _Contrib();
+        for (int i = 0; i < FLEET_WINDOW_MINUTES; i++) _slots[i] = _Slot();
+        _online = 0;
+        _hash = _power = 0;
+        _acc = _rej = 0;
+        for (int m = 0; m < _MAX_COUNT; m++) { _max[m] = 0; _owner[m] = 0xFF; }
+        _maxDirty = false;
+        _started = false;
+        _lastTick = 0;
+        _ewmaHash = _ewmaPower = _ewmaShares = 0;
+        _pendingShares = 0;
+    }
+
+    // Fold in a fresh sample for device i
+    void ingest(uint8_t i, const FleetSample& s, uint32_t now) {
+        if (i >= MAX_DEVICES) return;
+        _Contrib& c = _dev[i];
+        if (c.seen) {
+            // Counters restart from zero when the miner reboots
+            uint32_t dAcc = (s.sharesAccepted >= c.s.sharesAccepted) ? s.sharesAccepted - c.s.sharesAccepted : s.sharesAccepted;
+            uint32_t dRej = (s.sharesRejected >= c.s.sharesRejected) ? s.sharesRejected - c.s.sharesRejected : s.sharesRejected;
+            _Slot& sl = _slot(now);
+            sl.acc += dAcc;
+            sl.rej += dRej;
+            _pendingShares += dAcc;
+        }
+        if (c.online) _sub(c.s);
+        else _online++;
+        _add(s);
+        c.s = s;
+        c.online = true;
+        c.seen = true;
+
+        _raise(_MAX_BEST, i, s.bestDiff);
+        _raise(_MAX_SESSION, i, s.bestSessionDiff);
+        _raise(_MAX_TEMP, i, s.temperature);
+        _tick(now);
+    }
+
+    // Device i stopped responding: remove its contribution
+    void drop(uint8_t i, uint32_t now) {
+        if (i >= MAX_DEVICES || !_dev[i].online) return;
+        _sub(_dev[i].s);
+        _dev[i].online = false;
+        _online--;
+        if (_online == 0) { _hash = _power = 0; _acc = _rej = 0; }
+        for (int m = 0; m < _MAX_COUNT; m++) {
+            if (_owner[m] == i) _maxDirty = true;
+        }
+        _tick(now);
+    }
+
+    int online() const { return _online; }
+    float totalHashrate() const { return (float)_hash; }
+    float totalPower() const { return (float)_power; }
+    uint32_t sharesAccepted() const { return _acc; }
+    uint32_t sharesRejected() const { return _rej; }
+
+    double maxBestDiff() { _refreshMax(); return _max[_MAX_BEST]; }
+    double maxBestSessionDiff() { _refreshMax(); return _max[_MAX_SESSION]; }
+    float maxTemperature() { _refreshMax(); return (float)_max[_MAX_TEMP]; }
+
+    // Lifetime reject rate of the online devices, percent
+    float rejectPct() const {
+        uint32_t total = _acc + _rej;
+        return total ? (float)_rej * 100.0f / total : 0;
+    }
+
+    float ewmaHashrate() const { return _ewmaHash; }
+    float ewmaPower() const { return _ewmaPower; }
+    float shareRate() const { return _ewmaShares; }      // accepted shares / minute
+
+    // Fleet J/TH averaged over the last `minutes` (0 if nothing was hashing)
+    float efficiency(int minutes) const {
+        double hash = 0, power = 0;
+        _window(minutes, [&](const _Slot& s) { hash += s.hashSum; power += s.powerSum; });
+        return (hash > 0) ? (float)(power / (hash / 1000.0)) : 0;
+    }
+
+    // Rejected / (accepted + rejected) over the last `minutes`, percent
+    float rejectPct(int minutes) const {
+        uint32_t acc = 0, rej = 0;
+        _window(minutes, [&](const _Slot& s) { acc += s.acc; rej += s.rej; });
+        return (acc + rej) ? (float)rej * 100.0f / (acc + rej) : 0;
+    }
+
+    // Accepted shares over the last `minutes`
+    uint32_t sharesIn(int minutes) const {
+        uint32_t acc = 0;
+        _window(minutes, [&](const _Slot& s) { acc += s.acc; });
+        return acc;
+    }
+
+private:
+    enum { _MAX_BEST = 0, _MAX_SESSION, _MAX_TEMP, _MAX_COUNT };
+
+    struct _Contrib {
+        FleetSample s = {};
+        bool online = false;
+        bool seen = false;         // share counters valid for deltas
+    };
+    struct _Slot {
+        uint32_t minute = 0xFFFFFFFF;
+        double hashSum = 0;        // fleet snapshots folded into this minute
+        double powerSum = 0;
+        uint32_t acc = 0;          // share deltas during this minute
+        uint32_t rej = 0;
+    };
+
+    _Contrib _dev[MAX_DEVICES];
+    _Slot _slots[FLEET_WINDOW_MINUTES];
+    int _online;
+    double _hash, _power;          // doubles so add / subtract cycles do not drift
+    uint32_t _acc, _rej;
+    double _max[_MAX_COUNT];
+    uint8_t _owner[_MAX_COUNT];
+    bool _maxDirty;
+    bool _started;
+    uint32_t _lastTick;
+    float _ewmaHash, _ewmaPower, _ewmaShares;
+    uint32_t _pendingShares;
+
+    void _add(const FleetSample& s) {
+        _hash += s.hashRate;
+        _power += s.power;
+        _acc += s.sharesAccepted;
+        _rej += s.sharesRejected;
+    }
+
+    void _sub(const FleetSample& s) {
+        _hash -= s.hashRate;
+        _power -= s.power;
+        _acc -= s.sharesAccepted;
+        _rej -= s.sharesRejected;
+    }
+
+    void _raise(int m, uint8_t i, double v) {
+        if (_maxDirty) return;
+        if (_owner[m] == 0xFF || v >= _max[m]) {
+            _max[m] = v;
+            _owner[m] = i;
+        } else if (_owner[m] == i) {
+            _maxDirty = true;      // the leader went down; someone else may lead now
+        }
+    }
+
+    void _refreshMax() {
+        if (!_maxDirty) return;
+        for (int m = 0; m < _MAX_COUNT; m++) { _max[m] = 0; _owner[m] = 0xFF; }
+        for (int i = 0; i < MAX_DEVICES; i++) {
+            if (!_dev[i].online) continue;
+            const FleetSample& s = _dev[i].s;
+            const double v[_MAX_COUNT] = {s.bestDiff, s.bestSessionDiff, s.temperature};
+            for (int m = 0; m < _MAX_COUNT; m++) {
+                if (_owner[m] == 0xFF || v[m] > _max[m]) { _max[m] = v[m]; _owner[m] = i; }
+            }
+        }
+        _maxDirty = false;
+    }
+
+    _Slot& _slot(uint32_t now) {
+        uint32_t minute = now / 60;
+        _Slot& sl = _slots[minute % FLEET_WINDOW_MINUTES];
+        if (sl.minute != minute) sl = _Slot(), sl.minute = minute;
+        return sl;
+    }
+
+    // Fold the new fleet totals into the EWMAs and the current minute
+    void _tick(uint32_t now) {
+        float hash = (float)_hash, power = (float)_power;
+        if (!_started) {
+            _started = true;
+            _ewmaHash = hash;
+            _ewmaPower = power;
+            _pendingShares = 0;
+        } else if (now > _lastTick) {
+            float dt = (float)(now - _lastTick);
+            float a = 1.0f - expf(-dt / FLEET_EWMA_TAU);
+            _ewmaHash += a * (hash - _ewmaHash);
+            _ewmaPower += a * (power - _ewmaPower);
+            float as = 1.0f - expf(-dt / FLEET_SHARE_TAU);
+            _ewmaShares += as * (_pendingShares * 60.0f / dt - _ewmaShares);
+            _pendingShares = 0;
+        }
+        _lastTick = now;
+        _Slot& sl = _slot(now);
+        sl.hashSum += hash;
+        sl.powerSum += power;
+    }
+
+    template <typename F>
+    void _window(int minutes, F fn) const {
+        if (!_started) return;
+        minutes = constrain(minutes, 1, FLEET_WINDOW_MINUTES);
+        uint32_t current = _lastTick / 60;
+        for (int k = 0; k < minutes && (uint32_t)k <= current; k++) {
+            const _Slot& sl = _slots[(current - k) % FLEET_WINDOW_MINUTES];
+            if (sl.minute == current - k) fn(sl);
+        }
+    }
+};
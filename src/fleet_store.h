@@ -0,0 +1,36 @@
+#pragma once
+/**
+ * Hot per-device metrics, one array per field
+ *
+ * The fleet table, the power governor and every fleet-wide pass read the
+ * same handful of numbers for each device: online, hashrate, power,
+ * temperature and the share counters. Kept as parallel arrays they sit in
+ * a few contiguous cache lines (21 bytes per device) instead of being
+ * strided across DeviceInfo with its addresses, names and pool details, so
+ * a pass over 64 or 256 devices reads only what it uses. Everything else a
+ * device reports stays in DeviceInfo, indexed the same way.
+ *
+ * host/layout_bench.cpp times these passes against the old
+ * array-of-structs layout (--layout-bench).
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+struct FleetStore {
+    bool valid[MAX_DEVICES] = {};              // answered within the last MAX_FAIL_BEFORE_INVALID polls
+    float hashRate[MAX_DEVICES] = {};          // GH/s
+    float power[MAX_DEVICES] = {};             // W
+    float temperature[MAX_DEVICES] = {};       // C
+    int sharesAccepted[MAX_DEVICES] = {};
+    int sharesRejected[MAX_DEVICES] = {};
+
+    void clear(int i) {
+        valid[i] = false;
+        hashRate[i] = power[i] = temperature[i] = 0;
+        sharesAccepted[i] = sharesRejected[i] = 0;
+    }
+};
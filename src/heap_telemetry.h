@@ -0,0 +1,205 @@
+#pragma once
+/**
+ * Heap and stack telemetry
+ *
+ * Every HEAP_SAMPLE_SEC the display's free heap, largest free block,
+ * lowest free heap since boot and the stack high-water marks of the loop
+ * and control tasks go into a ring of HEAP_RING samples (an hour by
+ * default). Fragmentation is 100 - largest block * 100 / free heap: free
+ * memory that exists but no longer comes in one piece. trend() fits a
+ * line through the ring, so a slow leak or a shrinking largest block shows
+ * as bytes per hour long before an allocation fails; low() says when the
+ * largest block is already smaller than a TLS session needs.
+ *
+ * Allocations are counted per subsystem when the build wraps the allocator
+ * (HEAP_COUNT_ALLOCS=1 with -Wl,--wrap=malloc,--wrap=calloc,--wrap=realloc,
+ * --wrap=free, see [heap_telemetry] in platformio.ini). The loop task tags
+ * what it is doing with a HeapTag scope; allocations made by any other task
+ * (WiFi, lwIP, the control worker) count as HT_TASKS. Direct
+ * heap_caps_malloc() calls bypass the wrapper and are not counted.
+ */
+
+#include <Arduino.h>
+
+#ifndef HEAP_COUNT_ALLOCS
+#define HEAP_COUNT_ALLOCS 0
+#endif
+
+#ifndef HEAP_RING
+#define HEAP_RING 120
+#endif
+
+#define HEAP_SAMPLE_SEC     30
+#define HEAP_LOW_BLOCK      20000          // below this a TLS handshake may not find its buffers
+
+enum HeapSubsystem : uint8_t {
+    HT_OTHER = 0,              // loop task, nothing tagged
+    HT_FETCH,                  // miner / price / difficulty requests
+    HT_INGEST,                 // parsing a miner's info and every hook that consumes it
+    HT_RENDER,                 // screen updates and redraws
+    HT_WEB,                    // web server handlers
+    HT_CONTROL,                // control queue and bulk dispatch
+    HT_LOG,                    // metric log, history export, alert webhook
+    HT_TASKS,                  // any task other than loop
+    HT_COUNT
+};
+
+static const char* const HEAP_SUBSYSTEM_NAMES[HT_COUNT] = {
+    "other", "fetch", "ingest", "render", "web", "control", "log", "tasks"
+};
+
+struct HeapSample {
+    uint32_t t;                // seconds since boot
+    uint32_t freeBytes;
+    uint32_t largest;
+    uint32_t minFree;          // lowest free heap since boot
+    uint16_t loopStack;        // bytes of stack never used
+    uint16_t workerStack;
+    uint32_t allocs;           // allocations counted so far, all subsystems
+};
+
+struct HeapCounts {
+    volatile uint32_t allocs[HT_COUNT];
+    volatile uint32_t bytes[HT_COUNT];
+    volatile uint32_t frees;
+};
+
+// Written by the allocator wrappers, from any task
+extern HeapCounts heapCounts;
+extern volatile uint8_t heapTagNow;
+extern TaskHandle_t heapLoopTask;
+
+// Tag the loop task's allocations for the rest of the enclosing block
+class HeapTag {
+public:
+    explicit HeapTag(uint8_t tag) : _prev(heapTagNow) { heapTagNow = tag; }
+    ~HeapTag() { heapTagNow = _prev; }
+
+private:
+    uint8_t _prev;
+};
+
+class HeapTelemetry {
+public:
+    // Call from setup(): the task calling it is the one HeapTag scopes attribute
+    void begin(TaskHandle_t worker) {
+        heapLoopTask = xTaskGetCurrentTaskHandle();
+        _worker = worker;
+        _n = _head = 0;
+        _lowWarned = false;
+    }
+
+    // Sample when due; returns true when it did
+    bool loop(uint32_t nowSec) {
+        if (_n > 0 && nowSec - _last().t < HEAP_SAMPLE_SEC) return false;
+        HeapSample s = current(nowSec);
+        _ring[_head] = s;
+        _head = (_head + 1) % HEAP_RING;
+        if (_n < HEAP_RING) _n++;
+        if (low() && !_lowWarned) {
+            Serial.printf("HEAP: largest block %lu bytes of %lu free (%d%% fragmented)\n",
+                          (unsigned long)s.largest, (unsigned long)s.freeBytes, fragmentation(s));
+        }
+        _lowWarned = low();
+        return true;
+    }
+
+    HeapSample current(uint32_t nowSec) const {
+        HeapSample s;
+        s.t = nowSec;
+        s.freeBytes = ESP.getFreeHeap();
+        s.largest = ESP.getMaxAllocHeap();
+        s.minFree = ESP.getMinFreeHeap();
+        s.loopStack = heapLoopTask ? uxTaskGetStackHighWaterMark(heapLoopTask) : 0;
+        s.workerStack = _worker ? uxTaskGetStackHighWaterMark(_worker) : 0;
+        s.allocs = 0;
+        for (int k = 0; k < HT_COUNT; k++) s.allocs += heapCounts.allocs[k];
+        return s;
+    }
+
+    static int fragmentation(const HeapSample& s) {
+        return s.freeBytes ? 100 - (int)((uint64_t)s.largest * 100 / s.freeBytes) : 0;
+    }
+
+    // Least-squares slope over the ring, bytes per hour, of free heap and largest block
+    bool trend(float& freePerHour, float& largestPerHour) const {
+        freePerHour = largestPerHour = 0;
+        if (_n < 4) return false;
+        double st = 0, sf = 0, sl = 0, stt = 0, stf = 0, stl = 0;
+        uint32_t t0 = sample(0).t;
+        for (int k = 0; k < _n; k++) {
+            const HeapSample& s = sample(k);
+            double t = (s.t - t0) / 3600.0;
+            st += t;
+            sf += s.freeBytes;
+            sl += s.largest;
+            stt += t * t;
+            stf += t * s.freeBytes;
+            stl += t * s.largest;
+        }
+        double d = _n * stt - st * st;
+        if (d <= 0) return false;
+        freePerHour = (_n * stf - st * sf) / d;
+        largestPerHour = (_n * stl - st * sl) / d;
+        return true;
+    }
+
+    bool low() const { return _n > 0 && _last().largest < HEAP_LOW_BLOCK; }
+
+    // Oldest first
+    int count() const { return _n; }
+    const HeapSample& sample(int k) const { return _ring[(_head - _n + k + HEAP_RING) % HEAP_RING]; }
+
+private:
+    HeapSample _ring[HEAP_RING];
+    int _n = 0;
+    int _head = 0;
+    TaskHandle_t _worker = nullptr;
+    bool _lowWarned = false;
+
+    const HeapSample& _last() const { return _ring[(_head + HEAP_RING - 1) % HEAP_RING]; }
+};
+
+// ===== ALLOCATOR WRAPPERS =====
+// One definition for the program; main.cpp is the only translation unit that includes this.
+
+HeapCounts heapCounts = {};
+volatile uint8_t heapTagNow = HT_OTHER;
+TaskHandle_t heapLoopTask = nullptr;
+
+#if HEAP_COUNT_ALLOCS
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+void __real_free(void* p);
+
+static inline void heapCount(size_t size) {
+    uint8_t tag = (heapLoopTask && xTaskGetCurrentTaskHandle() == heapLoopTask) ? heapTagNow : HT_TASKS;
+    heapCounts.allocs[tag]++;
+    heapCounts.bytes[tag] += size;
+}
+
+void* __wrap_malloc(size_t size) {
+    heapCount(size);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+    heapCount(n * size);
+    return __real_calloc(n, size);
+}
+
+void* __wrap_realloc(void* p, size_t size) {
+    if (size) heapCount(size);
+    return __real_realloc(p, size);
+}
+
+void __wrap_free(void* p) {
+    if (p) heapCounts.frees++;
+    __real_free(p);
+}
+}
+
+#endif
@@ -0,0 +1,300 @@
+#pragma once
+/**
+ * Streaming history export for /api/history
+ *
+ * The request handler hands the client socket over to a HistoryExport job
+ * and returns immediately; loop() then calls pump() which produces rows into
+ * a fixed HEXP_BUFFER_BYTES buffer and writes them as HTTP/1.1 chunks for a
+ * bounded amount of time per call. Nothing proportional to the export size is
+ * ever allocated and the render loop keeps running between slices.
+ *
+ * Sources:
+ *   step > 0 and the range is covered by an in-memory tier no wider than
+ *            step  -> MetricsHistory buckets, one row per step per series
+ *   otherwise      -> MetricLog on flash, raw rows (step = 0) or rows
+ *                     averaged per step on the fly
+ *
+ * Formats:
+ *   csv  "time,device,hashrate,temp,power" (only the selected metrics)
+ *   bin  16-byte header {"BXH1", u8 version, u8 metricMask, u16 reserved,
+ *        u32 from, u32 step} then little-endian rows {u32 time, u16 series,
+ *        f32 per selected metric}. Series HIST_FLEET is the fleet total.
+ */
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include "metrics_history.h"
+#include "metric_log.h"
+
+#ifndef HEXP_BUFFER_BYTES
+#define HEXP_BUFFER_BYTES 512
+#endif
+
+#define HEXP_MAX_ROW 96          // worst-case CSV / binary row
+#define HEXP_IDLE_TIMEOUT 15000  // give up on a client that stopped reading
+#define HEXP_SCAN_BUDGET 64      // records or (step, series) cells looked at per call, emitted or not
+
+static const char* const HEXP_METRIC_NAMES[HM_COUNT] = {"hashrate", "temp", "power"};
+
+struct HistoryQuery {
+    uint16_t firstSeries;
+    uint16_t lastSeries;      // inclusive
+    uint8_t metricMask;       // bit per HistMetric
+    uint32_t from;
+    uint32_t to;
+    uint32_t step;            // seconds, 0 = raw samples
+    bool binary;
+};
+
+class HistoryExport {
+public:
+    bool active() const { return _active; }
+
+    // Take over an accepted client and start streaming. Returns false if busy.
+    bool begin(WiFiClient client, const HistoryQuery& q, MetricsHistory& hist, MetricLog& log) {
+        if (_active) return false;
+        _client = client;
+        _q = q;
+        _hist = &hist;
+        _log = &log;
+        _len = 0;
+        _rows = 0;
+        _lastProgress = millis();
+
+        _fromMemory = false;
+        if (q.step > 0) {
+            _fromMemory = hist.canServe(q.firstSeries, q.from, q.step) || !log.ready();
+        }
+        if (!_fromMemory) {
+            if (!_cursor.open(log, q.from, q.to)) {
+                _fromMemory = true;   // no flash log: fall back to the 1 min tier
+                if (_q.step == 0) _q.step = HIST_TIERS[0].width;
+            }
+            for (int s = 0; s < HIST_SERIES; s++) _acc[s].n = 0;
+        }
+        if (_fromMemory) _clampToMemory();
+        _t = _q.from;
+        _series = _q.firstSeries;
+        _draining = false;
+
+        _client.print("HTTP/1.1 200 OK\r\n");
+        _client.print(_q.binary ? "Content-Type: application/octet-stream\r\n"
+                                : "Content-Type: text/csv\r\n");
+        _client.print(_q.binary ? "Content-Disposition: attachment; filename=history.bin\r\n"
+                                : "Content-Disposition: attachment; filename=history.csv\r\n");
+        _client.print("Transfer-Encoding: chunked\r\n"
+                      "Access-Control-Allow-Origin: *\r\n"
+                      "Connection: close\r\n\r\n");
+        _writeHeader();
+        _active = true;
+        return true;
+    }
+
+    // Produce and send rows for at most budgetMs. Call every loop().
+    void pump(unsigned long budgetMs) {
+        if (!_active) return;
+        unsigned long start = millis();
+        if (!_client.connected() || start - _lastProgress > HEXP_IDLE_TIMEOUT) {
+            _finish(false);
+            return;
+        }
+        while (millis() - start < budgetMs) {
+            bool more = _fromMemory ? _nextMemoryRow() : _nextLogRow();
+            if (!more) {
+                _flushChunk();
+                _finish(true);
+                return;
+            }
+            if (_len + HEXP_MAX_ROW > HEXP_BUFFER_BYTES && !_flushChunk()) return;
+        }
+    }
+
+    uint32_t rowsSent() const { return _rows; }
+
+private:
+    bool _active = false;
+    WiFiClient _client;
+    HistoryQuery _q;
+    MetricsHistory* _hist = nullptr;
+    MetricLog* _log = nullptr;
+    MetricLogCursor _cursor;
+    bool _fromMemory = false;
+    uint32_t _t = 0;            // memory mode: start of current step
+    uint16_t _series = 0;       // memory mode: next series within the step
+    uint32_t _rows = 0;
+    unsigned long _lastProgress = 0;
+    uint8_t _buf[HEXP_BUFFER_BYTES];
+    size_t _len = 0;
+
+    struct _Acc { uint32_t start; uint16_t n; float sum[HM_COUNT]; };
+    _Acc _acc[HIST_SERIES];
+    uint16_t _drainSeries = 0;
+    bool _draining = false;
+
+    void _writeHeader() {
+        if (_q.binary) {
+            memcpy(_buf, "BXH1", 4);
+            _buf[4] = 1;
+            _buf[5] = _q.metricMask;
+            _buf[6] = 0;
+            _buf[7] = 0;
+            memcpy(_buf + 8, &_q.from, 4);
+            memcpy(_buf + 12, &_q.step, 4);
+            _len = 16;
+        } else {
+            _len = snprintf((char*)_buf, HEXP_BUFFER_BYTES, "time,device");
+            for (int m = 0; m < HM_COUNT; m++) {
+                if (_q.metricMask & (1 << m)) {
+                    _len += snprintf((char*)_buf + _len, HEXP_BUFFER_BYTES - _len, ",%s", HEXP_METRIC_NAMES[m]);
+                }
+            }
+            _buf[_len++] = '\n';
+        }
+    }
+
+    void _emit(uint32_t t, uint16_t series, const float* v) {
+        if (_q.binary) {
+            memcpy(_buf + _len, &t, 4);
+            memcpy(_buf + _len + 4, &series, 2);
+            _len += 6;
+            for (int m = 0; m < HM_COUNT; m++) {
+                if (!(_q.metricMask & (1 << m))) continue;
+                memcpy(_buf + _len, &v[m], 4);
+                _len += 4;
+            }
+        } else {
+            char* p = (char*)_buf + _len;
+            size_t room = HEXP_BUFFER_BYTES - _len;
+            int n = (series == HIST_FLEET)
+                ? snprintf(p, room, "%lu,fleet", (unsigned long)t)
+                : snprintf(p, room, "%lu,%u", (unsigned long)t, (unsigned)series);
+            for (int m = 0; m < HM_COUNT; m++) {
+                if (!(_q.metricMask & (1 << m))) continue;
+                n += snprintf(p + n, room - n, ",%.2f", v[m]);
+            }
+            p[n++] = '\n';
+            _len += n;
+        }
+        _rows++;
+    }
+
+    bool _inSelection(uint16_t series) const {
+        return series >= _q.firstSeries && series <= _q.lastSeries;
+    }
+
+    // Memory mode starts at the oldest bucket any selected series still holds, on the step grid
+    void _clampToMemory() {
+        uint32_t oldest = 0;
+        for (uint16_t s = _q.firstSeries; s <= _q.lastSeries; s++) {
+            uint32_t o = _hist->oldest(s);
+            if (o && (oldest == 0 || o < oldest)) oldest = o;
+        }
+        if (oldest == 0) {
+            _q.from = _q.to;      // nothing in memory: header only
+        } else if (oldest > _q.from) {
+            _q.from += (oldest - _q.from) / _q.step * _q.step;
+        }
+    }
+
+    // One row per (step, series) from the in-memory tiers. Like _nextLogRow, a call looks at
+    // a bounded number of cells, so a range of empty steps cannot hold up loop().
+    bool _nextMemoryRow() {
+        for (int budget = HEXP_SCAN_BUDGET; budget > 0 && _t < _q.to; budget--) {
+            if (_series > _q.lastSeries) {
+                _series = _q.firstSeries;
+                _t += _q.step;
+                continue;
+            }
+            uint16_t s = _series++;
+            uint32_t t1 = min(_t + _q.step, _q.to);
+            float v[HM_COUNT] = {0};
+            bool any = false;
+            for (int m = 0; m < HM_COUNT; m++) {
+                if (!(_q.metricMask & (1 << m))) continue;
+                HistPoint pt;
+                if (_hist->read(s, m, _t, t1, 1, &pt) > 0) {
+                    v[m] = pt.mean;
+                    any = true;
+                }
+            }
+            if (any) {
+                _emit(_t, s, v);
+                return true;
+            }
+        }
+        return _t < _q.to;
+    }
+
+    void _emitAcc(uint16_t s) {
+        _Acc& a = _acc[s];
+        float v[HM_COUNT];
+        for (int m = 0; m < HM_COUNT; m++) v[m] = a.sum[m] / a.n;
+        _emit(a.start, s, v);
+        a.n = 0;
+    }
+
+    // Raw or step-averaged rows from the flash log. Returns true while there is
+    // more to do; a call reads a bounded number of records even if none is emitted.
+    bool _nextLogRow() {
+        if (_draining) {
+            while (_drainSeries < HIST_SERIES) {
+                uint16_t s = _drainSeries++;
+                if (_acc[s].n > 0) { _emitAcc(s); return true; }
+            }
+            return false;
+        }
+        MlogRecord r;
+        for (int budget = HEXP_SCAN_BUDGET; budget > 0; budget--) {
+            if (!_cursor.next(r)) {
+                _cursor.close();
+                _draining = true;
+                _drainSeries = 0;
+                return _nextLogRow();
+            }
+            if (!_inSelection(r.series)) continue;
+            if (_q.step == 0) {
+                _emit(r.t, r.series, r.v);
+                return true;
+            }
+            _Acc& a = _acc[r.series];
+            uint32_t start = r.t - (r.t - _q.from) % _q.step;
+            bool emitted = false;
+            if (a.n > 0 && start != a.start) {
+                _emitAcc(r.series);
+                emitted = true;
+            }
+            if (a.n == 0) {
+                a.start = start;
+                for (int m = 0; m < HM_COUNT; m++) a.sum[m] = 0;
+            }
+            for (int m = 0; m < HM_COUNT; m++) a.sum[m] += r.v[m];
+            a.n++;
+            if (emitted) return true;
+        }
+        return true;
+    }
+
+    bool _flushChunk() {
+        if (_len == 0) return true;
+        char head[12];
+        int hl = snprintf(head, sizeof(head), "%X\r\n", (unsigned)_len);
+        if (_client.write((const uint8_t*)head, hl) != (size_t)hl ||
+            _client.write(_buf, _len) != _len ||
+            _client.write((const uint8_t*)"\r\n", 2) != 2) {
+            _finish(false);
+            return false;
+        }
+        _len = 0;
+        _lastProgress = millis();
+        return true;
+    }
+
+    void _finish(bool ok) {
+        if (ok) _client.print("0\r\n\r\n");
+        _client.stop();
+        _cursor.close();
+        _draining = false;
+        _active = false;
+        Serial.printf("HISTORY EXPORT: %s, %u rows\n", ok ? "done" : "aborted", (unsigned)_rows);
+    }
+};
@@ -0,0 +1,174 @@
+#pragma once
+/**
+ * Scratch arena for JSON documents
+ *
+ * Every parse and every web API response used to size its own
+ * DynamicJsonDocument on the heap, 512 bytes to 20 KB at a time, several
+ * times a second. JsonArena is one preallocated buffer handed out as a
+ * stack: a document takes its capacity from the top, the text it
+ * serializes to goes right behind it, and both are given back in reverse
+ * order when they leave scope. shrinkToFit() on the top block returns the
+ * unused tail in place, which is what makes room for the text.
+ *
+ * An arena belongs to one task: jsonArena to loop(), which does all the
+ * fetching, ingesting and serving; the control worker has its own.
+ * Requests that do not fit (too big, or more than JSON_ARENA_BLOCKS live
+ * at once) fall back to malloc and are counted, so highWater() and
+ * overflows() say whether JSON_ARENA_SIZE is right for a fleet.
+ *
+ *   ScratchJsonDocument doc(2048);         // from jsonArena
+ *   doc["x"] = 1;
+ *   ScratchJsonText text(doc);             // serialized behind it
+ *   http.POST((uint8_t*)text.c_str(), text.length());
+ */
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE 24576
+#endif
+
+#define JSON_ARENA_BLOCKS 4        // document + text, twice over
+
+class JsonArena {
+public:
+    JsonArena(const char* name, uint8_t* buf, size_t size) : _name(name), _buf(buf), _size(size) {}
+
+    void* allocate(size_t n) {
+        n = _round(n);
+        if (_depth < JSON_ARENA_BLOCKS && n <= _size - _top) {
+            _Block& b = _blocks[_depth++];
+            b.off = _top;
+            b.size = n;
+            b.live = true;
+            _top += n;
+            if (_top > _peak) _peak = _top;
+            return _buf + b.off;
+        }
+        _overflows++;
+        if (n > _largestOverflow) _largestOverflow = n;
+        return malloc(n);
+    }
+
+    void deallocate(void* p) {
+        if (!p) return;
+        if (!_owns(p)) {
+            _heapFree(p);
+            return;
+        }
+        int k = _block(p);
+        if (k < 0) return;
+        _blocks[k].live = false;
+        while (_depth > 0 && !_blocks[_depth - 1].live) _top = _blocks[--_depth].off;
+    }
+
+    // In place for the top block (grow or shrink) and for any shrink; otherwise moved
+    void* reallocate(void* p, size_t n) {
+        if (!p) return allocate(n);
+        if (!_owns(p)) return realloc(p, n);
+        int k = _block(p);
+        if (k < 0) return nullptr;
+        n = _round(n);
+        _Block& b = _blocks[k];
+        if (k == _depth - 1 && n <= _size - b.off) {
+            b.size = n;
+            _top = b.off + n;
+            if (_top > _peak) _peak = _top;
+            return p;
+        }
+        if (n <= b.size) return p;
+        void* q = allocate(n);
+        if (q) memcpy(q, p, b.size);
+        deallocate(p);
+        return q;
+    }
+
+    const char* name() const { return _name; }
+    size_t size() const { return _size; }
+    size_t used() const { return _top; }
+    size_t highWater() const { return _peak; }             // most bytes held at once since boot
+    uint32_t overflows() const { return _overflows; }      // requests that went to malloc
+    size_t largestOverflow() const { return _largestOverflow; }
+
+private:
+    struct _Block {
+        size_t off;
+        size_t size;
+        bool live;
+    };
+
+    const char* _name;
+    uint8_t* _buf;
+    size_t _size;
+    size_t _top = 0;
+    _Block _blocks[JSON_ARENA_BLOCKS] = {};
+    int _depth = 0;
+    size_t _peak = 0;
+    uint32_t _overflows = 0;
+    size_t _largestOverflow = 0;
+
+    static size_t _round(size_t n) { return (n + 7) & ~(size_t)7; }
+
+    // Out of line: GCC cannot follow _owns() through the block bookkeeping and would
+    // otherwise see arena pointers reaching free() (-Wfree-nonheap-object)
+    static void __attribute__((noinline)) _heapFree(void* p) { free(p); }
+
+    // Inside the buffer: never handed to free() / realloc(), whatever _block() finds
+    bool _owns(const void* p) const { return (const uint8_t*)p >= _buf && (const uint8_t*)p < _buf + _size; }
+
+    int _block(const void* p) const {
+        const uint8_t* q = (const uint8_t*)p;
+        for (int k = _depth - 1; k >= 0; k--)
+            if (_buf + _blocks[k].off == q) return k;
+        return -1;
+    }
+};
+
+// One definition for the program, in main.cpp; other translation units (the unit tests)
+// define JSON_ARENA_EXTERN before including this and share it.
+#ifdef JSON_ARENA_EXTERN
+extern JsonArena jsonArena;
+#else
+static uint8_t jsonArenaBuf[JSON_ARENA_SIZE];
+JsonArena jsonArena("loop", jsonArenaBuf, sizeof(jsonArenaBuf));
+#endif
+
+// ArduinoJson allocator over an arena, jsonArena unless told otherwise
+struct ArenaAllocator {
+    JsonArena* arena;
+
+    ArenaAllocator(JsonArena& a = jsonArena) : arena(&a) {}
+    void* allocate(size_t n) { return arena->allocate(n); }
+    void deallocate(void* p) { arena->deallocate(p); }
+    void* reallocate(void* p, size_t n) { return arena->reallocate(p, n); }
+};
+
+typedef BasicJsonDocument<ArenaAllocator> ScratchJsonDocument;
+
+// doc serialized into the same arena, released when this goes out of scope (before doc)
+class ScratchJsonText {
+public:
+    explicit ScratchJsonText(ScratchJsonDocument& doc, JsonArena& arena = jsonArena) : _arena(arena) {
+        doc.shrinkToFit();
+        _len = measureJson(doc);
+        _text = (char*)_arena.allocate(_len + 1);
+        if (_text) {
+            serializeJson(doc, _text, _len + 1);
+        } else {
+            _len = 0;
+        }
+    }
+    ~ScratchJsonText() { _arena.deallocate(_text); }
+
+    ScratchJsonText(const ScratchJsonText&) = delete;
+    ScratchJsonText& operator=(const ScratchJsonText&) = delete;
+
+    const char* c_str() const { return _text ? _text : ""; }
+    size_t length() const { return _len; }
+
+private:
+    JsonArena& _arena;
+    char* _text;
+    size_t _len;
+};
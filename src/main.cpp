@@ -35,6 +35,37 @@
 // Scale a value by the smaller axis (for square things like radii, icons)
 #define SS(n) ((int)((long)(n) * min(SCR_W, SCR_H) / 240))
 
+// Maximum number of monitored BitAxe devices
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+// Saved device list: up to MAX_DEVICES "ip" or "ip:port" entries, comma-separated
+#define DEVICE_LIST_LEN (MAX_DEVICES * 40)
+
+#include "metrics_history.h"
+#include "metric_log.h"
+#include "history_export.h"
+#include "trend_chart.h"
+#include "fleet_stats.h"
+#include "auto_tuner.h"
+#include "power_governor.h"
+#include "thermal_governor.h"
+#include "benchmark.h"
+#include "energy_tariff.h"
+#include "profitability.h"
+#include "alert_engine.h"
+#include "miner_watchdog.h"
+#include "control_queue.h"
+#include "bulk_dispatch.h"
+#include "api_trace.h"
+#include "perf_stats.h"
+#include "heap_telemetry.h"
+#include "string_pool.h"
+#include "fleet_store.h"
+#include "json_arena.h"
+#include "settings_store.h"
+
 // Display
 TFT_eSPI tft = TFT_eSPI();
 
@@ -87,6 +118,7 @@ const unsigned long SHARE_FLASH_DURATION = 200;
 
 // Data storage
 Preferences prefs;
+SettingsStore settings(prefs);            // int / float / bool keys, flushed in batches
 WebServer webServer(80);
 
 // Update interval
@@ -95,35 +127,70 @@ const unsigned long UPDATE_INTERVAL = 5000;
 int deviceFetchIndex = 0;
 
 // === DEVICE DATA ===
+// Text fields are fixed buffers or interned in devicePool, rewritten only when the miner reports
+// something new, and the request URLs are formatted once from the IP, not on every poll.
+// Online flag, hashrate, power, temperature and shares live in fleet (FleetStore), same index.
 struct DeviceInfo {
-    bool valid = false;
     char ip[40] = "";
-    String hostname = "";
-    String deviceModel = "";
-    String asicModel = "";
-    float hashRate = 0;
+    char host[40] = "";                // ip without the port
+    uint16_t port = 80;
+    char url[64] = "";                 // http://ip[:port]/api/system (PATCH)
+    char infoUrl[64] = "";             // .../api/system/info (poll)
+    char hostname[33] = "";
+    const char* deviceModel = "";      // interned in devicePool
+    const char* asicModel = "";
     float hashRate_1h = 0;
-    float temperature = 0;
     float vrTemp = 0;
-    float power = 0;
     float voltage = 0;
     int coreVoltage = 1200;
     int frequency = 0;
     int fanSpeed = 0;
     int fanRpm = 0;
-    int sharesAccepted = 0;
-    int sharesRejected = 0;
     double bestDiff = 0;
     double bestSessionDiff = 0;
-    String stratumURL = "";
+    const char* stratumURL = "";
     int stratumPort = 0;
-    String stratumUser = "";
+    char stratumUser[96] = "";
     int uptimeSeconds = 0;
     int wifiRSSI = 0;
+    double poolDifficulty = 0;
 };
 
-DeviceInfo devices[8];
+DeviceInfo devices[MAX_DEVICES];
+FleetStore fleet;
 int deviceCount = 0;
+StringPool<3 * MAX_DEVICES + 1, 64> devicePool;    // deviceModel, asicModel, stratumURL
+
+// Last response body (a miner's /api/system/info, the price, the difficulty); only loop()
+// fetches and ingests. Its parse lives in jsonArena.
+#define FETCH_BODY_MAX 6144
+#define DEVICE_DOC_SIZE 8192
+char fetchBody[FETCH_BODY_MAX];
+
+// One HTTP client for every fetch loop() makes: its Strings keep their capacity from one
+// request to the next, and the URL is copied into fetchUrl rather than a fresh String each time
+WiFiClient deviceClient;
+WiFiClientSecure apiClient;
+HTTPClient fetchHttp;
+String fetchUrl;
+const char* fetchHeaders[] = {"Transfer-Encoding"};
+
+// Running fleet totals, maxima and windows — updated per fetch, read by every screen
+FleetStats fleetStats;
+
+// Per-device frequency / voltage efficiency search (driven from /api/tune)
+AutoTuner autoTuner;
+
+// Fleet watt budget (0 = off), persisted as powerCap / powerHyst
+PowerGovernor powerGov;
+
+// Per-device fan curves + throttling, persisted as thermalOn / throttleC / fanCurveN
+ThermalGovernor thermalGov;
+const uint32_t FAN_MANUAL_HOLD_SEC = 600;   // a FAN+ tap pauses the curve this long
+
+// Frequency x voltage sweep on one device (started from /benchmark), shown as a heatmap screen
+Benchmark benchmark;
+uint32_t benchDrawnVersion = 0;
 
 // Pool/price info (global, not per-device)
 struct PoolInfo {
@@ -153,8 +220,108 @@ const int COIN_COUNT = 5;
 int selectedCoin = 0;
 float electricityRate = 0.12;
 
+// Time-of-use windows on top of electricityRate, real kWh / cost, and the frequency
+// profiles tied to the windows; persisted as tariff / tz / profilesOn / energy
+TariffSchedule tariff;
+EnergyMeter energyMeter;
+ProfileScheduler profiles;
+unsigned long lastEnergySave = 0;
+const unsigned long ENERGY_SAVE_INTERVAL = 600000;  // 10 min — flash wear vs. lost kWh on power cut
+int rateHoursDay = -1;                              // weekday todayRateHours() was cached for, -1 = stale
+float rateHoursCache = 0;
+
+// Expected blocks / revenue / profit per device and fleet; block reward persisted as blockReward
+Profitability profit;
+float blockReward = 3.125;
+
+// Alert rules (persisted as alertRules) -> title bar banner, LED, webhook (alertHook)
+AlertEngine alerts;
+const char* const ALERT_RULES_DEFAULT =
+    "temp > 70 for 3 hyst 3 cool 900; vrtemp > 90 for 3 hyst 5 cool 900; "
+    "hashdrop > 25 for 3 hyst 10 cool 1800; reject > 10 for 3 hyst 5 cool 1800; "
+    "offline cool 900; vin < 4.9 for 2 hyst 0.1 cool 900";
+String alertWebhook = "";
+uint32_t bannerVersion = 0;
+char screenTitle[40] = "";
+unsigned long alertRetryAt = 0;
+uint8_t alertAttempts = 0;
+const uint8_t ALERT_HOOK_ATTEMPTS = 3;
+const unsigned long ALERT_HOOK_RETRY_MS = 30000;
+
+// The webhook POST (3 s timeout, TLS for https://) runs on webhookWorker, one event at a time;
+// loop() formats the body, hands over a copy and consumes or retries on the result.
+#define ALERT_HOOK_URL_MAX  160
+#define ALERT_HOOK_BODY_MAX 384
+struct WebhookJob {
+    char url[ALERT_HOOK_URL_MAX];
+    char body[ALERT_HOOK_BODY_MAX];
+    uint16_t len;
+};
+QueueHandle_t webhookJobs = nullptr;
+QueueHandle_t webhookResults = nullptr;        // int HTTP code, < 0 on a transport error
+bool webhookBusy = false;
+
+// Restarts miners that answer but stopped mining; persisted as wdOn / wdZeroMin / wdStaleMin / wdGapMin
+MinerWatchdog watchdog;
+
+// FRQ / mV / FAN taps, merged per device and sent + read back by controlWorker on the other core.
+// Only the worker touches the network for them; devices[] stays with loop().
+ControlQueue controlQueue;
+struct ControlJob {
+    uint8_t device;
+    uint16_t seq;
+    char url[64];                      // DeviceInfo::url
+    char body[96];
+};
+struct ControlResult {
+    uint8_t device;
+    uint16_t seq;
+    bool patched;
+    bool readOk;
+    int values[CF_COUNT];
+};
+const int CONTROL_MIN[CF_COUNT] = {100, 1000, 0};      // MHz, mV, fan % — also the bulk limits
+const int CONTROL_MAX[CF_COUNT] = {1200, 1400, 100};
+QueueHandle_t controlJobs = nullptr;
+QueueHandle_t controlResults = nullptr;
+const uint32_t CONTROL_VERIFY_DELAY_MS = 300;      // let AxeOS apply the PATCH before reading back
+
+// Fleet-wide settings / staggered restarts on concurrent sockets (fleet screen, /fleet, /api/bulk)
+BulkDispatcher bulk;
+struct BulkSetting {
+    bool set[CF_COUNT];
+    bool relative[CF_COUNT];           // value is a step from each device's own setting
+    int value[CF_COUNT];
+};
+int bulkTargets[MAX_DEVICES][CF_COUNT];    // per job: what its PATCH sets, -1 = untouched
+bool bulkApplied[MAX_DEVICES];             // per job: outcome already folded into devices[]
+uint32_t fleetDrawnVersion = 0;
+const uint32_t BULK_RESTART_STAGGER_MS = 20000;
+
+// Recorded device / price / difficulty responses (/api/trace)
+ApiTraceWriter traceWriter;
+ApiTraceReader traceReader;
+char tracePath[48] = "";
+char* replayBuf = nullptr;                 // payload of the record being replayed, only while replaying
+int replayDevices = 0;                     // device count of the trace being replayed
+bool replaying() { return replayBuf != nullptr; }
+
+// Hot-path timing (/debug/perf); the overlay is off unless asked for
+PerfStats perf;
+bool perfOverlay = false;
+uint32_t perfLoopAt = 0;
+
+// Free heap, largest block and stack marks every 30 s (/api/heap)
+HeapTelemetry heapTelemetry;
+TaskHandle_t controlTask = nullptr;
+
+// The control worker's JSON, kept apart from loop()'s jsonArena
+#define CONTROL_ARENA_SIZE 8192
+uint8_t controlArenaBuf[CONTROL_ARENA_SIZE];
+JsonArena controlArena("control", controlArenaBuf, sizeof(controlArenaBuf));
+
 // Consecutive API failure tracking per device
-int deviceFailCount[8] = {0};
+int deviceFailCount[MAX_DEVICES] = {0};
 const int MAX_FAIL_BEFORE_INVALID = 3;
 
 // Double-tap confirmation
@@ -162,6 +329,21 @@ unsigned long lastRestartTap = 0;
 int restartTapDevice = -1;
 bool restartConfirmPending = false;
 
+// Rolled-up metric history (1 min / 15 min / 1 h tiers)
+MetricsHistory history;
+
+// On-flash metric log — history survives reboots
+MetricLog metricLog;
+HistoryExport historyExport;
+
+// Sparklines: one hashrate + one temperature chart, re-bound by whichever screen is shown
+TrendChart trendHash(&tft);
+TrendChart trendTemp(&tft);
+const TrendStyle TREND_HASH_STYLE = {PANEL_FILL, CRT_GLOW, CRT_BRIGHT, CRT_DIM, CRT_MID};
+const TrendStyle TREND_TEMP_STYLE = {PANEL_FILL, CRT_RED_DARK, CRT_WHITE, CRT_DIM, CRT_MID};
+bool historyRestored = false;
+const uint16_t LOG_RETENTION_DAYS = 14;
+
 // POST feedback
 unsigned long postFeedbackTime = 0;
 bool postFeedbackSuccess = false;
@@ -183,21 +365,85 @@ void updateLed(unsigned long now);
 void fetchBtcPrice();
 void fetchNetworkDifficulty();
 void fetchDeviceData(int index);
+int fetchHttps(const char* host, const char* url, size_t &len);
+uint16_t deviceHostPort(const char* entry, char* host, size_t size);
+size_t readBody(HTTPClient &http, char* buf, size_t size);
+void assignText(char* dst, size_t size, const char* src);
+void drawPerfOverlay();
+void sendPerfStats();
+void sendHeapTelemetry();
+void applyDevicePayload(int index, int httpCode, const char* payload, size_t len);
+void deviceFetchFailed(int index);
+void applyPricePayload(int httpCode, const char* payload, size_t len);
+void applyDifficultyPayload(int httpCode, const char* payload, size_t len);
+void traceResponse(uint8_t source, int device, int httpCode, unsigned long latencyMs, const char* payload, size_t len);
+bool startCapture(const char* path, uint32_t maxBytes);
+void stopCapture();
+bool startReplay(const char* path, float speed);
+void stopReplay();
+void useDeviceList(const char* ips);
+void pumpReplay(unsigned long now);
+void sendTraceStatus(int code);
+void sendJson(int code, ScratchJsonDocument &doc);
 void updateDisplay();
 void updatePoolScreen();
 void updateDeviceScreen(int devIndex);
 void drawPoolScreen();
 void drawDeviceScreen(int devIndex);
+void drawBenchmarkScreen();
+void updateBenchmarkScreen();
 void redrawCurrentScreen();
+void recordDeviceSample(int index);
+uint32_t historyClock();
+bool clockSynced();
+void restoreHistoryFromLog();
+void prepareRestart();
+void attachTrendChart(TrendChart &chart, int x, int y, int w, int h, uint16_t series, uint8_t metric,
+                      const TrendStyle &style, const char* label);
+void detachTrendCharts();
+void feedTrendCharts(uint16_t series, const float* values);
 void drawScanlines();
 void flashButton(ButtonArea &btn, const char* label, ButtonStyle style);
 void scanlineWipeTransition();
 void parseDeviceIPs(const char* ipList);
 bool postDeviceSetting(int deviceIndex, const char* jsonBody);
 bool postDeviceRestart(int deviceIndex);
+bool postDevicePoint(int deviceIndex, int frequency, int coreVoltage);
+void runAutoTuner(int index);
+void runPowerGovernor();
+void runThermalGovernor(int index);
+void runBenchmark(int index);
+void runTariff();
+void runProfile(int index);
+void saveEnergy();
+bool localTime(struct tm &tm);
+float projectedDailyCost(float watts);
+float currentRate();
+float todayRateHours();
+bool benchmarkOwns(int index);
+void manualOverride(int index);
+void runAlerts(int index, bool online);
+void runWatchdog(int index);
+void startControlWorker();
+void pumpControlQueue(unsigned long now);
+int formatControlBody(char* buf, size_t size, const int values[CF_COUNT]);
+int startBulkSettings(const bool* selected, const BulkSetting &setting);
+int startBulkRestart(const bool* selected, uint32_t staggerMs);
+void pumpBulk(unsigned long now, uint32_t waitMs = 0);
+int fleetScreenIndex();
+void drawFleetScreen();
+void drawFleetTable();
+void handleFleetTouch(int x, int y);
+void drawRestartPrompt();
+uint16_t controlColor(int devIndex, uint8_t field, uint16_t normal);
+void printDeviceFan(int devIndex);
+void pumpAlertWebhook(unsigned long now);
+void startWebhookWorker();
+void drawAlertBanner();
 
 // UI helpers
 void drawScreenFrame(const char* title);
+void drawScreenTitle();
 void drawPanel(int x, int y, int w, int h, const char* title = nullptr);
 void drawArcGauge(int cx, int cy, int R, int r, float value, float minVal, float maxVal,
                    const char* label, const char* valueStr, const char* unit, uint16_t color);
@@ -355,6 +601,7 @@ void drawGlowText(int x, int y, const char* text, int size, uint16_t color) {
 }
 
 void drawScreenFrame(const char* title) {
+    detachTrendCharts();
     tft.fillScreen(CRT_BG);
     drawScanlines();
     tft.drawRect(SX(2), SY(2), SCR_W - SX(4), SCR_H - SY(4), CRT_DIM);
@@ -371,12 +618,49 @@ void drawScreenFrame(const char* title) {
     tft.print("AxeOS");
     tft.setFreeFont(NULL);
 
-    // Screen title (right-aligned)
+    strncpy(screenTitle, title, sizeof(screenTitle) - 1);
+    drawScreenTitle();
+    if (alerts.activeCount() > 0) drawAlertBanner();
+    else bannerVersion = alerts.version();
+}
+
+// Screen title (right-aligned)
+void drawScreenTitle() {
     tft.setTextColor(CRT_BRIGHT);
     tft.setTextSize(1);
-    int titleW = strlen(title) * 6;
+    int titleW = strlen(screenTitle) * 6;
     tft.setCursor(SCR_W - SX(10) - titleW, SY(12));
-    tft.print(title);
+    tft.print(screenTitle);
+}
+
+// Active alert over the title bar; the title comes back once everything has cleared
+void drawAlertBanner() {
+    bannerVersion = alerts.version();
+    int x = SX(78), y = SY(8), w = SCR_W - SX(86), h = SY(18);
+    tft.fillRect(x, y, w, h, PANEL_FILL);
+    uint8_t r, i;
+    if (!alerts.banner(r, i)) {
+        drawScreenTitle();
+        return;
+    }
+    const AlertRule &rule = alerts.rule(r);
+    char what[24];
+    if (rule.metric == AM_OFFLINE) snprintf(what, sizeof(what), "OFFLINE");
+    else snprintf(what, sizeof(what), "%s%c%g", ALERT_METRIC_NAMES[rule.metric], rule.below ? '<' : '>', rule.threshold);
+    for (char *c = what; *c; c++) *c = toupper(*c);
+    const DeviceInfo &dev = devices[i];
+    const char* name = dev.hostname[0] ? dev.hostname : dev.ip;
+    char text[64];
+    int more = alerts.activeCount() - 1;
+    if (more > 0) snprintf(text, sizeof(text), "! %.12s %s +%d", name, what, more);
+    else snprintf(text, sizeof(text), "! %.12s %s", name, what);
+    text[min((int)sizeof(text) - 1, (w - SX(8)) / 6)] = '\0';
+    tft.fillRoundRect(x, y, w, h, 3, CRT_RED_DARK);
+    tft.drawRoundRect(x, y, w, h, 3, CRT_RED);
+    tft.setTextColor(CRT_WHITE);
+    tft.setTextSize(1);
+    tft.setCursor(x + SX(4), y + (h - 8) / 2);
+    tft.print(text);
 }
 
 void drawPanel(int x, int y, int w, int h, const char* title) {
@@ -503,8 +787,9 @@ void drawButton(ButtonArea &btn, const char* label, ButtonStyle style) {
     tft.print(label);
 }
 
+// Overview, pool, one per device, fleet control, then the benchmark once it has something to show
 int getTotalScreens() {
-    return 2 + deviceCount;
+    return 3 + deviceCount + (benchmark.hasResults() ? 1 : 0);
 }
 
 uint16_t tempColor(float temp) {
@@ -520,6 +805,15 @@ void formatDiff(char* buf, int bufSize, double val) {
     else snprintf(buf, bufSize, "%.0f", val);
 }
 
+// Expected wait, hours -> "5.2h" / "41d" / "13y" / "2.1ky"
+void formatWait(char* buf, int bufSize, double hours) {
+    if (hours <= 0) snprintf(buf, bufSize, "--");
+    else if (hours < 48) snprintf(buf, bufSize, "%.1fh", hours);
+    else if (hours < 24 * 730) snprintf(buf, bufSize, "%.0fd", hours / 24);
+    else if (hours < 8766.0 * 10000) snprintf(buf, bufSize, "%.0fy", hours / 8766.0);
+    else snprintf(buf, bufSize, "%.1fky", hours / 8766000.0);
+}
+
 void formatShares(char* buf, int bufSize, int val) {
     if (val >= 1000000) snprintf(buf, bufSize, "%.1fM", val / 1000000.0);
     else if (val >= 1000) snprintf(buf, bufSize, "%.1fK", val / 1000.0);
@@ -543,60 +837,486 @@ void formatUptime(char* buf, int bufSize, int seconds) {
     else snprintf(buf, bufSize, "%dm", mins);
 }
 
+// Dotted local IP for the status bars, without building a String every update
+const char* localIpText() {
+    static char buf[16];
+    IPAddress ip = WiFi.localIP();
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    return buf;
+}
+
 // ===== AGGREGATE HELPERS =====
 
+// Thin wrappers over FleetStats: O(1), no scan of devices[]
+
 float getTotalHashrate() {
-    float total = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid) total += devices[i].hashRate;
-    }
-    return total;
+    return fleetStats.totalHashrate();
 }
 
 float getTotalPower() {
-    float total = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid) total += devices[i].power;
-    }
-    return total;
+    return fleetStats.totalPower();
 }
 
 int getValidDeviceCount() {
-    int count = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid) count++;
-    }
-    return count;
+    return fleetStats.online();
 }
 
 int getTotalSharesAccepted() {
-    int total = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid) total += devices[i].sharesAccepted;
-    }
-    return total;
+    return (int)fleetStats.sharesAccepted();
+}
+
+int getTotalSharesRejected() {
+    return (int)fleetStats.sharesRejected();
 }
 
 double getMaxBestSessionDiff() {
-    double maxDiff = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid && devices[i].bestSessionDiff > maxDiff)
-            maxDiff = devices[i].bestSessionDiff;
-    }
-    return maxDiff;
+    return fleetStats.maxBestSessionDiff();
 }
 
 double getMaxBestDiff() {
-    double maxDiff = 0;
+    return fleetStats.maxBestDiff();
+}
+
+FleetSample fleetSampleOf(int index) {
+    const DeviceInfo &dev = devices[index];
+    FleetSample s;
+    s.hashRate = fleet.hashRate[index];
+    s.power = fleet.power[index];
+    s.temperature = fleet.temperature[index];
+    s.sharesAccepted = (uint32_t)max(0, fleet.sharesAccepted[index]);
+    s.sharesRejected = (uint32_t)max(0, fleet.sharesRejected[index]);
+    s.bestDiff = dev.bestDiff;
+    s.bestSessionDiff = dev.bestSessionDiff;
+    return s;
+}
+
+// ===== HISTORY =====
+
+bool clockSynced() {
+    return time(nullptr) > 1700000000;
+}
+
+// Seconds for history timestamps: UNIX time once NTP has synced, uptime before that.
+// The jump at sync time simply restarts the tiers.
+uint32_t historyClock() {
+    if (clockSynced()) return (uint32_t)time(nullptr);
+    return millis() / 1000 + 1;
+}
+
+// Replay the on-flash log into the in-memory tiers (once, after the first NTP sync)
+void restoreHistoryFromLog() {
+    historyRestored = true;
+    if (!metricLog.ready()) return;
+    const HistTier &coarsest = HIST_TIERS[HIST_TIER_COUNT - 1];
+    uint32_t now = historyClock();
+    uint32_t span = coarsest.width * coarsest.slots;
+    unsigned long t0 = millis();
+    uint32_t n = 0;
+    MetricLogCursor cur;
+    if (!cur.open(metricLog, now > span ? now - span : 0, now + 1)) return;
+    MlogRecord r;
+    while (cur.next(r)) {
+        history.add(r.series, r.t, r.v);
+        if ((++n & 255) == 0) yield();
+    }
+    Serial.printf("HISTORY: restored %u samples from flash in %lums\n", (unsigned)n, millis() - t0);
+}
+
+// Persist anything still buffered in RAM before a deliberate reboot
+void prepareRestart() {
+    stopCapture();
+    metricLog.flush();
+    saveEnergy();
+    settings.flush();
+}
+
+// Fold the freshly fetched sample of one device, and the new fleet totals, into the history tiers
+void recordDeviceSample(int index) {
+    bool synced = clockSynced();
+    if (synced && !historyRestored) restoreHistoryFromLog();
+    uint32_t t = historyClock();
+    float v[HM_COUNT];
+    v[HM_HASHRATE] = fleet.hashRate[index];
+    v[HM_TEMP] = fleet.temperature[index];
+    v[HM_POWER] = fleet.power[index];
+    history.add(index, t, v);
+    if (synced && !replaying()) {
+        HeapTag tag(HT_LOG);        // the flash log opens and writes files; that is log work, not ingest
+        metricLog.append(index, t, v);
+    }
+    feedTrendCharts(index, v);
+
+    v[HM_HASHRATE] = getTotalHashrate();
+    v[HM_TEMP] = fleetStats.maxTemperature();
+    v[HM_POWER] = getTotalPower();
+    history.add(HIST_FLEET, t, v);
+    if (synced && !replaying()) {
+        HeapTag tag(HT_LOG);
+        metricLog.append(HIST_FLEET, t, v);
+    }
+    feedTrendCharts(HIST_FLEET, v);
+}
+
+// ===== TREND CHARTS =====
+
+// One chart column per sample of the series: the fleet gets a sample every fetch,
+// a single device once per round-robin pass
+uint32_t trendColumnSeconds(uint16_t series) {
+    uint32_t perFetch = UPDATE_INTERVAL / 1000;
+    if (series == HIST_FLEET) return perFetch;
+    return perFetch * max(1, deviceCount);
+}
+
+void attachTrendChart(TrendChart &chart, int x, int y, int w, int h, uint16_t series, uint8_t metric,
+                      const TrendStyle &style, const char* label) {
+    w = min(w, TREND_MAX_COLS);
+    tft.drawRect(x - 1, y - 1, w + 2, h + 2, CRT_DIM);
+    if (chart.attach(x, y, w, h, series, metric, style, label)) {
+        chart.load(history, historyClock(), trendColumnSeconds(series));
+    }
+}
+
+// Called whenever the screen is rebuilt; the owning screen re-attaches what it shows
+void detachTrendCharts() {
+    trendHash.detach();
+    trendTemp.detach();
+}
+
+void feedTrendCharts(uint16_t series, const float* values) {
+    if (trendHash.attached() && trendHash.series() == series) trendHash.push(values[trendHash.metric()]);
+    if (trendTemp.attached() && trendTemp.series() == series) trendTemp.push(values[trendTemp.metric()]);
+}
+
+// ===== AUTO-TUNE =====
+
+TuneSample tuneSampleOf(int index) {
+    const DeviceInfo &dev = devices[index];
+    TuneSample s;
+    s.hashRate = fleet.hashRate[index];
+    s.hashRate1h = dev.hashRate_1h;
+    s.power = fleet.power[index];
+    s.temperature = fleet.temperature[index];
+    s.vrTemp = dev.vrTemp;
+    s.vin = dev.voltage;
+    s.frequency = dev.frequency;
+    s.coreVoltage = dev.coreVoltage;
+    return s;
+}
+
+// Feed the fresh sample to the tuner and push any new setpoint it asks for
+void runAutoTuner(int index) {
+    int freq, mv;
+    uint32_t now = millis() / 1000;
+    if (!autoTuner.update(index, tuneSampleOf(index), now, freq, mv)) return;
+    autoTuner.applied(index, postDevicePoint(index, freq, mv), now);
+}
+
+// Manual FRQ / mV taps take the device back from the tuner, the benchmark and the governors
+void manualOverride(int index) {
+    int freq, mv;
+    if (autoTuner.active(index)) autoTuner.stop(index, millis() / 1000, freq, mv);
+    if (benchmarkOwns(index)) benchmark.abort(false);
+    powerGov.forget(index);
+    thermalGov.forget(index);
+    profiles.forget(index);
+}
+
+// ===== THERMAL =====
+
+// Fan first; frequency only once the fan is flat out. PATCHes only on a changed target.
+void runThermalGovernor(int index) {
+    DeviceInfo &dev = devices[index];
+    ThermalSample sample = {fleet.temperature[index], dev.fanSpeed, dev.frequency};
+    ThermalAction act;
+    uint32_t now = millis() / 1000;
+    if (!thermalGov.evaluate(index, sample, now, act)) return;
+    char body[48];
+    if (act.fan >= 0) {
+        snprintf(body, sizeof(body), "{\"autofanspeed\":0,\"fanspeed\":%d}", act.fan);
+        thermalGov.appliedFan(index, act.fan, postDeviceSetting(index, body));
+    }
+    if (act.frequency >= 0) {
+        // Heat wins over an efficiency search or sweep in progress
+        if (act.deltaMHz < 0 && autoTuner.active(index)) {
+            int freq, mv;
+            autoTuner.stop(index, now, freq, mv);
+        }
+        if (act.deltaMHz < 0 && benchmarkOwns(index)) benchmark.abort(false);
+        snprintf(body, sizeof(body), "{\"frequency\":%d}", act.frequency);
+        bool ok = postDeviceSetting(index, body);
+        thermalGov.appliedFreq(index, act.deltaMHz, ok, now);
+        // runProfile() looks at the same sample next; let it see the new setpoint
+        if (ok) dev.frequency = act.frequency;
+    }
+}
+
+void loadFanCurves() {
+    char key[24];
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        snprintf(key, sizeof(key), "fanCurve%d", i);
+        String curve = prefs.getString(key, "");
+        if (curve.length() > 0) thermalGov.curve(i).parse(curve.c_str());
+    }
+}
+
+// ===== POWER CAP =====
+
+// One frequency step per call at most; the governor rate limits itself
+void runPowerGovernor() {
+    if (!powerGov.enabled()) return;
+    GovDevice govDevs[MAX_DEVICES];
     for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid && devices[i].bestDiff > maxDiff)
-            maxDiff = devices[i].bestDiff;
+        govDevs[i].online = fleet.valid[i];
+        govDevs[i].busy = autoTuner.active(i) || benchmarkOwns(i);
+        govDevs[i].frequency = devices[i].frequency;
+        govDevs[i].hashRate = fleet.hashRate[i];
+        govDevs[i].power = fleet.power[i];
+    }
+    GovAction act;
+    uint32_t now = millis() / 1000;
+    if (!powerGov.evaluate(govDevs, deviceCount, fleetStats.totalPower(), now, act)) return;
+    // The budget wins over an efficiency search or sweep in progress
+    if (govDevs[act.device].busy) {
+        int freq, mv;
+        if (autoTuner.active(act.device)) autoTuner.stop(act.device, now, freq, mv);
+        if (benchmarkOwns(act.device)) benchmark.abort(false);
+    }
+    char body[32];
+    snprintf(body, sizeof(body), "{\"frequency\":%d}", act.frequency);
+    powerGov.applied(act, postDeviceSetting(act.device, body), now);
+}
+
+// ===== BENCHMARK =====
+
+BenchSample benchSampleOf(int index) {
+    const DeviceInfo &dev = devices[index];
+    BenchSample s;
+    s.hashRate = fleet.hashRate[index];
+    s.power = fleet.power[index];
+    s.temperature = fleet.temperature[index];
+    s.vrTemp = dev.vrTemp;
+    s.vin = dev.voltage;
+    s.sharesAccepted = (uint32_t)max(0, fleet.sharesAccepted[index]);
+    s.sharesRejected = (uint32_t)max(0, fleet.sharesRejected[index]);
+    s.frequency = dev.frequency;
+    s.coreVoltage = dev.coreVoltage;
+    return s;
+}
+
+bool benchmarkOwns(int index) {
+    return benchmark.running() && benchmark.device() == index;
+}
+
+// Same shape as runAutoTuner: the sweep decides, we PATCH and report back
+void runBenchmark(int index) {
+    if (!benchmarkOwns(index)) return;
+    int freq, mv;
+    uint32_t now = millis() / 1000;
+    if (!benchmark.update(benchSampleOf(index), now, freq, mv)) return;
+    benchmark.applied(postDevicePoint(index, freq, mv), now);
+}
+
+// ===== TARIFF / ENERGY =====
+
+bool localTime(struct tm &tm) {
+    if (!clockSynced()) return false;
+    time_t t = time(nullptr);
+    localtime_r(&t, &tm);
+    return true;
+}
+
+// Rate in force right now (base rate until NTP has synced)
+float currentRate() {
+    struct tm tm;
+    if (!localTime(tm)) return electricityRate;
+    return tariff.rateAt(tm.tm_wday, tm.tm_hour * 60 + tm.tm_min);
+}
+
+// Rate summed over today's tariff windows; recomputed when the day or the tariff changes
+float todayRateHours() {
+    struct tm tm;
+    int wday = localTime(tm) ? tm.tm_wday : 0;
+    if (wday != rateHoursDay) {
+        rateHoursCache = tariff.dailyRateHours(wday);
+        rateHoursDay = wday;
+    }
+    return rateHoursCache;
+}
+
+// Cost of a whole day at this draw, through today's tariff windows
+float projectedDailyCost(float watts) {
+    return watts / 1000.0f * todayRateHours();
+}
+
+// Once per fetch cycle: integrate fleet power at the rate in force and pick the profile.
+// Until NTP has synced the base rate and 100 % apply.
+void runTariff() {
+    struct tm tm;
+    bool local = localTime(tm);
+    int minute = local ? tm.tm_hour * 60 + tm.tm_min : 0;
+    energyMeter.add(fleetStats.totalPower(), currentRate(), millis() / 1000, local ? energyDay(tm) : -1);
+    profiles.setPct(local ? tariff.pctAt(tm.tm_wday, minute) : 100);
+    // No-ops unless something moved
+    profit.setNetwork(pool.networkDifficulty, pool.btcPrice, blockReward);
+    profit.setRateHours(todayRateHours());
+    if (energyMeter.dirty() && millis() - lastEnergySave >= ENERGY_SAVE_INTERVAL) saveEnergy();
+}
+
+void saveEnergy() {
+    prefs.putBytes("energy", &energyMeter.totals(), sizeof(EnergyTotals));
+    energyMeter.saved();
+    lastEnergySave = millis();
+}
+
+// Move a device toward base x profile, net of what the governors have cut.
+// Devices being tuned, benchmarked or changed from the screen are left alone and re-learned afterwards.
+void runProfile(int index) {
+    if (autoTuner.active(index) || benchmarkOwns(index) || controlQueue.pending(index)) {
+        profiles.forget(index);
+        return;
+    }
+    int cut = powerGov.cutMHz(index) + thermalGov.cutMHz(index);
+    int freq;
+    if (!profiles.evaluate(index, devices[index].frequency, cut, millis() / 1000, freq)) return;
+    char body[32];
+    snprintf(body, sizeof(body), "{\"frequency\":%d}", freq);
+    profiles.applied(index, freq, postDeviceSetting(index, body));
+}
+
+// ===== ALERTS =====
+
+// Rules see every fetch; an offline device is fed in on each failed fetch
+void runAlerts(int index, bool online) {
+    const DeviceInfo &dev = devices[index];
+    AlertSample s;
+    s.online = online;
+    s.temperature = fleet.temperature[index];
+    s.vrTemp = dev.vrTemp;
+    s.hashRate = fleet.hashRate[index];
+    s.hashRate1h = dev.hashRate_1h;
+    s.vin = dev.voltage;
+    s.power = fleet.power[index];
+    s.fanSpeed = dev.fanSpeed;
+    s.sharesAccepted = (uint32_t)max(0, fleet.sharesAccepted[index]);
+    s.sharesRejected = (uint32_t)max(0, fleet.sharesRejected[index]);
+    alerts.ingest(index, s, millis() / 1000);
+}
+
+// POSTs off the UI core; works on its own copy of the URL and body
+void webhookWorker(void*) {
+    WebhookJob job;
+    for (;;) {
+        if (xQueueReceive(webhookJobs, &job, portMAX_DELAY) != pdTRUE) continue;
+        HTTPClient http;
+        http.setTimeout(3000);
+        WiFiClientSecure secure;
+        if (strncmp(job.url, "https://", 8) == 0) {
+            secure.setInsecure();
+            http.begin(secure, job.url);
+        } else {
+            http.begin(job.url);
+        }
+        http.addHeader("Content-Type", "application/json");
+        int code = http.POST((uint8_t*)job.body, job.len);
+        http.end();
+        xQueueSend(webhookResults, &code, portMAX_DELAY);
+    }
+}
+
+void startWebhookWorker() {
+    webhookJobs = xQueueCreate(1, sizeof(WebhookJob));
+    webhookResults = xQueueCreate(1, sizeof(int));
+    // Stack sized for a TLS handshake, like the control worker
+    xTaskCreatePinnedToCore(webhookWorker, "webhook", 8192, nullptr, 1, nullptr, 0);
+}
+
+// The oldest queued event is handed to webhookWorker and consumed once it was delivered;
+// failed deliveries back off and are dropped after a few tries
+void pumpAlertWebhook(unsigned long now) {
+    int code;
+    if (webhookBusy) {
+        if (xQueueReceive(webhookResults, &code, 0) != pdTRUE) return;
+        webhookBusy = false;
+        if (code >= 200 && code < 300) {
+            alerts.consume();
+            alertAttempts = 0;
+            return;
+        }
+        if (++alertAttempts >= ALERT_HOOK_ATTEMPTS) {
+            Serial.printf("ALERT: webhook failed (%d), dropping event\n", code);
+            alerts.consume();
+            alertAttempts = 0;
+        }
+        alertRetryAt = now + ALERT_HOOK_RETRY_MS;
+        return;
+    }
+
+    AlertEvent e;
+    if (!alerts.next(e)) return;
+    if (alertWebhook.length() == 0) {
+        alerts.consume();
+        return;
     }
-    return maxDiff;
+    if (now < alertRetryAt || WiFi.status() != WL_CONNECTED) return;
+
+    ScratchJsonDocument doc(384);
+    char rule[96];
+    alerts.formatRule(e.rule, rule, sizeof(rule));
+    doc["event"] = e.raised ? "raised" : "cleared";
+    doc["device"] = e.device;
+    doc["hostname"] = devices[e.device].hostname;
+    doc["ip"] = devices[e.device].ip;
+    doc["metric"] = ALERT_METRIC_NAMES[alerts.rule(e.rule).metric];
+    doc["rule"] = rule;
+    doc["value"] = e.value;
+    doc["age"] = millis() / 1000 - e.t;
+    if (clockSynced()) doc["time"] = (uint32_t)time(nullptr) - (millis() / 1000 - e.t);
+    ScratchJsonText body(doc);
+
+    WebhookJob job;
+    strncpy(job.url, alertWebhook.c_str(), sizeof(job.url) - 1);
+    job.url[sizeof(job.url) - 1] = '\0';
+    job.len = min(body.length(), sizeof(job.body));
+    memcpy(job.body, body.c_str(), job.len);
+    if (xQueueSend(webhookJobs, &job, 0) == pdTRUE) webhookBusy = true;
+}
+
+// ===== WATCHDOG =====
+
+// Restart a miner that answers but no longer mines. A sweep is left to its own safety
+// limits; a tuning run is stopped, and a safe restart takes the device back from the
+// governors and profiles like a manual frequency change would.
+void runWatchdog(int index) {
+    if (benchmarkOwns(index)) return;
+    const DeviceInfo &dev = devices[index];
+    WatchSample s = {fleet.hashRate[index], (uint32_t)max(0, fleet.sharesAccepted[index]), (uint32_t)max(0, dev.uptimeSeconds), dev.frequency};
+    WatchDecision d;
+    uint32_t now = millis() / 1000;
+    if (!watchdog.evaluate(index, s, now, d)) return;
+    if (d.frequency >= 0) {
+        manualOverride(index);
+        char body[32];
+        snprintf(body, sizeof(body), "{\"frequency\":%d}", d.frequency);
+        if (!postDeviceSetting(index, body)) d.frequency = -1;
+    } else if (autoTuner.active(index)) {
+        int freq, mv;
+        autoTuner.stop(index, now, freq, mv);
+    }
+    watchdog.applied(index, d, postDeviceRestart(index), now);
 }
 
 // ===== TOUCH EFFECTS =====
 
+// First RST tap: ask for the second one
+void drawRestartPrompt() {
+    tft.fillRoundRect(btnDevRestart.x, btnDevRestart.y, btnDevRestart.w, btnDevRestart.h, 3, CRT_RED_DARK);
+    tft.drawRoundRect(btnDevRestart.x, btnDevRestart.y, btnDevRestart.w, btnDevRestart.h, 3, CRT_YELLOW);
+    tft.setTextColor(CRT_YELLOW);
+    tft.setTextSize(1);
+    tft.setCursor(btnDevRestart.x + 4, btnDevRestart.y + 6);
+    tft.print("AGAIN?");
+}
+
 void flashButton(ButtonArea &btn, const char* label, ButtonStyle style) {
     // Pressed state
     uint16_t pressedFill, pressedBorder;
@@ -637,19 +1357,33 @@ void scanlineWipeTransition() {
 
 void parseDeviceIPs(const char* ipList) {
     deviceCount = 0;
-    char buf[320];
+    fleetStats.reset();
+    profit.reset();
+    alerts.reset();
+    watchdog.reset();
+    controlQueue.reset();
+    // Jobs point at device indices that are about to change meaning
+    bulk.cancel(millis());
+    for (int k = 0; k < MAX_DEVICES; k++) bulkApplied[k] = true;
+    char buf[DEVICE_LIST_LEN];
     strncpy(buf, ipList, sizeof(buf) - 1);
     buf[sizeof(buf) - 1] = '\0';
     char* tok = strtok(buf, ",");
-    while (tok && deviceCount < 8) {
+    while (tok && deviceCount < MAX_DEVICES) {
         while (*tok == ' ') tok++;
         // Trim trailing spaces
         char* end = tok + strlen(tok) - 1;
         while (end > tok && *end == ' ') { *end = '\0'; end--; }
         if (strlen(tok) > 0) {
-            strncpy(devices[deviceCount].ip, tok, 39);
-            devices[deviceCount].ip[39] = '\0';
-            devices[deviceCount].valid = false;
+            DeviceInfo &dev = devices[deviceCount];
+            strncpy(dev.ip, tok, sizeof(dev.ip) - 1);
+            dev.ip[sizeof(dev.ip) - 1] = '\0';
+            dev.port = deviceHostPort(dev.ip, dev.host, sizeof(dev.host));
+            // From tok, cut to what ip holds: both URLs then fit by construction
+            int n = sizeof(dev.ip) - 1;
+            snprintf(dev.url, sizeof(dev.url), "http://%.*s/api/system", n, tok);
+            snprintf(dev.infoUrl, sizeof(dev.infoUrl), "http://%.*s/api/system/info", n, tok);
+            fleet.clear(deviceCount);
             deviceCount++;
         }
         tok = strtok(NULL, ",");
@@ -827,7 +1561,7 @@ void drawMainUI() {
     tft.print("|");
     tft.setTextColor(CRT_MID);
     tft.setCursor(SX(56), statusY + SY(7));
-    tft.print(WiFi.localIP().toString());
+    tft.print(localIpText());
     tft.setTextColor(CRT_DIM);
     tft.setCursor(SX(164), statusY + SY(7));
     tft.print("|");
@@ -844,6 +1578,12 @@ void drawMainUI() {
     tft.setCursor(SCR_W / 2 - 36, SY(196));
     tft.print("bitaxe.local");
 
+    // Fleet trends either side of the URL hint
+    int trendY = SY(193), trendH = SY(18);
+    int trendW = SCR_W / 2 - SX(42) - SX(10);
+    attachTrendChart(trendHash, SX(10), trendY, trendW, trendH, HIST_FLEET, HM_HASHRATE, TREND_HASH_STYLE, "HR");
+    attachTrendChart(trendTemp, SCR_W / 2 + SX(42), trendY, trendW, trendH, HIST_FLEET, HM_TEMP, TREND_TEMP_STYLE, "MAX C");
+
     drawNavBar(0, getTotalScreens());
 }
 
@@ -936,7 +1676,7 @@ void updateDisplay() {
     tft.print("|");
     tft.setTextColor(CRT_MID);
     tft.setCursor(SX(56), statusY + SY(7));
-    tft.print(WiFi.localIP().toString());
+    tft.print(localIpText());
     tft.setTextColor(CRT_DIM);
     tft.setCursor(SX(164), statusY + SY(7));
     tft.print("|");
@@ -950,6 +1690,21 @@ void updateDisplay() {
 
 // ===== SCREEN 1: BITCOIN/PRICE PAGE =====
 
+// Fleet expected time to block and net profit, under the NET DIFF value
+void drawProfitLines(int x, int w) {
+    const ProfitFigures &f = profit.fleet();
+    char buf[16];
+    tft.fillRect(x + SX(4), SY(166), w - SX(8), SY(22), PANEL_FILL);
+    tft.setTextSize(1);
+    tft.setTextColor(CRT_DIM);
+    tft.setCursor(x + SX(6), SY(167));
+    formatWait(buf, sizeof(buf), f.hoursToBlock);
+    tft.printf("BLK %s", buf);
+    tft.setCursor(x + SX(6), SY(178));
+    tft.setTextColor(f.profitPerDay >= 0 ? CRT_BRIGHT : CRT_RED);
+    tft.printf("P/L %s$%.2f/d", f.profitPerDay < 0 ? "-" : "+", fabsf(f.profitPerDay));
+}
+
 void drawPoolScreen() {
     drawScreenFrame("COIN / NETWORK");
 
@@ -988,8 +1743,8 @@ void drawPoolScreen() {
     tft.setCursor(SX(110), SY(58));
     tft.print(coins[selectedCoin].name);
     tft.setCursor(SX(38), SY(70));
-    if (deviceCount > 0 && devices[0].valid && devices[0].stratumURL.length() > 0) {
-        tft.printf("POOL: %s:%d", devices[0].stratumURL.c_str(), devices[0].stratumPort);
+    if (deviceCount > 0 && fleet.valid[0] && devices[0].stratumURL[0]) {
+        tft.printf("POOL: %s:%d", devices[0].stratumURL, devices[0].stratumPort);
     } else {
         tft.print("POOL: --");
     }
@@ -1026,10 +1781,7 @@ void drawPoolScreen() {
     // Bottom row: Error Rate | Net Diff | Daily Cost
     float errPct = 0;
     int totalAcc = getTotalSharesAccepted();
-    int totalRej = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid) totalRej += devices[i].sharesRejected;
-    }
+    int totalRej = getTotalSharesRejected();
     if (totalAcc + totalRej > 0) errPct = (float)totalRej / (float)(totalAcc + totalRej) * 100.0;
 
     int botW = (SCR_W - SX(24)) / 3;
@@ -1052,6 +1804,9 @@ void drawPoolScreen() {
     tft.print(errBuf);
     tft.setTextSize(1);
     drawHBar(SX(14), SY(164), botW - SX(14), SY(6), errPct, 10.0, errColor, NULL);
+    tft.setTextColor(CRT_DIM);
+    tft.setCursor(SX(14), SY(174));
+    tft.printf("1H %.2f%%", fleetStats.rejectPct(60));
 
     int bot2X = SX(8) + botW + SX(4);
     drawPanel(bot2X, botY, botW, botH, "NET DIFF");
@@ -1065,17 +1820,18 @@ void drawPoolScreen() {
         tft.print("Loading...");
     }
     tft.setTextSize(1);
+    drawProfitLines(bot2X, botW);
 
     int bot3X = bot2X + botW + SX(4);
     int bot3W = SCR_W - bot3X - SX(8);
     drawPanel(bot3X, botY, bot3W, botH, "DAILY COST");
     float totalPower = getTotalPower();
-    float dailyKwh = totalPower * 24.0 / 1000.0;
-    float dailyCost = dailyKwh * electricityRate;
+    float dailyCost = projectedDailyCost(totalPower);
     tft.setTextColor(CRT_MID);
     tft.setTextSize(1);
     tft.setCursor(bot3X + SX(6), SY(142));
-    tft.printf("%.0fW", totalPower);
+    if (powerGov.enabled()) tft.printf("%.0f/%.0fW", totalPower, powerGov.cap());
+    else tft.printf("%.0fW", totalPower);
     char costBuf[16];
     snprintf(costBuf, sizeof(costBuf), "$%.2f/d", dailyCost);
     tft.setTextColor(CRT_WHITE);
@@ -1084,7 +1840,7 @@ void drawPoolScreen() {
     tft.print(costBuf);
     tft.setTextSize(1);
     char rateBuf[16];
-    snprintf(rateBuf, sizeof(rateBuf), "@$%.2f", electricityRate);
+    snprintf(rateBuf, sizeof(rateBuf), "@$%.2f", currentRate());
     tft.setTextColor(CRT_DIM);
     tft.setCursor(bot3X + SX(6), SY(172));
     tft.print(rateBuf);
@@ -1122,8 +1878,8 @@ void updatePoolScreen() {
     tft.setTextColor(CRT_DIM);
     tft.setTextSize(1);
     tft.setCursor(SX(38), SY(70));
-    if (deviceCount > 0 && devices[0].valid && devices[0].stratumURL.length() > 0) {
-        tft.printf("POOL: %s:%d", devices[0].stratumURL.c_str(), devices[0].stratumPort);
+    if (deviceCount > 0 && fleet.valid[0] && devices[0].stratumURL[0]) {
+        tft.printf("POOL: %s:%d", devices[0].stratumURL, devices[0].stratumPort);
     } else {
         tft.print("POOL: --");
     }
@@ -1160,10 +1916,7 @@ void updatePoolScreen() {
     tft.fillRect(SX(12), SY(141), SX(90), SY(28), PANEL_FILL);
     float errPct = 0;
     int totalAcc = getTotalSharesAccepted();
-    int totalRej = 0;
-    for (int i = 0; i < deviceCount; i++) {
-        if (devices[i].valid) totalRej += devices[i].sharesRejected;
-    }
+    int totalRej = getTotalSharesRejected();
     if (totalAcc + totalRej > 0) errPct = (float)totalRej / (float)(totalAcc + totalRej) * 100.0;
     uint16_t errColor = CRT_BRIGHT;
     if (errPct > 5) errColor = CRT_RED;
@@ -1177,6 +1930,10 @@ void updatePoolScreen() {
     tft.setTextSize(1);
     tft.fillRect(SX(14), SY(164), botW - SX(14), SY(6), PANEL_FILL);
     drawHBar(SX(14), SY(164), botW - SX(14), SY(6), errPct, 10.0, errColor, NULL);
+    tft.fillRect(SX(14), SY(173), botW - SX(16), SY(10), PANEL_FILL);
+    tft.setTextColor(CRT_DIM);
+    tft.setCursor(SX(14), SY(174));
+    tft.printf("1H %.2f%%", fleetStats.rejectPct(60));
 
     // Network difficulty
     int bot2X = SX(8) + botW + SX(4);
@@ -1191,17 +1948,18 @@ void updatePoolScreen() {
         tft.print("Loading...");
     }
     tft.setTextSize(1);
+    drawProfitLines(bot2X, botW);
 
     // Daily cost
     int bot3X = bot2X + botW + SX(4);
     tft.fillRect(bot3X + SX(4), SY(139), SX(86), SY(44), PANEL_FILL);
     float totalPower = getTotalPower();
-    float dailyKwh = totalPower * 24.0 / 1000.0;
-    float dailyCost = dailyKwh * electricityRate;
+    float dailyCost = projectedDailyCost(totalPower);
     tft.setTextColor(CRT_MID);
     tft.setTextSize(1);
     tft.setCursor(bot3X + SX(6), SY(142));
-    tft.printf("%.0fW", totalPower);
+    if (powerGov.enabled()) tft.printf("%.0f/%.0fW", totalPower, powerGov.cap());
+    else tft.printf("%.0fW", totalPower);
     char costBuf[16];
     snprintf(costBuf, sizeof(costBuf), "$%.2f/d", dailyCost);
     tft.setTextColor(CRT_WHITE);
@@ -1210,7 +1968,7 @@ void updatePoolScreen() {
     tft.print(costBuf);
     tft.setTextSize(1);
     char rateBuf[16];
-    snprintf(rateBuf, sizeof(rateBuf), "@$%.2f", electricityRate);
+    snprintf(rateBuf, sizeof(rateBuf), "@$%.2f", currentRate());
     tft.setTextColor(CRT_DIM);
     tft.setCursor(bot3X + SX(6), SY(172));
     tft.print(rateBuf);
@@ -1220,19 +1978,41 @@ void updatePoolScreen() {
 
 // ===== SCREEN 2+: INDIVIDUAL DEVICE SCREENS =====
 
+// A value being changed from the screen: yellow until read back, red for a moment if the device refused
+uint16_t controlColor(int devIndex, uint8_t field, uint16_t normal) {
+    if (controlQueue.pending(devIndex, field)) return CRT_YELLOW;
+    if (controlQueue.outcome(devIndex, millis()) == CQ_REJECTED) return CRT_RED;
+    return normal;
+}
+
+// FAN slot of the info line: the fanspeed target while one is pending, else rpm (or RSSI without a tach)
+void printDeviceFan(int devIndex) {
+    const DeviceInfo &dev = devices[devIndex];
+    if (controlQueue.pending(devIndex, CF_FAN)) {
+        tft.setTextColor(CRT_YELLOW);
+        tft.printf("FAN:%d%%", controlQueue.shown(devIndex, CF_FAN, dev.fanSpeed));
+    } else if (dev.fanRpm > 0) {
+        tft.printf("FAN:%d", dev.fanRpm);
+    } else {
+        tft.printf("RSSI:%d", dev.wifiRSSI);
+    }
+}
+
 void drawDeviceScreen(int devIndex) {
     if (devIndex >= deviceCount) return;
     DeviceInfo &dev = devices[devIndex];
+    float hashRate = fleet.hashRate[devIndex], temperature = fleet.temperature[devIndex], power = fleet.power[devIndex];
+    int shares = fleet.sharesAccepted[devIndex];
 
     char title[40];
-    if (dev.valid && dev.hostname.length() > 0) {
-        snprintf(title, sizeof(title), "WORKER: %s", dev.hostname.c_str());
+    if (fleet.valid[devIndex] && dev.hostname[0]) {
+        snprintf(title, sizeof(title), "WORKER: %s", dev.hostname);
     } else {
         snprintf(title, sizeof(title), "WORKER: %s", dev.ip);
     }
     drawScreenFrame(title);
 
-    if (!dev.valid) {
+    if (!fleet.valid[devIndex]) {
         drawGlowText(SX(60), SY(80), "DEVICE OFFLINE", 1, CRT_RED);
         tft.setTextColor(CRT_DIM);
         tft.setTextSize(1);
@@ -1255,19 +2035,23 @@ void drawDeviceScreen(int devIndex) {
 
         int gaugeR = SS(29), gauger = SS(22);
         char hashBuf[16]; const char* hashUnit;
-        if (dev.hashRate >= 1000) { snprintf(hashBuf, 16, "%.2f", dev.hashRate/1000.0); hashUnit = "TH/s"; }
-        else                      { snprintf(hashBuf, 16, "%.0f", dev.hashRate);         hashUnit = "GH/s"; }
-        drawArcGauge(SCR_W/4,     SY(88), gaugeR, gauger, dev.hashRate,    0, 1000, "", hashBuf, hashUnit,      CRT_BRIGHT);
-        char tempBuf[16]; snprintf(tempBuf, 16, "%.1f", dev.temperature);
-        drawArcGauge(SCR_W*3/4,   SY(88), gaugeR, gauger, dev.temperature, 0, 80,   "", tempBuf, "C",           tempColor(dev.temperature));
+        if (hashRate >= 1000) { snprintf(hashBuf, 16, "%.2f", hashRate/1000.0); hashUnit = "TH/s"; }
+        else                  { snprintf(hashBuf, 16, "%.0f", hashRate);         hashUnit = "GH/s"; }
+        drawArcGauge(SCR_W/4,     SY(88), gaugeR, gauger, hashRate,    0, 1000, "", hashBuf, hashUnit,      CRT_BRIGHT);
+        char tempBuf[16]; snprintf(tempBuf, 16, "%.1f", temperature);
+        drawArcGauge(SCR_W*3/4,   SY(88), gaugeR, gauger, temperature, 0, 80,   "", tempBuf, "C",           tempColor(temperature));
+
+        // Trends between the gauges
+        attachTrendChart(trendHash, SX(108), SY(65), SX(104), SY(25), devIndex, HM_HASHRATE, TREND_HASH_STYLE, "HR");
+        attachTrendChart(trendTemp, SX(108), SY(93), SX(104), SY(25), devIndex, HM_TEMP,     TREND_TEMP_STYLE, "C");
 
         tft.setTextColor(CRT_MID); tft.setTextSize(1);
         tft.setCursor(SX(10), SY(121));  tft.printf("IP:%s", dev.ip);
-        tft.setTextColor(CRT_BRIGHT);
-        tft.setCursor(SX(148), SY(121)); tft.printf("CORE:%dmV", dev.coreVoltage);
+        tft.setTextColor(controlColor(devIndex, CF_VOLT, CRT_BRIGHT));
+        tft.setCursor(SX(148), SY(121)); tft.printf("CORE:%dmV", controlQueue.shown(devIndex, CF_VOLT, dev.coreVoltage));
         tft.setTextColor(CRT_MID);
         tft.setCursor(SX(240), SY(121));
-        if (dev.fanRpm > 0) tft.printf("FAN:%d", dev.fanRpm); else tft.printf("RSSI:%d", dev.wifiRSSI);
+        printDeviceFan(devIndex);
 
         int perfY = SY(130), perfH = SY(72);
         drawPanel(SX(8), perfY, SCR_W - SX(16), perfH, "PERFORMANCE");
@@ -1275,12 +2059,13 @@ void drawDeviceScreen(int devIndex) {
         int row1Y = SY(144);
         tft.setTextColor(CRT_DIM); tft.setTextSize(1);
         tft.setCursor(SX(14), row1Y+2); tft.print("PWR");
-        tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row1Y+2); tft.printf("%.1fW", dev.power);
-        drawHBar(barX, row1Y, barW, barH, dev.power, 30.0, CRT_BRIGHT, NULL);
+        tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row1Y+2); tft.printf("%.1fW", power);
+        drawHBar(barX, row1Y, barW, barH, power, 30.0, CRT_BRIGHT, NULL);
         int row2Y = row1Y + rowSpacing;
         tft.setTextColor(CRT_DIM); tft.setCursor(SX(14), row2Y+2); tft.print("FRQ");
-        tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row2Y+2); tft.printf("%dM", dev.frequency);
-        drawHBar(barX, row2Y, barW, barH, (float)dev.frequency, 1200.0, CRT_BRIGHT, NULL);
+        int freq = controlQueue.shown(devIndex, CF_FREQ, dev.frequency);
+        tft.setTextColor(controlColor(devIndex, CF_FREQ, CRT_MID)); tft.setCursor(SX(38), row2Y+2); tft.printf("%dM", freq);
+        drawHBar(barX, row2Y, barW, barH, (float)freq, 1200.0, CRT_BRIGHT, NULL);
         int row3Y = row2Y + rowSpacing;
         tft.setTextColor(CRT_DIM); tft.setCursor(SX(14), row3Y+2); tft.print("VIN");
         tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row3Y+2); tft.printf("%.2fV", dev.voltage);
@@ -1288,28 +2073,32 @@ void drawDeviceScreen(int devIndex) {
         drawHBar(barX, row3Y, barW, barH, dev.voltage, 5.5, vinColor, NULL);
         int row4Y = row3Y + rowSpacing;
         tft.setTextColor(CRT_DIM); tft.setCursor(SX(14), row4Y+2); tft.print("SHR");
-        char sBuf[16]; formatShares(sBuf, sizeof(sBuf), dev.sharesAccepted);
+        char sBuf[16]; formatShares(sBuf, sizeof(sBuf), shares);
         tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row4Y+2); tft.print(sBuf);
-        drawHBar(barX, row4Y, barW, barH, (float)dev.sharesAccepted, (float)max(1, dev.sharesAccepted)*1.2f, CRT_BRIGHT, NULL);
+        drawHBar(barX, row4Y, barW, barH, (float)shares, (float)max(1, shares)*1.2f, CRT_BRIGHT, NULL);
     }
 #else
     // 320x240: gauges top, stats middle, controls bottom
     {
         int gaugeR = SS(26), gauger = SS(20);
         char hashBuf[16]; const char* hashUnit;
-        if (dev.hashRate >= 1000) { snprintf(hashBuf, 16, "%.2f", dev.hashRate/1000.0); hashUnit = "TH/s"; }
-        else                      { snprintf(hashBuf, 16, "%.0f", dev.hashRate);         hashUnit = "GH/s"; }
-        drawArcGauge(SCR_W/4,   SY(52), gaugeR, gauger, dev.hashRate,    0, 1000, "", hashBuf, hashUnit, CRT_BRIGHT);
-        char tempBuf[16]; snprintf(tempBuf, 16, "%.1f", dev.temperature);
-        drawArcGauge(SCR_W*3/4, SY(52), gaugeR, gauger, dev.temperature, 0, 80,   "", tempBuf, "C",      tempColor(dev.temperature));
+        if (hashRate >= 1000) { snprintf(hashBuf, 16, "%.2f", hashRate/1000.0); hashUnit = "TH/s"; }
+        else                  { snprintf(hashBuf, 16, "%.0f", hashRate);         hashUnit = "GH/s"; }
+        drawArcGauge(SCR_W/4,   SY(52), gaugeR, gauger, hashRate,    0, 1000, "", hashBuf, hashUnit, CRT_BRIGHT);
+        char tempBuf[16]; snprintf(tempBuf, 16, "%.1f", temperature);
+        drawArcGauge(SCR_W*3/4, SY(52), gaugeR, gauger, temperature, 0, 80,   "", tempBuf, "C",      tempColor(temperature));
+
+        // Trends between the gauges
+        attachTrendChart(trendHash, SX(112), SY(32), SX(96), SY(22), devIndex, HM_HASHRATE, TREND_HASH_STYLE, "HR");
+        attachTrendChart(trendTemp, SX(112), SY(58), SX(96), SY(22), devIndex, HM_TEMP,     TREND_TEMP_STYLE, "C");
 
         tft.setTextColor(CRT_MID); tft.setTextSize(1);
         tft.setCursor(SX(10), SY(92));  tft.printf("IP:%s", dev.ip);
-        tft.setTextColor(CRT_BRIGHT);
-        tft.setCursor(SX(148), SY(92)); tft.printf("CORE:%dmV", dev.coreVoltage);
+        tft.setTextColor(controlColor(devIndex, CF_VOLT, CRT_BRIGHT));
+        tft.setCursor(SX(148), SY(92)); tft.printf("CORE:%dmV", controlQueue.shown(devIndex, CF_VOLT, dev.coreVoltage));
         tft.setTextColor(CRT_MID);
         tft.setCursor(SX(240), SY(92));
-        if (dev.fanRpm > 0) tft.printf("FAN:%d", dev.fanRpm); else tft.printf("RSSI:%d", dev.wifiRSSI);
+        printDeviceFan(devIndex);
 
         int perfY = SY(104), perfH = SY(68);
         drawPanel(SX(8), perfY, SCR_W - SX(16), perfH, "PERFORMANCE");
@@ -1317,12 +2106,13 @@ void drawDeviceScreen(int devIndex) {
         int row1Y = SY(118);
         tft.setTextColor(CRT_DIM); tft.setTextSize(1);
         tft.setCursor(SX(14), row1Y+2); tft.print("PWR");
-        tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row1Y+2); tft.printf("%.1fW", dev.power);
-        drawHBar(barX, row1Y, barW, barH, dev.power, 30.0, CRT_BRIGHT, NULL);
+        tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row1Y+2); tft.printf("%.1fW", power);
+        drawHBar(barX, row1Y, barW, barH, power, 30.0, CRT_BRIGHT, NULL);
         int row2Y = row1Y + rowSpacing;
         tft.setTextColor(CRT_DIM); tft.setCursor(SX(14), row2Y+2); tft.print("FRQ");
-        tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row2Y+2); tft.printf("%dM", dev.frequency);
-        drawHBar(barX, row2Y, barW, barH, (float)dev.frequency, 1200.0, CRT_BRIGHT, NULL);
+        int freq = controlQueue.shown(devIndex, CF_FREQ, dev.frequency);
+        tft.setTextColor(controlColor(devIndex, CF_FREQ, CRT_MID)); tft.setCursor(SX(38), row2Y+2); tft.printf("%dM", freq);
+        drawHBar(barX, row2Y, barW, barH, (float)freq, 1200.0, CRT_BRIGHT, NULL);
         int row3Y = row2Y + rowSpacing;
         tft.setTextColor(CRT_DIM); tft.setCursor(SX(14), row3Y+2); tft.print("VIN");
         tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row3Y+2); tft.printf("%.2fV", dev.voltage);
@@ -1330,9 +2120,9 @@ void drawDeviceScreen(int devIndex) {
         drawHBar(barX, row3Y, barW, barH, dev.voltage, 5.5, vinColor, NULL);
         int row4Y = row3Y + rowSpacing;
         tft.setTextColor(CRT_DIM); tft.setCursor(SX(14), row4Y+2); tft.print("SHR");
-        char sBuf[16]; formatShares(sBuf, sizeof(sBuf), dev.sharesAccepted);
+        char sBuf[16]; formatShares(sBuf, sizeof(sBuf), shares);
         tft.setTextColor(CRT_MID); tft.setCursor(SX(38), row4Y+2); tft.print(sBuf);
-        drawHBar(barX, row4Y, barW, barH, (float)dev.sharesAccepted, (float)max(1, dev.sharesAccepted)*1.2f, CRT_BRIGHT, NULL);
+        drawHBar(barX, row4Y, barW, barH, (float)shares, (float)max(1, shares)*1.2f, CRT_BRIGHT, NULL);
 
         drawPanel(SX(6), SY(178), SCR_W - SX(12), SY(38), NULL);
         drawButton(btnDevRestart,   "RST",  BTN_DANGER);
@@ -1350,8 +2140,10 @@ void drawDeviceScreen(int devIndex) {
 void updateDeviceScreen(int devIndex) {
     if (devIndex >= deviceCount) return;
     DeviceInfo &dev = devices[devIndex];
+    float hashRate = fleet.hashRate[devIndex], temperature = fleet.temperature[devIndex], power = fleet.power[devIndex];
+    int shares = fleet.sharesAccepted[devIndex];
 
-    if (!dev.valid) return;
+    if (!fleet.valid[devIndex]) return;
 
 #if SCR_W >= 480
     int gaugeR = SS(29), gauger = SS(22), gaugeClear = SS(20);
@@ -1365,20 +2157,20 @@ void updateDeviceScreen(int devIndex) {
     tft.fillCircle(SCR_W * 3/4, gaugeCY, gaugeClear, CRT_BG);
 
     char hashBuf[16]; const char* hashUnit;
-    if (dev.hashRate >= 1000) { snprintf(hashBuf, sizeof(hashBuf), "%.2f", dev.hashRate/1000.0); hashUnit = "TH/s"; }
-    else                      { snprintf(hashBuf, sizeof(hashBuf), "%.0f", dev.hashRate);         hashUnit = "GH/s"; }
-    drawArcGauge(SCR_W/4,   gaugeCY, gaugeR, gauger, dev.hashRate,    0, 1000, "", hashBuf, hashUnit, CRT_BRIGHT);
-    char tempBuf[16]; snprintf(tempBuf, sizeof(tempBuf), "%.1f", dev.temperature);
-    drawArcGauge(SCR_W*3/4, gaugeCY, gaugeR, gauger, dev.temperature, 0, 80,   "", tempBuf, "C",      tempColor(dev.temperature));
+    if (hashRate >= 1000) { snprintf(hashBuf, sizeof(hashBuf), "%.2f", hashRate/1000.0); hashUnit = "TH/s"; }
+    else                  { snprintf(hashBuf, sizeof(hashBuf), "%.0f", hashRate);         hashUnit = "GH/s"; }
+    drawArcGauge(SCR_W/4,   gaugeCY, gaugeR, gauger, hashRate,    0, 1000, "", hashBuf, hashUnit, CRT_BRIGHT);
+    char tempBuf[16]; snprintf(tempBuf, sizeof(tempBuf), "%.1f", temperature);
+    drawArcGauge(SCR_W*3/4, gaugeCY, gaugeR, gauger, temperature, 0, 80,   "", tempBuf, "C",      tempColor(temperature));
 
     tft.fillRect(SX(8), infoY - 2, SCR_W - SX(16), SY(10), CRT_BG);
     tft.setTextColor(CRT_MID); tft.setTextSize(1);
     tft.setCursor(SX(10), infoY);  tft.printf("IP:%s", dev.ip);
-    tft.setTextColor(CRT_BRIGHT);
-    tft.setCursor(SX(148), infoY); tft.printf("CORE:%dmV", dev.coreVoltage);
+    tft.setTextColor(controlColor(devIndex, CF_VOLT, CRT_BRIGHT));
+    tft.setCursor(SX(148), infoY); tft.printf("CORE:%dmV", controlQueue.shown(devIndex, CF_VOLT, dev.coreVoltage));
     tft.setTextColor(CRT_MID);
     tft.setCursor(SX(240), infoY);
-    if (dev.fanRpm > 0) tft.printf("FAN:%d", dev.fanRpm); else tft.printf("RSSI:%d", dev.wifiRSSI);
+    printDeviceFan(devIndex);
 
     int barX = SX(80), barW = SCR_W - SX(96), barH = SY(10), rowSpacing = SY(12);
 
@@ -1388,17 +2180,18 @@ void updateDeviceScreen(int devIndex) {
     tft.setTextColor(CRT_MID);
     tft.setTextSize(1);
     tft.setCursor(SX(38), row1Y + 2);
-    tft.printf("%.1fW", dev.power);
-    drawHBar(barX, row1Y, barW, barH, dev.power, 30.0, CRT_BRIGHT, NULL);
+    tft.printf("%.1fW", power);
+    drawHBar(barX, row1Y, barW, barH, power, 30.0, CRT_BRIGHT, NULL);
 
     // Frequency
     int row2Y = row1Y + rowSpacing;
     tft.fillRect(SX(36), row2Y - 1, SX(40), barH, PANEL_FILL);
     tft.fillRect(barX, row2Y, barW, barH, PANEL_FILL);
-    tft.setTextColor(CRT_MID);
+    int freq = controlQueue.shown(devIndex, CF_FREQ, dev.frequency);
+    tft.setTextColor(controlColor(devIndex, CF_FREQ, CRT_MID));
     tft.setCursor(SX(38), row2Y + 2);
-    tft.printf("%dM", dev.frequency);
-    drawHBar(barX, row2Y, barW, barH, (float)dev.frequency, 1200.0, CRT_BRIGHT, NULL);
+    tft.printf("%dM", freq);
+    drawHBar(barX, row2Y, barW, barH, (float)freq, 1200.0, CRT_BRIGHT, NULL);
 
     // Voltage
     int row3Y = row2Y + rowSpacing;
@@ -1415,156 +2208,958 @@ void updateDeviceScreen(int devIndex) {
     tft.fillRect(SX(36), row4Y - 1, SX(40), barH, PANEL_FILL);
     tft.fillRect(barX, row4Y, barW, barH, PANEL_FILL);
     char sBuf[16];
-    formatShares(sBuf, sizeof(sBuf), dev.sharesAccepted);
+    formatShares(sBuf, sizeof(sBuf), shares);
     tft.setTextColor(CRT_MID);
     tft.setCursor(SX(38), row4Y + 2);
     tft.print(sBuf);
-    drawHBar(barX, row4Y, barW, barH, (float)dev.sharesAccepted, (float)max(1, dev.sharesAccepted) * 1.2f, CRT_BRIGHT, NULL);
+    drawHBar(barX, row4Y, barW, barH, (float)shares, (float)max(1, shares) * 1.2f, CRT_BRIGHT, NULL);
 }
 
-// ===== NETWORK FETCH FUNCTIONS =====
+// ===== SCREEN N+2: FLEET CONTROL =====
 
-void fetchDeviceData(int index) {
-    if (index >= deviceCount) return;
-    if (WiFi.status() != WL_CONNECTED) return;
-    if (strlen(devices[index].ip) == 0) return;
+int fleetScreenIndex() {
+    return 2 + deviceCount;
+}
 
-    String url = "http://" + String(devices[index].ip) + "/api/system/info";
-    HTTPClient http;
-    http.setTimeout(5000);
-    http.begin(url);
-    int httpCode = http.GET();
+// One row per device: its settings and what the last bulk operation did to it
+void drawFleetTable() {
+#if SCR_W >= 480
+    int top = SY(68), bottom = SY(212);
+#else
+    int top = SY(34), bottom = SY(174);
+#endif
+    int rowH = SY(14);
+    const int colX[] = {SX(10), SX(24), SX(112), SX(152), SX(192), SX(226)};
+    tft.fillRect(SX(6), top, SCR_W - SX(12), bottom - top, CRT_BG);
+    tft.setTextSize(1);
+    tft.setTextColor(CRT_DIM);
+    const char* heads[] = {"#", "WORKER", "MHZ", "MV", "FAN", bulk.id() ? (bulk.kind() == BK_RESTART ? "RESTART" : "SET") : "LAST"};
+    for (int c = 0; c < 6; c++) {
+        tft.setCursor(colX[c], top + SY(2));
+        tft.print(heads[c]);
+    }
+    tft.drawFastHLine(SX(8), top + rowH - SY(2), SCR_W - SX(16), CRT_DIM);
 
-    if (httpCode == 200) {
-        String payload = http.getString();
-        DynamicJsonDocument doc(8192);
-        DeserializationError error = deserializeJson(doc, payload);
-
-        if (!error) {
-            deviceFailCount[index] = 0;
-            DeviceInfo &dev = devices[index];
-            dev.valid = true;
-            dev.hashRate = doc["hashRate"] | 0.0f;
-            dev.hashRate_1h = doc["hashRate_1h"] | 0.0f;
-            dev.temperature = doc["temp"] | 0.0f;
-            dev.vrTemp = doc["vrTemp"] | 0.0f;
-            dev.power = doc["power"] | 0.0f;
-            dev.voltage = (doc["voltage"] | 0.0f) / 1000.0f;
-            dev.coreVoltage = doc["coreVoltage"] | 1200;
-            dev.frequency = doc["frequency"] | 0;
-            dev.fanRpm = doc["fanrpm"] | 0;
-            dev.fanSpeed = doc["fanspeed"] | 0;
-            dev.sharesAccepted = doc["sharesAccepted"] | 0;
-            dev.sharesRejected = doc["sharesRejected"] | 0;
-            dev.bestDiff = doc["bestDiff"] | 0.0;
-            dev.bestSessionDiff = doc["bestSessionDiff"] | 0.0;
-            dev.hostname = doc["hostname"] | "";
-            dev.deviceModel = doc["deviceModel"] | "";
-            dev.asicModel = doc["ASICModel"] | "";
-            dev.stratumURL = doc["stratumURL"] | "";
-            dev.stratumPort = doc["stratumPort"] | 0;
-            dev.stratumUser = doc["stratumUser"] | "";
-            dev.uptimeSeconds = doc["uptimeSeconds"] | 0;
-            dev.wifiRSSI = doc["wifiRSSI"] | 0;
+    int maxRows = (bottom - top) / rowH - 1;
+    unsigned long now = millis();
+    for (int i = 0; i < deviceCount; i++) {
+        int y = top + (i + 1) * rowH + SY(2);
+        if (i == maxRows - 1 && deviceCount > maxRows) {
+            tft.setTextColor(CRT_DIM);
+            tft.setCursor(colX[1], y);
+            tft.printf("+%d MORE", deviceCount - i);
+            break;
+        }
+        const DeviceInfo &dev = devices[i];
+        char name[15];
+        snprintf(name, sizeof(name), "%s", dev.hostname[0] ? dev.hostname : dev.ip);
+        tft.setTextColor(fleet.valid[i] ? CRT_MID : CRT_DIM);
+        tft.setCursor(colX[0], y); tft.print(i);
+        tft.setCursor(colX[1], y); tft.print(name);
+        if (!fleet.valid[i]) {
+            tft.setCursor(colX[2], y); tft.print("OFFLINE");
         } else {
-            deviceFailCount[index]++;
-            if (deviceFailCount[index] >= MAX_FAIL_BEFORE_INVALID) {
-                devices[index].valid = false;
-            }
+            tft.setTextColor(CRT_BRIGHT);
+            tft.setCursor(colX[2], y); tft.print(dev.frequency);
+            tft.setCursor(colX[3], y); tft.print(dev.coreVoltage);
+            tft.setCursor(colX[4], y); tft.printf("%d%%", dev.fanSpeed);
         }
-    } else {
-        deviceFailCount[index]++;
-        if (deviceFailCount[index] >= MAX_FAIL_BEFORE_INVALID) {
-            devices[index].valid = false;
+
+        const BulkJob* j = bulk.forDevice(i);
+        if (!j) continue;
+        char res[16];
+        uint16_t color = CRT_YELLOW;
+        switch (j->state) {
+            case BJ_QUEUED:
+                if ((int32_t)(j->startAt - now) > 0) snprintf(res, sizeof(res), "IN %us", (unsigned)min<uint32_t>((j->startAt - now + 999) / 1000, 9999));
+                else snprintf(res, sizeof(res), "QUEUED");
+                break;
+            case BJ_OK:      snprintf(res, sizeof(res), "OK %lums", (unsigned long)j->rtt()); color = CRT_BRIGHT; break;
+            case BJ_FAILED:  snprintf(res, sizeof(res), j->status > 0 ? "HTTP %d" : "FAILED", j->status); color = CRT_RED; break;
+            case BJ_TIMEOUT: snprintf(res, sizeof(res), "TIMEOUT"); color = CRT_RED; break;
+            default:         snprintf(res, sizeof(res), "..."); break;
         }
+        tft.setTextColor(color);
+        tft.setCursor(colX[5], y);
+        tft.print(res);
     }
-    http.end();
+    fleetDrawnVersion = bulk.version();
 }
 
-void fetchBtcPrice() {
-    if (WiFi.status() != WL_CONNECTED) return;
-
-    String url = "https://api.coingecko.com/api/v3/simple/price?ids="
-        + String(coins[selectedCoin].apiId)
-        + "&vs_currencies=usd&include_24hr_change=true";
-
-    WiFiClientSecure client;
-    client.setInsecure();
-    HTTPClient http;
-    http.setTimeout(10000);
-    http.begin(client, url);
-    int httpCode = http.GET();
+void drawFleetScreen() {
+    drawScreenFrame("FLEET CONTROL");
+#if SCR_W >= 480
+    drawPanel(SX(4), SY(32), SCR_W - SX(8), SY(30), NULL);
+#else
+    drawPanel(SX(6), SY(178), SCR_W - SX(12), SY(38), NULL);
+#endif
+    drawButton(btnDevRestart,   "RST",  BTN_DANGER);
+    drawButton(btnDevFreqPlus,  "FRQ+", BTN_PRIMARY);
+    drawButton(btnDevFreqMinus, "FRQ-", BTN_PRIMARY);
+    drawButton(btnDevVoltPlus,  "mV+",  BTN_PRIMARY);
+    drawButton(btnDevVoltMinus, "mV-",  BTN_PRIMARY);
+    drawButton(btnDevFanPlus,   "FAN+", BTN_PRIMARY);
+    drawFleetTable();
+    drawNavBar(fleetScreenIndex(), getTotalScreens());
+}
 
-    if (httpCode == 200) {
-        String payload = http.getString();
-        DynamicJsonDocument doc(512);
-        DeserializationError error = deserializeJson(doc, payload);
-        if (!error) {
-            pool.btcPrice = doc[coins[selectedCoin].apiId]["usd"].as<float>();
-            pool.priceChange24h = doc[coins[selectedCoin].apiId]["usd_24h_change"].as<float>();
+// Device-screen buttons, applied to every online device: steps from each one's own
+// setting, RST (double tap) restarts them BULK_RESTART_STAGGER_MS apart
+void handleFleetTouch(int x, int y) {
+    bool all[MAX_DEVICES];
+    for (int i = 0; i < MAX_DEVICES; i++) all[i] = true;
+    if (checkButtonPress(btnDevRestart, x, y)) {
+        unsigned long now = millis();
+        if (restartConfirmPending && restartTapDevice == fleetScreenIndex() && (now - lastRestartTap < 2000)) {
+            flashButton(btnDevRestart, "RST", BTN_DANGER);
+            startBulkRestart(all, BULK_RESTART_STAGGER_MS);
+            restartConfirmPending = false;
+            restartTapDevice = -1;
+            drawButton(btnDevRestart, "RST", BTN_DANGER);
+            drawFleetTable();
+        } else {
+            restartConfirmPending = true;
+            restartTapDevice = fleetScreenIndex();
+            lastRestartTap = now;
+            drawRestartPrompt();
         }
+        return;
+    }
+
+    BulkSetting setting = {};
+    struct { ButtonArea &btn; const char* label; uint8_t field; int step; } steps[] = {
+        {btnDevFreqPlus,  "FRQ+", CF_FREQ, 25},
+        {btnDevFreqMinus, "FRQ-", CF_FREQ, -25},
+        {btnDevVoltPlus,  "mV+",  CF_VOLT, 25},
+        {btnDevVoltMinus, "mV-",  CF_VOLT, -25},
+        {btnDevFanPlus,   "FAN+", CF_FAN,  5},
+    };
+    for (auto &st : steps) {
+        if (!checkButtonPress(st.btn, x, y)) continue;
+        flashButton(st.btn, st.label, BTN_PRIMARY);
+        setting.set[st.field] = setting.relative[st.field] = true;
+        setting.value[st.field] = st.step;
+        if (startBulkSettings(all, setting) >= 0) drawFleetTable();
+        return;
     }
-    http.end();
 }
 
-void fetchNetworkDifficulty() {
-    if (WiFi.status() != WL_CONNECTED) return;
+// ===== SCREEN N+3: BENCHMARK HEATMAP =====
 
-    WiFiClientSecure client;
-    client.setInsecure();
-    HTTPClient http;
-    http.setTimeout(10000);
-    http.begin(client, "https://mempool.space/api/v1/mining/hashrate/1m");
-    int httpCode = http.GET();
+// Linear mix of two RGB565 colours, t = 0 -> a, t = 1 -> b
+uint16_t blend565(uint16_t a, uint16_t b, float t) {
+    t = constrain(t, 0.0f, 1.0f);
+    int r = ((a >> 11) & 0x1F) + (int)((((b >> 11) & 0x1F) - ((a >> 11) & 0x1F)) * t);
+    int g = ((a >> 5) & 0x3F) + (int)((((b >> 5) & 0x3F) - ((a >> 5) & 0x3F)) * t);
+    int bl = (a & 0x1F) + (int)(((b & 0x1F) - (a & 0x1F)) * t);
+    return (r << 11) | (g << 5) | bl;
+}
 
-    if (httpCode == 200) {
-        String payload = http.getString();
-        DynamicJsonDocument doc(8192);
-        DeserializationError error = deserializeJson(doc, payload);
-        if (!error) {
-            pool.networkDifficulty = doc["currentDifficulty"].as<double>();
-        }
+// Status lines + grid; everything below the title bar and above the nav bar
+void drawBenchmarkBody() {
+    tft.fillRect(SX(6), SY(31), SCR_W - SX(12), SY(180), CRT_BG);
+    tft.setTextSize(1);
+
+    int rows = benchmark.rows(), cols = benchmark.cols();
+    BenchState st = benchmark.state();
+    tft.setTextColor(CRT_DIM);
+    tft.setCursor(SX(8), SY(34));
+    const DeviceInfo &dev = devices[benchmark.device()];
+    tft.printf("%.12s  %s  %d/%d", dev.hostname[0] ? dev.hostname : dev.ip,
+               BENCH_STATE_NAMES[st], benchmark.pointsDone(), rows * cols);
+    if (benchmark.running() && st != BENCH_RESTORING) {
+        tft.setTextColor(CRT_MID);
+        tft.printf("  @ %dMHz %dmV", benchmark.freqAt(benchmark.currentRow()), benchmark.mvAt(benchmark.currentCol()));
     }
-    http.end();
-}
 
-// ===== POST FUNCTIONS =====
+    // Colour scale from the measured cells: best J/TH bright gold, worst dark red
+    float lo = 0, hi = 0;
+    bool any = false;
+    for (int r = 0; r < rows; r++) {
+        for (int c = 0; c < cols; c++) {
+            const BenchCell &cell = benchmark.cell(r, c);
+            if (cell.state != BC_DONE || cell.hashRate <= 0) continue;
+            float j = cell.jth();
+            if (!any || j < lo) lo = j;
+            if (!any || j > hi) hi = j;
+            any = true;
+        }
+    }
+    int bestR, bestC;
+    tft.setCursor(SX(8), SY(45));
+    if (benchmark.best(bestR, bestC)) {
+        const BenchCell &b = benchmark.cell(bestR, bestC);
+        tft.setTextColor(CRT_BRIGHT);
+        tft.printf("BEST %dMHz %dmV  %.1fJ/TH  %.0fGH/s", benchmark.freqAt(bestR), benchmark.mvAt(bestC),
+                   b.jth(), b.hashRate);
+    } else {
+        tft.setTextColor(CRT_DIM);
+        tft.print("BEST --");
+    }
 
-bool postDeviceSetting(int deviceIndex, const char* jsonBody) {
-    if (deviceIndex >= deviceCount) return false;
-    if (WiFi.status() != WL_CONNECTED) return false;
-    if (strlen(devices[deviceIndex].ip) == 0) return false;
+    // Grid: frequency rows (low at the top), voltage columns
+    int gx = SX(40), gy = SY(57);
+    int cw = (SCR_W - SX(8) - gx) / cols;
+    int ch = SY(138) / rows;
+    bool values = cw >= 28 && ch >= 10;
+    for (int r = 0; r < rows; r++) {
+        int y = gy + r * ch;
+        tft.setTextColor(CRT_DIM);
+        tft.setCursor(SX(10), y + (ch - 8) / 2);
+        tft.printf("%d", benchmark.freqAt(r));
+        for (int c = 0; c < cols; c++) {
+            int x = gx + c * cw;
+            const BenchCell &cell = benchmark.cell(r, c);
+            uint16_t fill;
+            float t = 0;
+            switch (cell.state) {
+                case BC_DONE:
+                    t = (hi > lo) ? (cell.jth() - lo) / (hi - lo) : 0;
+                    fill = (t < 0.5f) ? blend565(CRT_BRIGHT, CRT_ORANGE, t * 2) : blend565(CRT_ORANGE, CRT_RED_DARK, t * 2 - 1);
+                    break;
+                case BC_UNSAFE:  fill = CRT_RED; break;
+                case BC_FAILED:  fill = CRT_RED_DARK; break;
+                case BC_SKIPPED: fill = CRT_SCANLINE; break;
+                default:         fill = PANEL_FILL; break;
+            }
+            tft.fillRect(x, y, cw - 1, ch - 1, fill);
+            if (cell.state == BC_UNSAFE || cell.state == BC_SKIPPED) {
+                tft.drawLine(x, y, x + cw - 2, y + ch - 2, cell.state == BC_UNSAFE ? CRT_WHITE : CRT_DIM);
+            } else if (values && cell.state == BC_DONE) {
+                tft.setTextColor(t < 0.5f ? CRT_BG : CRT_WHITE);
+                tft.setCursor(x + (cw - 24) / 2, y + (ch - 8) / 2);
+                tft.printf("%4.1f", cell.jth());
+            }
+        }
+    }
+    if (benchmark.running() && st != BENCH_RESTORING) {
+        tft.drawRect(gx + benchmark.currentCol() * cw - 1, gy + benchmark.currentRow() * ch - 1, cw + 1, ch + 1, CRT_WHITE);
+    }
+    if (any) {
+        tft.drawRect(gx + bestC * cw - 1, gy + bestR * ch - 1, cw + 1, ch + 1, CRT_BRIGHT);
+    }
 
-    String url = "http://" + String(devices[deviceIndex].ip) + "/api/system";
-    HTTPClient http;
-    http.setTimeout(5000);
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    int httpCode = http.sendRequest("PATCH", jsonBody);
-    http.end();
-    return (httpCode == 200);
+    // Voltage labels, thinned out when the columns are narrow
+    int every = (cw >= 26) ? 1 : 2;
+    tft.setTextColor(CRT_DIM);
+    for (int c = 0; c < cols; c += every) {
+        tft.setCursor(gx + c * cw + (cw - 24) / 2, gy + rows * ch + SY(3));
+        tft.printf("%d", benchmark.mvAt(c));
+    }
+    tft.setCursor(SX(10), gy + rows * ch + SY(3));
+    tft.print("MHz");
+    benchDrawnVersion = benchmark.version();
 }
 
-bool postDeviceRestart(int deviceIndex) {
-    if (deviceIndex >= deviceCount) return false;
-    if (WiFi.status() != WL_CONNECTED) return false;
-    if (strlen(devices[deviceIndex].ip) == 0) return false;
-
-    String url = "http://" + String(devices[deviceIndex].ip) + "/api/system/restart";
-    HTTPClient http;
-    http.setTimeout(5000);
-    http.begin(url);
-    http.addHeader("Content-Type", "application/json");
-    int httpCode = http.POST("");
-    http.end();
-    return (httpCode == 200);
+void drawBenchmarkScreen() {
+    drawScreenFrame("BENCHMARK");
+    drawBenchmarkBody();
+    drawNavBar(getTotalScreens() - 1, getTotalScreens());
 }
 
-// ===== TOUCH HANDLING =====
+// Only redraw when a point finished or the job changed state
+void updateBenchmarkScreen() {
+    if (benchmark.version() != benchDrawnVersion) drawBenchmarkBody();
+}
 
-unsigned long lastTouchDebug = 0;
+// ===== NETWORK FETCH FUNCTIONS =====
 
-void handleTouch() {
+void fetchDeviceData(int index) {
+    if (index >= deviceCount) return;
+    if (WiFi.status() != WL_CONNECTED) return;
+    if (strlen(devices[index].ip) == 0) return;
+
+    // Connect ourselves so connect and time-to-first-byte are timed apart; HTTPClient uses the socket
+    const DeviceInfo &dev = devices[index];
+    fetchHttp.setTimeout(5000);
+    unsigned long t0 = millis();
+    PerfLap lap(perf);
+    int httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+    size_t len = 0;
+    if (deviceClient.connect(dev.host, dev.port, 5000)) {
+        lap.split(PS_DEV_CONNECT);
+        fetchUrl = dev.infoUrl;
+        fetchHttp.begin(deviceClient, fetchUrl);
+        httpCode = fetchHttp.GET();
+        lap.split(PS_DEV_TTFB);
+        if (httpCode == 200) {
+            len = readBody(fetchHttp, fetchBody, sizeof(fetchBody));
+            lap.split(PS_DEV_BODY);
+        }
+        fetchHttp.end();
+        deviceClient.stop();
+    } else {
+        lap.split(PS_DEV_CONNECT_FAIL);
+    }
+    traceResponse(TS_DEVICE, index, httpCode, millis() - t0, fetchBody, len);
+    applyDevicePayload(index, httpCode, fetchBody, len);
+}
+
+// Body of the response into buf, NUL-terminated; 0 when empty, cut short or larger than buf.
+// Read straight off the socket: Content-Length bytes, chunk by chunk (collectHeaders() must
+// include Transfer-Encoding), or up to the close.
+size_t readBody(HTTPClient &http, char* buf, size_t size) {
+    Stream& in = http.getStream();
+    int expected = http.getSize();
+    size_t n = 0;
+    if (expected >= 0) {
+        if ((size_t)expected >= size) return 0;
+        n = in.readBytes(buf, expected);
+        if (n != (size_t)expected) return 0;
+    } else if (http.header("Transfer-Encoding").equalsIgnoreCase("chunked")) {
+        char line[20];
+        for (;;) {
+            size_t k = in.readBytesUntil('\n', line, sizeof(line) - 1);
+            line[k] = '\0';
+            char* end;
+            size_t chunk = strtoul(line, &end, 16);
+            if (end == line) return 0;
+            if (chunk == 0) break;
+            if (chunk >= size - n || in.readBytes(buf + n, chunk) != chunk) return 0;
+            n += chunk;
+            in.readBytesUntil('\n', line, sizeof(line) - 1);        // CRLF closing the chunk
+        }
+    } else {
+        unsigned long start = millis();
+        while ((http.connected() || in.available() > 0) && millis() - start < 5000) {
+            int k = in.available();
+            if (k <= 0) {
+                delay(1);
+                continue;
+            }
+            if ((size_t)k >= size - n) return 0;
+            n += in.readBytes(buf + n, k);
+        }
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+// dst = src, written only when it differs
+void assignText(char* dst, size_t size, const char* src) {
+    if (strncmp(dst, src, size - 1) == 0) return;
+    strncpy(dst, src, size - 1);
+    dst[size - 1] = '\0';
+}
+
+// Ingest one /api/system/info response, live or replayed
+void applyDevicePayload(int index, int httpCode, const char* payload, size_t len) {
+    if (index >= deviceCount) return;
+    HeapTag tag(HT_INGEST);
+    PerfLap lap(perf);
+    ScratchJsonDocument doc(DEVICE_DOC_SIZE);
+    if (httpCode != 200 || len == 0 || deserializeJson(doc, payload, len)) {
+        deviceFetchFailed(index);
+        return;
+    }
+    lap.split(PS_DEV_PARSE);
+
+    deviceFailCount[index] = 0;
+    DeviceInfo &dev = devices[index];
+    fleet.valid[index] = true;
+    fleet.hashRate[index] = doc["hashRate"] | 0.0f;
+    dev.hashRate_1h = doc["hashRate_1h"] | 0.0f;
+    fleet.temperature[index] = doc["temp"] | 0.0f;
+    dev.vrTemp = doc["vrTemp"] | 0.0f;
+    fleet.power[index] = doc["power"] | 0.0f;
+    dev.voltage = (doc["voltage"] | 0.0f) / 1000.0f;
+    dev.coreVoltage = doc["coreVoltage"] | 1200;
+    dev.frequency = doc["frequency"] | 0;
+    dev.fanRpm = doc["fanrpm"] | 0;
+    dev.fanSpeed = doc["fanspeed"] | 0;
+    fleet.sharesAccepted[index] = doc["sharesAccepted"] | 0;
+    fleet.sharesRejected[index] = doc["sharesRejected"] | 0;
+    dev.bestDiff = doc["bestDiff"] | 0.0;
+    dev.bestSessionDiff = doc["bestSessionDiff"] | 0.0;
+    assignText(dev.hostname, sizeof(dev.hostname), doc["hostname"] | "");
+    devicePool.assign(dev.deviceModel, doc["deviceModel"] | "");
+    devicePool.assign(dev.asicModel, doc["ASICModel"] | "");
+    devicePool.assign(dev.stratumURL, doc["stratumURL"] | "");
+    dev.stratumPort = doc["stratumPort"] | 0;
+    assignText(dev.stratumUser, sizeof(dev.stratumUser), doc["stratumUser"] | "");
+    dev.uptimeSeconds = doc["uptimeSeconds"] | 0;
+    dev.wifiRSSI = doc["wifiRSSI"] | 0;
+    dev.poolDifficulty = doc["poolDifficulty"] | 0.0;
+    fleetStats.ingest(index, fleetSampleOf(index), millis() / 1000);
+    profit.setDevice(index, fleet.hashRate[index], fleet.power[index], dev.poolDifficulty);
+    recordDeviceSample(index);
+    powerGov.sampled(index);
+    runAutoTuner(index);
+    runBenchmark(index);
+    runThermalGovernor(index);
+    runProfile(index);
+    runAlerts(index, true);
+    runWatchdog(index);
+    lap.split(PS_DEV_INGEST);
+}
+
+void deviceFetchFailed(int index) {
+    deviceFailCount[index]++;
+    if (deviceFailCount[index] >= MAX_FAIL_BEFORE_INVALID) {
+        fleet.valid[index] = false;
+        fleetStats.drop(index, millis() / 1000);
+        profit.dropDevice(index);
+        runAlerts(index, false);
+        watchdog.unreachable(index, millis() / 1000);
+    }
+}
+
+// GET an https URL on host into fetchBody (len = its length, 0 unless 200);
+// DNS, TLS handshake, first byte and body are timed apart
+int fetchHttps(const char* host, const char* url, size_t &len) {
+    PerfLap lap(perf);
+    len = 0;
+    IPAddress addr;
+    if (!WiFi.hostByName(host, addr)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    lap.split(PS_API_DNS);
+    if (!apiClient.connect(host, 443, 10000)) return HTTPC_ERROR_CONNECTION_REFUSED;
+    lap.split(PS_API_TLS);
+    fetchHttp.setTimeout(10000);
+    fetchUrl = url;
+    fetchHttp.begin(apiClient, fetchUrl);
+    int httpCode = fetchHttp.GET();
+    lap.split(PS_API_TTFB);
+    if (httpCode == 200) {
+        len = readBody(fetchHttp, fetchBody, sizeof(fetchBody));
+        lap.split(PS_API_BODY);
+    }
+    fetchHttp.end();
+    apiClient.stop();
+    return httpCode;
+}
+
+// "ip" or "ip:port" -> host and port (80 when none is given)
+uint16_t deviceHostPort(const char* entry, char* host, size_t size) {
+    const char* colon = strchr(entry, ':');
+    size_t n = colon ? (size_t)(colon - entry) : strlen(entry);
+    if (n >= size) n = size - 1;
+    memcpy(host, entry, n);
+    host[n] = '\0';
+    return colon ? atoi(colon + 1) : 80;
+}
+
+void fetchBtcPrice() {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    char url[128];
+    snprintf(url, sizeof(url), "https://api.coingecko.com/api/v3/simple/price?ids=%s&vs_currencies=usd&include_24hr_change=true",
+             coins[selectedCoin].apiId);
+
+    unsigned long t0 = millis();
+    size_t len;
+    int httpCode = fetchHttps("api.coingecko.com", url, len);
+    traceResponse(TS_PRICE, 0, httpCode, millis() - t0, fetchBody, len);
+    applyPricePayload(httpCode, fetchBody, len);
+}
+
+void applyPricePayload(int httpCode, const char* payload, size_t len) {
+    if (httpCode != 200) return;
+    PerfScope timed(perf, PS_API_PARSE);
+    ScratchJsonDocument doc(512);
+    if (deserializeJson(doc, payload, len)) return;
+    pool.btcPrice = doc[coins[selectedCoin].apiId]["usd"].as<float>();
+    pool.priceChange24h = doc[coins[selectedCoin].apiId]["usd_24h_change"].as<float>();
+}
+
+void fetchNetworkDifficulty() {
+    if (WiFi.status() != WL_CONNECTED) return;
+
+    unsigned long t0 = millis();
+    size_t len;
+    int httpCode = fetchHttps("mempool.space", "https://mempool.space/api/v1/mining/hashrate/1m", len);
+    traceResponse(TS_DIFFICULTY, 0, httpCode, millis() - t0, fetchBody, len);
+    applyDifficultyPayload(httpCode, fetchBody, len);
+}
+
+void applyDifficultyPayload(int httpCode, const char* payload, size_t len) {
+    if (httpCode != 200) return;
+    PerfScope timed(perf, PS_API_PARSE);
+    ScratchJsonDocument doc(8192);
+    if (deserializeJson(doc, payload, len)) return;
+    pool.networkDifficulty = doc["currentDifficulty"].as<double>();
+}
+
+// ===== TRACE CAPTURE / REPLAY =====
+
+void traceResponse(uint8_t source, int device, int httpCode, unsigned long latencyMs, const char* payload, size_t len) {
+    if (!traceWriter.active()) return;
+    traceWriter.record(source, device, httpCode, latencyMs, payload, len, millis());
+}
+
+bool startCapture(const char* path, uint32_t maxBytes) {
+    if (replaying()) return false;
+    if (!traceWriter.begin(path, prefs.getString("ips", "").c_str(), deviceCount, maxBytes,
+                           clockSynced() ? (uint32_t)time(nullptr) : 0, millis())) return false;
+    strncpy(tracePath, path, sizeof(tracePath) - 1);
+    Serial.printf("TRACE: capturing to %s (%lu KB max)\n", path, (unsigned long)(maxBytes / 1024));
+    return true;
+}
+
+void stopCapture() {
+    if (!traceWriter.open()) return;
+    traceWriter.end();
+    Serial.printf("TRACE: captured %lu records, %lu bytes\n",
+                  (unsigned long)traceWriter.records(), (unsigned long)traceWriter.bytes());
+}
+
+// Swap the live device list for the one in the trace; live fetches and control stop until it ends
+bool startReplay(const char* path, float speed) {
+    if (replaying() || traceWriter.open()) return false;
+    char ips[DEVICE_LIST_LEN];
+    if (!traceReader.begin(path, speed, millis(), ips, sizeof(ips))) return false;
+    replayBuf = (char*)malloc(TRACE_MAX_PAYLOAD + 1);
+    if (!replayBuf) {
+        traceReader.end();
+        return false;
+    }
+    strncpy(tracePath, path, sizeof(tracePath) - 1);
+    useDeviceList(ips);
+    replayDevices = deviceCount;
+    Serial.printf("TRACE: replaying %s at %.1fx, %d devices\n", path, traceReader.speed(), deviceCount);
+    return true;
+}
+
+void stopReplay() {
+    if (!replayBuf) return;
+    traceReader.end();
+    free(replayBuf);
+    replayBuf = nullptr;
+    Serial.printf("TRACE: replay done, %lu records\n", (unsigned long)traceReader.records());
+    useDeviceList(prefs.getString("ips", "").c_str());
+}
+
+// Device indices change meaning: start counting and drawing from scratch
+void useDeviceList(const char* ips) {
+    parseDeviceIPs(ips);
+    memset(deviceFailCount, 0, sizeof(deviceFailCount));
+    deviceFetchIndex = 0;
+    currentScreen = 0;
+    redrawCurrentScreen();
+}
+
+// Feed every record that is due through the live ingest path
+void pumpReplay(unsigned long now) {
+    if (!replayBuf) return;
+    ApiTraceRecord r;
+    while (traceReader.next(now, r, replayBuf, TRACE_MAX_PAYLOAD + 1)) {
+        if (r.source == TS_DEVICE) {
+            if (r.device < replayDevices) applyDevicePayload(r.device, r.code, replayBuf, r.len);
+        } else if (r.source == TS_PRICE) {
+            applyPricePayload(r.code, replayBuf, r.len);
+        } else {
+            applyDifficultyPayload(r.code, replayBuf, r.len);
+        }
+    }
+    if (!traceReader.active()) stopReplay();
+}
+
+void sendTraceStatus(int code) {
+    ScratchJsonDocument doc(1024 + 64 * 16);
+    JsonObject cap = doc.createNestedObject("capture");
+    cap["active"] = traceWriter.active();
+    cap["open"] = traceWriter.open();
+    cap["records"] = traceWriter.records();
+    cap["bytes"] = traceWriter.bytes();
+    cap["maxBytes"] = traceWriter.maxBytes();
+    JsonObject rep = doc.createNestedObject("replay");
+    rep["active"] = replaying();
+    rep["records"] = traceReader.records();
+    rep["speed"] = traceReader.speed();
+    rep["traceMs"] = traceReader.traceMs();
+    rep["startEpoch"] = traceReader.header().startEpoch;
+    doc["file"] = tracePath;
+    JsonArray files = doc.createNestedArray("files");
+    File dir = LittleFS.open(TRACE_DIR);
+    if (dir && dir.isDirectory()) {
+        for (File f = dir.openNextFile(); f && files.size() < 16; f = dir.openNextFile()) {
+            JsonObject o = files.createNestedObject();
+            o["name"] = String(f.name());
+            o["bytes"] = f.size();
+        }
+    }
+    sendJson(code, doc);
+}
+
+// ===== PERF STATS =====
+
+// "850us" / "12.4ms" / "5.0s" in at most 6 characters
+void formatMicros(char* buf, size_t size, uint32_t us) {
+    if (us < 1000) snprintf(buf, size, "%luus", (unsigned long)us);
+    else if (us < 100000) snprintf(buf, size, "%.1fms", us / 1000.0f);
+    else if (us < 1000000) snprintf(buf, size, "%lums", (unsigned long)(us / 1000));
+    else snprintf(buf, size, "%.1fs", us / 1000000.0f);
+}
+
+// p50 / p99 of the stages that decide how the current screen feels, drawn over its top right
+void drawPerfOverlay() {
+    uint8_t draw = PS_DRAW_BENCH;
+    if (currentScreen == 0) draw = PS_DRAW_MAIN;
+    else if (currentScreen == 1) draw = PS_DRAW_POOL;
+    else if (currentScreen - 2 < deviceCount) draw = PS_DRAW_DEVICE;
+    else if (currentScreen == fleetScreenIndex()) draw = PS_DRAW_FLEET;
+    const uint8_t stages[] = {PS_DEV_TTFB, PS_DEV_PARSE, draw, PS_WEB, PS_LOOP_PERIOD};
+    const int lines = sizeof(stages);
+    int w = 6 * 25 + 6, h = lines * 10 + 4;
+    int x = SCR_W - w - SX(4), y = SY(30);
+    tft.fillRect(x, y, w, h, TFT_BLACK);
+    tft.drawRect(x, y, w, h, CRT_DIM);
+    tft.setTextSize(1);
+    tft.setTextColor(CRT_WHITE, TFT_BLACK);
+    for (int k = 0; k < lines; k++) {
+        char p50[8], p99[8], line[32];
+        formatMicros(p50, sizeof(p50), perf.percentile(stages[k], 50));
+        formatMicros(p99, sizeof(p99), perf.percentile(stages[k], 99));
+        snprintf(line, sizeof(line), "%-11.11s%6s %6s", PERF_STAGE_NAMES[stages[k]], p50, p99);
+        tft.setCursor(x + 3, y + 3 + k * 10);
+        tft.print(line);
+    }
+}
+
+// /debug/perf: per stage count, mean, p50/p90/p99, max (us); buckets=1 adds the non-empty buckets
+void sendPerfStats() {
+    bool buckets = webServer.hasArg("buckets") && webServer.arg("buckets").toInt() != 0;
+    ScratchJsonDocument doc(2048 + PS_COUNT * (buckets ? 1024 : 160));
+    doc["enabled"] = PERF_STATS != 0;
+    doc["overlay"] = perfOverlay;
+    doc["cpuMHz"] = perf.cyclesPerUs();
+    doc["uptime"] = millis() / 1000;
+    JsonObject stages = doc.createNestedObject("stages");
+    for (int st = 0; st < PS_COUNT; st++) {
+        if (perf.count(st) == 0) continue;
+        JsonObject o = stages.createNestedObject(PERF_STAGE_NAMES[st]);
+        o["count"] = perf.count(st);
+        o["mean"] = perf.meanUs(st);
+        o["p50"] = perf.percentile(st, 50);
+        o["p90"] = perf.percentile(st, 90);
+        o["p99"] = perf.percentile(st, 99);
+        o["max"] = perf.maxUs(st);
+        if (!buckets) continue;
+        JsonArray b = o.createNestedArray("buckets");       // [upper edge us, count]
+        for (int k = 0; k < PERF_BUCKETS; k++) {
+            if (perf.bucket(st, k) == 0) continue;
+            JsonArray e = b.createNestedArray();
+            e.add(PerfStats::bucketTop(k));
+            e.add(perf.bucket(st, k));
+        }
+    }
+    sendJson(200, doc);
+}
+
+// Serialized behind the document in jsonArena and sent from there
+void sendJson(int code, ScratchJsonDocument &doc) {
+    ScratchJsonText text(doc);
+    webServer.send_P(code, "application/json", text.c_str(), text.length());
+}
+
+void addArenaStats(JsonObject o, const JsonArena &arena) {
+    o["size"] = arena.size();
+    o["used"] = arena.used();
+    o["highWater"] = arena.highWater();
+    o["overflows"] = arena.overflows();
+    o["largestOverflow"] = arena.largestOverflow();
+}
+
+// /api/heap: heap now, allocations per subsystem, stack marks, the sample ring and its trend
+void sendHeapTelemetry() {
+    HeapSample s = heapTelemetry.current(millis() / 1000);
+    ScratchJsonDocument doc(2048 + heapTelemetry.count() * (JSON_ARRAY_SIZE(7) + JSON_ARRAY_SIZE(1)));
+    doc["uptime"] = s.t;
+    doc["free"] = s.freeBytes;
+    doc["largest"] = s.largest;
+    doc["minFree"] = s.minFree;
+    doc["size"] = ESP.getHeapSize();
+    doc["fragmentation"] = HeapTelemetry::fragmentation(s);
+    doc["low"] = heapTelemetry.low();
+    JsonObject stacks = doc.createNestedObject("stackFree");    // bytes never touched
+    stacks["loop"] = s.loopStack;
+    stacks["control"] = s.workerStack;
+    JsonObject json = doc.createNestedObject("json");       // scratch arenas; used counts this response
+    addArenaStats(json.createNestedObject(jsonArena.name()), jsonArena);
+    addArenaStats(json.createNestedObject(controlArena.name()), controlArena);
+    doc["counting"] = HEAP_COUNT_ALLOCS != 0;
+    if (HEAP_COUNT_ALLOCS) {
+        JsonObject subs = doc.createNestedObject("allocs");
+        for (int k = 0; k < HT_COUNT; k++) {
+            JsonObject o = subs.createNestedObject(HEAP_SUBSYSTEM_NAMES[k]);
+            o["count"] = heapCounts.allocs[k];
+            o["bytes"] = heapCounts.bytes[k];
+        }
+        doc["frees"] = heapCounts.frees;
+    }
+    float freePerHour, largestPerHour;
+    if (heapTelemetry.trend(freePerHour, largestPerHour)) {
+        JsonObject trend = doc.createNestedObject("trendPerHour");
+        trend["free"] = (int32_t)freePerHour;
+        trend["largest"] = (int32_t)largestPerHour;
+    }
+    // [t, free, largest, minFree, loop stack, control stack, allocs], oldest first
+    JsonArray ring = doc.createNestedArray("samples");
+    for (int k = 0; k < heapTelemetry.count(); k++) {
+        const HeapSample& h = heapTelemetry.sample(k);
+        JsonArray e = ring.createNestedArray();
+        e.add(h.t);
+        e.add(h.freeBytes);
+        e.add(h.largest);
+        e.add(h.minFree);
+        e.add(h.loopStack);
+        e.add(h.workerStack);
+        e.add(h.allocs);
+    }
+    sendJson(200, doc);
+}
+
+// ===== POST FUNCTIONS =====
+
+bool postDeviceSetting(int deviceIndex, const char* jsonBody) {
+    if (deviceIndex >= deviceCount || replaying()) return false;
+    if (WiFi.status() != WL_CONNECTED) return false;
+    if (strlen(devices[deviceIndex].ip) == 0) return false;
+
+    HTTPClient http;
+    http.setTimeout(5000);
+    http.begin(devices[deviceIndex].url);
+    http.addHeader("Content-Type", "application/json");
+    int httpCode = http.sendRequest("PATCH", jsonBody);
+    http.end();
+    return (httpCode == 200);
+}
+
+bool postDevicePoint(int deviceIndex, int frequency, int coreVoltage) {
+    char body[64];
+    snprintf(body, sizeof(body), "{\"frequency\":%d,\"coreVoltage\":%d}", frequency, coreVoltage);
+    return postDeviceSetting(deviceIndex, body);
+}
+
+bool postDeviceRestart(int deviceIndex) {
+    if (deviceIndex >= deviceCount || replaying()) return false;
+    if (WiFi.status() != WL_CONNECTED) return false;
+    if (strlen(devices[deviceIndex].ip) == 0) return false;
+
+    char url[72];
+    snprintf(url, sizeof(url), "%s/restart", devices[deviceIndex].url);
+    HTTPClient http;
+    http.setTimeout(5000);
+    http.begin(url);
+    http.addHeader("Content-Type", "application/json");
+    int httpCode = http.POST("");
+    http.end();
+    return (httpCode == 200);
+}
+
+// ===== CONTROL QUEUE =====
+
+// PATCH + read-back off the UI core. Works on copies only; results go back through controlResults.
+void controlWorker(void*) {
+    ControlJob job;
+    for (;;) {
+        if (xQueueReceive(controlJobs, &job, portMAX_DELAY) != pdTRUE) continue;
+        ControlResult r = {};
+        r.device = job.device;
+        r.seq = job.seq;
+        if (WiFi.status() == WL_CONNECTED) {
+            HTTPClient http;
+            http.setTimeout(5000);
+            http.begin(job.url);
+            http.addHeader("Content-Type", "application/json");
+            r.patched = http.sendRequest("PATCH", job.body) == 200;
+            http.end();
+            if (r.patched) {
+                vTaskDelay(pdMS_TO_TICKS(CONTROL_VERIFY_DELAY_MS));
+                char infoUrl[72];
+                snprintf(infoUrl, sizeof(infoUrl), "%s/info", job.url);
+                http.begin(infoUrl);
+                if (http.GET() == 200) {
+                    String payload = http.getString();
+                    ScratchJsonDocument doc(CONTROL_ARENA_SIZE, controlArena);
+                    if (!deserializeJson(doc, payload)) {
+                        r.values[CF_FREQ] = doc["frequency"] | -1;
+                        r.values[CF_VOLT] = doc["coreVoltage"] | -1;
+                        r.values[CF_FAN] = doc["fanspeed"] | -1;
+                        r.readOk = true;
+                    }
+                }
+                http.end();
+            }
+        }
+        xQueueSend(controlResults, &r, portMAX_DELAY);
+    }
+}
+
+void startControlWorker() {
+    controlJobs = xQueueCreate(MAX_DEVICES, sizeof(ControlJob));
+    controlResults = xQueueCreate(MAX_DEVICES, sizeof(ControlResult));
+    // Core 0 next to the WiFi stack; loop() runs on core 1
+    xTaskCreatePinnedToCore(controlWorker, "control", 8192, nullptr, 1, &controlTask, 0);
+}
+
+// PATCH body for the fields that are >= 0; a fan speed also turns AxeOS's own fan control off
+int formatControlBody(char* buf, size_t size, const int values[CF_COUNT]) {
+    int len = snprintf(buf, size, "{");
+    if (values[CF_FREQ] >= 0) len += snprintf(buf + len, size - len, "\"frequency\":%d,", values[CF_FREQ]);
+    if (values[CF_VOLT] >= 0) len += snprintf(buf + len, size - len, "\"coreVoltage\":%d,", values[CF_VOLT]);
+    if (values[CF_FAN] >= 0) len += snprintf(buf + len, size - len, "\"autofanspeed\":0,\"fanspeed\":%d,", values[CF_FAN]);
+    if (len > 1) buf[--len] = '\0';
+    len += snprintf(buf + len, size - len, "}");
+    return len;
+}
+
+// Every loop: apply read-backs, then hand settled targets to the worker
+void pumpControlQueue(unsigned long now) {
+    ControlResult r;
+    while (xQueueReceive(controlResults, &r, 0) == pdTRUE) {
+        if (r.device >= deviceCount) continue;
+        if (controlQueue.complete(r.device, r.seq, r.patched, r.readOk, r.values, now) == CQ_NONE) continue;
+        if (r.readOk) {
+            // -1 = the field was missing from /info; keep what the last poll said
+            DeviceInfo &dev = devices[r.device];
+            if (r.values[CF_FREQ] >= 0) dev.frequency = r.values[CF_FREQ];
+            if (r.values[CF_VOLT] >= 0) dev.coreVoltage = r.values[CF_VOLT];
+            if (r.values[CF_FAN] >= 0) dev.fanSpeed = r.values[CF_FAN];
+        }
+        if (currentScreen - 2 == r.device) updateDeviceScreen(r.device);
+    }
+
+    for (int i = 0; i < deviceCount; i++) {
+        int v[CF_COUNT];
+        uint16_t seq;
+        if (!controlQueue.take(i, now, v, seq)) continue;
+        ControlJob job;
+        job.device = i;
+        job.seq = seq;
+        memcpy(job.url, devices[i].url, sizeof(job.url));
+        formatControlBody(job.body, sizeof(job.body), v);
+        // A replayed device is not there to take the PATCH
+        if (replaying() || xQueueSend(controlJobs, &job, 0) != pdTRUE) {
+            int none[CF_COUNT] = {-1, -1, -1};
+            controlQueue.complete(i, seq, false, false, none, now);
+        }
+    }
+}
+
+// ===== BULK CONTROL =====
+
+// Set (or step, per field) settings on every selected online device in one concurrent round.
+// Returns the number of devices queued, -1 while the previous operation is still running.
+int startBulkSettings(const bool* selected, const BulkSetting &setting) {
+    unsigned long now = millis();
+    if (replaying() || !bulk.begin(BK_SETTINGS, now)) return -1;
+    for (int i = 0; i < deviceCount; i++) {
+        if (!selected[i] || !fleet.valid[i]) continue;
+        const DeviceInfo &dev = devices[i];
+        int reported[CF_COUNT] = {dev.frequency, dev.coreVoltage, dev.fanSpeed};
+        int k = bulk.count();
+        for (int f = 0; f < CF_COUNT; f++) {
+            bulkTargets[k][f] = -1;
+            if (!setting.set[f]) continue;
+            int v = setting.relative[f] ? controlQueue.shown(i, f, reported[f]) + setting.value[f] : setting.value[f];
+            bulkTargets[k][f] = constrain(v, CONTROL_MIN[f], CONTROL_MAX[f]);
+        }
+        // Same hand-over as the per-device buttons
+        if (setting.set[CF_FREQ] || setting.set[CF_VOLT]) manualOverride(i);
+        if (setting.set[CF_FAN]) thermalGov.pause(i, now / 1000 + FAN_MANUAL_HOLD_SEC);
+        char body[BULK_BODY_LEN];
+        formatControlBody(body, sizeof(body), bulkTargets[k]);
+        bulk.add(i, dev.ip, 80, body, 0);
+        bulkApplied[k] = false;
+    }
+    return bulk.count();
+}
+
+// Restart the selected online devices staggerMs apart
+int startBulkRestart(const bool* selected, uint32_t staggerMs) {
+    if (replaying() || !bulk.begin(BK_RESTART, millis())) return -1;
+    for (int i = 0; i < deviceCount; i++) {
+        if (!selected[i] || !fleet.valid[i]) continue;
+        bulkApplied[bulk.count()] = false;
+        bulk.add(i, devices[i].ip, 80, "", bulk.count() * staggerMs);
+    }
+    return bulk.count();
+}
+
+// Advance the sockets and fold finished jobs into devices[] / the watchdog
+void pumpBulk(unsigned long now, uint32_t waitMs) {
+    if (bulk.count() == 0) return;
+    bulk.pump(now, waitMs);
+    bool finished = false;
+    for (int k = 0; k < bulk.count(); k++) {
+        const BulkJob &j = bulk.job(k);
+        if (!j.done() || bulkApplied[k]) continue;
+        bulkApplied[k] = true;
+        finished = true;
+        if (bulk.kind() == BK_RESTART) {
+            watchdog.expectRestart(j.device, j.state == BJ_OK, now / 1000);
+        } else if (j.state == BJ_OK) {
+            DeviceInfo &dev = devices[j.device];
+            if (bulkTargets[k][CF_FREQ] >= 0) dev.frequency = bulkTargets[k][CF_FREQ];
+            if (bulkTargets[k][CF_VOLT] >= 0) dev.coreVoltage = bulkTargets[k][CF_VOLT];
+            if (bulkTargets[k][CF_FAN] >= 0) dev.fanSpeed = bulkTargets[k][CF_FAN];
+        }
+    }
+    if (finished && !bulk.busy()) {
+        Serial.printf("BULK: %s %d/%d ok in %lums\n", BULK_KIND_NAMES[bulk.kind()], bulk.okCount(), bulk.count(),
+                      now - bulk.startedAt());
+    }
+}
+
+// Device selection from ?devices=all|0,2,5 (default all); false on a bad index
+bool parseDeviceSelection(bool* selected) {
+    String arg = webServer.hasArg("devices") ? webServer.arg("devices") : String("all");
+    arg.trim();
+    for (int i = 0; i < MAX_DEVICES; i++) selected[i] = (arg == "all");
+    if (arg == "all") return true;
+    char buf[128];
+    strncpy(buf, arg.c_str(), sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (char* tok = strtok(buf, ","); tok; tok = strtok(NULL, ",")) {
+        char* end;
+        long i = strtol(tok, &end, 10);
+        if (end == tok || i < 0 || i >= deviceCount) return false;
+        selected[i] = true;
+    }
+    return true;
+}
+
+// Last bulk operation with per-device results, plus the current settings of every device
+void sendBulkStatus(int code) {
+    ScratchJsonDocument doc(1024 + deviceCount * 320);
+    unsigned long now = millis();
+    doc["id"] = bulk.id();
+    if (bulk.id() > 0) {
+        doc["kind"] = BULK_KIND_NAMES[bulk.kind()];
+        doc["busy"] = bulk.busy();
+        doc["age"] = now - bulk.startedAt();
+        doc["count"] = bulk.count();
+        doc["ok"] = bulk.okCount();
+    }
+    JsonArray jobs = doc.createNestedArray("jobs");
+    for (int k = 0; k < bulk.count(); k++) {
+        const BulkJob &j = bulk.job(k);
+        JsonObject o = jobs.createNestedObject();
+        o["device"] = j.device;
+        o["state"] = BULK_JOB_NAMES[j.state];
+        if (j.status != 0) o["status"] = j.status;
+        if (j.state == BJ_OK) o["rtt"] = j.rtt();
+        if (j.state == BJ_QUEUED && (int32_t)(j.startAt - now) > 0) o["startIn"] = j.startAt - now;
+    }
+    JsonArray devs = doc.createNestedArray("devices");
+    for (int i = 0; i < deviceCount; i++) {
+        const DeviceInfo &dev = devices[i];
+        JsonObject o = devs.createNestedObject();
+        o["ip"] = dev.ip;
+        o["hostname"] = dev.hostname;
+        o["online"] = fleet.valid[i];
+        o["frequency"] = dev.frequency;
+        o["coreVoltage"] = dev.coreVoltage;
+        o["fan"] = dev.fanSpeed;
+    }
+    sendJson(code, doc);
+}
+
+// ===== TOUCH HANDLING =====
+
+unsigned long lastTouchDebug = 0;
+
+void handleTouch() {
     TouchPoint tp = touch.read();
 
     if (millis() - lastTouchDebug > 200) {
@@ -1600,7 +3195,7 @@ void handleTouch() {
                     if (checkButtonPress(btnNextCoin, touchStartX, touchStartY)) {
                         flashButton(btnNextCoin, "NEXT>", BTN_GHOST);
                         selectedCoin = (selectedCoin + 1) % COIN_COUNT;
-                        prefs.putInt("coin", selectedCoin);
+                        settings.setInt("coin", selectedCoin, millis());
                         pool.btcPrice = 0;
                         pool.priceChange24h = 0;
                         fetchBtcPrice();
@@ -1608,12 +3203,16 @@ void handleTouch() {
                     }
                     if (checkButtonPress(btnRateMinus, touchStartX, touchStartY)) {
                         electricityRate = max(0.01f, electricityRate - 0.01f);
-                        prefs.putFloat("elecRate", electricityRate);
+                        tariff.baseRate = electricityRate;
+                        rateHoursDay = -1;
+                        settings.setFloat("elecRate", electricityRate, millis());
                         updatePoolScreen();
                     }
                     if (checkButtonPress(btnRatePlus, touchStartX, touchStartY)) {
                         electricityRate = min(1.00f, electricityRate + 0.01f);
-                        prefs.putFloat("elecRate", electricityRate);
+                        tariff.baseRate = electricityRate;
+                        rateHoursDay = -1;
+                        settings.setFloat("elecRate", electricityRate, millis());
                         updatePoolScreen();
                     }
                 }
@@ -1621,13 +3220,13 @@ void handleTouch() {
                 // === Screen 2+: Device control buttons ===
                 if (currentScreen >= 2) {
                     int devIndex = currentScreen - 2;
-                    if (devIndex < deviceCount && devices[devIndex].valid) {
+                    if (devIndex < deviceCount && fleet.valid[devIndex]) {
                         // RST button with double-tap confirm
                         if (checkButtonPress(btnDevRestart, touchStartX, touchStartY)) {
                             unsigned long now = millis();
                             if (restartConfirmPending && restartTapDevice == devIndex && (now - lastRestartTap < 2000)) {
                                 flashButton(btnDevRestart, "RST", BTN_DANGER);
-                                postDeviceRestart(devIndex);
+                                watchdog.expectRestart(devIndex, postDeviceRestart(devIndex), millis() / 1000);
                                 restartConfirmPending = false;
                                 restartTapDevice = -1;
                                 drawDeviceScreen(devIndex);
@@ -1635,60 +3234,49 @@ void handleTouch() {
                                 restartConfirmPending = true;
                                 restartTapDevice = devIndex;
                                 lastRestartTap = now;
-                                tft.fillRoundRect(btnDevRestart.x, btnDevRestart.y, btnDevRestart.w, btnDevRestart.h, 3, CRT_RED_DARK);
-                                tft.drawRoundRect(btnDevRestart.x, btnDevRestart.y, btnDevRestart.w, btnDevRestart.h, 3, CRT_YELLOW);
-                                tft.setTextColor(CRT_YELLOW);
-                                tft.setTextSize(1);
-                                tft.setCursor(btnDevRestart.x + 4, btnDevRestart.y + 6);
-                                tft.print("AGAIN?");
+                                drawRestartPrompt();
                             }
                         }
-                        // FRQ+
+                        // FRQ / mV / FAN: merged per device and sent once the taps stop (pumpControlQueue)
+                        unsigned long tapAt = millis();
                         if (checkButtonPress(btnDevFreqPlus, touchStartX, touchStartY)) {
-                            int newFreq = devices[devIndex].frequency + 25;
+                            manualOverride(devIndex);
                             flashButton(btnDevFreqPlus, "FRQ+", BTN_PRIMARY);
-                            char body[32];
-                            snprintf(body, sizeof(body), "{\"frequency\":%d}", newFreq);
-                            postDeviceSetting(devIndex, body);
+                            controlQueue.nudge(devIndex, CF_FREQ, 25, devices[devIndex].frequency, CONTROL_MIN[CF_FREQ], CONTROL_MAX[CF_FREQ], tapAt);
+                            updateDeviceScreen(devIndex);
                         }
-                        // FRQ-
                         if (checkButtonPress(btnDevFreqMinus, touchStartX, touchStartY)) {
-                            int newFreq = max(100, devices[devIndex].frequency - 25);
+                            manualOverride(devIndex);
                             flashButton(btnDevFreqMinus, "FRQ-", BTN_PRIMARY);
-                            char body[32];
-                            snprintf(body, sizeof(body), "{\"frequency\":%d}", newFreq);
-                            postDeviceSetting(devIndex, body);
+                            controlQueue.nudge(devIndex, CF_FREQ, -25, devices[devIndex].frequency, CONTROL_MIN[CF_FREQ], CONTROL_MAX[CF_FREQ], tapAt);
+                            updateDeviceScreen(devIndex);
                         }
-                        // mV+
                         if (checkButtonPress(btnDevVoltPlus, touchStartX, touchStartY)) {
-                            int newVolt = min(1400, devices[devIndex].coreVoltage + 25);
+                            manualOverride(devIndex);
                             flashButton(btnDevVoltPlus, "mV+", BTN_PRIMARY);
-                            char body[32];
-                            snprintf(body, sizeof(body), "{\"coreVoltage\":%d}", newVolt);
-                            postDeviceSetting(devIndex, body);
+                            controlQueue.nudge(devIndex, CF_VOLT, 25, devices[devIndex].coreVoltage, CONTROL_MIN[CF_VOLT], CONTROL_MAX[CF_VOLT], tapAt);
+                            updateDeviceScreen(devIndex);
                         }
-                        // mV-
                         if (checkButtonPress(btnDevVoltMinus, touchStartX, touchStartY)) {
-                            int newVolt = max(1000, devices[devIndex].coreVoltage - 25);
+                            manualOverride(devIndex);
                             flashButton(btnDevVoltMinus, "mV-", BTN_PRIMARY);
-                            char body[32];
-                            snprintf(body, sizeof(body), "{\"coreVoltage\":%d}", newVolt);
-                            postDeviceSetting(devIndex, body);
+                            controlQueue.nudge(devIndex, CF_VOLT, -25, devices[devIndex].coreVoltage, CONTROL_MIN[CF_VOLT], CONTROL_MAX[CF_VOLT], tapAt);
+                            updateDeviceScreen(devIndex);
                         }
-                        // FAN+
                         if (checkButtonPress(btnDevFanPlus, touchStartX, touchStartY)) {
-                            int newFan = min(100, devices[devIndex].fanSpeed + 5);
+                            thermalGov.pause(devIndex, millis() / 1000 + FAN_MANUAL_HOLD_SEC);
                             flashButton(btnDevFanPlus, "FAN+", BTN_PRIMARY);
-                            char body[32];
-                            snprintf(body, sizeof(body), "{\"fanspeed\":%d}", newFan);
-                            postDeviceSetting(devIndex, body);
+                            controlQueue.nudge(devIndex, CF_FAN, 5, devices[devIndex].fanSpeed, CONTROL_MIN[CF_FAN], CONTROL_MAX[CF_FAN], tapAt);
+                            updateDeviceScreen(devIndex);
                         }
                     }
+                    // Fleet screen: the same buttons, for every online device at once
+                    if (currentScreen == fleetScreenIndex()) handleFleetTouch(touchStartX, touchStartY);
                 }
             }
             // Swipe navigation
             else if (abs(swipeDist) > SWIPE_THRESHOLD) {
-                int maxScreen = 1 + deviceCount;
+                int maxScreen = getTotalScreens() - 1;
                 if (swipeDist < 0) {
                     if (currentScreen < maxScreen) {
                         currentScreen++;
@@ -1707,14 +3295,19 @@ void handleTouch() {
 }
 
 void redrawCurrentScreen() {
+    PerfScope timed(perf, PS_REDRAW);
     scanlineWipeTransition();
     if (currentScreen == 0) {
         drawMainUI();
         updateDisplay();
     } else if (currentScreen == 1) {
         drawPoolScreen();
-    } else {
+    } else if (currentScreen - 2 < deviceCount) {
         drawDeviceScreen(currentScreen - 2);
+    } else if (currentScreen == fleetScreenIndex()) {
+        drawFleetScreen();
+    } else {
+        drawBenchmarkScreen();
     }
 }
 
@@ -1732,7 +3325,11 @@ void updateLed(unsigned long now) {
         lastLedToggle = now;
         ledState = !ledState;
         int validCount = getValidDeviceCount();
-        if (validCount > 0 && WiFi.status() == WL_CONNECTED) {
+        if (alerts.activeCount() > 0) {
+            digitalWrite(LED_RED, ledState ? LOW : HIGH);
+            digitalWrite(LED_GREEN, HIGH);
+            digitalWrite(LED_BLUE, HIGH);
+        } else if (validCount > 0 && WiFi.status() == WL_CONNECTED) {
             digitalWrite(LED_GREEN, ledState ? LOW : HIGH);
             digitalWrite(LED_RED, HIGH);
             digitalWrite(LED_BLUE, HIGH);
@@ -1784,6 +3381,32 @@ bool checkButtonPress(ButtonArea &btn, int x, int y) {
 
 // ===== SETUP & LOOP =====
 
+void addProfitFigures(JsonObject o, const ProfitFigures &f) {
+    o["sharesPerHour"] = f.sharesPerHour;
+    o["blocksPerDay"] = f.blocksPerDay;
+    o["hoursToBlock"] = f.hoursToBlock;
+    o["revenuePerDay"] = f.revenuePerDay;
+    o["costPerDay"] = f.costPerDay;
+    o["profitPerDay"] = f.profitPerDay;
+}
+
+// Shared by the settings and benchmark pages (a literal so it can sit inside F())
+#define WEB_PAGE_STYLE \
+    "<style>" \
+    "*{box-sizing:border-box}" \
+    "body{background:#000;color:#FFB000;font-family:'Courier New',monospace;padding:20px;max-width:600px;margin:0 auto}" \
+    "h1{color:#FFB000;text-shadow:0 0 10px #FFB000;letter-spacing:3px;border-bottom:1px solid #614000;padding-bottom:10px}" \
+    "label{display:block;margin:15px 0 5px;color:#A36000;text-transform:uppercase;font-size:12px}" \
+    "textarea,input{background:#000020;color:#FFB000;border:2px solid #A36000;padding:8px;font-family:'Courier New',monospace;width:100%}" \
+    "textarea:focus,input:focus{border-color:#FFB000;outline:none}" \
+    "button{background:#000020;color:#FFB000;border:2px solid #FFB000;padding:10px 20px;" \
+    "font-family:'Courier New',monospace;text-transform:uppercase;cursor:pointer;margin:4px 4px 4px 0}" \
+    "button:hover{background:#FFB000;color:#000}" \
+    ".warn{border-color:#FF4000;color:#FF4000}.warn:hover{background:#FF4000;color:#000}" \
+    ".note{color:#614000;font-size:11px;margin:6px 0 15px}" \
+    "hr{border:none;border-top:1px solid #614000;margin:20px 0}" \
+    "</style>"
+
 void setupWebServer() {
     // Settings page
     webServer.on("/", HTTP_GET, []() {
@@ -1794,29 +3417,19 @@ void setupWebServer() {
             "<!DOCTYPE html><html><head><meta charset='utf-8'>"
             "<meta name='viewport' content='width=device-width,initial-scale=1'>"
             "<title>BitAxe Monitor</title>"
-            "<style>"
-            "*{box-sizing:border-box}"
-            "body{background:#000;color:#FFB000;font-family:'Courier New',monospace;padding:20px;max-width:600px;margin:0 auto}"
-            "h1{color:#FFB000;text-shadow:0 0 10px #FFB000;letter-spacing:3px;border-bottom:1px solid #614000;padding-bottom:10px}"
-            "label{display:block;margin:15px 0 5px;color:#A36000;text-transform:uppercase;font-size:12px}"
-            "textarea{background:#000020;color:#FFB000;border:2px solid #A36000;padding:8px;font-family:'Courier New',monospace;width:100%}"
-            "textarea:focus{border-color:#FFB000;outline:none}"
-            "button{background:#000020;color:#FFB000;border:2px solid #FFB000;padding:10px 20px;"
-            "font-family:'Courier New',monospace;text-transform:uppercase;cursor:pointer;margin:4px 4px 4px 0}"
-            "button:hover{background:#FFB000;color:#000}"
-            ".warn{border-color:#FF4000;color:#FF4000}.warn:hover{background:#FF4000;color:#000}"
-            ".note{color:#614000;font-size:11px;margin:6px 0 15px}"
-            "hr{border:none;border-top:1px solid #614000;margin:20px 0}"
-            "</style></head><body>"
+            WEB_PAGE_STYLE
+            "</head><body>"
             "<h1>&#9889; BITAXE MONITOR</h1>"
             "<form method='POST' action='/save'>"
             "<label>BitAxe IP Addresses</label>"
             "<textarea name='ips' rows='6' placeholder='192.168.1.50&#10;192.168.1.51'>{{IPS}}</textarea>"
-            "<div class='note'>One IP per line or comma-separated</div>"
+            "<div class='note'>One IP (or IP:port) per line or comma-separated</div>"
             "<button type='submit'>[ SAVE &amp; REBOOT ]</button>"
             "</form><hr>"
             "<button class='warn' onclick=\"if(confirm('Clear WiFi and restart into setup mode?'))location='/reset-wifi'\">[ RESET WIFI ]</button>"
             "<button class='warn' onclick=\"if(confirm('Run touch calibration? Device will reboot.'))location='/recalibrate'\">[ RECAL TOUCH ]</button>"
+            "<button onclick=\"location='/benchmark'\">[ BENCHMARK ]</button>"
+            "<button onclick=\"location='/fleet'\">[ FLEET ]</button>"
             "<hr><div class='note'>&#9670; http://bitaxe.local &nbsp;&bull;&nbsp; IP: {{IP}}</div>"
             "</body></html>"
         );
@@ -1834,12 +3447,15 @@ void setupWebServer() {
             ips.replace("\n", ",");
             ips.replace(" ", "");
             while (ips.endsWith(",")) ips.remove(ips.length() - 1);
+            // History series are indexed by device slot — start over when the list changes
+            if (!(prefs.getString("ips", "") == ips)) metricLog.wipe();
             prefs.putString("ips", ips);
         }
         webServer.send(200, "text/html",
             "<html><body style='background:#000;color:#FFB000;font-family:monospace;padding:20px'>"
             "<h1>&#10003; SAVED</h1><p>Rebooting in 2 seconds...</p></body></html>");
         delay(2000);
+        prepareRestart();
         ESP.restart();
     });
 
@@ -1851,6 +3467,7 @@ void setupWebServer() {
         delay(2000);
         WiFiManager wm;
         wm.resetSettings();
+        prepareRestart();
         ESP.restart();
     });
 
@@ -1868,9 +3485,848 @@ void setupWebServer() {
             "<p>Rebooting — tap the crosshairs when prompted...</p>"
             "</body></html>");
         delay(2000);
+        prepareRestart();
         ESP.restart();
     });
 
+    // Fleet statistics as JSON
+    webServer.on("/api/fleet", HTTP_GET, []() {
+        ScratchJsonDocument doc(2048 + deviceCount * 256);
+        doc["online"] = fleetStats.online();
+        doc["devices"] = deviceCount;
+        doc["hashrate"] = fleetStats.totalHashrate();
+        doc["power"] = fleetStats.totalPower();
+        doc["maxTemp"] = fleetStats.maxTemperature();
+        doc["sharesAccepted"] = fleetStats.sharesAccepted();
+        doc["sharesRejected"] = fleetStats.sharesRejected();
+        doc["rejectPct"] = fleetStats.rejectPct();
+        doc["bestDiff"] = fleetStats.maxBestDiff();
+        doc["bestSessionDiff"] = fleetStats.maxBestSessionDiff();
+        JsonObject ewma = doc.createNestedObject("ewma");
+        ewma["hashrate"] = fleetStats.ewmaHashrate();
+        ewma["power"] = fleetStats.ewmaPower();
+        ewma["sharesPerMin"] = fleetStats.shareRate();
+        JsonObject w5 = doc.createNestedObject("window5m");
+        w5["efficiency"] = fleetStats.efficiency(5);
+        w5["rejectPct"] = fleetStats.rejectPct(5);
+        w5["shares"] = fleetStats.sharesIn(5);
+        JsonObject w60 = doc.createNestedObject("window1h");
+        w60["efficiency"] = fleetStats.efficiency(60);
+        w60["rejectPct"] = fleetStats.rejectPct(60);
+        w60["shares"] = fleetStats.sharesIn(60);
+        JsonObject pr = doc.createNestedObject("profit");
+        pr["networkDifficulty"] = profit.difficulty();
+        pr["price"] = pool.btcPrice;
+        pr["blockReward"] = profit.blockReward();
+        addProfitFigures(pr, profit.fleet());
+        pr["blockProb24h"] = profit.fleetBlockProbability(24);
+        pr["blockProb30d"] = profit.fleetBlockProbability(24 * 30);
+        pr["blockProb1y"] = profit.fleetBlockProbability(24 * 365);
+        JsonArray devs = pr.createNestedArray("devices");
+        for (int i = 0; i < deviceCount; i++) {
+            if (!fleet.valid[i]) continue;
+            JsonObject d = devs.createNestedObject();
+            d["index"] = i;
+            d["poolDifficulty"] = devices[i].poolDifficulty;
+            addProfitFigures(d, profit.device(i));
+            d["blockProb30d"] = profit.blockProbability(fleet.hashRate[i], 24 * 30);
+        }
+        sendJson(200, doc);
+    });
+
+    // POST /api/fleet?reward=BTC — block reward used for revenue (subsidy, fees not included)
+    webServer.on("/api/fleet", HTTP_POST, []() {
+        float reward = webServer.hasArg("reward") ? webServer.arg("reward").toFloat() : -1;
+        if (reward < 0) {
+            webServer.send(400, "text/plain", "Expected reward=<coins per block>");
+            return;
+        }
+        blockReward = reward;
+        settings.setFloat("blockReward", blockReward, millis());
+        profit.setNetwork(pool.networkDifficulty, pool.btcPrice, blockReward);
+        webServer.send(200, "text/plain", "Block reward saved");
+    });
+
+    // Auto-tune: status + audit log, start / stop per device
+    webServer.on("/api/tune", HTTP_GET, []() {
+        ScratchJsonDocument doc(4096 + TUNE_LOG_SIZE * 160);
+        JsonArray devs = doc.createNestedArray("devices");
+        for (int i = 0; i < deviceCount; i++) {
+            JsonObject d = devs.createNestedObject();
+            d["device"] = i;
+            d["state"] = TUNE_STATE_NAMES[autoTuner.state(i)];
+            if (autoTuner.state(i) == TUNE_IDLE) continue;
+            d["frequency"] = autoTuner.pointFreq(i);
+            d["coreVoltage"] = autoTuner.pointMv(i);
+            d["points"] = autoTuner.pointsTried(i);
+            if (autoTuner.hasBest(i)) {
+                JsonObject best = d.createNestedObject("best");
+                best["frequency"] = autoTuner.bestFreq(i);
+                best["coreVoltage"] = autoTuner.bestMv(i);
+                best["jth"] = autoTuner.bestJth(i);
+            }
+        }
+        // Log times are uptime seconds; convert to UNIX time once NTP has synced
+        uint32_t up = millis() / 1000;
+        uint32_t epoch = clockSynced() ? (uint32_t)time(nullptr) : 0;
+        JsonArray log = doc.createNestedArray("log");
+        for (int i = 0; i < autoTuner.logCount(); i++) {
+            const TuneLogEntry &e = autoTuner.logEntry(i);
+            JsonObject o = log.createNestedObject();
+            o["t"] = epoch ? epoch - (up - e.t) : e.t;
+            o["device"] = e.device;
+            o["event"] = TUNE_EVENT_NAMES[e.event];
+            o["frequency"] = e.frequency;
+            o["coreVoltage"] = e.coreVoltage;
+            if (e.hashRate > 0) o["hashrate"] = e.hashRate;
+            if (e.power > 0) o["power"] = e.power;
+            if (e.jth > 0) o["jth"] = e.jth;
+        }
+        sendJson(200, doc);
+    });
+
+    // POST /api/tune/start?device=N[&fmin=&fmax=&fstep=&vmin=&vmax=&vstep=&tmax=&vrmax=&vinmin=&settle=&measure=]
+    webServer.on("/api/tune/start", HTTP_POST, []() {
+        int idx = webServer.hasArg("device") ? webServer.arg("device").toInt() : -1;
+        if (idx < 0 || idx >= deviceCount || !fleet.valid[idx]) {
+            webServer.send(400, "text/plain", "Unknown or offline device");
+            return;
+        }
+        if (benchmarkOwns(idx)) {
+            webServer.send(409, "text/plain", "Device is running a benchmark");
+            return;
+        }
+        TuneLimits lim;
+        if (webServer.hasArg("fmin"))    lim.freqMin = webServer.arg("fmin").toInt();
+        if (webServer.hasArg("fmax"))    lim.freqMax = webServer.arg("fmax").toInt();
+        if (webServer.hasArg("fstep"))   lim.freqStep = webServer.arg("fstep").toInt();
+        if (webServer.hasArg("vmin"))    lim.mvMin = webServer.arg("vmin").toInt();
+        if (webServer.hasArg("vmax"))    lim.mvMax = webServer.arg("vmax").toInt();
+        if (webServer.hasArg("vstep"))   lim.mvStep = webServer.arg("vstep").toInt();
+        if (webServer.hasArg("tmax"))    lim.maxTemp = webServer.arg("tmax").toFloat();
+        if (webServer.hasArg("vrmax"))   lim.maxVrTemp = webServer.arg("vrmax").toFloat();
+        if (webServer.hasArg("vinmin"))  lim.minVin = webServer.arg("vinmin").toFloat();
+        if (webServer.hasArg("settle"))  lim.settleSec = webServer.arg("settle").toInt();
+        if (webServer.hasArg("measure")) lim.measureSec = webServer.arg("measure").toInt();
+        // Same hard bounds as the manual mV buttons
+        lim.mvMin = max(lim.mvMin, 1000);
+        lim.mvMax = min(lim.mvMax, 1400);
+        lim.freqMin = max(lim.freqMin, 100);
+        if (!autoTuner.start(idx, tuneSampleOf(idx), lim, millis() / 1000)) {
+            webServer.send(400, "text/plain", "Invalid limits or no hashrate yet");
+            return;
+        }
+        webServer.send(200, "text/plain", "Tuning started");
+    });
+
+    webServer.on("/api/tune/stop", HTTP_POST, []() {
+        int idx = webServer.hasArg("device") ? webServer.arg("device").toInt() : -1;
+        int freq, mv;
+        if (idx < 0 || idx >= deviceCount || !autoTuner.active(idx)) {
+            webServer.send(400, "text/plain", "Device is not tuning");
+            return;
+        }
+        // Mid-search the original settings go back; a converged device keeps its best point
+        if (autoTuner.stop(idx, millis() / 1000, freq, mv)) postDevicePoint(idx, freq, mv);
+        webServer.send(200, "text/plain", "Tuning stopped");
+    });
+
+    // Power cap: GET status, POST ?cap=W[&hyst=W] (cap=0 disables)
+    webServer.on("/api/power", HTTP_GET, []() {
+        ScratchJsonDocument doc(768);
+        doc["cap"] = powerGov.cap();
+        doc["hysteresis"] = powerGov.hysteresis();
+        doc["power"] = fleetStats.totalPower();
+        doc["state"] = powerGov.lastReason();
+        JsonArray cuts = doc.createNestedArray("cutMHz");
+        for (int i = 0; i < deviceCount; i++) cuts.add(powerGov.cutMHz(i));
+        sendJson(200, doc);
+    });
+
+    webServer.on("/api/power", HTTP_POST, []() {
+        float cap = webServer.hasArg("cap") ? webServer.arg("cap").toFloat() : powerGov.cap();
+        float hyst = webServer.hasArg("hyst") ? webServer.arg("hyst").toFloat() : powerGov.hysteresis();
+        if (cap < 0 || hyst < 0) {
+            webServer.send(400, "text/plain", "cap and hyst must be >= 0");
+            return;
+        }
+        settings.setFloat("powerCap", cap, millis());
+        settings.setFloat("powerHyst", hyst, millis());
+        powerGov.configure(cap, hyst);
+        webServer.send(200, "text/plain", cap > 0 ? "Power cap set" : "Power cap disabled");
+    });
+
+    // Thermal governor: GET status, POST ?enabled=0|1&throttle=C&device=N|all&curve=T:P,T:P,...
+    webServer.on("/api/thermal", HTTP_GET, []() {
+        ScratchJsonDocument doc(1024 + MAX_DEVICES * 192);
+        uint32_t now = millis() / 1000;
+        doc["enabled"] = thermalGov.enabled();
+        doc["throttleTemp"] = thermalGov.config().throttleTemp;
+        JsonArray devs = doc.createNestedArray("devices");
+        char curve[64];
+        for (int i = 0; i < deviceCount; i++) {
+            JsonObject d = devs.createNestedObject();
+            d["temp"] = fleet.temperature[i];
+            d["fanSpeed"] = devices[i].fanSpeed;
+            d["fanTarget"] = thermalGov.fanTarget(i);
+            d["cutMHz"] = thermalGov.cutMHz(i);
+            d["paused"] = thermalGov.paused(i, now);
+            thermalGov.curve(i).format(curve, sizeof(curve));
+            d["curve"] = curve;
+        }
+        sendJson(200, doc);
+    });
+
+    webServer.on("/api/thermal", HTTP_POST, []() {
+        if (webServer.hasArg("curve")) {
+            FanCurve curve;
+            String text = webServer.arg("curve");
+            if (!curve.parse(text.c_str())) {
+                webServer.send(400, "text/plain", "Curve must be ascending T:P pairs, e.g. 45:35,58:70,66:100");
+                return;
+            }
+            String dev = webServer.hasArg("device") ? webServer.arg("device") : String("all");
+            int first = 0, last = MAX_DEVICES - 1;
+            if (dev != "all") {
+                first = last = dev.toInt();
+                if (first < 0 || first >= deviceCount) {
+                    webServer.send(400, "text/plain", "Unknown device");
+                    return;
+                }
+            }
+            char key[24];
+            for (int i = first; i <= last; i++) {
+                thermalGov.curve(i) = curve;
+                snprintf(key, sizeof(key), "fanCurve%d", i);
+                prefs.putString(key, text);
+            }
+        }
+        if (webServer.hasArg("throttle")) {
+            thermalGov.config().throttleTemp = webServer.arg("throttle").toFloat();
+            settings.setFloat("throttleC", thermalGov.config().throttleTemp, millis());
+        }
+        if (webServer.hasArg("enabled")) {
+            bool on = webServer.arg("enabled").toInt() != 0;
+            thermalGov.setEnabled(on);
+            settings.setBool("thermalOn", on, millis());
+        }
+        webServer.send(200, "text/plain", "Thermal settings saved");
+    });
+
+    // Benchmark page: start / stop a sweep and watch the heatmap fill in
+    webServer.on("/benchmark", HTTP_GET, []() {
+        String page = F(
+            "<!DOCTYPE html><html><head><meta charset='utf-8'>"
+            "<meta name='viewport' content='width=device-width,initial-scale=1'>"
+            "<title>BitAxe Benchmark</title>"
+            WEB_PAGE_STYLE
+            "<style>.row{display:flex;gap:8px}.row>div{flex:1}"
+            "table{border-collapse:collapse;margin:15px 0;font-size:11px}td,th{border:1px solid #000;padding:3px 5px;text-align:center}"
+            "th{color:#A36000;font-weight:normal}</style>"
+            "</head><body>"
+            "<h1>&#9881; BENCHMARK</h1>"
+            "<div class='row'><div><label>Device #</label><input id='device' value='0'></div>"
+            "<div><label>Settle s</label><input id='settle' value='180'></div>"
+            "<div><label>Measure s</label><input id='measure' value='300'></div></div>"
+            "<div class='row'><div><label>MHz min</label><input id='fmin' value='400'></div>"
+            "<div><label>MHz max</label><input id='fmax' value='600'></div>"
+            "<div><label>MHz step</label><input id='fstep' value='25'></div></div>"
+            "<div class='row'><div><label>mV min</label><input id='vmin' value='1100'></div>"
+            "<div><label>mV max</label><input id='vmax' value='1250'></div>"
+            "<div><label>mV step</label><input id='vstep' value='25'></div></div>"
+            "<div class='row'><div><label>Max chip C</label><input id='tmax' value='65'></div>"
+            "<div><label>Max VR C</label><input id='vrmax' value='85'></div>"
+            "<div><label>Min Vin</label><input id='vinmin' value='4.8'></div></div>"
+            "<div class='note'>Up to 12 x 12 points; the device is restored to its current settings afterwards</div>"
+            "<button onclick='go()'>[ START ]</button>"
+            "<button class='warn' onclick=\"post('/api/benchmark/stop')\">[ STOP ]</button>"
+            "<button onclick=\"location='/api/benchmark.csv'\">[ CSV ]</button>"
+            "<div id='st' class='note'></div><table id='map'></table>"
+            "<script>"
+            "function post(u){fetch(u,{method:'POST'}).then(r=>r.text()).then(t=>{st.textContent=t;load()})}"
+            "function go(){var q=[];['device','settle','measure','fmin','fmax','fstep','vmin','vmax','vstep','tmax','vrmax','vinmin']"
+            ".forEach(k=>q.push(k+'='+encodeURIComponent(document.getElementById(k).value)));post('/api/benchmark/start?'+q.join('&'))}"
+            "function load(){fetch('/api/benchmark').then(r=>r.json()).then(b=>{"
+            "st.textContent=b.state+(b.rows?' '+b.done+'/'+(b.rows*b.cols):'')+(b.best?' | best '+b.best.frequency+'MHz '+b.best.coreVoltage+'mV '+b.best.jth.toFixed(2)+' J/TH':'');"
+            "if(!b.rows){map.innerHTML='';return}var lo=1e9,hi=0;"
+            "b.cells.forEach(r=>r.forEach(c=>{if(c[0]=='done'&&c[1]>0){var j=c[2]/c[1]*1000;lo=Math.min(lo,j);hi=Math.max(hi,j)}}));"
+            "var h='<tr><th>MHz/mV</th>'+b.voltages.map(v=>'<th>'+v+'</th>').join('')+'</tr>';"
+            "b.cells.forEach((r,i)=>{h+='<tr><th>'+b.frequencies[i]+'</th>';r.forEach((c,k)=>{var bg='#000020',t=c[0];"
+            "if(t=='done'&&c[1]>0){var j=c[2]/c[1]*1000,f=hi>lo?(j-lo)/(hi-lo):0;bg='hsl('+(48-48*f)+',100%,'+(50-25*f)+'%)';"
+            "t=j.toFixed(1)+'<br>'+c[1].toFixed(0)+'G '+c[3].toFixed(0)+'C'+(c[4]>0?'<br>'+c[4].toFixed(1)+'%':'')}"
+            "else if(t=='unsafe')bg='#800';else if(t=='pending')t='';"
+            "if(b.current&&b.current[0]==i&&b.current[1]==k)bg+=';outline:2px solid #fff';"
+            "h+='<td style=\\'background:'+bg+';color:'+(f<.5?'#000':'#FFB000')+'\\'>'+t+'</td>'});h+='</tr>'});map.innerHTML=h})}"
+            "load();setInterval(load,5000)"
+            "</script></body></html>"
+        );
+        webServer.send(200, "text/html", page);
+    });
+
+    // Benchmark status and result grid; cells are [state, GH/s, W, C, reject %]
+    webServer.on("/api/benchmark", HTTP_GET, []() {
+        int rows = benchmark.rows(), cols = benchmark.cols();
+        ScratchJsonDocument doc(1024 + JSON_ARRAY_SIZE(rows) * 2 + JSON_ARRAY_SIZE(cols) * (rows + 1) +
+                                rows * cols * JSON_ARRAY_SIZE(5));
+        doc["state"] = BENCH_STATE_NAMES[benchmark.state()];
+        if (benchmark.hasResults()) {
+            const BenchConfig &cfg = benchmark.config();
+            doc["device"] = cfg.device;
+            doc["elapsed"] = millis() / 1000 - benchmark.startedAt();
+            doc["settle"] = cfg.settleSec;
+            doc["measure"] = cfg.measureSec;
+            doc["rows"] = rows;
+            doc["cols"] = cols;
+            doc["done"] = benchmark.pointsDone();
+            if (benchmark.running()) {
+                JsonArray cur = doc.createNestedArray("current");
+                cur.add(benchmark.currentRow());
+                cur.add(benchmark.currentCol());
+            }
+            int bestR, bestC;
+            if (benchmark.best(bestR, bestC)) {
+                JsonObject best = doc.createNestedObject("best");
+                best["frequency"] = benchmark.freqAt(bestR);
+                best["coreVoltage"] = benchmark.mvAt(bestC);
+                best["jth"] = benchmark.cell(bestR, bestC).jth();
+                best["hashRate"] = benchmark.cell(bestR, bestC).hashRate;
+            }
+            JsonArray freqs = doc.createNestedArray("frequencies");
+            for (int r = 0; r < rows; r++) freqs.add(benchmark.freqAt(r));
+            JsonArray volts = doc.createNestedArray("voltages");
+            for (int c = 0; c < cols; c++) volts.add(benchmark.mvAt(c));
+            JsonArray cells = doc.createNestedArray("cells");
+            for (int r = 0; r < rows; r++) {
+                JsonArray row = cells.createNestedArray();
+                for (int c = 0; c < cols; c++) {
+                    const BenchCell &cell = benchmark.cell(r, c);
+                    JsonArray a = row.createNestedArray();
+                    a.add(BENCH_CELL_NAMES[cell.state]);
+                    a.add(cell.hashRate);
+                    a.add(cell.power);
+                    a.add(cell.temperature);
+                    a.add(cell.errPct);
+                }
+            }
+        }
+        sendJson(200, doc);
+    });
+
+    // Result table, one line per grid point
+    webServer.on("/api/benchmark.csv", HTTP_GET, []() {
+        if (!benchmark.hasResults()) {
+            webServer.send(404, "text/plain", "No benchmark results");
+            return;
+        }
+        String out;
+        out.reserve(80 + benchmark.rows() * benchmark.cols() * 56);
+        out = "frequency,coreVoltage,state,hashrate,power,temperature,jth,rejectPct\n";
+        char line[96];
+        for (int r = 0; r < benchmark.rows(); r++) {
+            for (int c = 0; c < benchmark.cols(); c++) {
+                const BenchCell &cell = benchmark.cell(r, c);
+                snprintf(line, sizeof(line), "%d,%d,%s,%.1f,%.2f,%.1f,%.3f,%.2f\n",
+                         benchmark.freqAt(r), benchmark.mvAt(c), BENCH_CELL_NAMES[cell.state],
+                         cell.hashRate, cell.power, cell.temperature, cell.jth(), cell.errPct);
+                out += line;
+            }
+        }
+        webServer.sendHeader("Content-Disposition", "attachment; filename=benchmark.csv");
+        webServer.send(200, "text/csv", out);
+    });
+
+    // POST /api/benchmark/start?device=N[&fmin=&fmax=&fstep=&vmin=&vmax=&vstep=&tmax=&vrmax=&vinmin=&settle=&measure=]
+    webServer.on("/api/benchmark/start", HTTP_POST, []() {
+        int idx = webServer.hasArg("device") ? webServer.arg("device").toInt() : -1;
+        if (idx < 0 || idx >= deviceCount || !fleet.valid[idx]) {
+            webServer.send(400, "text/plain", "Unknown or offline device");
+            return;
+        }
+        if (benchmark.running() || autoTuner.active(idx)) {
+            webServer.send(409, "text/plain", "A benchmark or auto-tune is already running");
+            return;
+        }
+        BenchConfig cfg;
+        cfg.device = idx;
+        if (webServer.hasArg("fmin"))    cfg.freqMin = webServer.arg("fmin").toInt();
+        if (webServer.hasArg("fmax"))    cfg.freqMax = webServer.arg("fmax").toInt();
+        if (webServer.hasArg("fstep"))   cfg.freqStep = webServer.arg("fstep").toInt();
+        if (webServer.hasArg("vmin"))    cfg.mvMin = webServer.arg("vmin").toInt();
+        if (webServer.hasArg("vmax"))    cfg.mvMax = webServer.arg("vmax").toInt();
+        if (webServer.hasArg("vstep"))   cfg.mvStep = webServer.arg("vstep").toInt();
+        if (webServer.hasArg("tmax"))    cfg.maxTemp = webServer.arg("tmax").toFloat();
+        if (webServer.hasArg("vrmax"))   cfg.maxVrTemp = webServer.arg("vrmax").toFloat();
+        if (webServer.hasArg("vinmin"))  cfg.minVin = webServer.arg("vinmin").toFloat();
+        if (webServer.hasArg("settle"))  cfg.settleSec = webServer.arg("settle").toInt();
+        if (webServer.hasArg("measure")) cfg.measureSec = webServer.arg("measure").toInt();
+        // Same hard bounds as the manual mV buttons and the tuner
+        cfg.mvMin = max(cfg.mvMin, 1000);
+        cfg.mvMax = min(cfg.mvMax, 1400);
+        cfg.freqMin = max(cfg.freqMin, 100);
+        if (!benchmark.start(cfg, benchSampleOf(idx), millis() / 1000)) {
+            webServer.send(400, "text/plain", "Invalid grid (max 12 x 12 points)");
+            return;
+        }
+        // The sweep owns frequency and voltage now; governor cuts no longer apply
+        powerGov.forget(idx);
+        thermalGov.forget(idx);
+        webServer.send(200, "text/plain", "Benchmark started");
+    });
+
+    webServer.on("/api/benchmark/stop", HTTP_POST, []() {
+        if (!benchmark.running()) {
+            webServer.send(400, "text/plain", "No benchmark running");
+            return;
+        }
+        benchmark.abort();
+        webServer.send(200, "text/plain", "Benchmark stopping, restoring settings");
+    });
+
+    // Tariff, energy and profiles: GET status,
+    // POST ?tariff=HH:MM-HH:MM[/days]=rate[@pct],...&tz=POSIX&profiles=0|1&reset=1
+    webServer.on("/api/energy", HTTP_GET, []() {
+        ScratchJsonDocument doc(1536);
+        const EnergyTotals &t = energyMeter.totals();
+        char buf[256];
+        tariff.format(buf, sizeof(buf));
+        doc["tariff"] = buf;
+        doc["tz"] = prefs.getString("tz", "UTC0");
+        doc["baseRate"] = electricityRate;
+        doc["rate"] = currentRate();
+        doc["profiles"] = profiles.enabled();
+        doc["profilePct"] = profiles.pct();
+        doc["projectedDailyCost"] = projectedDailyCost(fleetStats.totalPower());
+        doc["kWh"] = t.kWh;
+        doc["cost"] = t.cost;
+        doc["todayKWh"] = t.todayKWh;
+        doc["todayCost"] = t.todayCost;
+        doc["yesterdayKWh"] = t.yesterdayKWh;
+        doc["yesterdayCost"] = t.yesterdayCost;
+        struct tm tm;
+        if (localTime(tm)) {
+            strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tm);
+            doc["localTime"] = buf;
+        }
+        JsonArray devs = doc.createNestedArray("devices");
+        for (int i = 0; i < deviceCount; i++) {
+            JsonObject d = devs.createNestedObject();
+            d["index"] = i;
+            d["baseFrequency"] = profiles.base(i);
+        }
+        sendJson(200, doc);
+    });
+
+    webServer.on("/api/energy", HTTP_POST, []() {
+        if (webServer.hasArg("tariff")) {
+            String text = webServer.arg("tariff");
+            if (!tariff.parse(text.c_str())) {
+                webServer.send(400, "text/plain", "Bad tariff, expected HH:MM-HH:MM[/1234567]=rate[@pct],...");
+                return;
+            }
+            char buf[256];
+            tariff.format(buf, sizeof(buf));
+            prefs.putString("tariff", buf);
+            rateHoursDay = -1;
+        }
+        if (webServer.hasArg("tz")) {
+            String tz = webServer.arg("tz");
+            prefs.putString("tz", tz);
+            setenv("TZ", tz.c_str(), 1);
+            tzset();
+        }
+        if (webServer.hasArg("profiles")) {
+            bool on = webServer.arg("profiles").toInt() != 0;
+            profiles.setEnabled(on);
+            settings.setBool("profilesOn", on, millis());
+        }
+        if (webServer.hasArg("reset") && webServer.arg("reset").toInt() != 0) {
+            energyMeter.reset();
+            saveEnergy();
+        }
+        webServer.send(200, "text/plain", "Energy settings saved");
+    });
+
+    // Alerts: GET rules / active / recent events, POST ?rules=...&webhook=URL (empty disables)
+    webServer.on("/api/alerts", HTTP_GET, []() {
+        ScratchJsonDocument doc(2048 + ALERT_MAX_RULES * 160 + ALERT_QUEUE_SIZE * 96);
+        char buf[ALERT_MAX_RULES * 64];
+        alerts.format(buf, sizeof(buf));
+        doc["rules"] = buf;
+        doc["webhook"] = alertWebhook;
+        doc["pending"] = alerts.pending();
+        doc["dropped"] = alerts.dropped();
+        doc["activeCount"] = alerts.activeCount();
+        JsonArray compiled = doc.createNestedArray("compiled");
+        for (int r = 0; r < alerts.ruleCount(); r++) {
+            const AlertRule &a = alerts.rule(r);
+            JsonObject o = compiled.createNestedObject();
+            o["metric"] = ALERT_METRIC_NAMES[a.metric];
+            o["op"] = a.below ? "<" : ">";
+            o["threshold"] = a.threshold;
+            o["for"] = a.forN;
+            o["hyst"] = a.hyst;
+            o["cooldown"] = a.cooldownSec;
+            if (a.device != ALERT_ALL_DEVICES) o["device"] = a.device;
+            JsonArray act = o.createNestedArray("active");
+            for (int i = 0; i < deviceCount; i++) {
+                if (alerts.active(r, i)) act.add(i);
+            }
+        }
+        uint32_t now = millis() / 1000;
+        JsonArray events = doc.createNestedArray("events");
+        for (int k = 0; k < alerts.logCount(); k++) {
+            const AlertEvent &e = alerts.logEntry(k);
+            JsonObject o = events.createNestedObject();
+            o["age"] = now - e.t;
+            o["rule"] = e.rule;
+            o["device"] = e.device;
+            o["event"] = e.raised ? "raised" : "cleared";
+            o["value"] = e.value;
+        }
+        sendJson(200, doc);
+    });
+
+    webServer.on("/api/alerts", HTTP_POST, []() {
+        if (webServer.hasArg("webhook") && webServer.arg("webhook").length() >= ALERT_HOOK_URL_MAX) {
+            webServer.send(400, "text/plain", "Webhook URL too long");
+            return;
+        }
+        if (webServer.hasArg("rules")) {
+            String rules = webServer.arg("rules");
+            const char* err = nullptr;
+            if (!alerts.compile(rules.c_str(), &err)) {
+                String msg = "Bad rule at: ";
+                msg += err ? err : "";
+                webServer.send(400, "text/plain", msg);
+                return;
+            }
+            prefs.putString("alertRules", rules);
+        }
+        if (webServer.hasArg("webhook")) {
+            alertWebhook = webServer.arg("webhook");
+            alertWebhook.trim();
+            prefs.putString("alertHook", alertWebhook);
+        }
+        webServer.send(200, "text/plain", "Alert settings saved");
+    });
+
+    // Fleet bulk control page
+    webServer.on("/fleet", HTTP_GET, []() {
+        String page = F(
+            "<!DOCTYPE html><html><head><meta charset='utf-8'>"
+            "<meta name='viewport' content='width=device-width,initial-scale=1'>"
+            "<title>BitAxe Fleet</title>"
+            WEB_PAGE_STYLE
+            "<style>.row{display:flex;gap:8px}.row>div{flex:1}"
+            "table{border-collapse:collapse;margin:15px 0;font-size:12px;width:100%}td,th{border:1px solid #614000;padding:3px 5px;text-align:center}"
+            "th{color:#A36000;font-weight:normal}</style>"
+            "</head><body>"
+            "<h1>&#9881; FLEET</h1>"
+            "<label>Devices</label><input id='devices' value='all'>"
+            "<div class='note'>all, or device numbers: 0,2,5</div>"
+            "<div class='row'><div><label>Frequency MHz</label><input id='frequency' placeholder='550 or +25'></div>"
+            "<div><label>Core mV</label><input id='coreVoltage' placeholder='1200 or -25'></div>"
+            "<div><label>Fan %</label><input id='fan' placeholder='80'></div></div>"
+            "<div class='note'>Blank fields are left alone; a leading + or - steps each device from its own setting</div>"
+            "<button onclick='apply()'>[ APPLY ]</button>"
+            "<div class='row'><div><label>Restart stagger s</label><input id='stagger' value='20'></div></div>"
+            "<button class='warn' onclick=\"if(confirm('Restart the selected devices?'))post('restart=1&stagger='+stagger.value)\">[ RESTART ]</button>"
+            "<div id='st' class='note'></div><table id='tb'></table>"
+            "<script>var t;"
+            "function post(x){st.textContent='...';fetch('/api/bulk?devices='+encodeURIComponent(devices.value)+'&'+x,{method:'POST'})"
+            ".then(r=>r.ok?r.json():r.text().then(e=>{throw e})).then(show).catch(e=>st.textContent=e)}"
+            "function apply(){var q=[];['frequency','coreVoltage','fan'].forEach(k=>{var v=document.getElementById(k).value.trim();"
+            "if(v)q.push(k+'='+encodeURIComponent(v))});if(q.length)post(q.join('&'))}"
+            "function show(b){var j={};(b.jobs||[]).forEach(x=>j[x.device]=x);"
+            "st.textContent=b.id?b.kind+' #'+b.id+': '+b.ok+'/'+b.count+' ok'+(b.busy?' (running)':''):'No operation yet';"
+            "var h='<tr><th>#</th><th>Worker</th><th>MHz</th><th>mV</th><th>Fan</th><th>Result</th></tr>';"
+            "b.devices.forEach((d,i)=>{var x=j[i],r='';if(x)r=x.state=='ok'?'ok '+x.rtt+' ms':x.startIn?'in '+Math.ceil(x.startIn/1000)+' s':x.state+(x.status>0?' '+x.status:'');"
+            "h+='<tr><td>'+i+'</td><td>'+(d.hostname||d.ip)+'</td><td>'+(d.online?d.frequency:'-')+'</td><td>'+(d.online?d.coreVoltage:'-')+'</td>"
+            "<td>'+(d.online?d.fan+'%':'-')+'</td><td>'+r+'</td></tr>'});tb.innerHTML=h;clearTimeout(t);t=setTimeout(load,b.busy?1000:5000)}"
+            "function load(){fetch('/api/bulk').then(r=>r.json()).then(show)}load()"
+            "</script></body></html>"
+        );
+        webServer.send(200, "text/html", page);
+    });
+
+    // Bulk control: GET the last operation, POST ?devices=all|0,2&frequency=&coreVoltage=&fan=
+    // (absolute, or +/- steps) or ?restart=1&stagger=<s>. POST answers 202 as soon as the operation
+    // is queued; loop() drives it and GET reports progress until "busy" is false.
+    webServer.on("/api/bulk", HTTP_GET, []() {
+        sendBulkStatus(200);
+    });
+
+    webServer.on("/api/bulk", HTTP_POST, []() {
+        bool selected[MAX_DEVICES];
+        if (!parseDeviceSelection(selected)) {
+            webServer.send(400, "text/plain", "Bad device list");
+            return;
+        }
+        if (bulk.busy()) {
+            webServer.send(409, "text/plain", "A bulk operation is still running");
+            return;
+        }
+        if (replaying()) {
+            webServer.send(409, "text/plain", "Replaying a trace");
+            return;
+        }
+        uint32_t staggerMs = 0;
+        int queued;
+        if (webServer.hasArg("restart") && webServer.arg("restart").toInt() != 0) {
+            int stagger = webServer.hasArg("stagger") ? webServer.arg("stagger").toInt() : 0;
+            if (stagger < 0 || stagger > 600) {
+                webServer.send(400, "text/plain", "stagger must be 0-600 s");
+                return;
+            }
+            staggerMs = stagger * 1000UL;
+            queued = startBulkRestart(selected, staggerMs);
+        } else {
+            BulkSetting setting = {};
+            const char* keys[CF_COUNT] = {"frequency", "coreVoltage", "fan"};
+            for (int f = 0; f < CF_COUNT; f++) {
+                if (!webServer.hasArg(keys[f])) continue;
+                String v = webServer.arg(keys[f]);
+                v.trim();
+                if (v.length() == 0) continue;
+                setting.set[f] = true;
+                setting.relative[f] = v.c_str()[0] == '+' || v.c_str()[0] == '-';
+                setting.value[f] = v.toInt();
+                if (!setting.relative[f] && (setting.value[f] < CONTROL_MIN[f] || setting.value[f] > CONTROL_MAX[f])) {
+                    String msg = String(keys[f]) + " must be " + CONTROL_MIN[f] + "-" + CONTROL_MAX[f];
+                    webServer.send(400, "text/plain", msg);
+                    return;
+                }
+            }
+            if (!setting.set[CF_FREQ] && !setting.set[CF_VOLT] && !setting.set[CF_FAN]) {
+                webServer.send(400, "text/plain", "Nothing to do: give frequency, coreVoltage, fan or restart=1");
+                return;
+            }
+            queued = startBulkSettings(selected, setting);
+        }
+        if (queued <= 0) {
+            webServer.send(400, "text/plain", "No online device selected");
+            return;
+        }
+        sendBulkStatus(202);
+    });
+
+    // Watchdog: GET per-device state and restart history,
+    // POST ?enabled=0|1&zeroMin=&staleMin=&gapMin=&rearm=<device>|all
+    webServer.on("/api/watchdog", HTTP_GET, []() {
+        ScratchJsonDocument doc(1024 + deviceCount * 192 + WATCHDOG_LOG_SIZE * 160);
+        WatchdogConfig &cfg = watchdog.config();
+        uint32_t now = millis() / 1000;
+        doc["enabled"] = watchdog.enabled();
+        doc["zeroMin"] = cfg.zeroHashSec / 60;
+        doc["staleMin"] = cfg.staleShareSec / 60;
+        doc["gapMin"] = cfg.minGapSec / 60;
+        doc["safeLevel"] = cfg.safeLevel;
+        doc["maxLevel"] = cfg.maxLevel;
+        JsonArray devs = doc.createNestedArray("devices");
+        for (int i = 0; i < deviceCount; i++) {
+            JsonObject o = devs.createNestedObject();
+            o["hostname"] = devices[i].hostname;
+            o["level"] = watchdog.level(i);
+            o["gaveUp"] = watchdog.gaveUp(i);
+            o["stuck"] = WATCH_REASON_NAMES[watchdog.stuck(i)];
+            if (watchdog.stuck(i) != WR_NONE) o["stuckFor"] = now - watchdog.stuckSince(i);
+            o["restarts"] = watchdog.restarts(i);
+            o["reboots"] = watchdog.reboots(i);
+            if (watchdog.restarts(i) > 0) o["lastRestartAge"] = now - watchdog.lastRestart(i);
+            o["holdoff"] = watchdog.holdoff(i, now);
+        }
+        JsonArray hist = doc.createNestedArray("history");
+        for (int k = 0; k < watchdog.logCount(); k++) {
+            const WatchEvent &e = watchdog.logEntry(k);
+            JsonObject o = hist.createNestedObject();
+            o["age"] = now - e.t;
+            if (clockSynced()) o["time"] = (uint32_t)time(nullptr) - (now - e.t);
+            o["device"] = e.device;
+            o["hostname"] = devices[e.device].hostname;
+            o["event"] = WATCH_EVENT_NAMES[e.kind];
+            if (e.reason != WR_NONE) o["reason"] = WATCH_REASON_NAMES[e.reason];
+            o["level"] = e.level;
+            o["ok"] = e.ok;
+            if (e.frequency >= 0) o["frequency"] = e.frequency;
+        }
+        sendJson(200, doc);
+    });
+
+    webServer.on("/api/watchdog", HTTP_POST, []() {
+        WatchdogConfig &cfg = watchdog.config();
+        if (webServer.hasArg("zeroMin")) {
+            int m = webServer.arg("zeroMin").toInt();
+            if (m < 1 || m > 240) { webServer.send(400, "text/plain", "zeroMin must be 1-240"); return; }
+            cfg.zeroHashSec = m * 60;
+            settings.setInt("wdZeroMin", m, millis());
+        }
+        if (webServer.hasArg("staleMin")) {
+            int m = webServer.arg("staleMin").toInt();
+            if (m < 5 || m > 1440) { webServer.send(400, "text/plain", "staleMin must be 5-1440"); return; }
+            cfg.staleShareSec = m * 60;
+            settings.setInt("wdStaleMin", m, millis());
+        }
+        if (webServer.hasArg("gapMin")) {
+            int m = webServer.arg("gapMin").toInt();
+            if (m < 5 || m > 720) { webServer.send(400, "text/plain", "gapMin must be 5-720"); return; }
+            cfg.minGapSec = m * 60;
+            settings.setInt("wdGapMin", m, millis());
+        }
+        if (webServer.hasArg("enabled")) {
+            bool on = webServer.arg("enabled").toInt() != 0;
+            watchdog.setEnabled(on);
+            settings.setBool("wdOn", on, millis());
+        }
+        if (webServer.hasArg("rearm")) {
+            String which = webServer.arg("rearm");
+            if (which == "all") {
+                for (int i = 0; i < deviceCount; i++) watchdog.rearm(i);
+            } else {
+                int i = which.toInt();
+                if (i < 0 || i >= deviceCount) { webServer.send(400, "text/plain", "Bad device"); return; }
+                watchdog.rearm(i);
+            }
+        }
+        webServer.send(200, "text/plain", "Watchdog settings saved");
+    });
+
+    // Timing histograms: GET /debug/perf[?buckets=1][&reset=1][&overlay=0|1]
+    webServer.on("/debug/perf", HTTP_GET, []() {
+        if (webServer.hasArg("overlay")) {
+            bool on = webServer.arg("overlay").toInt() != 0;
+            if (perfOverlay && !on) redrawCurrentScreen();
+            perfOverlay = on;
+        }
+        sendPerfStats();
+        if (webServer.hasArg("reset") && webServer.arg("reset").toInt() != 0) perf.reset();
+    });
+
+    // Heap and stack telemetry: GET /api/heap
+    webServer.on("/api/heap", HTTP_GET, []() {
+        sendHeapTelemetry();
+    });
+
+    // Trace capture / replay: GET status, POST ?capture=1&maxKB= | capture=0 | replay=<file>&speed= | stop=1.
+    // Files live in /trace; /api/trace/file?name= downloads one.
+    webServer.on("/api/trace", HTTP_GET, []() {
+        sendTraceStatus(200);
+    });
+
+    webServer.on("/api/trace", HTTP_POST, []() {
+        if (webServer.hasArg("stop")) {
+            stopCapture();
+            stopReplay();
+        } else if (webServer.hasArg("capture")) {
+            if (webServer.arg("capture").toInt() == 0) {
+                stopCapture();
+            } else {
+                long maxKB = webServer.hasArg("maxKB") ? webServer.arg("maxKB").toInt() : 256;
+                if (maxKB < 4 || maxKB > 1024) {
+                    webServer.send(400, "text/plain", "maxKB must be 4-1024");
+                    return;
+                }
+                if (replaying()) {
+                    webServer.send(409, "text/plain", "Replaying a trace");
+                    return;
+                }
+                char path[48];
+                snprintf(path, sizeof(path), TRACE_DIR "/%lu.trc", (unsigned long)(clockSynced() ? time(nullptr) : millis() / 1000));
+                if (!startCapture(path, maxKB * 1024)) {
+                    webServer.send(500, "text/plain", "Cannot create trace file");
+                    return;
+                }
+            }
+        } else if (webServer.hasArg("replay")) {
+            String name = webServer.arg("replay");
+            float speed = webServer.hasArg("speed") ? webServer.arg("speed").toFloat() : 1.0f;
+            if (name.indexOf('/') >= 0 || name.length() == 0 || speed <= 0 || speed > 1000) {
+                webServer.send(400, "text/plain", "Give replay=<file in /trace> and speed 0-1000");
+                return;
+            }
+            if (replaying() || traceWriter.open()) {
+                webServer.send(409, "text/plain", "Capture or replay already running");
+                return;
+            }
+            String path = String(TRACE_DIR "/") + name;
+            if (!startReplay(path.c_str(), speed)) {
+                webServer.send(400, "text/plain", "Not a readable trace");
+                return;
+            }
+        } else {
+            webServer.send(400, "text/plain", "Give capture=0|1, replay=<file> or stop=1");
+            return;
+        }
+        sendTraceStatus(200);
+    });
+
+    webServer.on("/api/trace/file", HTTP_GET, []() {
+        String name = webServer.arg("name");
+        if (name.length() == 0 || name.indexOf('/') >= 0) {
+            webServer.send(400, "text/plain", "Give name=<file in /trace>");
+            return;
+        }
+        String path = String(TRACE_DIR "/") + name;
+        if (traceWriter.open() && path == tracePath) {
+            webServer.send(409, "text/plain", "Still capturing");
+            return;
+        }
+        File f = LittleFS.open(path, FILE_READ);
+        if (!f) {
+            webServer.send(404, "text/plain", "No such trace");
+            return;
+        }
+        webServer.streamFile(f, "application/octet-stream");
+        f.close();
+    });
+
+    // History export: /api/history?device=0|fleet|all&metric=hashrate|temp|power|all
+    //                 &from=<epoch or -secs>&to=<epoch>&step=<secs, 0 = raw>&format=csv|bin
+    webServer.on("/api/history", HTTP_GET, []() {
+        if (historyExport.active()) {
+            webServer.send(503, "text/plain", "Export already running");
+            return;
+        }
+        HistoryQuery q;
+        String dev = webServer.hasArg("device") ? webServer.arg("device") : String("all");
+        if (dev == "all") {
+            q.firstSeries = 0;
+            q.lastSeries = HIST_FLEET;
+        } else if (dev == "fleet") {
+            q.firstSeries = q.lastSeries = HIST_FLEET;
+        } else {
+            int idx = dev.toInt();
+            if (idx < 0 || idx >= deviceCount) {
+                webServer.send(400, "text/plain", "Unknown device");
+                return;
+            }
+            q.firstSeries = q.lastSeries = idx;
+        }
+
+        String metric = webServer.hasArg("metric") ? webServer.arg("metric") : String("all");
+        q.metricMask = 0;
+        for (int m = 0; m < HM_COUNT; m++) {
+            if (metric == "all" || metric == HEXP_METRIC_NAMES[m]) q.metricMask |= 1 << m;
+        }
+        if (q.metricMask == 0) {
+            webServer.send(400, "text/plain", "Unknown metric");
+            return;
+        }
+
+        uint32_t now = historyClock();
+        q.to = webServer.hasArg("to") ? min((uint32_t)webServer.arg("to").toInt(), now + 1) : now + 1;
+        long from = webServer.hasArg("from") ? webServer.arg("from").toInt() : -3600;
+        q.from = (from < 0) ? (uint32_t)max(0L, (long)now + from) : (uint32_t)from;
+        q.step = webServer.hasArg("step") ? (uint32_t)webServer.arg("step").toInt() : 0;
+        q.binary = webServer.hasArg("format") && webServer.arg("format") == "bin";
+        if (q.to <= q.from) {
+            webServer.send(400, "text/plain", "Empty time range");
+            return;
+        }
+
+        // The export owns the socket from here; loop() streams it in slices
+        historyExport.begin(webServer.client(), q, history, metricLog);
+    });
+
     webServer.onNotFound([]() {
         webServer.sendHeader("Location", "/");
         webServer.send(302);
@@ -1902,16 +4358,37 @@ void setup() {
     drawBootScreen();
 
     prefs.begin("bitaxemon", false);
-    selectedCoin = prefs.getInt("coin", 0);
-    electricityRate = prefs.getFloat("elecRate", 0.12);
+    selectedCoin = settings.getInt("coin", 0);
+    electricityRate = settings.getFloat("elecRate", 0.12);
+    tariff.baseRate = electricityRate;
+    tariff.parse(prefs.getString("tariff", "").c_str());
+    blockReward = settings.getFloat("blockReward", 3.125);
+    if (!alerts.compile(prefs.getString("alertRules", ALERT_RULES_DEFAULT).c_str())) alerts.compile(ALERT_RULES_DEFAULT);
+    alertWebhook = prefs.getString("alertHook", "");
+    profiles.setEnabled(settings.getBool("profilesOn", false));
+    {
+        EnergyTotals saved;
+        if (prefs.getBytes("energy", &saved, sizeof(saved)) == sizeof(saved)) energyMeter.restore(saved);
+    }
+    powerGov.configure(settings.getFloat("powerCap", 0), settings.getFloat("powerHyst", 10));
+    thermalGov.setEnabled(settings.getBool("thermalOn", false));
+    thermalGov.config().throttleTemp = settings.getFloat("throttleC", 68);
+    loadFanCurves();
+    watchdog.setEnabled(settings.getBool("wdOn", false));
+    watchdog.config().zeroHashSec = settings.getInt("wdZeroMin", 5) * 60;
+    watchdog.config().staleShareSec = settings.getInt("wdStaleMin", 30) * 60;
+    watchdog.config().minGapSec = settings.getInt("wdGapMin", 30) * 60;
     if (selectedCoin < 0 || selectedCoin >= COIN_COUNT) selectedCoin = 0;
     String savedIPs = prefs.getString("ips", "");
     if (savedIPs.length() > 0) {
         parseDeviceIPs(savedIPs.c_str());
     }
 
+    // Mount the metric log (header-only recovery scan)
+    metricLog.begin(LOG_RETENTION_DAYS);
+
     // WiFiManager - scoped to free memory
-    char ipListBuf[320] = "";
+    char ipListBuf[DEVICE_LIST_LEN] = "";
     if (savedIPs.length() > 0) {
         savedIPs.toCharArray(ipListBuf, sizeof(ipListBuf));
     }
@@ -1939,7 +4416,7 @@ void setup() {
     wm.setCustomHeadElement(steampunkCSS);
     wm.setTitle("BITAXE SYSTEMS");
 
-    WiFiManagerParameter custom_ips("ips", "BitAxe IPs (comma-separated)", ipListBuf, 320);
+    WiFiManagerParameter custom_ips("ips", "BitAxe IPs (comma-separated)", ipListBuf, DEVICE_LIST_LEN);
     wm.addParameter(&custom_ips);
     wm.setConfigPortalTimeout(180);
 
@@ -1973,12 +4450,22 @@ void setup() {
         parseDeviceIPs(ipListBuf);
     }
 
+    // NTP time for history timestamps; the POSIX TZ string only matters for tariff windows
+    configTime(0, 0, "pool.ntp.org", "time.nist.gov");
+    setenv("TZ", prefs.getString("tz", "UTC0").c_str(), 1);
+    tzset();
+
     // Start mDNS — accessible at http://bitaxe.local
     if (MDNS.begin("bitaxe")) {
         MDNS.addService("http", "tcp", 80);
         Serial.println("mDNS: http://bitaxe.local");
     }
     setupWebServer();
+    fetchHttp.collectHeaders(fetchHeaders, 1);
+    apiClient.setInsecure();
+    startControlWorker();
+    startWebhookWorker();
+    heapTelemetry.begin(controlTask);
 
     Serial.printf("Free heap after WiFiManager: %d bytes\n", ESP.getFreeHeap());
     Serial.println("WiFi connected: " + WiFi.localIP().toString());
@@ -2005,13 +4492,49 @@ void setup() {
 
 void loop() {
     unsigned long now = millis();
-    webServer.handleClient();
-    handleTouch();
+    uint32_t loopAt = perfCycles();
+    if (perfLoopAt) perf.add(PS_LOOP_PERIOD, loopAt - perfLoopAt);
+    perfLoopAt = loopAt;
+    {
+        PerfScope timed(perf, PS_WEB);
+        HeapTag tag(HT_WEB);
+        webServer.handleClient();
+    }
+    {
+        HeapTag tag(HT_RENDER);
+        handleTouch();
+    }
+    {
+        HeapTag tag(HT_CONTROL);
+        pumpControlQueue(now);
+        pumpBulk(now);
+    }
+    if (currentScreen == fleetScreenIndex() && bulk.version() != fleetDrawnVersion) {
+        HeapTag tag(HT_RENDER);
+        drawFleetTable();
+    }
     updateLed(now);
+    {
+        HeapTag tag(HT_LOG);
+        metricLog.loop(clockSynced() ? (uint32_t)time(nullptr) : 0);
+        settings.loop(now);
+        historyExport.pump(20);
+        if (!historyExport.active()) pumpAlertWebhook(now);
+    }
+    if (alerts.version() != bannerVersion) {
+        HeapTag tag(HT_RENDER);
+        drawAlertBanner();
+    }
+    {
+        HeapTag tag(HT_FETCH);
+        pumpReplay(now);
+    }
+    heapTelemetry.loop(now / 1000);
 
-    // BTC price + network difficulty every 60s
-    if (now - lastBtcUpdate >= BTC_UPDATE_INTERVAL) {
+    // BTC price + network difficulty every 60s (a replayed trace brings its own)
+    if (now - lastBtcUpdate >= BTC_UPDATE_INTERVAL && !replaying()) {
         lastBtcUpdate = now;
+        HeapTag tag(HT_FETCH);
         fetchBtcPrice();
         fetchNetworkDifficulty();
     }
@@ -2020,10 +4543,16 @@ void loop() {
     if (now - lastUpdate >= UPDATE_INTERVAL) {
         lastUpdate = now;
 
-        if (deviceCount > 0) {
+        if (deviceCount > 0 && !replaying()) {
+            HeapTag tag(HT_FETCH);
             fetchDeviceData(deviceFetchIndex);
             deviceFetchIndex = (deviceFetchIndex + 1) % deviceCount;
         }
+        {
+            HeapTag tag(HT_CONTROL);
+            runPowerGovernor();
+            runTariff();
+        }
 
         // Track share flashes
         int totalShares = getTotalSharesAccepted();
@@ -2035,10 +4564,28 @@ void loop() {
         }
 
         // Update current screen
-        if (currentScreen == 0) updateDisplay();
-        else if (currentScreen == 1) updatePoolScreen();
-        else updateDeviceScreen(currentScreen - 2);
+        HeapTag tag(HT_RENDER);
+        PerfLap lap(perf);
+        if (currentScreen == 0) {
+            updateDisplay();
+            lap.split(PS_DRAW_MAIN);
+        } else if (currentScreen == 1) {
+            updatePoolScreen();
+            lap.split(PS_DRAW_POOL);
+        } else if (currentScreen - 2 < deviceCount) {
+            updateDeviceScreen(currentScreen - 2);
+            lap.split(PS_DRAW_DEVICE);
+        } else if (currentScreen == fleetScreenIndex()) {
+            drawFleetTable();
+            lap.split(PS_DRAW_FLEET);
+        } else {
+            updateBenchmarkScreen();
+            lap.split(PS_DRAW_BENCH);
+        }
+        if (perfOverlay) drawPerfOverlay();
     }
+    perf.add(PS_LOOP_WORK, perfCycles() - loopAt);
 
-    delay(50);
+    // Keep the loop tight while an export is streaming or bulk sockets are open
+    delay((historyExport.active() || bulk.active()) ? 5 : 50);
 }
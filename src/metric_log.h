@@ -0,0 +1,768 @@
+#pragma once
+/**
+ * Persistent metric log on LittleFS
+ *
+ * Append-only log of every history sample, so trends survive reboots.
+ *
+ * Layout:
+ *   /mlog/NNNNNNNN.seg   raw segment (full resolution)
+ *   /mlog/NNNNNNNN.cmp   compacted segment (one mean sample per series per MLOG_COMPACT_STEP)
+ *   /mlog/NNNNNNNN.tmp   compaction in progress (discarded at boot)
+ * Segments are numbered in write order and capped at MLOG_SEGMENT_BYTES.
+ *
+ * Samples are batched in RAM and written as self-contained blocks of at most
+ * MLOG_BLOCK_BYTES, so flash only sees one append per block (or per
+ * MLOG_FLUSH_MS when the fleet is quiet). Each block is:
+ *   [MlogBlockHeader][Gorilla-style bit stream]
+ * with timestamps as delta-of-delta and values XORed against the previous
+ * value of the same series (mantissa trimmed to 12 bits first). Encoder state
+ * resets per block so any block decodes on its own.
+ *
+ * Crash safety: the header carries a CRC32 over the block. Readers stop at the
+ * first block that fails magic/length/CRC, and a fresh segment is started on
+ * every boot and after a short write, so a torn tail write only ever loses
+ * that one block.
+ *
+ * Boot recovery is a header-only scan (seek from block to block) plus a CRC
+ * check of each segment's final block.
+ *
+ * Background work runs from loop() one block at a time: old raw segments are
+ * compacted, segments beyond the retention window (or the space budget) are
+ * deleted.
+ */
+
+#include <Arduino.h>
+#include <FS.h>
+#include <LittleFS.h>
+#include "metrics_history.h"
+
+#ifndef MLOG_BLOCK_BYTES
+#define MLOG_BLOCK_BYTES   1024
+#endif
+#ifndef MLOG_SEGMENT_BYTES
+#define MLOG_SEGMENT_BYTES 65536
+#endif
+#ifndef MLOG_MAX_SEGMENTS
+#define MLOG_MAX_SEGMENTS  64
+#endif
+
+#define MLOG_DIR            "/mlog"
+#define MLOG_MAGIC          0xB7A5
+#define MLOG_FLAG_COMPACTED 0x01
+#define MLOG_FLUSH_MS       (10UL * 60 * 1000)  // seal a partial block after 10 min
+#define MLOG_RAW_SECONDS    (2UL * 86400)       // keep full resolution for 2 days
+#define MLOG_COMPACT_STEP   900                 // compacted resolution, seconds
+#define MLOG_MAINT_MS       60000               // retention / compaction scheduling
+
+struct MlogBlockHeader {
+    uint16_t magic;
+    uint16_t len;       // payload bytes following the header
+    uint32_t crc;       // CRC32 over t0..reserved and the payload
+    uint32_t t0;        // first timestamp in the block (delta base)
+    uint32_t t1;        // last timestamp in the block
+    uint16_t count;     // records in the block
+    uint8_t flags;
+    uint8_t reserved;
+};
+
+#define MLOG_PAYLOAD_BYTES (MLOG_BLOCK_BYTES - sizeof(MlogBlockHeader))
+
+struct MlogRecord {
+    uint16_t series;
+    uint32_t t;
+    float v[HM_COUNT];
+};
+
+static uint32_t mlogCrc32(uint32_t crc, const uint8_t* p, size_t n) {
+    static const uint32_t tbl[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    while (n--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ tbl[crc & 15];
+        crc = (crc >> 4) ^ tbl[crc & 15];
+    }
+    return ~crc;
+}
+
+static uint32_t mlogBlockCrc(const MlogBlockHeader& h, const uint8_t* payload) {
+    uint32_t crc = mlogCrc32(0, (const uint8_t*)&h.t0, sizeof(MlogBlockHeader) - offsetof(MlogBlockHeader, t0));
+    return mlogCrc32(crc, payload, h.len);
+}
+
+// ===== GORILLA-STYLE BLOCK CODEC =====
+
+static const int MLOG_SERIES_BITS = (HIST_SERIES <= 16) ? 4 : (HIST_SERIES <= 256 ? 8 : 12);
+// Worst case for one record: series + 36-bit timestamp + 2+5+5+32 bits per value
+static const int MLOG_MAX_RECORD_BITS = MLOG_SERIES_BITS + 36 + HM_COUNT * 44;
+
+struct _MlogSeriesState {
+    uint32_t prevT;
+    int32_t prevDelta;
+    uint32_t prev[HM_COUNT];
+    uint8_t lead[HM_COUNT];    // 0xFF = no window yet
+    uint8_t trail[HM_COUNT];
+    bool seen;
+};
+
+static inline uint32_t mlogQuantize(float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return bits & 0xFFFFF800;   // keep 12 mantissa bits (~0.03 % resolution)
+}
+
+class MlogEncoder {
+public:
+    void reset(uint8_t flags = 0) {
+        _bitPos = 0;
+        _count = 0;
+        _t0 = 0;
+        _t1 = 0;
+        _flags = flags;
+        for (int i = 0; i < HIST_SERIES; i++) _st[i].seen = false;
+        memset(_block + sizeof(MlogBlockHeader), 0, MLOG_PAYLOAD_BYTES);
+    }
+
+    // Returns false when the block is full; the record is then not added.
+    bool add(const MlogRecord& r) {
+        if (r.series >= HIST_SERIES) return true;
+        if (_bitPos + MLOG_MAX_RECORD_BITS > MLOG_PAYLOAD_BYTES * 8) return false;
+        if (_count == 0) _t0 = r.t;
+        _MlogSeriesState& st = _st[r.series];
+        if (!st.seen) {
+            st.seen = true;
+            st.prevT = _t0;
+            st.prevDelta = 0;
+            for (int m = 0; m < HM_COUNT; m++) { st.prev[m] = 0; st.lead[m] = 0xFF; st.trail[m] = 0; }
+        }
+        _put(r.series, MLOG_SERIES_BITS);
+
+        int32_t delta = (int32_t)(r.t - st.prevT);
+        int32_t dod = delta - st.prevDelta;
+        if (dod == 0)                        _put(0, 1);
+        else if (dod >= -63 && dod <= 64)    { _put(0x2, 2); _put(dod + 63, 7); }
+        else if (dod >= -255 && dod <= 256)  { _put(0x6, 3); _put(dod + 255, 9); }
+        else if (dod >= -2047 && dod <= 2048) { _put(0xE, 4); _put(dod + 2047, 12); }
+        else                                 { _put(0xF, 4); _put((uint32_t)dod, 32); }
+        st.prevT = r.t;
+        st.prevDelta = delta;
+
+        for (int m = 0; m < HM_COUNT; m++) {
+            uint32_t bits = mlogQuantize(r.v[m]);
+            uint32_t x = bits ^ st.prev[m];
+            st.prev[m] = bits;
+            if (x == 0) { _put(0, 1); continue; }
+            int lead = __builtin_clz(x);
+            int trail = __builtin_ctz(x);
+            if (lead > 31) lead = 31;
+            if (st.lead[m] != 0xFF && lead >= st.lead[m] && trail >= st.trail[m]) {
+                // Reuse the previous meaningful-bit window
+                _put(0x2, 2);
+                _put(x >> st.trail[m], 32 - st.lead[m] - st.trail[m]);
+            } else {
+                int n = 32 - lead - trail;
+                _put(0x3, 2);
+                _put(lead, 5);
+                _put(n - 1, 5);
+                _put(x >> trail, n);
+                st.lead[m] = lead;
+                st.trail[m] = trail;
+            }
+        }
+        _t1 = r.t;
+        _count++;
+        return true;
+    }
+
+    uint16_t count() const { return _count; }
+    uint32_t firstTime() const { return _t0; }
+
+    // Finalise the header in place; returns the full block (header + payload) to write.
+    const uint8_t* seal(size_t& bytes) {
+        MlogBlockHeader h;
+        h.magic = MLOG_MAGIC;
+        h.len = (_bitPos + 7) / 8;
+        h.t0 = _t0;
+        h.t1 = _t1;
+        h.count = _count;
+        h.flags = _flags;
+        h.reserved = 0;
+        h.crc = mlogBlockCrc(h, _block + sizeof(MlogBlockHeader));
+        memcpy(_block, &h, sizeof(h));
+        bytes = sizeof(h) + h.len;
+        return _block;
+    }
+
+private:
+    uint8_t _block[MLOG_BLOCK_BYTES];
+    uint32_t _bitPos = 0;
+    uint16_t _count = 0;
+    uint32_t _t0 = 0, _t1 = 0;
+    uint8_t _flags = 0;
+    _MlogSeriesState _st[HIST_SERIES];
+
+    void _put(uint32_t value, int nbits) {
+        uint8_t* p = _block + sizeof(MlogBlockHeader);
+        for (int i = nbits - 1; i >= 0; i--) {
+            if ((value >> i) & 1) p[_bitPos >> 3] |= (0x80 >> (_bitPos & 7));
+            _bitPos++;
+        }
+    }
+};
+
+class MlogDecoder {
+public:
+    void begin(const MlogBlockHeader& h, const uint8_t* payload) {
+        _p = payload;
+        _bits = (uint32_t)h.len * 8;
+        _bitPos = 0;
+        _left = h.count;
+        _t0 = h.t0;
+        for (int i = 0; i < HIST_SERIES; i++) _st[i].seen = false;
+    }
+
+    bool next(MlogRecord& r) {
+        if (_left == 0) return false;
+        _left--;
+        r.series = _get(MLOG_SERIES_BITS);
+        if (r.series >= HIST_SERIES) { _left = 0; return false; }
+        _MlogSeriesState& st = _st[r.series];
+        if (!st.seen) {
+            st.seen = true;
+            st.prevT = _t0;
+            st.prevDelta = 0;
+            for (int m = 0; m < HM_COUNT; m++) { st.prev[m] = 0; st.lead[m] = 0; st.trail[m] = 0; }
+        }
+
+        int32_t dod;
+        if (_get(1) == 0)      dod = 0;
+        else if (_get(1) == 0) dod = (int32_t)_get(7) - 63;
+        else if (_get(1) == 0) dod = (int32_t)_get(9) - 255;
+        else if (_get(1) == 0) dod = (int32_t)_get(12) - 2047;
+        else                   dod = (int32_t)_get(32);
+        int32_t delta = st.prevDelta + dod;
+        r.t = st.prevT + delta;
+        st.prevT = r.t;
+        st.prevDelta = delta;
+
+        for (int m = 0; m < HM_COUNT; m++) {
+            if (_get(1)) {
+                uint32_t x;
+                if (_get(1) == 0) {
+                    x = _get(32 - st.lead[m] - st.trail[m]) << st.trail[m];
+                } else {
+                    int lead = _get(5);
+                    int n = _get(5) + 1;
+                    int trail = 32 - lead - n;
+                    x = _get(n) << trail;
+                    st.lead[m] = lead;
+                    st.trail[m] = trail;
+                }
+                st.prev[m] ^= x;
+            }
+            memcpy(&r.v[m], &st.prev[m], sizeof(float));
+        }
+        if (_bitPos > _bits) { _left = 0; return false; }   // corrupt stream
+        return true;
+    }
+
+private:
+    const uint8_t* _p = nullptr;
+    uint32_t _bits = 0, _bitPos = 0;
+    uint16_t _left = 0;
+    uint32_t _t0 = 0;
+    _MlogSeriesState _st[HIST_SERIES];
+
+    uint32_t _get(int nbits) {
+        uint32_t v = 0;
+        for (int i = 0; i < nbits; i++) {
+            uint32_t bit = 0;
+            if (_bitPos < _bits) bit = (_p[_bitPos >> 3] >> (7 - (_bitPos & 7))) & 1;
+            v = (v << 1) | bit;
+            _bitPos++;
+        }
+        return v;
+    }
+};
+
+// Read one CRC-checked block from an open segment. Returns false at end / torn block.
+static bool mlogReadBlock(File& f, MlogBlockHeader& h, uint8_t* payload) {
+    if (f.read((uint8_t*)&h, sizeof(h)) != sizeof(h)) return false;
+    if (h.magic != MLOG_MAGIC || h.len > MLOG_PAYLOAD_BYTES) return false;
+    if (f.read(payload, h.len) != h.len) return false;
+    return mlogBlockCrc(h, payload) == h.crc;
+}
+
+// ===== LOG =====
+
+struct MlogSegment {
+    uint32_t seq;
+    uint32_t tFirst;
+    uint32_t tLast;
+    uint32_t bytes;      // valid bytes (torn tail excluded)
+    bool compacted;
+};
+
+class MetricLogCursor;
+
+class MetricLog {
+public:
+    // Mount LittleFS (formatting a blank partition) and recover the segment table.
+    bool begin(uint16_t retentionDays) {
+        _retentionSec = (uint32_t)retentionDays * 86400UL;
+        if (!LittleFS.begin(true)) {
+            Serial.println("MLOG: LittleFS mount failed");
+            return false;
+        }
+        if (!LittleFS.exists(MLOG_DIR)) LittleFS.mkdir(MLOG_DIR);
+        unsigned long t0 = millis();
+        _scan();
+        _writeSeq = (_segCount > 0) ? _segs[_segCount - 1].seq + 1 : 1;
+        _writeBytes = 0;
+        _enc.reset();
+        _ready = true;
+        Serial.printf("MLOG: %d segments, %u bytes, %u torn blocks, scan %lums\n",
+                      _segCount, (unsigned)bytesUsed(), (unsigned)_tornBlocks, millis() - t0);
+        return true;
+    }
+
+    bool ready() const { return _ready; }
+
+    void setRetentionDays(uint16_t days) { _retentionSec = (uint32_t)days * 86400UL; }
+
+    void append(uint16_t series, uint32_t t, const float* v) {
+        if (!_ready) return;
+        MlogRecord r;
+        r.series = series;
+        r.t = t;
+        for (int m = 0; m < HM_COUNT; m++) r.v[m] = v[m];
+        if (_enc.count() == 0) _blockStartMs = millis();
+        if (!_enc.add(r)) {
+            flush();
+            _blockStartMs = millis();
+            _enc.add(r);
+        }
+    }
+
+    // Seal the pending block to flash (also call before restarting)
+    void flush() {
+        if (!_ready || _enc.count() == 0) return;
+        size_t bytes;
+        const uint8_t* block = _enc.seal(bytes);
+        if (_writeBytes > 0 && _writeBytes + bytes > MLOG_SEGMENT_BYTES) {
+            _writeSeq++;
+            _writeBytes = 0;
+        }
+        char path[32];
+        _path(path, sizeof(path), _writeSeq, "seg");
+        File f = LittleFS.open(path, FILE_APPEND);
+        if (f) {
+            size_t written = f.write(block, bytes);
+            f.close();
+            if (written == bytes) {
+                MlogBlockHeader h;
+                memcpy(&h, block, sizeof(h));
+                _noteWrite(h.t0, h.t1, bytes);
+            } else {
+                // Torn bytes now end this segment; the next block starts a new one so readers reach it
+                _tornBlocks++;
+                _writeSeq++;
+                _writeBytes = 0;
+                Serial.printf("MLOG: short write to %s (%u of %u bytes)\n", path, (unsigned)written, (unsigned)bytes);
+            }
+        }
+        _enc.reset();
+    }
+
+    // Periodic work: timed flush, retention and one step of compaction.
+    void loop(uint32_t nowEpoch) {
+        if (!_ready) return;
+        unsigned long now = millis();
+        if (_enc.count() > 0 && now - _blockStartMs >= MLOG_FLUSH_MS) flush();
+        if (nowEpoch == 0 || _readers > 0) return;
+        if (_compactSrc) {
+            _compactStep();
+            return;
+        }
+        if (now - _lastMaint >= MLOG_MAINT_MS) {
+            _lastMaint = now;
+            _applyRetention(nowEpoch);
+            _startCompaction(nowEpoch);
+        }
+    }
+
+    // Remove every segment (used when the monitored device list changes)
+    void wipe() {
+        if (!_ready) return;
+        _abortCompaction();
+        for (int i = 0; i < _segCount; i++) _removeSegmentFiles(_segs[i].seq);
+        _segCount = 0;
+        _writeSeq++;
+        _writeBytes = 0;
+        _enc.reset();
+    }
+
+    int segmentCount() const { return _segCount; }
+    const MlogSegment& segment(int i) const { return _segs[i]; }
+    uint32_t tornBlocks() const { return _tornBlocks; }
+    uint32_t bytesUsed() const {
+        uint32_t total = 0;
+        for (int i = 0; i < _segCount; i++) total += _segs[i].bytes;
+        return total;
+    }
+    uint32_t oldest() const { return _segCount > 0 ? _segs[0].tFirst : 0; }
+
+    static void segmentPath(char* buf, size_t n, const MlogSegment& s) {
+        _path(buf, n, s.seq, s.compacted ? "cmp" : "seg");
+    }
+
+private:
+    friend class MetricLogCursor;
+
+    bool _ready = false;
+    uint32_t _retentionSec = 14UL * 86400UL;
+    MlogSegment _segs[MLOG_MAX_SEGMENTS];
+    int _segCount = 0;
+    uint32_t _tornBlocks = 0;
+    uint32_t _writeSeq = 1;
+    uint32_t _writeBytes = 0;
+    unsigned long _blockStartMs = 0;
+    unsigned long _lastMaint = 0;
+    int _readers = 0;
+    MlogEncoder _enc;
+
+    // Compaction state (one segment at a time, one block per loop)
+    File _compactSrc;
+    File _compactDst;
+    uint32_t _compactSeq = 0;
+    MlogEncoder _compactEnc;
+    MlogDecoder _compactDec;
+    uint8_t _compactBuf[MLOG_PAYLOAD_BYTES];
+    uint32_t _compactBytes = 0, _compactFirst = 0, _compactLast = 0;
+    struct _Acc { uint32_t start; uint16_t n; float sum[HM_COUNT]; };
+    _Acc _acc[HIST_SERIES];
+
+    static void _path(char* buf, size_t n, uint32_t seq, const char* ext) {
+        snprintf(buf, n, MLOG_DIR "/%08lu.%s", (unsigned long)seq, ext);
+    }
+
+    static void _removeSegmentFiles(uint32_t seq) {
+        char path[32];
+        _path(path, sizeof(path), seq, "seg");
+        if (LittleFS.exists(path)) LittleFS.remove(path);
+        _path(path, sizeof(path), seq, "cmp");
+        if (LittleFS.exists(path)) LittleFS.remove(path);
+    }
+
+    void _noteWrite(uint32_t t0, uint32_t t1, size_t bytes) {
+        if (_segCount == 0 || _segs[_segCount - 1].seq != _writeSeq) {
+            if (_segCount == MLOG_MAX_SEGMENTS) _dropOldest();
+            MlogSegment& s = _segs[_segCount++];
+            s.seq = _writeSeq;
+            s.tFirst = t0;
+            s.tLast = t1;
+            s.bytes = 0;
+            s.compacted = false;
+        }
+        MlogSegment& s = _segs[_segCount - 1];
+        if (t1 > s.tLast) s.tLast = t1;
+        s.bytes += bytes;
+        _writeBytes += bytes;
+    }
+
+    void _dropOldest() {
+        if (_segCount == 0) return;
+        if (_compactSrc && _compactSeq == _segs[0].seq) _abortCompaction();
+        _removeSegmentFiles(_segs[0].seq);
+        memmove(&_segs[0], &_segs[1], sizeof(MlogSegment) * (_segCount - 1));
+        _segCount--;
+    }
+
+    // Header-only recovery scan
+    void _scan() {
+        _segCount = 0;
+        _tornBlocks = 0;
+        File dir = LittleFS.open(MLOG_DIR);
+        if (!dir) return;
+        uint32_t seqs[MLOG_MAX_SEGMENTS];
+        bool cmp[MLOG_MAX_SEGMENTS];
+        int n = 0;
+        File f = dir.openNextFile();
+        while (f) {
+            char name[32];
+            strncpy(name, f.name(), sizeof(name) - 1);
+            name[sizeof(name) - 1] = '\0';
+            f.close();
+            const char* base = strrchr(name, '/');
+            base = base ? base + 1 : name;
+            uint32_t seq = strtoul(base, nullptr, 10);
+            const char* ext = strrchr(base, '.');
+            char path[40];
+            snprintf(path, sizeof(path), MLOG_DIR "/%s", base);
+            if (ext && strcmp(ext, ".tmp") == 0) {
+                LittleFS.remove(path);   // interrupted compaction: raw segment is still there
+            } else if (ext && seq > 0 && (strcmp(ext, ".seg") == 0 || strcmp(ext, ".cmp") == 0)) {
+                bool isCmp = strcmp(ext, ".cmp") == 0;
+                int dup = -1;
+                for (int i = 0; i < n; i++) if (seqs[i] == seq) dup = i;
+                if (dup >= 0) {
+                    // Compaction finished but the raw segment was not removed yet
+                    char raw[32];
+                    _path(raw, sizeof(raw), seq, "seg");
+                    LittleFS.remove(raw);
+                    cmp[dup] = true;
+                } else if (n < MLOG_MAX_SEGMENTS) {
+                    seqs[n] = seq;
+                    cmp[n] = isCmp;
+                    n++;
+                }
+            }
+            f = dir.openNextFile();
+        }
+        dir.close();
+
+        // Sort by sequence (small n, insertion sort)
+        for (int i = 1; i < n; i++) {
+            uint32_t s = seqs[i]; bool c = cmp[i]; int j = i - 1;
+            while (j >= 0 && seqs[j] > s) { seqs[j + 1] = seqs[j]; cmp[j + 1] = cmp[j]; j--; }
+            seqs[j + 1] = s; cmp[j + 1] = c;
+        }
+
+        for (int i = 0; i < n; i++) {
+            MlogSegment s;
+            s.seq = seqs[i];
+            s.compacted = cmp[i];
+            if (_scanSegment(s)) _segs[_segCount++] = s;
+            else _removeSegmentFiles(s.seq);
+        }
+    }
+
+    // Walk block headers; CRC-check only the final block (the only one a torn write can hit).
+    bool _scanSegment(MlogSegment& s) {
+        char path[32];
+        segmentPath(path, sizeof(path), s);
+        File f = LittleFS.open(path, FILE_READ);
+        if (!f) return false;
+        uint32_t size = f.size();
+        uint32_t pos = 0, lastPos = 0, prevT1 = 0;
+        bool any = false;
+        MlogBlockHeader h, last;
+        s.tFirst = 0;
+        s.tLast = 0;
+        while (pos + sizeof(h) <= size) {
+            f.seek(pos);
+            if (f.read((uint8_t*)&h, sizeof(h)) != sizeof(h)) break;
+            if (h.magic != MLOG_MAGIC || h.len > MLOG_PAYLOAD_BYTES || pos + sizeof(h) + h.len > size) {
+                _tornBlocks++;
+                break;
+            }
+            if (!any) s.tFirst = h.t0;
+            prevT1 = s.tLast;
+            s.tLast = h.t1;
+            last = h;
+            lastPos = pos;
+            pos += sizeof(h) + h.len;
+            any = true;
+        }
+        if (any) {
+            f.seek(lastPos + sizeof(MlogBlockHeader));
+            if (f.read(_compactBuf, last.len) != last.len || mlogBlockCrc(last, _compactBuf) != last.crc) {
+                _tornBlocks++;
+                pos = lastPos;
+                s.tLast = prevT1;
+                any = lastPos > 0;
+            }
+        }
+        f.close();
+        s.bytes = pos;
+        return any;
+    }
+
+    void _applyRetention(uint32_t nowEpoch) {
+        uint32_t cutoff = (nowEpoch > _retentionSec) ? nowEpoch - _retentionSec : 0;
+        while (_segCount > 0 && _segs[0].tLast < cutoff && _segs[0].seq != _writeSeq) _dropOldest();
+        // Space budget: keep a quarter of the partition free for LittleFS copy-on-write
+        uint32_t budget = LittleFS.totalBytes() * 3 / 4;
+        while (_segCount > 1 && LittleFS.usedBytes() > budget && _segs[0].seq != _writeSeq) _dropOldest();
+    }
+
+    void _startCompaction(uint32_t nowEpoch) {
+        if (nowEpoch < MLOG_RAW_SECONDS) return;
+        uint32_t cutoff = nowEpoch - MLOG_RAW_SECONDS;
+        for (int i = 0; i < _segCount; i++) {
+            MlogSegment& s = _segs[i];
+            if (s.compacted || s.seq == _writeSeq || s.tLast >= cutoff) continue;
+            char src[32], dst[32];
+            _path(src, sizeof(src), s.seq, "seg");
+            _path(dst, sizeof(dst), s.seq, "tmp");
+            _compactSrc = LittleFS.open(src, FILE_READ);
+            if (!_compactSrc) return;
+            _compactDst = LittleFS.open(dst, FILE_WRITE);
+            if (!_compactDst) { _compactSrc.close(); return; }
+            _compactSeq = s.seq;
+            _compactBytes = 0;
+            _compactFirst = 0;
+            _compactLast = 0;
+            _compactEnc.reset(MLOG_FLAG_COMPACTED);
+            for (int k = 0; k < HIST_SERIES; k++) _acc[k].n = 0;
+            return;
+        }
+    }
+
+    void _compactEmit(uint16_t series) {
+        _Acc& a = _acc[series];
+        if (a.n == 0) return;
+        MlogRecord r;
+        r.series = series;
+        r.t = a.start;
+        for (int m = 0; m < HM_COUNT; m++) r.v[m] = a.sum[m] / a.n;
+        if (!_compactEnc.add(r)) {
+            _compactWriteBlock();
+            _compactEnc.add(r);
+        }
+        a.n = 0;
+    }
+
+    void _compactWriteBlock() {
+        if (_compactEnc.count() == 0) return;
+        size_t bytes;
+        const uint8_t* block = _compactEnc.seal(bytes);
+        MlogBlockHeader h;
+        memcpy(&h, block, sizeof(h));
+        if (_compactFirst == 0) _compactFirst = h.t0;
+        if (h.t1 > _compactLast) _compactLast = h.t1;
+        _compactBytes += _compactDst.write(block, bytes);
+        _compactEnc.reset(MLOG_FLAG_COMPACTED);
+    }
+
+    void _compactStep() {
+        MlogBlockHeader h;
+        if (mlogReadBlock(_compactSrc, h, _compactBuf)) {
+            MlogRecord r;
+            _compactDec.begin(h, _compactBuf);
+            while (_compactDec.next(r)) {
+                _Acc& a = _acc[r.series];
+                uint32_t start = r.t - r.t % MLOG_COMPACT_STEP;
+                if (a.n > 0 && start != a.start) _compactEmit(r.series);
+                if (a.n == 0) {
+                    a.start = start;
+                    for (int m = 0; m < HM_COUNT; m++) a.sum[m] = 0;
+                }
+                for (int m = 0; m < HM_COUNT; m++) a.sum[m] += r.v[m];
+                a.n++;
+            }
+            return;
+        }
+
+        // Source exhausted (or torn tail): drain accumulators and swap files
+        for (int k = 0; k < HIST_SERIES; k++) _compactEmit(k);
+        _compactWriteBlock();
+        _compactSrc.close();
+        _compactDst.close();
+        char src[32], tmp[32], dst[32];
+        _path(src, sizeof(src), _compactSeq, "seg");
+        _path(tmp, sizeof(tmp), _compactSeq, "tmp");
+        _path(dst, sizeof(dst), _compactSeq, "cmp");
+        for (int i = 0; i < _segCount; i++) {
+            if (_segs[i].seq != _compactSeq) continue;
+            if (_compactBytes == 0) {
+                LittleFS.remove(tmp);
+                LittleFS.remove(src);
+                memmove(&_segs[i], &_segs[i + 1], sizeof(MlogSegment) * (_segCount - i - 1));
+                _segCount--;
+            } else if (LittleFS.rename(tmp, dst)) {
+                LittleFS.remove(src);
+                _segs[i].compacted = true;
+                _segs[i].bytes = _compactBytes;
+                _segs[i].tFirst = _compactFirst;
+                _segs[i].tLast = _compactLast;
+            } else {
+                LittleFS.remove(tmp);
+            }
+            break;
+        }
+        _compactSeq = 0;
+    }
+
+    void _abortCompaction() {
+        if (!_compactSrc) return;
+        _compactSrc.close();
+        _compactDst.close();
+        char tmp[32];
+        _path(tmp, sizeof(tmp), _compactSeq, "tmp");
+        LittleFS.remove(tmp);
+        _compactSeq = 0;
+    }
+};
+
+// Sequential reader over [from, to). Holds off compaction/retention while open.
+class MetricLogCursor {
+public:
+    ~MetricLogCursor() { close(); }
+
+    bool open(MetricLog& log, uint32_t from, uint32_t to) {
+        close();
+        if (!log.ready()) return false;
+        _log = &log;
+        _log->_readers++;
+        _log->flush();   // make the writer's pending RAM block visible
+        _from = from;
+        _to = to;
+        _nextSeq = 0;
+        _inBlock = false;
+        return true;
+    }
+
+    void close() {
+        if (_file) _file.close();
+        if (_log) _log->_readers--;
+        _log = nullptr;
+    }
+
+    bool next(MlogRecord& r) {
+        if (!_log) return false;
+        while (true) {
+            if (_inBlock) {
+                while (_dec.next(r)) {
+                    if (r.t >= _from && r.t < _to) return true;
+                }
+                _inBlock = false;
+            }
+            if (_file) {
+                MlogBlockHeader h;
+                if (mlogReadBlock(_file, h, _buf)) {
+                    if (h.t1 < _from || h.t0 >= _to) continue;
+                    _dec.begin(h, _buf);
+                    _inBlock = true;
+                    continue;
+                }
+                _file.close();
+            }
+            if (!_openNextSegment()) return false;
+        }
+    }
+
+private:
+    MetricLog* _log = nullptr;
+    File _file;
+    uint32_t _from = 0, _to = 0, _nextSeq = 0;
+    bool _inBlock = false;
+    MlogDecoder _dec;
+    uint8_t _buf[MLOG_PAYLOAD_BYTES];
+
+    bool _openNextSegment() {
+        for (int i = 0; i < _log->_segCount; i++) {
+            const MlogSegment& s = _log->_segs[i];
+            if (s.seq < _nextSeq) continue;
+            _nextSeq = s.seq + 1;
+            if (s.tLast < _from || s.tFirst >= _to) continue;
+            char path[32];
+            MetricLog::segmentPath(path, sizeof(path), s);
+            _file = LittleFS.open(path, FILE_READ);
+            if (_file) return true;
+        }
+        return false;
+    }
+};
@@ -0,0 +1,301 @@
+#pragma once
+/**
+ * Multi-resolution metrics history
+ *
+ * Every device sample is folded into three downsampled tiers as it arrives:
+ *   TIER 0 —  1 minute buckets  (HIST_SLOTS_1M,  default 60 = last hour)
+ *   TIER 1 — 15 minute buckets  (HIST_SLOTS_15M, default 32 = last 8 hours)
+ *   TIER 2 —  1 hour buckets    (HIST_SLOTS_1H,  default 48 = last 2 days)
+ *
+ * Each bucket keeps min / max / mean / last for every HistMetric. Values are
+ * stored as IEEE half floats so the whole store for 8 devices + fleet stays
+ * around 32 KB; the open bucket accumulates in full floats.
+ *
+ * Series 0..MAX_DEVICES-1 are individual devices, series HIST_FLEET holds the
+ * fleet totals (summed hashrate / power, hottest chip). A half float tops out
+ * at 65504, about 65 TH/s as GH/s, so the fleet's sums are stored in TH/s and
+ * kW and scaled back on read; callers always see GH/s and W.
+ *
+ * Reads pick the tier whose bucket width matches the requested column width,
+ * so a chart costs O(columns) regardless of how many samples went in.
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#ifndef HIST_SLOTS_1M
+#define HIST_SLOTS_1M  60
+#endif
+#ifndef HIST_SLOTS_15M
+#define HIST_SLOTS_15M 32
+#endif
+#ifndef HIST_SLOTS_1H
+#define HIST_SLOTS_1H  48
+#endif
+
+#define HIST_FLEET       MAX_DEVICES
+#define HIST_SERIES      (MAX_DEVICES + 1)
+#define HIST_TIER_COUNT  3
+#define HIST_TOTAL_SLOTS (HIST_SLOTS_1M + HIST_SLOTS_15M + HIST_SLOTS_1H)
+
+enum HistMetric : uint8_t {
+    HM_HASHRATE = 0,   // GH/s
+    HM_TEMP,           // chip temperature, C
+    HM_POWER,          // W
+    HM_COUNT
+};
+
+struct HistTier {
+    uint32_t width;    // bucket width in seconds
+    uint16_t slots;
+    uint16_t offset;   // first slot in the flat bucket array
+};
+
+static const HistTier HIST_TIERS[HIST_TIER_COUNT] = {
+    {60,   HIST_SLOTS_1M,  0},
+    {900,  HIST_SLOTS_15M, HIST_SLOTS_1M},
+    {3600, HIST_SLOTS_1H,  HIST_SLOTS_1M + HIST_SLOTS_15M},
+};
+
+// One aggregated chart column / bucket as seen by readers
+struct HistPoint {
+    float min;
+    float max;
+    float mean;
+    float last;
+    bool valid;
+};
+
+class MetricsHistory {
+public:
+    // Fold one sample (values indexed by HistMetric) into every tier of a series.
+    void add(uint16_t series, uint32_t t, const float* values) {
+        if (series >= HIST_SERIES || t == 0) return;
+        for (int k = 0; k < HIST_TIER_COUNT; k++) {
+            const HistTier& td = HIST_TIERS[k];
+            _Accum& acc = _acc[series][k];
+            _Bucket* ring = &_buckets[series][td.offset];
+            uint32_t start = t - t % td.width;
+
+            if (acc.headStart == 0 || start < acc.headStart) {
+                // First sample, or the clock stepped backwards (NTP sync): restart the tier
+                for (int s = 0; s < td.slots; s++) ring[s].count = 0;
+                acc.head = 0;
+                acc.headStart = start;
+                _resetAccum(acc);
+            } else if (start > acc.headStart) {
+                uint32_t steps = (start - acc.headStart) / td.width;
+                if (steps >= td.slots) {
+                    for (int s = 0; s < td.slots; s++) ring[s].count = 0;
+                    acc.head = 0;
+                } else {
+                    // Skipped buckets stay in the ring as empty gaps
+                    for (uint32_t s = 0; s < steps; s++) {
+                        acc.head = (acc.head + 1) % td.slots;
+                        ring[acc.head].count = 0;
+                    }
+                }
+                acc.headStart = start;
+                _resetAccum(acc);
+            }
+
+            _Bucket& b = ring[acc.head];
+            if (b.count < 0xFFFF) b.count++;
+            for (int m = 0; m < HM_COUNT; m++) {
+                float v = values[m];
+                acc.sum[m] += v;
+                if (b.count == 1 || v < acc.min[m]) acc.min[m] = v;
+                if (b.count == 1 || v > acc.max[m]) acc.max[m] = v;
+                float unit = _unit(series, m);
+                b.s[m].min = _toHalf(acc.min[m] / unit);
+                b.s[m].max = _toHalf(acc.max[m] / unit);
+                b.s[m].mean = _toHalf(acc.sum[m] / b.count / unit);
+                b.s[m].last = _toHalf(v / unit);
+            }
+        }
+    }
+
+    // Drop everything recorded for one series (device list changed, etc.)
+    void clear(uint16_t series) {
+        if (series >= HIST_SERIES) return;
+        for (int k = 0; k < HIST_TIER_COUNT; k++) {
+            _acc[series][k].headStart = 0;
+            _acc[series][k].head = 0;
+            _resetAccum(_acc[series][k]);
+        }
+        for (int s = 0; s < HIST_TOTAL_SLOTS; s++) _buckets[series][s].count = 0;
+    }
+
+    // Timestamp of the newest sample bucket in the finest tier (0 = no data)
+    uint32_t newest(uint16_t series) const {
+        if (series >= HIST_SERIES) return 0;
+        return _acc[series][0].headStart;
+    }
+
+    // Start of the oldest bucket any tier still holds for a series (0 = no data)
+    uint32_t oldest(uint16_t series) const {
+        if (series >= HIST_SERIES) return 0;
+        uint32_t t = 0;
+        for (int k = 0; k < HIST_TIER_COUNT; k++) {
+            if (_acc[series][k].headStart == 0) continue;
+            uint32_t o = _oldest(series, k);
+            if (t == 0 || o < t) t = o;
+        }
+        return t;
+    }
+
+    // Pick the tier for a column width: the finest tier still covering `from`,
+    // then coarser while a coarser bucket is no wider than one column.
+    int tierFor(uint16_t series, uint32_t from, uint32_t step) const {
+        int k = 0;
+        while (k + 1 < HIST_TIER_COUNT && from < _oldest(series, k)) k++;
+        while (k + 1 < HIST_TIER_COUNT && HIST_TIERS[k + 1].width <= step) k++;
+        return k;
+    }
+
+    // True when a tier no wider than `step` still reaches back to `from`
+    bool canServe(uint16_t series, uint32_t from, uint32_t step) const {
+        if (series >= HIST_SERIES) return false;
+        for (int k = 0; k < HIST_TIER_COUNT; k++) {
+            if (HIST_TIERS[k].width <= step && _acc[series][k].headStart != 0 && from >= _oldest(series, k)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Aggregate [from, to) into `columns` evenly spaced points.
+    // Returns the number of columns that contain data.
+    int read(uint16_t series, uint8_t metric, uint32_t from, uint32_t to,
+             int columns, HistPoint* out) const {
+        if (series >= HIST_SERIES || metric >= HM_COUNT || columns <= 0 || to <= from) return 0;
+        uint32_t span = to - from;
+        uint32_t step = span / columns;
+        if (step == 0) step = 1;
+        int k = tierFor(series, from, step);
+        int filled = 0;
+        for (int c = 0; c < columns; c++) {
+            uint32_t c0 = from + (uint32_t)((uint64_t)span * c / columns);
+            uint32_t c1 = from + (uint32_t)((uint64_t)span * (c + 1) / columns);
+            if (c1 <= c0) c1 = c0 + 1;
+            if (_aggregate(series, k, metric, c0, c1, out[c])) filled++;
+        }
+        return filled;
+    }
+
+    // Read a single bucket from a tier, `age` buckets back from the newest (0 = open bucket)
+    bool bucket(uint16_t series, uint8_t metric, int tier, int age, HistPoint& out) const {
+        out.valid = false;
+        if (series >= HIST_SERIES || metric >= HM_COUNT || tier < 0 || tier >= HIST_TIER_COUNT) return false;
+        const HistTier& td = HIST_TIERS[tier];
+        const _Accum& acc = _acc[series][tier];
+        if (acc.headStart == 0 || age < 0 || age >= td.slots) return false;
+        const _Bucket& b = _buckets[series][td.offset + (acc.head + td.slots - age) % td.slots];
+        if (b.count == 0) return false;
+        float unit = _unit(series, metric);
+        out.min = _fromHalf(b.s[metric].min) * unit;
+        out.max = _fromHalf(b.s[metric].max) * unit;
+        out.mean = _fromHalf(b.s[metric].mean) * unit;
+        out.last = _fromHalf(b.s[metric].last) * unit;
+        out.valid = true;
+        return true;
+    }
+
+private:
+    struct _Stat { uint16_t min, max, mean, last; };   // half floats
+    struct _Bucket { uint16_t count; _Stat s[HM_COUNT]; };
+    struct _Accum {
+        uint32_t headStart = 0;    // start time of the open bucket (0 = tier empty)
+        uint16_t head = 0;         // slot index of the open bucket
+        float sum[HM_COUNT];
+        float min[HM_COUNT];
+        float max[HM_COUNT];
+    };
+
+    _Bucket _buckets[HIST_SERIES][HIST_TOTAL_SLOTS] = {};
+    _Accum _acc[HIST_SERIES][HIST_TIER_COUNT];
+
+    static void _resetAccum(_Accum& acc) {
+        for (int m = 0; m < HM_COUNT; m++) {
+            acc.sum[m] = 0;
+            acc.min[m] = 0;
+            acc.max[m] = 0;
+        }
+    }
+
+    // Stored value = value / unit: the fleet's summed hashrate and power would overflow a half float
+    static float _unit(uint16_t series, uint8_t metric) {
+        return series == HIST_FLEET && (metric == HM_HASHRATE || metric == HM_POWER) ? 1000.0f : 1.0f;
+    }
+
+    uint32_t _oldest(uint16_t series, int k) const {
+        const _Accum& acc = _acc[series][k];
+        uint32_t back = (uint32_t)(HIST_TIERS[k].slots - 1) * HIST_TIERS[k].width;
+        return (acc.headStart > back) ? acc.headStart - back : 0;
+    }
+
+    bool _aggregate(uint16_t series, int k, uint8_t metric, uint32_t c0, uint32_t c1, HistPoint& out) const {
+        const HistTier& td = HIST_TIERS[k];
+        const _Accum& acc = _acc[series][k];
+        out.valid = false;
+        if (acc.headStart == 0) return false;
+
+        uint32_t headEnd = acc.headStart + td.width;
+        if (c0 >= headEnd) return false;
+        if (c1 > headEnd) c1 = headEnd;
+        uint32_t b0 = c0 - c0 % td.width;
+        uint32_t b1 = c1 - 1 - (c1 - 1) % td.width;
+        int ageLo = (int)((acc.headStart - b1) / td.width);   // newest bucket in range
+        int ageHi = (int)((acc.headStart - b0) / td.width);   // oldest bucket in range
+        if (ageLo >= td.slots) return false;
+        if (ageHi >= td.slots) ageHi = td.slots - 1;
+
+        float mn = 0, mx = 0, wsum = 0, last = 0;
+        uint32_t n = 0;
+        for (int age = ageHi; age >= ageLo; age--) {
+            const _Bucket& b = _buckets[series][td.offset + (acc.head + td.slots - age) % td.slots];
+            if (b.count == 0) continue;
+            float bmin = _fromHalf(b.s[metric].min);
+            float bmax = _fromHalf(b.s[metric].max);
+            if (n == 0 || bmin < mn) mn = bmin;
+            if (n == 0 || bmax > mx) mx = bmax;
+            wsum += _fromHalf(b.s[metric].mean) * b.count;
+            n += b.count;
+            last = _fromHalf(b.s[metric].last);
+        }
+        if (n == 0) return false;
+        float unit = _unit(series, metric);
+        out.min = mn * unit;
+        out.max = mx * unit;
+        out.mean = wsum / n * unit;
+        out.last = last * unit;
+        out.valid = true;
+        return true;
+    }
+
+    static uint16_t _toHalf(float f) {
+        uint32_t x;
+        memcpy(&x, &f, sizeof(x));
+        uint16_t sign = (x >> 16) & 0x8000;
+        int32_t exp = (int32_t)((x >> 23) & 0xFF) - 127 + 15;
+        uint32_t mant = x & 0x7FFFFF;
+        if (exp <= 0) return sign;                  // too small: flush to zero
+        if (exp >= 31) return sign | 0x7BFF;        // too large / NaN: clamp to max
+        uint16_t h = sign | (uint16_t)(exp << 10) | (uint16_t)(mant >> 13);
+        if (mant & 0x1000) h++;                     // round to nearest
+        if ((h & 0x7FFF) > 0x7BFF) h = sign | 0x7BFF;
+        return h;
+    }
+
+    static float _fromHalf(uint16_t h) {
+        uint32_t exp = (h >> 10) & 0x1F;
+        if (exp == 0) return 0.0f;
+        uint32_t x = ((uint32_t)(h & 0x8000) << 16) | ((exp - 15 + 127) << 23) | ((uint32_t)(h & 0x3FF) << 13);
+        float f;
+        memcpy(&f, &x, sizeof(f));
+        return f;
+    }
+};
@@ -0,0 +1,279 @@
+#pragma once
+/**
+ * Hung-miner watchdog with an automatic restart policy
+ *
+ * Watches every successful fetch for a miner that answers but no longer mines:
+ *
+ *   no-hashrate   hashrate below 1 GH/s for zeroHashSec
+ *   no-shares     accepted shares flat for staleShareSec (stratum wedged)
+ *
+ * and separately records unplanned reboots — uptimeSeconds going backwards
+ * without a restart having been asked for. Those recover by themselves, so
+ * they only go into the log. Nothing is judged while the miner's own uptime
+ * is below bootGraceSec.
+ *
+ * Like the other controllers it only decides; the caller POSTs the restart
+ * and reports back with applied(). Escalation, per device:
+ *
+ *   level 0            restart straight away
+ *   level 1..          wait minGapSec << (level - 1) since the last restart
+ *   level >= safeLevel also step the frequency down by safeStep first
+ *   level >= maxLevel  give up — left for a human until rearm()
+ *
+ * The level drops back to 0 (and a give-up clears) once the device has been
+ * healthy for healthySec. Restarts, unplanned reboots and give-ups go to a
+ * small ring, newest first through logEntry().
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define WATCHDOG_LOG_SIZE   24
+#define WATCHDOG_BOOT_WAIT  600        // s a requested restart may take to show up as a reboot
+
+struct WatchdogConfig {
+    uint32_t zeroHashSec = 300;
+    uint32_t staleShareSec = 1800;
+    uint32_t bootGraceSec = 300;       // miner uptime below this is still warming up
+    uint32_t minGapSec = 1800;         // doubles per escalation level
+    uint32_t healthySec = 21600;
+    uint8_t safeLevel = 2;
+    uint8_t maxLevel = 4;
+    int safeStep = 25;
+    int minFreq = 400;
+};
+
+// What the watchdog needs from one device fetch
+struct WatchSample {
+    float hashRate;
+    uint32_t sharesAccepted;
+    uint32_t uptime;
+    int frequency;
+};
+
+enum WatchReason : uint8_t {
+    WR_NONE = 0,
+    WR_NO_HASH,
+    WR_NO_SHARES
+};
+
+enum WatchEventKind : uint8_t {
+    WE_RESTART = 0,
+    WE_SAFE_RESTART,           // frequency stepped down, then restarted
+    WE_REBOOT,                 // unplanned: uptime went backwards
+    WE_MANUAL,                 // RST on the device screen
+    WE_GAVE_UP
+};
+
+static const char* const WATCH_REASON_NAMES[] = {"none", "no-hashrate", "no-shares"};
+static const char* const WATCH_EVENT_NAMES[] = {"restart", "safe-restart", "reboot", "manual", "gave-up"};
+
+struct WatchDecision {
+    uint8_t reason = WR_NONE;
+    uint8_t level = 0;
+    int frequency = -1;        // PATCH this before restarting, -1 = leave as is
+};
+
+struct WatchEvent {
+    uint32_t t;
+    uint8_t device;
+    uint8_t kind;
+    uint8_t reason;
+    uint8_t level;
+    bool ok;
+    int16_t frequency;         // safe-restart setpoint, -1 otherwise
+};
+
+class MinerWatchdog {
+public:
+    void setEnabled(bool on) { _enabled = on; }
+    bool enabled() const { return _enabled; }
+    WatchdogConfig& config() { return _cfg; }
+
+    // Fresh sample of device i. True when it should be restarted as described by `out`.
+    bool evaluate(uint8_t i, const WatchSample& s, uint32_t now, WatchDecision& out) {
+        out = WatchDecision();
+        if (i >= MAX_DEVICES) return false;
+        _State& st = _st[i];
+        if (!st.seen) {
+            st.seen = true;
+            st.uptime = s.uptime;
+            st.acc = s.sharesAccepted;
+            st.shareAt = now;
+            st.okSince = now;
+            return false;
+        }
+
+        if (s.uptime < st.uptime) {
+            if (st.expectBoot) {
+                st.expectBoot = false;
+            } else {
+                st.reboots++;
+                _log(now, i, WE_REBOOT, WR_NONE, st.level, true, -1);
+                Serial.printf("WATCHDOG: device %d rebooted on its own (uptime %lu -> %lu)\n",
+                              i, (unsigned long)st.uptime, (unsigned long)s.uptime);
+            }
+            st.acc = s.sharesAccepted;
+            st.shareAt = now;
+            st.zero = false;
+        }
+        st.uptime = s.uptime;
+        if (st.expectBoot && now - st.bootAskedAt > WATCHDOG_BOOT_WAIT) st.expectBoot = false;
+        if (s.sharesAccepted != st.acc) {
+            st.acc = s.sharesAccepted;
+            st.shareAt = now;
+        }
+        if (s.hashRate < 1.0f) {
+            if (!st.zero) { st.zero = true; st.zeroAt = now; }
+        } else {
+            st.zero = false;
+        }
+        if (s.uptime < _cfg.bootGraceSec) return false;
+
+        uint8_t reason = WR_NONE;
+        if (st.zero && now - st.zeroAt >= _cfg.zeroHashSec) reason = WR_NO_HASH;
+        else if (now - st.shareAt >= _cfg.staleShareSec) reason = WR_NO_SHARES;
+
+        if (reason == WR_NONE) {
+            if (st.stuck != WR_NONE) { st.stuck = WR_NONE; st.okSince = now; }
+            if ((st.level > 0 || st.gaveUp) && now - st.okSince >= _cfg.healthySec) {
+                st.level = 0;
+                st.gaveUp = false;
+            }
+            return false;
+        }
+        if (st.stuck == WR_NONE) st.stuckAt = now;
+        st.stuck = reason;
+
+        if (!_enabled || st.gaveUp) return false;
+        if (st.level > 0 && now - st.restartAt < _gap(st.level)) return false;
+        if (st.level >= _cfg.maxLevel) {
+            st.gaveUp = true;
+            _log(now, i, WE_GAVE_UP, reason, st.level, false, -1);
+            Serial.printf("WATCHDOG: device %d still %s after %d restarts, giving up\n",
+                          i, WATCH_REASON_NAMES[reason], st.level);
+            return false;
+        }
+        out.reason = reason;
+        out.level = st.level;
+        if (st.level >= _cfg.safeLevel && s.frequency - _cfg.safeStep >= _cfg.minFreq) {
+            out.frequency = s.frequency - _cfg.safeStep;
+        }
+        return true;
+    }
+
+    // The restart for `d` was sent; failed attempts count as a level too, so they back off.
+    void applied(uint8_t i, const WatchDecision& d, bool ok, uint32_t now) {
+        if (i >= MAX_DEVICES) return;
+        _State& st = _st[i];
+        st.level++;
+        st.restartAt = now;
+        st.restarts++;
+        st.expectBoot = ok;
+        st.bootAskedAt = now;
+        st.zero = false;
+        st.shareAt = now;
+        st.stuck = WR_NONE;
+        st.okSince = now;
+        _log(now, i, d.frequency >= 0 ? WE_SAFE_RESTART : WE_RESTART, d.reason, st.level, ok, d.frequency);
+        Serial.printf("WATCHDOG: device %d %s, restart %d%s%s\n", i, WATCH_REASON_NAMES[d.reason], st.level,
+                      d.frequency >= 0 ? " at lower frequency" : "", ok ? "" : " FAILED");
+    }
+
+    // A restart someone asked for by hand: not a crash, but it belongs in the history
+    void expectRestart(uint8_t i, bool ok, uint32_t now) {
+        if (i >= MAX_DEVICES) return;
+        _st[i].expectBoot = ok;
+        _st[i].bootAskedAt = now;
+        _log(now, i, WE_MANUAL, WR_NONE, _st[i].level, ok, -1);
+    }
+
+    // Fetch failed: the clocks restart when the device answers again
+    void unreachable(uint8_t i, uint32_t now) {
+        if (i >= MAX_DEVICES) return;
+        _st[i].zero = false;
+        _st[i].shareAt = now;
+    }
+
+    // Let a device that was given up on be restarted again
+    void rearm(uint8_t i) {
+        if (i >= MAX_DEVICES) return;
+        _st[i].level = 0;
+        _st[i].gaveUp = false;
+    }
+
+    // Device list changed: indices no longer mean the same miners
+    void reset() {
+        for (int i = 0; i < MAX_DEVICES; i++) _st[i] = _State();
+        _logHead = _logCount = 0;
+    }
+
+    uint8_t level(uint8_t i) const { return i < MAX_DEVICES ? _st[i].level : 0; }
+    bool gaveUp(uint8_t i) const { return i < MAX_DEVICES && _st[i].gaveUp; }
+    uint8_t stuck(uint8_t i) const { return i < MAX_DEVICES ? _st[i].stuck : (uint8_t)WR_NONE; }
+    uint32_t stuckSince(uint8_t i) const { return i < MAX_DEVICES ? _st[i].stuckAt : 0; }
+    uint16_t restarts(uint8_t i) const { return i < MAX_DEVICES ? _st[i].restarts : 0; }
+    uint16_t reboots(uint8_t i) const { return i < MAX_DEVICES ? _st[i].reboots : 0; }
+    uint32_t lastRestart(uint8_t i) const { return i < MAX_DEVICES ? _st[i].restartAt : 0; }
+
+    // Seconds until the next restart of device i is allowed, 0 = now
+    uint32_t holdoff(uint8_t i, uint32_t now) const {
+        if (i >= MAX_DEVICES || _st[i].level == 0) return 0;
+        uint32_t gap = _gap(_st[i].level);
+        uint32_t since = now - _st[i].restartAt;
+        return since < gap ? gap - since : 0;
+    }
+
+    uint8_t logCount() const { return _logCount; }
+    const WatchEvent& logEntry(uint8_t k) const {
+        return _events[(_logHead + WATCHDOG_LOG_SIZE - 1 - k) % WATCHDOG_LOG_SIZE];
+    }
+
+private:
+    struct _State {
+        bool seen = false;
+        bool zero = false;
+        bool expectBoot = false;
+        bool gaveUp = false;
+        uint8_t stuck = WR_NONE;
+        uint8_t level = 0;
+        uint16_t restarts = 0;
+        uint16_t reboots = 0;
+        uint32_t uptime = 0;
+        uint32_t acc = 0;
+        uint32_t shareAt = 0;          // last time accepted shares moved
+        uint32_t zeroAt = 0;
+        uint32_t stuckAt = 0;
+        uint32_t okSince = 0;
+        uint32_t restartAt = 0;
+        uint32_t bootAskedAt = 0;
+    };
+
+    bool _enabled = false;
+    WatchdogConfig _cfg;
+    _State _st[MAX_DEVICES];
+    WatchEvent _events[WATCHDOG_LOG_SIZE];
+    uint8_t _logHead = 0;
+    uint8_t _logCount = 0;
+
+    uint32_t _gap(uint8_t level) const {
+        if (level == 0) return 0;
+        return _cfg.minGapSec << (level > 7 ? 6 : level - 1);
+    }
+
+    void _log(uint32_t now, uint8_t i, uint8_t kind, uint8_t reason, uint8_t level, bool ok, int freq) {
+        WatchEvent& e = _events[_logHead];
+        e.t = now;
+        e.device = i;
+        e.kind = kind;
+        e.reason = reason;
+        e.level = level;
+        e.ok = ok;
+        e.frequency = (int16_t)freq;
+        _logHead = (_logHead + 1) % WATCHDOG_LOG_SIZE;
+        if (_logCount < WATCHDOG_LOG_SIZE) _logCount++;
+    }
+};
@@ -0,0 +1,183 @@
+#pragma once
+/**
+ * Hot-path timing histograms
+ *
+ * Each PerfStage keeps a fixed histogram of how long it took, in CPU
+ * cycles converted to microseconds at add() time. Buckets are half-octaves
+ * (edges at 1, 2, 3, 4, 6, 8, 12, 16 ... us), PERF_BUCKETS of them, so a
+ * stage costs PERF_BUCKETS * 4 bytes and percentiles come out within one
+ * bucket (interpolated inside it) whatever the spread — from a 20 us parse to
+ * a 5 s connect timeout.
+ *
+ * PerfLap times consecutive stages of one function with one clock read per
+ * boundary:
+ *
+ *   PerfLap lap(perf);
+ *   client.connect(...);   lap.split(PS_DEV_CONNECT);
+ *   http.GET();            lap.split(PS_DEV_TTFB);
+ *
+ * Build with -DPERF_STATS=0 and add(), PerfLap and PerfScope compile to
+ * nothing; the store itself stays, always empty.
+ */
+
+#include <Arduino.h>
+
+#ifndef PERF_STATS
+#define PERF_STATS 1
+#endif
+
+#define PERF_BUCKETS 49            // half-octaves from 1 us up to ~16.8 s; the last also takes anything slower
+
+enum PerfStage : uint8_t {
+    PS_DEV_CONNECT = 0,        // TCP connect to the miner
+    PS_DEV_CONNECT_FAIL,       // connect refused or timed out; count() is the failure count
+    PS_DEV_TTFB,               // request sent until status line and headers
+    PS_DEV_BODY,               // reading /api/system/info
+    PS_DEV_PARSE,              // deserializeJson of it
+    PS_DEV_INGEST,             // DeviceInfo update and every controller hook
+    PS_API_DNS,                // CoinGecko / mempool.space name lookup
+    PS_API_TLS,                // TCP connect + TLS handshake
+    PS_API_TTFB,
+    PS_API_BODY,
+    PS_API_PARSE,
+    PS_DRAW_MAIN,              // periodic update of each screen
+    PS_DRAW_POOL,
+    PS_DRAW_DEVICE,
+    PS_DRAW_FLEET,
+    PS_DRAW_BENCH,
+    PS_REDRAW,                 // full redraw after a swipe, transition included
+    PS_WEB,                    // webServer.handleClient()
+    PS_LOOP_WORK,              // loop() minus its closing delay()
+    PS_LOOP_PERIOD,            // start to start of loop(); its spread is the jitter
+    PS_COUNT
+};
+
+static const char* const PERF_STAGE_NAMES[PS_COUNT] = {
+    "dev.connect", "dev.connfail", "dev.ttfb", "dev.body", "dev.parse", "dev.ingest",
+    "api.dns", "api.tls", "api.ttfb", "api.body", "api.parse",
+    "draw.main", "draw.pool", "draw.device", "draw.fleet", "draw.bench", "redraw",
+    "web", "loop.work", "loop.period"
+};
+
+inline uint32_t perfCycles() { return ESP.getCycleCount(); }
+
+class PerfStats {
+public:
+    PerfStats() { reset(); }
+
+    void reset() {
+        memset(_st, 0, sizeof(_st));
+        _cyclesPerUs = ESP.getCpuFreqMHz();
+        if (_cyclesPerUs == 0) _cyclesPerUs = 240;
+    }
+
+    void add(uint8_t stage, uint32_t cycles) {
+        if (!PERF_STATS || stage >= PS_COUNT) return;
+        uint32_t us = cycles / _cyclesPerUs;
+        _Stage& s = _st[stage];
+        s.n[bucketOf(us)]++;
+        s.count++;
+        s.sumUs += us;
+        if (us > s.maxUs) s.maxUs = us;
+    }
+
+    // p-th percentile in us, interpolated inside its bucket (the last one reaches up to maxUs); 0 with no samples
+    uint32_t percentile(uint8_t stage, uint8_t p) const {
+        if (stage >= PS_COUNT || _st[stage].count == 0) return 0;
+        const _Stage& s = _st[stage];
+        uint32_t want = (uint32_t)(((uint64_t)s.count * p + 99) / 100);
+        if (want == 0) want = 1;
+        uint32_t seen = 0;
+        for (int b = 0; b < PERF_BUCKETS; b++) {
+            if (seen + s.n[b] >= want) {
+                uint32_t lo = b ? bucketTop(b - 1) : 0, hi = bucketTop(b);
+                if (b == PERF_BUCKETS - 1) hi = max(hi, s.maxUs);
+                uint32_t v = lo + (uint32_t)((uint64_t)(hi - lo) * (want - seen) / s.n[b]);
+                return min(v, s.maxUs);
+            }
+            seen += s.n[b];
+        }
+        return s.maxUs;
+    }
+
+    uint32_t count(uint8_t stage) const { return stage < PS_COUNT ? _st[stage].count : 0; }
+    uint32_t maxUs(uint8_t stage) const { return stage < PS_COUNT ? _st[stage].maxUs : 0; }
+    uint32_t meanUs(uint8_t stage) const {
+        return stage < PS_COUNT && _st[stage].count ? (uint32_t)(_st[stage].sumUs / _st[stage].count) : 0;
+    }
+    uint32_t bucket(uint8_t stage, uint8_t b) const { return stage < PS_COUNT && b < PERF_BUCKETS ? _st[stage].n[b] : 0; }
+    uint32_t cyclesPerUs() const { return _cyclesPerUs; }
+
+    // Bucket b holds [bucketTop(b - 1), bucketTop(b)) us
+    static uint8_t bucketOf(uint32_t us) {
+        if (us < 1) return 0;
+        int octave = 31 - __builtin_clz(us);
+        int half = octave > 0 ? (us >> (octave - 1)) & 1 : 0;
+        int b = 1 + octave * 2 + half;
+        return b < PERF_BUCKETS ? b : PERF_BUCKETS - 1;
+    }
+
+    static uint32_t bucketTop(uint8_t b) {
+        if (b == 0) return 1;
+        int octave = (b - 1) / 2;
+        uint32_t base = 1UL << octave;
+        return (b - 1) % 2 ? base * 2 : base + max<uint32_t>(base / 2, 1);
+    }
+
+private:
+    struct _Stage {
+        uint32_t n[PERF_BUCKETS];
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t sumUs;
+    };
+
+    _Stage _st[PS_COUNT];
+    uint32_t _cyclesPerUs = 240;
+};
+
+#if PERF_STATS
+
+// Consecutive stages of one code path: each split() books the time since the previous one
+class PerfLap {
+public:
+    explicit PerfLap(PerfStats& stats) : _stats(stats), _t(perfCycles()) {}
+    void split(uint8_t stage) {
+        uint32_t now = perfCycles();
+        _stats.add(stage, now - _t);
+        _t = now;
+    }
+    void restart() { _t = perfCycles(); }
+
+private:
+    PerfStats& _stats;
+    uint32_t _t;
+};
+
+// One stage for the rest of the enclosing block
+class PerfScope {
+public:
+    PerfScope(PerfStats& stats, uint8_t stage) : _stats(stats), _stage(stage), _t(perfCycles()) {}
+    ~PerfScope() { _stats.add(_stage, perfCycles() - _t); }
+
+private:
+    PerfStats& _stats;
+    uint8_t _stage;
+    uint32_t _t;
+};
+
+#else
+
+class PerfLap {
+public:
+    explicit PerfLap(PerfStats&) {}
+    void split(uint8_t) {}
+    void restart() {}
+};
+
+class PerfScope {
+public:
+    PerfScope(PerfStats&, uint8_t) {}
+};
+
+#endif
@@ -0,0 +1,168 @@
+#pragma once
+/**
+ * Fleet-wide power cap governor
+ *
+ * Keeps the summed device power under a configured watt budget by trimming
+ * ASIC frequency, one PATCH at a time:
+ *
+ *   total > cap                    cut freqStep MHz from the online device with
+ *                                  the worst J/TH that is still above minFreq
+ *   total + estimate <= cap - hyst give freqStep MHz back to the most efficient
+ *                                  device the governor has cut; the estimate
+ *                                  scales that device's power by the step
+ *
+ * Between cap and cap - hyst nothing moves, so the fleet does not oscillate
+ * around the limit. Actions are rate limited to one per intervalSec, and a
+ * device that was just changed is not touched again until a fresh sample
+ * from it has arrived (the reported power has to reflect the change first).
+ *
+ * Only the governor's own reductions are undone: cutMHz(i) is what it took
+ * from device i and is the most it will give back. Devices flagged busy
+ * (being auto-tuned, for example) are only cut if nothing else can be.
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+// What the governor needs to know about one device
+struct GovDevice {
+    bool online;
+    bool busy;                 // another controller owns it right now
+    int frequency;             // MHz, as last reported
+    float hashRate;            // GH/s
+    float power;               // W
+};
+
+struct GovAction {
+    uint8_t device;
+    int frequency;             // new setpoint
+    int deltaMHz;              // negative = cut, positive = restore
+};
+
+class PowerGovernor {
+public:
+    void configure(float capW, float hystW, int freqStep = 25, int minFreq = 400, uint32_t intervalSec = 30) {
+        _cap = max(0.0f, capW);
+        _hyst = max(0.0f, hystW);
+        _step = max(1, freqStep);
+        _minFreq = minFreq;
+        _interval = intervalSec;
+    }
+
+    bool enabled() const { return _cap > 0; }
+    float cap() const { return _cap; }
+    float hysteresis() const { return _hyst; }
+    int cutMHz(uint8_t i) const { return i < MAX_DEVICES ? _cut[i] : 0; }
+    int totalCutMHz() const {
+        int t = 0;
+        for (int i = 0; i < MAX_DEVICES; i++) t += _cut[i];
+        return t;
+    }
+    const char* lastReason() const { return _reason; }
+
+    // A fresh sample from device i arrived
+    void sampled(uint8_t i) {
+        if (i < MAX_DEVICES) _awaiting[i] = false;
+    }
+
+    // Someone else took over device i (manual setting): forget what was cut there
+    void forget(uint8_t i) {
+        if (i >= MAX_DEVICES) return;
+        _cut[i] = 0;
+        _awaiting[i] = false;
+    }
+
+    // Decide the next step. Returns true with one frequency change to PATCH.
+    bool evaluate(const GovDevice* devs, int n, float totalPower, uint32_t now, GovAction& out) {
+        if (!enabled()) {
+            _reason = "disabled";
+            return false;
+        }
+        if (_acted && now - _lastAction < _interval) return false;
+        n = min(n, MAX_DEVICES);
+
+        if (totalPower > _cap) {
+            int pick = _pickCut(devs, n, false);
+            if (pick < 0) pick = _pickCut(devs, n, true);
+            if (pick < 0) {
+                _reason = "over cap, nothing left to cut";
+                return false;
+            }
+            out.device = pick;
+            out.deltaMHz = -min(_step, devs[pick].frequency - _minFreq);
+            out.frequency = devs[pick].frequency + out.deltaMHz;
+            _reason = "over cap";
+            return true;
+        }
+
+        // Headroom: give back to the most efficient device we have cut
+        int pick = -1;
+        float bestJth = 0;
+        for (int i = 0; i < n; i++) {
+            const GovDevice& d = devs[i];
+            if (_cut[i] <= 0 || !d.online || _awaiting[i] || d.frequency <= 0) continue;
+            float jth = _jth(d);
+            if (pick < 0 || jth < bestJth) { pick = i; bestJth = jth; }
+        }
+        if (pick < 0) {
+            _reason = "within cap";
+            return false;
+        }
+        const GovDevice& d = devs[pick];
+        int delta = min(_step, _cut[pick]);
+        float estimate = d.power * delta / d.frequency;
+        if (totalPower + estimate > _cap - _hyst) {
+            _reason = "holding (inside hysteresis band)";
+            return false;
+        }
+        out.device = pick;
+        out.deltaMHz = delta;
+        out.frequency = d.frequency + delta;
+        _reason = "restoring headroom";
+        return true;
+    }
+
+    // Result of the PATCH for an action returned by evaluate()
+    void applied(const GovAction& a, bool ok, uint32_t now) {
+        _acted = true;
+        _lastAction = now;               // failures are rate limited too
+        if (!ok || a.device >= MAX_DEVICES) return;
+        _cut[a.device] = max(0, _cut[a.device] - a.deltaMHz);
+        _awaiting[a.device] = true;
+        Serial.printf("POWER CAP: device %d %+dMHz -> %dMHz (cut %dMHz)\n",
+                      a.device, a.deltaMHz, a.frequency, _cut[a.device]);
+    }
+
+private:
+    float _cap = 0;
+    float _hyst = 10;
+    int _step = 25;
+    int _minFreq = 400;
+    uint32_t _interval = 30;
+    int _cut[MAX_DEVICES] = {0};
+    bool _awaiting[MAX_DEVICES] = {false};
+    bool _acted = false;
+    uint32_t _lastAction = 0;
+    const char* _reason = "disabled";
+
+    static float _jth(const GovDevice& d) {
+        return (d.hashRate > 0) ? d.power / (d.hashRate / 1000.0f) : 1e9f;
+    }
+
+    // Worst J/TH online device that can still go lower
+    int _pickCut(const GovDevice* devs, int n, bool allowBusy) const {
+        int pick = -1;
+        float worst = 0;
+        for (int i = 0; i < n; i++) {
+            const GovDevice& d = devs[i];
+            if (!d.online || _awaiting[i] || d.frequency - _minFreq <= 0) continue;
+            if (d.busy && !allowBusy) continue;
+            float jth = _jth(d);
+            if (pick < 0 || jth > worst) { pick = i; worst = jth; }
+        }
+        return pick;
+    }
+};
@@ -0,0 +1,152 @@
+#pragma once
+/**
+ * Profitability and expected-block engine
+ *
+ * Solo / lottery figures from hashrate, network difficulty and coin price:
+ *
+ *   hashes per block      D * 2^32
+ *   blocks per day        H * 86400 / (D * 2^32)        (H in H/s)
+ *   time to block         1 / block rate                (expected)
+ *   P(block within T)     1 - exp(-H * T / (D * 2^32))
+ *   shares per hour       H * 3600 / (d_share * 2^32)   (pool share difficulty)
+ *   revenue per day       blocks per day * block reward * price
+ *   profit per day        revenue - energy cost (kW * tariff rate-hours per day)
+ *
+ * Inputs arrive through setters — setDevice() per fetch, setNetwork() when
+ * the price or difficulty is refreshed, setRateHours() when the tariff day
+ * changes. Each setter only marks what it affects; figures are recomputed on
+ * read, and fleet sums are kept by difference like FleetStats.
+ */
+
+#include <Arduino.h>
+#include <math.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define PROFIT_TWO_32 4294967296.0
+
+struct ProfitFigures {
+    float sharesPerHour = 0;       // expected at the pool's share difficulty, 0 = unknown
+    double blocksPerDay = 0;
+    double hoursToBlock = 0;       // expected, 0 = no hashrate or no difficulty
+    float revenuePerDay = 0;       // fiat
+    float costPerDay = 0;
+    float profitPerDay = 0;
+};
+
+class Profitability {
+public:
+    void setNetwork(double difficulty, float price, float blockReward) {
+        if (difficulty == _difficulty && price == _price && blockReward == _reward) return;
+        _difficulty = difficulty;
+        _price = price;
+        _reward = blockReward;
+        _dirtyAll();
+    }
+
+    // Energy price of running one kW for a whole day (TariffSchedule::dailyRateHours)
+    void setRateHours(float rateHours) {
+        if (rateHours == _rateHours) return;
+        _rateHours = rateHours;
+        _dirtyAll();
+    }
+
+    void setDevice(uint8_t i, float ghs, float watts, double shareDiff) {
+        if (i >= MAX_DEVICES) return;
+        _In& d = _in[i];
+        if (d.online && d.ghs == ghs && d.watts == watts && d.shareDiff == shareDiff) return;
+        if (d.online) { _ghs -= d.ghs; _watts -= d.watts; _sph -= d.sph; }
+        d.ghs = ghs;
+        d.watts = watts;
+        d.shareDiff = shareDiff;
+        d.sph = (shareDiff > 0) ? ghs * 1e9 * 3600.0 / (shareDiff * PROFIT_TWO_32) : 0;
+        d.online = true;
+        _ghs += ghs; _watts += watts; _sph += d.sph;
+        d.dirty = true;
+        _fleetDirty = true;
+    }
+
+    void dropDevice(uint8_t i) {
+        if (i >= MAX_DEVICES || !_in[i].online) return;
+        _In& d = _in[i];
+        _ghs -= d.ghs; _watts -= d.watts; _sph -= d.sph;
+        d = _In();
+        _fleetDirty = true;
+    }
+
+    void reset() {
+        for (int i = 0; i < MAX_DEVICES; i++) _in[i] = _In();
+        _ghs = _watts = _sph = 0;
+        _fleetDirty = true;
+    }
+
+    bool ready() const { return _difficulty > 0; }
+    double difficulty() const { return _difficulty; }
+    float blockReward() const { return _reward; }
+
+    const ProfitFigures& device(uint8_t i) {
+        static const ProfitFigures none;
+        if (i >= MAX_DEVICES || !_in[i].online) return none;
+        _In& d = _in[i];
+        if (d.dirty) {
+            _compute(d.ghs, d.watts, d.sph, d.out);
+            d.dirty = false;
+        }
+        return d.out;
+    }
+
+    const ProfitFigures& fleet() {
+        if (_fleetDirty) {
+            _compute(_ghs, _watts, _sph, _fleet);
+            _fleetDirty = false;
+        }
+        return _fleet;
+    }
+
+    // Chance of at least one block within `hours` at the given hashrate (GH/s)
+    double blockProbability(float ghs, float hours) const {
+        if (_difficulty <= 0 || ghs <= 0) return 0;
+        return 1.0 - exp(-(double)ghs * 1e9 * hours * 3600.0 / (_difficulty * PROFIT_TWO_32));
+    }
+    double fleetBlockProbability(float hours) const { return blockProbability((float)_ghs, hours); }
+
+private:
+    struct _In {
+        bool online = false;
+        bool dirty = false;
+        float ghs = 0;
+        float watts = 0;
+        double shareDiff = 0;
+        double sph = 0;
+        ProfitFigures out;
+    };
+
+    _In _in[MAX_DEVICES];
+    ProfitFigures _fleet;
+    bool _fleetDirty = true;
+    double _ghs = 0, _watts = 0, _sph = 0;     // doubles so add / subtract cycles do not drift
+    double _difficulty = 0;
+    float _price = 0;
+    float _reward = 3.125f;
+    float _rateHours = 0;
+
+    void _dirtyAll() {
+        for (int i = 0; i < MAX_DEVICES; i++) _in[i].dirty = true;
+        _fleetDirty = true;
+    }
+
+    void _compute(double ghs, double watts, double sph, ProfitFigures& out) const {
+        out = ProfitFigures();
+        out.sharesPerHour = (float)max(0.0, sph);
+        out.costPerDay = (float)(max(0.0, watts) / 1000.0 * _rateHours);
+        if (_difficulty > 0 && ghs > 0) {
+            double perDay = ghs * 1e9 * 86400.0 / (_difficulty * PROFIT_TWO_32);
+            out.blocksPerDay = perDay;
+            out.hoursToBlock = 24.0 / perDay;
+            out.revenuePerDay = (float)(perDay * _reward * _price);
+        }
+        out.profitPerDay = out.revenuePerDay - out.costPerDay;
+    }
+};
@@ -0,0 +1,164 @@
+#pragma once
+/**
+ * Scalar settings held in RAM, written to flash in batches
+ *
+ * A Preferences put is a blocking NVS write, and holding a rate button
+ * down used to make one per tap. SettingsStore keeps the int, float and
+ * bool settings of the namespace in a small table: get() reads flash once
+ * and caches the value, set() only updates the table and marks the key
+ * dirty. loop() writes every dirty key in one go once nothing has changed
+ * for SETTINGS_QUIET_MS; flush() does it at once and belongs in every path
+ * that reboots on purpose. A value set back to what flash already holds is
+ * no longer dirty, so stepping a rate up and down again writes nothing.
+ *
+ * Keys must outlive the store (string literals); past SETTINGS_MAX keys a
+ * set() writes through. Strings and blobs (device list, rules, energy
+ * totals) are not cached here; they are written where they change, which
+ * is never on the touch path.
+ */
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#define SETTINGS_MAX        24
+#define SETTINGS_QUIET_MS   5000           // after the last change: long enough for a held button
+
+class SettingsStore {
+public:
+    explicit SettingsStore(Preferences& prefs) : _prefs(prefs) {}
+
+    int getInt(const char* key, int def) {
+        _Entry* e = _load(key, S_INT);
+        if (!e) return _prefs.getInt(key, def);
+        if (!e->known) {
+            e->v.i = e->saved.i = _prefs.getInt(key, def);
+            e->known = true;
+        }
+        return e->v.i;
+    }
+    float getFloat(const char* key, float def) {
+        _Entry* e = _load(key, S_FLOAT);
+        if (!e) return _prefs.getFloat(key, def);
+        if (!e->known) {
+            e->v.f = e->saved.f = _prefs.getFloat(key, def);
+            e->known = true;
+        }
+        return e->v.f;
+    }
+    bool getBool(const char* key, bool def) {
+        _Entry* e = _load(key, S_BOOL);
+        if (!e) return _prefs.getBool(key, def);
+        if (!e->known) {
+            e->v.b = e->saved.b = _prefs.getBool(key, def);
+            e->known = true;
+        }
+        return e->v.b;
+    }
+
+    void setInt(const char* key, int v, unsigned long now) {
+        _Entry* e = _load(key, S_INT);
+        if (!e) {
+            _prefs.putInt(key, v);
+            return;
+        }
+        e->v.i = v;
+        _touched(e, !e->known || e->saved.i != v, now);
+    }
+    void setFloat(const char* key, float v, unsigned long now) {
+        _Entry* e = _load(key, S_FLOAT);
+        if (!e) {
+            _prefs.putFloat(key, v);
+            return;
+        }
+        e->v.f = v;
+        _touched(e, !e->known || e->saved.f != v, now);
+    }
+    void setBool(const char* key, bool v, unsigned long now) {
+        _Entry* e = _load(key, S_BOOL);
+        if (!e) {
+            _prefs.putBool(key, v);
+            return;
+        }
+        e->v.b = v;
+        _touched(e, !e->known || e->saved.b != v, now);
+    }
+
+    // Flush once the settings have been left alone for SETTINGS_QUIET_MS; true when it wrote.
+    // now may be older than the last set() (taken at the top of loop()), hence the signed test.
+    bool loop(unsigned long now) {
+        if (pending() == 0 || (long)(now - _changedAt) < (long)SETTINGS_QUIET_MS) return false;
+        return flush() > 0;
+    }
+
+    // Write every dirty key now; returns how many
+    int flush() {
+        int n = 0;
+        for (int k = 0; k < _n; k++) {
+            _Entry& e = _e[k];
+            if (!e.dirty) continue;
+            switch (e.type) {
+            case S_INT: _prefs.putInt(e.key, e.v.i); break;
+            case S_FLOAT: _prefs.putFloat(e.key, e.v.f); break;
+            case S_BOOL: _prefs.putBool(e.key, e.v.b); break;
+            }
+            e.saved = e.v;
+            e.known = true;
+            e.dirty = false;
+            n++;
+        }
+        _writes += n;
+        if (n) _flushes++;
+        return n;
+    }
+
+    int pending() const {
+        int n = 0;
+        for (int k = 0; k < _n; k++) n += _e[k].dirty;
+        return n;
+    }
+    uint32_t writes() const { return _writes; }        // keys written since boot
+    uint32_t flushes() const { return _flushes; }
+
+private:
+    enum _Type : uint8_t { S_INT, S_FLOAT, S_BOOL };
+
+    union _Value {
+        int i;
+        float f;
+        bool b;
+    };
+
+    struct _Entry {
+        const char* key;
+        _Type type;
+        bool known;                // saved holds what flash has
+        bool dirty;
+        _Value v;
+        _Value saved;
+    };
+
+    Preferences& _prefs;
+    _Entry _e[SETTINGS_MAX];
+    int _n = 0;
+    unsigned long _changedAt = 0;
+    uint32_t _writes = 0;
+    uint32_t _flushes = 0;
+
+    // Entry for key, added (not yet read) when new; null when the table is full
+    _Entry* _load(const char* key, _Type type) {
+        for (int k = 0; k < _n; k++)
+            if (_e[k].type == type && strcmp(_e[k].key, key) == 0) return &_e[k];
+        if (_n >= SETTINGS_MAX) return nullptr;
+        _Entry& e = _e[_n++];
+        e.key = key;
+        e.type = type;
+        e.known = e.dirty = false;
+        e.v.i = e.saved.i = 0;
+        return &e;
+    }
+
+    void _touched(_Entry* e, bool dirty, unsigned long now) {
+        e->dirty = dirty;
+        _changedAt = now;
+    }
+};
@@ -0,0 +1,77 @@
+#pragma once
+/**
+ * Interned strings shared across devices
+ *
+ * Model, ASIC and pool URL take a handful of distinct values across a fleet
+ * and change only when a miner is reconfigured. StringPool keeps each
+ * distinct value once, in a fixed slot with a reference count. assign()
+ * compares first and only touches the pool when the value differs: it finds
+ * or fills a slot for the new value and releases the old one. Nothing is
+ * allocated; with F interned fields per device, F * MAX_DEVICES + 1 slots
+ * can never run out (the +1 covers the moment both old and new are held).
+ *
+ * Values longer than LEN - 1 are truncated. The empty string is never
+ * pooled; a field that holds no value points at "".
+ */
+
+#include <Arduino.h>
+
+template <int SLOTS, int LEN>
+class StringPool {
+public:
+    // Point ref at the pooled copy of s; false when it already held that value
+    bool assign(const char*& ref, const char* s) {
+        if (!s) s = "";
+        if (ref && strncmp(ref, s, LEN - 1) == 0) return false;
+        const char* next = "";
+        if (*s) {
+            int k = _find(s);
+            if (k < 0) k = _unused();
+            if (k < 0) return false;
+            if (_refs[k] == 0) {
+                size_t n = strnlen(s, LEN - 1);
+                memcpy(_slot[k], s, n);
+                _slot[k][n] = '\0';
+            }
+            _refs[k]++;
+            next = _slot[k];
+        }
+        release(ref);
+        ref = next;
+        return true;
+    }
+
+    void release(const char*& ref) {
+        int k = _index(ref);
+        if (k >= 0 && _refs[k] > 0) _refs[k]--;
+        ref = "";
+    }
+
+    // Slots holding a value
+    int used() const {
+        int n = 0;
+        for (int k = 0; k < SLOTS; k++) n += _refs[k] > 0;
+        return n;
+    }
+
+private:
+    char _slot[SLOTS][LEN] = {};
+    uint16_t _refs[SLOTS] = {};
+
+    int _find(const char* s) const {
+        for (int k = 0; k < SLOTS; k++)
+            if (_refs[k] && strncmp(_slot[k], s, LEN - 1) == 0) return k;
+        return -1;
+    }
+
+    int _unused() const {
+        for (int k = 0; k < SLOTS; k++)
+            if (_refs[k] == 0) return k;
+        return -1;
+    }
+
+    int _index(const char* p) const {
+        if (!p || p < _slot[0] || p >= _slot[0] + SLOTS * LEN) return -1;
+        return (p - _slot[0]) / LEN;
+    }
+};
@@ -0,0 +1,195 @@
+#pragma once
+/**
+ * Thermal governor: per-device fan curves with frequency throttling
+ *
+ * Stage 1 — fan. Each device has a FanCurve (up to FAN_CURVE_POINTS
+ * temp -> fanspeed points, linearly interpolated, flat outside the ends).
+ * The fan follows the curve immediately when the chip heats up, but only
+ * steps down once the chip is hystC below the temperature that asked for
+ * the current speed, so it does not hunt around a breakpoint.
+ *
+ * Stage 2 — frequency. Only when the fan is already commanded to 100 % and
+ * the chip is still above throttleTemp, frequency is cut by freqStep (down
+ * to minFreq). Cuts are given back one step at a time once the chip is
+ * releaseHyst below throttleTemp. At most one frequency change per device
+ * per intervalSec.
+ *
+ * A PATCH is only requested when a target actually changes, or when the
+ * device reports a fan speed that no longer matches what was sent (e.g.
+ * after a reboot). The latter is retried THERMAL_DRIFT_RETRIES times in a
+ * row at most: a device that keeps its own fan floor would otherwise be
+ * PATCHed on every poll. cutMHz(i) is what stage 2 took from device i.
+ */
+
+#include <Arduino.h>
+
+#ifndef MAX_DEVICES
+#define MAX_DEVICES 8
+#endif
+
+#define FAN_CURVE_POINTS 6
+#define THERMAL_DRIFT_RETRIES 3    // fan re-sends while the device keeps reporting something else
+
+struct FanCurve {
+    uint8_t n = 0;
+    float temp[FAN_CURVE_POINTS];      // ascending, C
+    uint8_t pct[FAN_CURVE_POINTS];     // fanspeed %
+
+    float eval(float t) const {
+        if (n == 0) return 100;
+        if (t <= temp[0]) return pct[0];
+        for (int k = 1; k < n; k++) {
+            if (t <= temp[k]) {
+                float f = (t - temp[k - 1]) / (temp[k] - temp[k - 1]);
+                return pct[k - 1] + f * (pct[k] - pct[k - 1]);
+            }
+        }
+        return pct[n - 1];
+    }
+
+    // "40:30,50:45,60:80,65:100" — temperatures must ascend, speeds 0..100
+    bool parse(const char* text) {
+        FanCurve c;
+        const char* p = text;
+        while (*p && c.n < FAN_CURVE_POINTS) {
+            char* end;
+            float t = strtof(p, &end);
+            if (end == p || *end != ':') return false;
+            p = end + 1;
+            long v = strtol(p, &end, 10);
+            if (end == p || v < 0 || v > 100) return false;
+            if (c.n > 0 && t <= c.temp[c.n - 1]) return false;
+            c.temp[c.n] = t;
+            c.pct[c.n] = (uint8_t)v;
+            c.n++;
+            p = end;
+            while (*p == ',' || *p == ' ') p++;
+        }
+        if (c.n == 0 || *p) return false;
+        *this = c;
+        return true;
+    }
+
+    void format(char* buf, size_t size) const {
+        size_t len = 0;
+        buf[0] = '\0';
+        for (int k = 0; k < n && len < size; k++) {
+            len += snprintf(buf + len, size - len, "%s%.0f:%u", k ? "," : "", temp[k], pct[k]);
+        }
+    }
+};
+
+static const char* const FAN_CURVE_DEFAULT = "45:35,52:50,58:70,63:90,66:100";
+
+struct ThermalConfig {
+    float hystC = 2.0f;            // fan step-down hysteresis
+    float throttleTemp = 68.0f;    // stage 2 threshold, C
+    float releaseHyst = 3.0f;      // give frequency back below throttleTemp - this
+    int freqStep = 25;
+    int minFreq = 400;
+    uint32_t intervalSec = 60;
+};
+
+// What the governor needs from one device fetch
+struct ThermalSample {
+    float temperature;
+    int fanSpeed;                  // % as reported
+    int frequency;                 // MHz as reported
+};
+
+struct ThermalAction {
+    int fan = -1;                  // new fanspeed %, -1 = no change
+    int frequency = -1;            // new frequency, -1 = no change
+    int deltaMHz = 0;
+};
+
+class ThermalGovernor {
+public:
+    ThermalGovernor() {
+        for (int i = 0; i < MAX_DEVICES; i++) _curve[i].parse(FAN_CURVE_DEFAULT);
+    }
+
+    void setEnabled(bool on) { _enabled = on; }
+    bool enabled() const { return _enabled; }
+    ThermalConfig& config() { return _cfg; }
+    FanCurve& curve(uint8_t i) { return _curve[i < MAX_DEVICES ? i : 0]; }
+
+    int fanTarget(uint8_t i) const { return i < MAX_DEVICES ? _st[i].fan : -1; }
+    int cutMHz(uint8_t i) const { return i < MAX_DEVICES ? _st[i].cut : 0; }
+    bool paused(uint8_t i, uint32_t now) const { return i < MAX_DEVICES && now < _st[i].pausedUntil; }
+
+    // Leave device i alone for a while (manual FAN+ tap)
+    void pause(uint8_t i, uint32_t until) {
+        if (i < MAX_DEVICES) _st[i].pausedUntil = until;
+    }
+
+    // Someone else set the frequency of device i: forget the stage 2 cut
+    void forget(uint8_t i) {
+        if (i < MAX_DEVICES) _st[i].cut = 0;
+    }
+
+    // Decide targets for a fresh sample. Returns true when something needs a PATCH.
+    bool evaluate(uint8_t i, const ThermalSample& s, uint32_t now, ThermalAction& out) {
+        out = ThermalAction();
+        if (!_enabled || i >= MAX_DEVICES || now < _st[i].pausedUntil) return false;
+        _State& st = _st[i];
+
+        // Stage 1: fan, up immediately, down only past the hysteresis
+        int up = (int)(_curve[i].eval(s.temperature) + 0.5f);
+        int down = (int)(_curve[i].eval(s.temperature + _cfg.hystC) + 0.5f);
+        int target = st.fan;
+        if (target < 0 || up > target) target = up;
+        else if (down < target) target = down;
+        bool drifted = st.fan >= 0 && abs(s.fanSpeed - st.fan) > 5;
+        if (!drifted) st.driftFixes = 0;
+        if (target != st.fan) {
+            out.fan = target;
+        } else if (drifted && st.driftFixes < THERMAL_DRIFT_RETRIES) {
+            out.fan = target;
+            if (++st.driftFixes == THERMAL_DRIFT_RETRIES) {
+                Serial.printf("THERMAL: device %d stays at fan %d%% (sent %d%%), not re-sending\n", i, s.fanSpeed, st.fan);
+            }
+        }
+
+        // Stage 2: frequency, only with the fan already flat out
+        bool canAct = !st.acted || now - st.lastFreqChange >= _cfg.intervalSec;
+        if (canAct && s.frequency > 0) {
+            if (target >= 100 && st.fan >= 100 && s.temperature > _cfg.throttleTemp && s.frequency > _cfg.minFreq) {
+                out.deltaMHz = -min(_cfg.freqStep, s.frequency - _cfg.minFreq);
+            } else if (st.cut > 0 && s.temperature < _cfg.throttleTemp - _cfg.releaseHyst) {
+                out.deltaMHz = min(_cfg.freqStep, st.cut);
+            }
+            if (out.deltaMHz != 0) out.frequency = s.frequency + out.deltaMHz;
+        }
+        return out.fan >= 0 || out.frequency >= 0;
+    }
+
+    void appliedFan(uint8_t i, int pct, bool ok) {
+        if (ok && i < MAX_DEVICES) _st[i].fan = pct;
+    }
+
+    void appliedFreq(uint8_t i, int deltaMHz, bool ok, uint32_t now) {
+        if (i >= MAX_DEVICES) return;
+        _State& st = _st[i];
+        st.acted = true;
+        st.lastFreqChange = now;
+        if (!ok) return;
+        st.cut = max(0, st.cut - deltaMHz);
+        Serial.printf("THERMAL: device %d %+dMHz (cut %dMHz)\n", i, deltaMHz, st.cut);
+    }
+
+private:
+    struct _State {
+        int fan = -1;                      // last fanspeed sent, -1 = never
+        int cut = 0;
+        uint8_t driftFixes = 0;            // consecutive re-sends of an unchanged fan target
+        bool acted = false;
+        uint32_t lastFreqChange = 0;
+        uint32_t pausedUntil = 0;
+    };
+
+    bool _enabled = false;
+    ThermalConfig _cfg;
+    FanCurve _curve[MAX_DEVICES];
+    _State _st[MAX_DEVICES];
+};
@@ -0,0 +1,182 @@
+#pragma once
+/**
+ * Scrolling sparkline / trend chart widget
+ *
+ * A TrendChart owns an 8-bit TFT_eSprite the size of its chart strip and is
+ * bound to one (series, metric) of the MetricsHistory store.
+ *
+ *   attach() + load()  — full render, backfilled from the history tiers
+ *   push(value)        — scroll the sprite left one column, draw only the new
+ *                        right-hand column, push the strip to the panel
+ *
+ * The last TREND_MAX_COLS values are mirrored in a small ring so the chart
+ * can re-render itself when a value leaves the current Y range, without going
+ * back to the history store. The Y range is recomputed from the ring once per
+ * chart width of samples so it can also shrink again.
+ */
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "metrics_history.h"
+
+#ifndef TREND_MAX_COLS
+#define TREND_MAX_COLS 160
+#endif
+
+#define TREND_GRID_STEP 4      // dotted midline spacing, px
+
+struct TrendStyle {
+    uint16_t bg;
+    uint16_t fill;             // area under the line
+    uint16_t line;
+    uint16_t grid;
+    uint16_t label;
+};
+
+class TrendChart {
+public:
+    explicit TrendChart(TFT_eSPI* tft) : _tft(tft), _spr(tft) {}
+
+    // Place the chart on screen and bind it to a history series.
+    // The sprite is kept between attaches and only reallocated when the size changes.
+    bool attach(int x, int y, int w, int h, uint16_t series, uint8_t metric,
+                const TrendStyle& style, const char* label = nullptr) {
+        w = constrain(w, 2, TREND_MAX_COLS);
+        if (h < 4) return false;
+        if (!_spr.created() || w != _w || h != _h) {
+            _spr.deleteSprite();
+            _spr.setColorDepth(8);
+            if (!_spr.createSprite(w, h)) {
+                Serial.println("TREND: sprite allocation failed");
+                _attached = false;
+                return false;
+            }
+        }
+        _x = x; _y = y; _w = w; _h = h;
+        _series = series;
+        _metric = metric;
+        _style = style;
+        _label = label;
+        _spr.setScrollRect(0, 0, _w, _h, _style.bg);
+        for (int i = 0; i < TREND_MAX_COLS; i++) _vals[i] = NAN;
+        _head = 0;
+        _ticks = 0;
+        _attached = true;
+        return true;
+    }
+
+    void detach() { _attached = false; }
+
+    bool attached() const { return _attached; }
+    uint16_t series() const { return _series; }
+    uint8_t metric() const { return _metric; }
+
+    // Backfill one column per `colSeconds` ending at `now`, then render everything
+    void load(const MetricsHistory& hist, uint32_t now, uint32_t colSeconds) {
+        if (!_attached) return;
+        if (colSeconds == 0) colSeconds = 1;
+        uint32_t span = colSeconds * _w;
+        uint32_t from = (now > span) ? now - span : 0;
+        for (int c = 0; c < _w; c++) {
+            uint32_t c0 = from + colSeconds * c;
+            HistPoint pt;
+            float v = (hist.read(_series, _metric, c0, c0 + colSeconds, 1, &pt) > 0) ? pt.mean : NAN;
+            _head = (_head + 1) % _w;
+            _vals[_head] = v;
+            _ticks++;
+        }
+        _rescale();
+        _render();
+    }
+
+    // Append one sample and scroll it in
+    void push(float v) {
+        if (!_attached) return;
+        float prev = _vals[_head];
+        _head = (_head + 1) % _w;
+        _vals[_head] = v;
+        _ticks++;
+        if (++_sinceRescale >= _w || (!isnan(v) && (v < _lo || v > _hi))) {
+            _rescale();
+            _render();
+            return;
+        }
+        _spr.scroll(-1, 0);
+        _drawColumn(_w - 1, v, prev, _ticks);
+        _present();
+    }
+
+private:
+    TFT_eSPI* _tft;
+    TFT_eSprite _spr;
+    bool _attached = false;
+    int _x = 0, _y = 0, _w = 0, _h = 0;
+    uint16_t _series = 0;
+    uint8_t _metric = 0;
+    TrendStyle _style = {};
+    const char* _label = nullptr;
+
+    float _vals[TREND_MAX_COLS];   // ring, NAN = gap
+    int _head = 0;                 // newest column
+    uint32_t _ticks = 0;           // samples pushed, keeps the grid phase stable while scrolling
+    int _sinceRescale = 0;
+    float _lo = 0, _hi = 1;
+
+    void _rescale() {
+        _sinceRescale = 0;
+        bool any = false;
+        float lo = 0, hi = 0;
+        for (int i = 0; i < _w; i++) {
+            float v = _vals[i];
+            if (isnan(v)) continue;
+            if (!any || v < lo) lo = v;
+            if (!any || v > hi) hi = v;
+            any = true;
+        }
+        if (!any) { _lo = 0; _hi = 1; return; }
+        // Pad so a steady value sits mid-chart instead of hugging an edge
+        float pad = max((hi - lo) * 0.1f, max(fabsf(hi) * 0.02f, 0.5f));
+        _lo = lo - pad;
+        _hi = hi + pad;
+    }
+
+    int _yOf(float v) const {
+        int y = (int)((_hi - v) / (_hi - _lo) * (_h - 1) + 0.5f);
+        return constrain(y, 0, _h - 1);
+    }
+
+    void _drawColumn(int x, float v, float prev, uint32_t tick) {
+        if (tick % TREND_GRID_STEP == 0) _spr.drawPixel(x, _h / 2, _style.grid);
+        if (isnan(v)) return;
+        int y = _yOf(v);
+        if (y + 1 < _h) _spr.drawFastVLine(x, y + 1, _h - y - 1, _style.fill);
+        if (isnan(prev)) {
+            _spr.drawPixel(x, y, _style.line);
+        } else {
+            int py = _yOf(prev);
+            _spr.drawFastVLine(x, min(y, py), abs(y - py) + 1, _style.line);
+        }
+    }
+
+    void _render() {
+        _spr.fillSprite(_style.bg);
+        for (int x = 0; x < _w; x++) {
+            int age = _w - 1 - x;
+            int i = (_head - age + _w) % _w;
+            float prev = (x > 0) ? _vals[(i - 1 + _w) % _w] : NAN;
+            _drawColumn(x, _vals[i], prev, _ticks - age);
+        }
+        _present();
+    }
+
+    void _present() {
+        _spr.pushSprite(_x, _y);
+        // The caption lives on the panel, not in the sprite, so it never scrolls
+        if (_label) {
+            _tft->setTextColor(_style.label);
+            _tft->setTextSize(1);
+            _tft->setCursor(_x + 2, _y + 2);
+            _tft->print(_label);
+        }
+    }
+};
@@ -0,0 +1,38 @@
+#pragma once
+/**
+ * src/main.cpp as the tests see it: the globals and entry points they drive
+ */
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <WebServer.h>
+#include <fleet_store.h>
+#include <fleet_stats.h>
+
+#define TEST_MINERS 3
+
+extern TFT_eSPI tft;
+extern WebServer webServer;
+extern FleetStore fleet;
+extern FleetStats fleetStats;
+extern int currentScreen;
+extern int deviceCount;
+
+void setup();
+void loop();
+void applyDevicePayload(int index, int httpCode, const char* payload, size_t len);
+void drawMainUI();
+void updateDisplay();
+void drawPoolScreen();
+void updatePoolScreen();
+void drawDeviceScreen(int devIndex);
+void updateDeviceScreen(int devIndex);
+void drawFleetScreen();
+void drawFleetTable();
+int fleetScreenIndex();
+
+// setup() once, against TEST_MINERS simulated miners on 10.0.0.1 ... (later calls do nothing)
+void bootFirmware();
+
+// loop() until ms of virtual time have passed
+void runFor(uint32_t ms);
@@ -0,0 +1,110 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <alert_engine.h>
+
+static AlertEngine engine;
+
+static AlertSample online(float temp) {
+    AlertSample s = {};
+    s.online = true;
+    s.temperature = temp;
+    s.hashRate = 1000;
+    s.hashRate1h = 1000;
+    s.vin = 5.1f;
+    return s;
+}
+
+static void test_compile_reads_every_option() {
+    TEST_ASSERT_TRUE(engine.compile("temp > 68 for 3 hyst 3 cool 900; vin < 4.9 for 2 hyst 0.1\noffline dev 2"));
+    TEST_ASSERT_EQUAL_UINT8(3, engine.ruleCount());
+
+    const AlertRule& t = engine.rule(0);
+    TEST_ASSERT_EQUAL_UINT8(AM_TEMP, t.metric);
+    TEST_ASSERT_FALSE(t.below);
+    TEST_ASSERT_EQUAL_FLOAT(68, t.threshold);
+    TEST_ASSERT_EQUAL_UINT8(3, t.forN);
+    TEST_ASSERT_EQUAL_FLOAT(3, t.hyst);
+    TEST_ASSERT_EQUAL_UINT32(900, t.cooldownSec);
+    TEST_ASSERT_EQUAL_UINT8(ALERT_ALL_DEVICES, t.device);
+
+    const AlertRule& v = engine.rule(1);
+    TEST_ASSERT_EQUAL_UINT8(AM_VIN, v.metric);
+    TEST_ASSERT_TRUE(v.below);
+    TEST_ASSERT_EQUAL_FLOAT(4.9f, v.threshold);
+    TEST_ASSERT_EQUAL_UINT8(2, v.forN);
+
+    const AlertRule& o = engine.rule(2);
+    TEST_ASSERT_EQUAL_UINT8(AM_OFFLINE, o.metric);
+    TEST_ASSERT_EQUAL_UINT8(1, o.forN);
+    TEST_ASSERT_EQUAL_UINT8(2, o.device);
+}
+
+static void test_format_compiles_back_to_the_same_rules() {
+    TEST_ASSERT_TRUE(engine.compile("hashdrop > 20 for 4 cool 600; fan>95; reject > 5 hyst 1 dev 0; offline"));
+    char text[256];
+    engine.format(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("hashdrop > 20 for 4 cool 600; fan > 95; reject > 5 hyst 1 dev 0; offline", text);
+
+    AlertRule before[ALERT_MAX_RULES];
+    uint8_t n = engine.ruleCount();
+    for (uint8_t r = 0; r < n; r++) before[r] = engine.rule(r);
+    TEST_ASSERT_TRUE(engine.compile(text));
+    TEST_ASSERT_EQUAL_UINT8(n, engine.ruleCount());
+    for (uint8_t r = 0; r < n; r++) TEST_ASSERT_EQUAL_MEMORY(&before[r], &engine.rule(r), sizeof(AlertRule));
+}
+
+static void test_bad_rule_is_reported_and_changes_nothing() {
+    TEST_ASSERT_TRUE(engine.compile("temp > 70"));
+    const char* bad[] = {
+        "temp > 70; bogus > 1",        // unknown metric
+        "temp > 70; power = 5",        // no operator
+        "temp > 70; power >",          // no threshold
+        "temp > 70; fan > 90 for 0",   // for out of range
+        "temp > 70; fan > 90 dev 8",   // no such slot
+        "temp > 70; fan > 90 soon",    // unknown option
+        "temperature > 70",            // a metric name must stand alone
+    };
+    for (const char* text : bad) {
+        const char* errAt = nullptr;
+        TEST_ASSERT_FALSE(engine.compile(text, &errAt));
+        TEST_ASSERT_NOT_NULL(errAt);
+        TEST_ASSERT_TRUE(errAt >= text && errAt <= text + strlen(text));
+        TEST_ASSERT_EQUAL_UINT8(1, engine.ruleCount());
+        TEST_ASSERT_EQUAL_FLOAT(70, engine.rule(0).threshold);
+    }
+
+    char many[256] = "";
+    for (int k = 0; k <= ALERT_MAX_RULES; k++) strcat(many, "temp > 80;");
+    TEST_ASSERT_FALSE(engine.compile(many));
+    TEST_ASSERT_EQUAL_UINT8(1, engine.ruleCount());
+}
+
+static void test_for_and_hysteresis() {
+    TEST_ASSERT_TRUE(engine.compile("temp > 68 for 2 hyst 3"));
+    engine.ingest(0, online(70), 10);
+    TEST_ASSERT_FALSE(engine.active(0, 0));
+    engine.ingest(0, online(70), 15);
+    TEST_ASSERT_TRUE(engine.active(0, 0));
+    TEST_ASSERT_EQUAL(1, engine.activeCount());
+    AlertEvent e;
+    TEST_ASSERT_TRUE(engine.next(e));
+    TEST_ASSERT_TRUE(e.raised);
+    TEST_ASSERT_EQUAL_UINT8(0, e.device);
+    engine.consume();
+
+    engine.ingest(0, online(66), 20);              // below 68 but not by 3
+    TEST_ASSERT_TRUE(engine.active(0, 0));
+    engine.ingest(0, online(65), 25);
+    TEST_ASSERT_FALSE(engine.active(0, 0));
+    TEST_ASSERT_TRUE(engine.next(e));
+    TEST_ASSERT_FALSE(e.raised);
+    engine.consume();
+    TEST_ASSERT_FALSE(engine.next(e));
+}
+
+void run_alert_engine_tests() {
+    RUN_TEST(test_compile_reads_every_option);
+    RUN_TEST(test_format_compiles_back_to_the_same_rules);
+    RUN_TEST(test_bad_rule_is_reported_and_changes_nothing);
+    RUN_TEST(test_for_and_hysteresis);
+}
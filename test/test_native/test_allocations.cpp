@@ -0,0 +1,34 @@
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <unity.h>
+#include "firmware.h"
+
+#include <string>
+
+// Allocations /api/heap has counted for one subsystem so far, -1 when the build does not count them
+static long counted(const char* subsystem) {
+    std::string body = webServer.request(HTTP_GET, "/api/heap").body;
+    std::string key = std::string("\"") + subsystem + "\":{\"count\":";
+    size_t p = body.find(key);
+    return p == std::string::npos ? -1 : atol(body.c_str() + p + key.size());
+}
+
+// Once every miner has been polled, fetching, ingest and rendering take nothing from the heap
+static void test_polling_allocates_nothing() {
+#ifndef ARDUINOJSON_VERSION_MAJOR
+    TEST_IGNORE_MESSAGE("needs ArduinoJson itself: the documents parse into jsonArena, a stand-in may not");
+#endif
+    bootFirmware();
+    runFor(max(60000, (TEST_MINERS + 1) * 5000));
+    long fetch = counted("fetch"), ingest = counted("ingest"), render = counted("render");
+    if (ingest < 0) TEST_IGNORE_MESSAGE("this build does not count allocations (HEAP_COUNT_ALLOCS)");
+
+    runFor(10 * 60000);
+    TEST_ASSERT_EQUAL_MESSAGE(0, counted("fetch") - fetch, "fetch");
+    TEST_ASSERT_EQUAL_MESSAGE(0, counted("ingest") - ingest, "ingest");
+    TEST_ASSERT_EQUAL_MESSAGE(0, counted("render") - render, "render");
+}
+
+void run_allocations_tests() {
+    RUN_TEST(test_polling_allocates_nothing);
+}
@@ -0,0 +1,139 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <auto_tuner.h>
+
+static AutoTuner tuner;
+
+// A miner that needs 1 mV more per MHz above 400 MHz @ 1100 mV to hash at full rate
+struct Miner {
+    int f = 500, mv = 1200;
+    float temp = 55;
+
+    TuneSample sample() const {
+        bool stable = mv >= 1100 + (f - 400);
+        float hash = (stable ? 2.0f : 1.5f) * f;
+        return {hash, hash, 3.0f + f * mv * 2.6e-5f, temp, temp + 10, 5.1f, f, mv};
+    }
+};
+
+static TuneLimits limits() {
+    TuneLimits lim;
+    lim.freqMin = 400;
+    lim.freqMax = 500;
+    lim.freqStep = 50;
+    lim.mvMin = 1100;
+    lim.mvMax = 1200;
+    lim.mvStep = 50;
+    lim.settleSec = 60;
+    lim.measureSec = 60;
+    return lim;
+}
+
+// Sample every 10 s from now until `until`, applying each setpoint the tuner asks for
+static void drive(Miner& m, uint32_t now, uint32_t until, bool patchOk = true) {
+    for (; now < until && tuner.active(0); now += 10) {
+        int f, mv;
+        if (tuner.update(0, m.sample(), now, f, mv)) {
+            if (patchOk) {
+                m.f = f;
+                m.mv = mv;
+            }
+            tuner.applied(0, patchOk, now);
+        }
+    }
+}
+
+static int countEvents(uint8_t ev) {
+    int n = 0;
+    for (int i = 0; i < tuner.logCount(); i++) n += tuner.logEntry(i).event == ev;
+    return n;
+}
+
+static void test_search_holds_the_most_efficient_stable_point() {
+    tuner = AutoTuner();
+    Miner m;
+    TEST_ASSERT_TRUE(tuner.start(0, m.sample(), limits(), 1000));
+    drive(m, 1000, 1000 + 24 * 3600);
+
+    // 400@1100, 450@1100 (unstable), 450@1150, 500@1150 (unstable), 500@1200
+    TEST_ASSERT_EQUAL(TUNE_HOLD, tuner.state(0));
+    TEST_ASSERT_EQUAL_UINT16(5, tuner.pointsTried(0));
+    TEST_ASSERT_EQUAL(3, countEvents(TEV_SCORE));
+    TEST_ASSERT_EQUAL(2, countEvents(TEV_UNSTABLE));
+    TEST_ASSERT_EQUAL(400, tuner.bestFreq(0));
+    TEST_ASSERT_EQUAL(1100, tuner.bestMv(0));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 14.44f / 0.8f, tuner.bestJth(0));
+    TEST_ASSERT_EQUAL(400, m.f);
+    TEST_ASSERT_EQUAL(1100, m.mv);
+}
+
+static void test_limit_trip_retreats_to_the_best_point() {
+    tuner = AutoTuner();
+    Miner m;
+    TEST_ASSERT_TRUE(tuner.start(0, m.sample(), limits(), 1000));
+    // Wait for 400 MHz to be scored, then run hot
+    uint32_t now = 1000;
+    for (; countEvents(TEV_SCORE) == 0; now += 10) drive(m, now, now + 10);
+    m.temp = 70;
+    drive(m, now, now + 30);
+    TEST_ASSERT_EQUAL(1, countEvents(TEV_LIMIT));
+    TEST_ASSERT_EQUAL(TUNE_HOLD, tuner.state(0));
+    TEST_ASSERT_EQUAL(400, m.f);
+
+    // Still hot once the cool-down settle period is over: restore and give up
+    drive(m, now + 30, now + 200);
+    TEST_ASSERT_EQUAL(TUNE_FAULT, tuner.state(0));
+    TEST_ASSERT_FALSE(tuner.active(0));
+    TEST_ASSERT_EQUAL(500, m.f);
+    TEST_ASSERT_EQUAL(1200, m.mv);
+}
+
+static void test_trip_before_any_point_restores_the_original() {
+    tuner = AutoTuner();
+    Miner m;
+    m.temp = 70;
+    TEST_ASSERT_TRUE(tuner.start(0, m.sample(), limits(), 1000));
+    drive(m, 1000, 2000);
+    TEST_ASSERT_EQUAL(TUNE_FAULT, tuner.state(0));
+    TEST_ASSERT_EQUAL(1, countEvents(TEV_NO_POINT));
+    TEST_ASSERT_EQUAL(500, m.f);
+    TEST_ASSERT_EQUAL(1200, m.mv);
+}
+
+static void test_failing_patches_fault() {
+    tuner = AutoTuner();
+    Miner m;
+    TEST_ASSERT_TRUE(tuner.start(0, m.sample(), limits(), 1000));
+    drive(m, 1000, 1030, false);
+    TEST_ASSERT_EQUAL(TUNE_FAULT, tuner.state(0));
+    TEST_ASSERT_EQUAL(1, countEvents(TEV_PATCH_FAIL));
+    TEST_ASSERT_FALSE(tuner.active(0));
+}
+
+static void test_stop_mid_search_restores() {
+    tuner = AutoTuner();
+    Miner m;
+    TuneSample start = m.sample();
+    TEST_ASSERT_FALSE(tuner.start(MAX_DEVICES, start, limits(), 1000));
+    TuneLimits bad = limits();
+    bad.freqStep = 0;
+    TEST_ASSERT_FALSE(tuner.start(0, start, bad, 1000));
+
+    TEST_ASSERT_TRUE(tuner.start(0, start, limits(), 1000));
+    drive(m, 1000, 1100);
+    TEST_ASSERT_EQUAL(400, m.f);
+    int f, mv;
+    TEST_ASSERT_TRUE(tuner.stop(0, 1100, f, mv));
+    TEST_ASSERT_EQUAL(500, f);
+    TEST_ASSERT_EQUAL(1200, mv);
+    TEST_ASSERT_FALSE(tuner.active(0));
+    TEST_ASSERT_FALSE(tuner.stop(0, 1110, f, mv));
+}
+
+void run_auto_tuner_tests() {
+    RUN_TEST(test_search_holds_the_most_efficient_stable_point);
+    RUN_TEST(test_limit_trip_retreats_to_the_best_point);
+    RUN_TEST(test_trip_before_any_point_restores_the_original);
+    RUN_TEST(test_failing_patches_fault);
+    RUN_TEST(test_stop_mid_search_restores);
+}
@@ -0,0 +1,138 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <benchmark.h>
+
+static Benchmark bench;
+
+// Runs hotter with frequency and voltage; one share in ten is rejected
+struct Miner {
+    int f = 500, mv = 1200;
+    uint32_t acc = 0, rej = 0;
+
+    BenchSample sample() {
+        acc += 9;
+        rej += 1;
+        float temp = 40 + (f - 400) * 0.4f + (mv - 1100) * 0.4f;
+        return {2.0f * f, 3.0f + f * mv * 2.6e-5f, temp, temp + 10, 5.1f, acc, rej, f, mv};
+    }
+};
+
+// 400 / 425 MHz x 1100 / 1125 / 1150 mV; above 55 C trips the limit
+static BenchConfig grid() {
+    BenchConfig c;
+    c.device = 2;
+    c.freqMin = 400;
+    c.freqMax = 425;
+    c.freqStep = 25;
+    c.mvMin = 1100;
+    c.mvMax = 1150;
+    c.mvStep = 25;
+    c.settleSec = 60;
+    c.measureSec = 60;
+    c.maxTemp = 55;
+    return c;
+}
+
+// Sample every 10 s while the job runs, applying its setpoints
+static uint32_t drive(Miner& m, uint32_t now, uint32_t until, bool patchOk = true) {
+    for (; now < until && bench.running(); now += 10) {
+        int f, mv;
+        if (bench.update(m.sample(), now, f, mv)) {
+            if (patchOk) {
+                m.f = f;
+                m.mv = mv;
+            }
+            bench.applied(patchOk, now);
+        }
+    }
+    return now;
+}
+
+static void test_sweep_fills_the_grid_and_restores() {
+    bench = Benchmark();
+    Miner m;
+    TEST_ASSERT_FALSE(bench.hasResults());
+    TEST_ASSERT_TRUE(bench.start(grid(), m.sample(), 0));
+    TEST_ASSERT_FALSE(bench.start(grid(), m.sample(), 0));     // one job at a time
+    TEST_ASSERT_EQUAL(2, bench.rows());
+    TEST_ASSERT_EQUAL(3, bench.cols());
+    TEST_ASSERT_EQUAL(1125, bench.mvAt(1));
+    drive(m, 0, 86400);
+
+    TEST_ASSERT_EQUAL(BENCH_DONE, bench.state());
+    TEST_ASSERT_EQUAL_UINT8(BC_DONE, bench.cell(0, 0).state);
+    TEST_ASSERT_EQUAL_UINT8(BC_DONE, bench.cell(0, 1).state);
+    TEST_ASSERT_EQUAL_UINT8(BC_UNSAFE, bench.cell(0, 2).state);    // 60 C
+    TEST_ASSERT_EQUAL_UINT8(BC_DONE, bench.cell(1, 0).state);
+    TEST_ASSERT_EQUAL_UINT8(BC_UNSAFE, bench.cell(1, 1).state);
+    TEST_ASSERT_EQUAL_UINT8(BC_SKIPPED, bench.cell(1, 2).state);   // hotter still: not tried
+    TEST_ASSERT_EQUAL(6, bench.pointsDone());
+
+    const BenchCell& c = bench.cell(0, 0);
+    TEST_ASSERT_EQUAL_FLOAT(800, c.hashRate);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 14.44f, c.power);
+    TEST_ASSERT_EQUAL_FLOAT(40, c.temperature);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 10, c.errPct);
+
+    int row, col;
+    TEST_ASSERT_TRUE(bench.best(row, col));
+    TEST_ASSERT_EQUAL(1, row);
+    TEST_ASSERT_EQUAL(0, col);
+    TEST_ASSERT_EQUAL(500, m.f);                                   // back where it started
+    TEST_ASSERT_EQUAL(1200, m.mv);
+}
+
+static void test_abort_restores_unless_taken_over() {
+    bench = Benchmark();
+    Miner m;
+    TEST_ASSERT_TRUE(bench.start(grid(), m.sample(), 0));
+    uint32_t now = drive(m, 0, 100);
+    TEST_ASSERT_EQUAL(400, m.f);
+    bench.abort();
+    TEST_ASSERT_TRUE(bench.running());                             // restoring
+    drive(m, now, now + 100);
+    TEST_ASSERT_EQUAL(BENCH_ABORTED, bench.state());
+    TEST_ASSERT_EQUAL(500, m.f);
+
+    m = Miner();
+    TEST_ASSERT_TRUE(bench.start(grid(), m.sample(), 0));
+    drive(m, 0, 100);
+    uint32_t v = bench.version();
+    bench.abort(false);
+    TEST_ASSERT_EQUAL(BENCH_ABORTED, bench.state());
+    TEST_ASSERT_TRUE(bench.version() > v);
+    TEST_ASSERT_EQUAL(400, m.f);                                   // left alone
+}
+
+static void test_failing_patch_marks_the_cell_and_restores() {
+    bench = Benchmark();
+    Miner m;
+    TEST_ASSERT_TRUE(bench.start(grid(), m.sample(), 0));
+    drive(m, 0, 10 * BENCH_MAX_PATCH_FAILS, false);
+    TEST_ASSERT_EQUAL_UINT8(BC_FAILED, bench.cell(0, 0).state);
+    TEST_ASSERT_EQUAL(BENCH_RESTORING, bench.state());
+    drive(m, 100, 200);
+    TEST_ASSERT_EQUAL(BENCH_ABORTED, bench.state());
+}
+
+static void test_grid_must_fit() {
+    bench = Benchmark();
+    Miner m;
+    BenchConfig c = grid();
+    c.freqMax = c.freqMin + BENCH_MAX_FREQS * c.freqStep;
+    TEST_ASSERT_FALSE(bench.start(c, m.sample(), 0));
+    c = grid();
+    c.mvStep = 0;
+    TEST_ASSERT_FALSE(bench.start(c, m.sample(), 0));
+    c = grid();
+    c.mvMin = c.mvMax + 1;
+    TEST_ASSERT_FALSE(bench.start(c, m.sample(), 0));
+    TEST_ASSERT_FALSE(bench.hasResults());
+}
+
+void run_benchmark_tests() {
+    RUN_TEST(test_sweep_fills_the_grid_and_restores);
+    RUN_TEST(test_abort_restores_unless_taken_over);
+    RUN_TEST(test_failing_patch_marks_the_cell_and_restores);
+    RUN_TEST(test_grid_must_fit);
+}
@@ -0,0 +1,158 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <bulk_dispatch.h>
+
+#include <string>
+
+static BulkDispatcher bulk;
+
+// A miner's web server on a loopback port, answered from the test's own loop
+struct Listener {
+    int fd = -1;
+    int conn = -1;
+    uint16_t port = 0;
+    const char* reply = nullptr;       // nullptr = accept, then never answer
+    std::string request;
+
+    void open(const char* answer) {
+        reply = answer;
+        request.clear();
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in sa = {};
+        sa.sin_family = AF_INET;
+        sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        TEST_ASSERT_EQUAL(0, bind(fd, (struct sockaddr*)&sa, sizeof(sa)));
+        TEST_ASSERT_EQUAL(0, listen(fd, 4));
+        socklen_t len = sizeof(sa);
+        getsockname(fd, (struct sockaddr*)&sa, &len);
+        port = ntohs(sa.sin_port);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    }
+
+    void serve() {
+        if (conn < 0) {
+            conn = accept(fd, nullptr, nullptr);
+            if (conn < 0) return;
+            fcntl(conn, F_SETFL, fcntl(conn, F_GETFL, 0) | O_NONBLOCK);
+        }
+        char buf[512];
+        int k;
+        while ((k = recv(conn, buf, sizeof(buf), 0)) > 0) request.append(buf, k);
+        size_t head = request.find("\r\n\r\n");
+        if (!reply || head == std::string::npos) return;
+        size_t need = head + 4 + atoi(request.c_str() + request.find("Content-Length: ") + 16);
+        if (request.size() < need) return;
+        send(conn, reply, strlen(reply), MSG_NOSIGNAL);
+        close(conn);
+        conn = -2;                     // answered
+    }
+
+    void shut() {
+        if (conn >= 0) close(conn);
+        if (fd >= 0) close(fd);
+        fd = conn = -1;
+    }
+
+    std::string addr() const { return "127.0.0.1:" + std::to_string(port); }
+};
+
+static Listener miners[3];
+
+// pump() and the listeners in turn, 10 ms of virtual time a round, until the operation is over
+static uint32_t run(uint32_t now, uint32_t until) {
+    for (; now < until && bulk.busy(); now += 10) {
+        bulk.pump(now, 5);
+        for (Listener& l : miners) l.serve();
+    }
+    return now;
+}
+
+static void test_settings_reach_every_miner() {
+    for (Listener& l : miners) l.open("HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n");
+    TEST_ASSERT_TRUE(bulk.begin(BK_SETTINGS, 1000));
+    uint32_t id = bulk.id();
+    for (int k = 0; k < 3; k++) TEST_ASSERT_TRUE(bulk.add(k, miners[k].addr().c_str(), 80, "{\"frequency\":525}", 0));
+    TEST_ASSERT_FALSE(bulk.begin(BK_RESTART, 1000));             // still running
+    run(1000, 3000);
+
+    TEST_ASSERT_FALSE(bulk.busy());
+    TEST_ASSERT_EQUAL_UINT16(3, bulk.okCount());
+    TEST_ASSERT_EQUAL_UINT32(id, bulk.id());
+    for (int k = 0; k < 3; k++) {
+        const BulkJob* j = bulk.forDevice(k);
+        TEST_ASSERT_NOT_NULL(j);
+        TEST_ASSERT_EQUAL_UINT8(BJ_OK, j->state);
+        TEST_ASSERT_EQUAL(200, j->status);
+        const std::string& r = miners[k].request;
+        TEST_ASSERT_EQUAL(0, r.find("PATCH /api/system HTTP/1.1\r\n"));
+        TEST_ASSERT_TRUE(r.find("Host: " + miners[k].addr() + "\r\n") != std::string::npos);
+        TEST_ASSERT_TRUE(r.find("\r\n\r\n{\"frequency\":525}") != std::string::npos);
+    }
+    TEST_ASSERT_NULL(bulk.forDevice(5));
+    for (Listener& l : miners) l.shut();
+}
+
+static void test_restarts_are_staggered() {
+    for (Listener& l : miners) l.open("HTTP/1.1 200 OK\r\n\r\n");
+    TEST_ASSERT_TRUE(bulk.begin(BK_RESTART, 0));
+    for (int k = 0; k < 3; k++) bulk.add(k, miners[k].addr().c_str(), 80, "", k * 1000);
+    run(0, 900);
+    TEST_ASSERT_EQUAL_UINT8(BJ_OK, bulk.job(0).state);
+    TEST_ASSERT_EQUAL_UINT8(BJ_QUEUED, bulk.job(1).state);
+    TEST_ASSERT_EQUAL_UINT8(BJ_QUEUED, bulk.job(2).state);
+    run(900, 5000);
+    TEST_ASSERT_EQUAL_UINT16(3, bulk.okCount());
+    TEST_ASSERT_TRUE(bulk.job(2).openedAt >= 2000);
+    TEST_ASSERT_EQUAL(0, miners[1].request.find("POST /api/system/restart HTTP/1.1\r\n"));
+    for (Listener& l : miners) l.shut();
+}
+
+static void test_failures_are_told_apart() {
+    miners[0].open("HTTP/1.1 500 Internal Server Error\r\n\r\n");
+    miners[1].open(nullptr);                                    // accepts and says nothing
+    miners[2].open("HTTP/1.1 200 OK\r\n\r\n");
+    uint16_t refused = miners[2].port;
+    miners[2].shut();                                           // nothing listens there now
+
+    TEST_ASSERT_TRUE(bulk.begin(BK_SETTINGS, 0));
+    bulk.add(0, miners[0].addr().c_str(), 80, "{}", 0);
+    bulk.add(1, miners[1].addr().c_str(), 80, "{}", 0);
+    bulk.add(2, ("127.0.0.1:" + std::to_string(refused)).c_str(), 80, "{}", 0);
+    bulk.add(3, "miner.local", 80, "{}", 0);
+    TEST_ASSERT_EQUAL_UINT8(BJ_FAILED, bulk.job(3).state);      // not an address: fails at once
+    run(0, BULK_TIMEOUT_MS + 1000);
+
+    TEST_ASSERT_EQUAL_UINT8(BJ_FAILED, bulk.job(0).state);
+    TEST_ASSERT_EQUAL(500, bulk.job(0).status);
+    TEST_ASSERT_EQUAL_UINT8(BJ_TIMEOUT, bulk.job(1).state);
+    TEST_ASSERT_EQUAL_UINT8(BJ_FAILED, bulk.job(2).state);
+    TEST_ASSERT_EQUAL(-ECONNREFUSED, bulk.job(2).status);
+    TEST_ASSERT_EQUAL_UINT16(0, bulk.okCount());
+    miners[0].shut();
+    miners[1].shut();
+}
+
+static void test_cancel_ends_the_operation() {
+    miners[0].open(nullptr);
+    TEST_ASSERT_TRUE(bulk.begin(BK_SETTINGS, 0));
+    bulk.add(0, miners[0].addr().c_str(), 80, "{}", 0);
+    bulk.add(1, miners[0].addr().c_str(), 80, "{}", 60000);
+    bulk.pump(0, 5);
+    TEST_ASSERT_TRUE(bulk.active());
+    uint32_t v = bulk.version();
+    bulk.cancel(10);
+    TEST_ASSERT_FALSE(bulk.busy());
+    TEST_ASSERT_FALSE(bulk.active());
+    TEST_ASSERT_TRUE(bulk.version() > v);
+    TEST_ASSERT_EQUAL_UINT8(BJ_FAILED, bulk.job(1).state);
+    TEST_ASSERT_TRUE(bulk.begin(BK_SETTINGS, 20));
+    TEST_ASSERT_EQUAL_UINT16(0, bulk.count());
+    miners[0].shut();
+}
+
+void run_bulk_dispatch_tests() {
+    RUN_TEST(test_settings_reach_every_miner);
+    RUN_TEST(test_restarts_are_staggered);
+    RUN_TEST(test_failures_are_told_apart);
+    RUN_TEST(test_cancel_ends_the_operation);
+}
@@ -0,0 +1,92 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <control_queue.h>
+
+static ControlQueue queue;
+
+static void test_taps_coalesce_into_one_send() {
+    queue = ControlQueue();
+    int values[CF_COUNT];
+    uint16_t seq = 0;
+    TEST_ASSERT_EQUAL(525, queue.nudge(0, CF_FREQ, 25, 500, 400, 650, 0));
+    TEST_ASSERT_EQUAL(550, queue.nudge(0, CF_FREQ, 25, 500, 400, 650, 100));
+    TEST_ASSERT_EQUAL(65, queue.nudge(0, CF_FAN, 5, 60, 0, 100, 200));
+    TEST_ASSERT_EQUAL(575, queue.nudge(0, CF_FREQ, 25, 500, 400, 650, 200));
+    TEST_ASSERT_TRUE(queue.pending(0, CF_FREQ));
+    TEST_ASSERT_FALSE(queue.pending(0, CF_VOLT));
+
+    // Not until CONTROL_DEBOUNCE_MS after the last tap
+    TEST_ASSERT_FALSE(queue.take(0, 799, values, seq));
+    TEST_ASSERT_TRUE(queue.take(0, 800, values, seq));
+    TEST_ASSERT_EQUAL_UINT16(1, seq);
+    TEST_ASSERT_EQUAL(575, values[CF_FREQ]);
+    TEST_ASSERT_EQUAL(-1, values[CF_VOLT]);
+    TEST_ASSERT_EQUAL(65, values[CF_FAN]);
+    TEST_ASSERT_FALSE(queue.take(0, 2000, values, seq));
+
+    // In flight the screen shows what was sent, and new taps start from it
+    TEST_ASSERT_EQUAL(575, queue.shown(0, CF_FREQ, 500));
+    TEST_ASSERT_EQUAL(600, queue.nudge(0, CF_FREQ, 25, 500, 400, 650, 1000));
+    TEST_ASSERT_FALSE(queue.take(0, 2000, values, seq));     // the first is still in flight
+
+    int readBack[CF_COUNT] = {575, 1200, 66};                // fan within one percent
+    TEST_ASSERT_EQUAL(CQ_CONFIRMED, queue.complete(0, 1, true, true, readBack, 2000));
+    TEST_ASSERT_EQUAL(CQ_CONFIRMED, queue.outcome(0, 2000));
+    TEST_ASSERT_TRUE(queue.take(0, 2000, values, seq));
+    TEST_ASSERT_EQUAL_UINT16(2, seq);
+    TEST_ASSERT_EQUAL(600, values[CF_FREQ]);
+    TEST_ASSERT_EQUAL(-1, values[CF_FAN]);
+
+    readBack[CF_FREQ] = 575;                                 // the device kept the old value
+    TEST_ASSERT_EQUAL(CQ_REJECTED, queue.complete(0, 2, true, true, readBack, 3000));
+    TEST_ASSERT_FALSE(queue.pending(0));
+    TEST_ASSERT_EQUAL(575, queue.shown(0, CF_FREQ, 575));
+    TEST_ASSERT_EQUAL(CQ_NONE, queue.outcome(0, 3000 + CONTROL_FEEDBACK_MS));
+}
+
+static void test_late_answer_after_timeout_is_ignored() {
+    queue = ControlQueue();
+    int values[CF_COUNT];
+    uint16_t seq = 0;
+    queue.nudge(3, CF_VOLT, 10, 1200, 1000, 1300, 0);
+    TEST_ASSERT_TRUE(queue.take(3, 600, values, seq));
+    uint16_t first = seq;
+
+    queue.nudge(3, CF_VOLT, 10, 1200, 1000, 1300, 1000);
+    TEST_ASSERT_TRUE(queue.take(3, 600 + CONTROL_INFLIGHT_MS, values, seq));
+    TEST_ASSERT_EQUAL_UINT16(first + 1, seq);
+    int readBack[CF_COUNT] = {500, 1210, 50};
+    TEST_ASSERT_EQUAL(CQ_NONE, queue.complete(3, first, true, true, readBack, 16000));
+    TEST_ASSERT_TRUE(queue.pending(3));
+
+    // reset() drops everything but keeps the numbering, so the answer to seq is ignored too
+    queue.reset();
+    TEST_ASSERT_FALSE(queue.pending(3));
+    TEST_ASSERT_EQUAL(CQ_NONE, queue.complete(3, seq, true, true, readBack, 16100));
+    queue.nudge(3, CF_VOLT, 10, 1200, 1000, 1300, 17000);
+    uint16_t after = 0;
+    TEST_ASSERT_TRUE(queue.take(3, 17600, values, after));
+    TEST_ASSERT_EQUAL_UINT16(seq + 1, after);
+}
+
+static void test_failed_or_unverified_send() {
+    queue = ControlQueue();
+    int values[CF_COUNT];
+    uint16_t seq = 0;
+    int readBack[CF_COUNT] = {0, 0, 0};
+    queue.nudge(1, CF_FAN, 10, 95, 0, 100, 0);
+    TEST_ASSERT_TRUE(queue.take(1, 600, values, seq));
+    TEST_ASSERT_EQUAL(100, values[CF_FAN]);                  // clamped to hi
+    TEST_ASSERT_EQUAL(CQ_UNVERIFIED, queue.complete(1, seq, true, false, readBack, 700));
+
+    queue.nudge(1, CF_FAN, -200, 95, 0, 100, 1000);
+    TEST_ASSERT_TRUE(queue.take(1, 1600, values, seq));
+    TEST_ASSERT_EQUAL(0, values[CF_FAN]);                    // clamped to lo
+    TEST_ASSERT_EQUAL(CQ_REJECTED, queue.complete(1, seq, false, false, readBack, 1700));
+}
+
+void run_control_queue_tests() {
+    RUN_TEST(test_taps_coalesce_into_one_send);
+    RUN_TEST(test_late_answer_after_timeout_is_ignored);
+    RUN_TEST(test_failed_or_unverified_send);
+}
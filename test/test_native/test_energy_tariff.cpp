@@ -0,0 +1,139 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <energy_tariff.h>
+
+static struct tm date(int year, int month, int mday) {
+    struct tm tm = {};
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = mday;
+    return tm;
+}
+
+static void test_schedule_parse_format_and_lookup() {
+    TariffSchedule s;
+    s.baseRate = 0.20f;
+    TEST_ASSERT_TRUE(s.parse("22:00-07:00/5=0.08@110, 17:00-21:00/12345=0.35@85,12:00-13:00=0.1"));
+    TEST_ASSERT_EQUAL_UINT8(3, s.count());
+    char text[128];
+    s.format(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("22:00-07:00/5=0.08@110,17:00-21:00/12345=0.35@85,12:00-13:00=0.1", text);
+
+    // Friday night's window runs on into Saturday morning, but does not start on Thursday
+    TEST_ASSERT_EQUAL(0, s.windowAt(5, 23 * 60));
+    TEST_ASSERT_EQUAL(0, s.windowAt(6, 3 * 60));
+    TEST_ASSERT_EQUAL(-1, s.windowAt(4, 23 * 60));
+    TEST_ASSERT_EQUAL(-1, s.windowAt(6, 7 * 60));
+    TEST_ASSERT_EQUAL_UINT8(110, s.pctAt(5, 22 * 60));
+    TEST_ASSERT_EQUAL_FLOAT(0.35f, s.rateAt(1, 18 * 60));
+    TEST_ASSERT_EQUAL_FLOAT(0.20f, s.rateAt(0, 18 * 60));           // weekdays only
+    TEST_ASSERT_EQUAL_UINT8(100, s.pctAt(0, 18 * 60));
+    TEST_ASSERT_FLOAT_WITHIN(1e-3f, 0.20f * 23 + 0.1f, s.dailyRateHours(0));
+
+    const char* bad[] = {"22:00-07:00", "25:00-07:00=1", "22:00-22:00=1", "10:00-11:00=1@40",
+                         "10:00-11:00/8=1", "10:00-11:00=-1", "10:00-11:00=1;"};
+    for (const char* b : bad) TEST_ASSERT_FALSE(s.parse(b));
+    TEST_ASSERT_EQUAL_UINT8(3, s.count());
+    TEST_ASSERT_TRUE(s.parse(""));
+    TEST_ASSERT_EQUAL_FLOAT(0.20f * 24, s.dailyRateHours(3));
+}
+
+static void test_energy_day_is_consecutive() {
+    TEST_ASSERT_EQUAL_INT32(0, energyDay(date(1970, 1, 1)));
+    TEST_ASSERT_EQUAL_INT32(19723, energyDay(date(2024, 1, 1)));
+    TEST_ASSERT_EQUAL_INT32(1, energyDay(date(2024, 1, 1)) - energyDay(date(2023, 12, 31)));
+    TEST_ASSERT_EQUAL_INT32(2, energyDay(date(2024, 3, 1)) - energyDay(date(2024, 2, 28)));
+    TEST_ASSERT_EQUAL_INT32(1, energyDay(date(2023, 3, 1)) - energyDay(date(2023, 2, 28)));
+    TEST_ASSERT_EQUAL_INT32(1, energyDay(date(2000, 3, 1)) - energyDay(date(2000, 2, 29)));
+    TEST_ASSERT_EQUAL_INT32(366, energyDay(date(2025, 1, 1)) - energyDay(date(2024, 1, 1)));
+}
+
+static void test_meter_integrates_and_skips_gaps() {
+    EnergyMeter m;
+    int32_t day = energyDay(date(2024, 6, 1));
+    for (uint32_t t = 0; t <= 3600; t += 60) m.add(100, 0.25f, t, day);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.1, m.totals().kWh);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.025, m.totals().cost);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.1, m.totals().todayKWh);
+    TEST_ASSERT_TRUE(m.dirty());
+    m.saved();
+
+    m.add(100, 0.25f, 3600 + ENERGY_MAX_GAP_SEC + 1, day);       // offline for a while: not bridged
+    TEST_ASSERT_FALSE(m.dirty());
+    m.add(300, 0.25f, 3600 + ENERGY_MAX_GAP_SEC + 61, day);      // trapezoid: 200 W for a minute
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.1 + 200.0 / 60 / 1000, m.totals().kWh);
+}
+
+static void test_days_roll_over_into_yesterday() {
+    EnergyMeter m;
+    uint32_t t = 0;
+    int32_t dec31 = energyDay(date(2023, 12, 31));
+    for (; t <= 3600; t += 60) m.add(1000, 0.1f, t, dec31);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0, m.totals().todayKWh);
+
+    // New year's day follows on: yesterday is what today was
+    m.add(1000, 0.1f, t, dec31 + 1);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0, m.totals().yesterdayKWh);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 0.1, m.totals().yesterdayCost);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1000.0 / 60 / 1000, m.totals().todayKWh);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0 + 1000.0 / 60 / 1000, m.totals().kWh);
+
+    // Off for a day: nothing was used yesterday
+    m.add(1000, 0.1f, t + 60, dec31 + 3);
+    TEST_ASSERT_EQUAL_FLOAT(0, m.totals().yesterdayKWh);
+    TEST_ASSERT_EQUAL_INT32(dec31 + 3, m.totals().day);
+
+    // Unknown time (no NTP yet) keeps the current buckets
+    m.add(1000, 0.1f, t + 120, -1);
+    TEST_ASSERT_EQUAL_INT32(dec31 + 3, m.totals().day);
+
+    EnergyMeter restored;
+    restored.restore(m.totals());
+    TEST_ASSERT_EQUAL_MEMORY(&m.totals(), &restored.totals(), sizeof(EnergyTotals));
+    restored.reset();
+    TEST_ASSERT_EQUAL_FLOAT(0, restored.totals().kWh);
+    TEST_ASSERT_EQUAL_INT32(-1, restored.totals().day);
+}
+
+static void test_profile_learns_the_base_and_walks_back() {
+    ProfileScheduler p;
+    int f;
+    p.setEnabled(true);
+    p.setPct(80);
+    TEST_ASSERT_TRUE(p.evaluate(0, 500, 0, 0, f));
+    TEST_ASSERT_EQUAL(500, p.base(0));
+    TEST_ASSERT_EQUAL(400, f);
+    p.applied(0, f, true);
+    TEST_ASSERT_FALSE(p.evaluate(0, 500, 0, 10, f));               // waits for a fresh sample
+    TEST_ASSERT_FALSE(p.evaluate(0, 400, 0, 40, f));
+
+    // A governor's cut comes off the target
+    TEST_ASSERT_TRUE(p.evaluate(0, 400, 25, 40, f));
+    TEST_ASSERT_EQUAL(375, f);
+    p.applied(0, f, true);
+
+    // Set by hand at 80 %: the base is re-learned from it
+    p.forget(0);
+    TEST_ASSERT_FALSE(p.evaluate(0, 360, 0, 100, f));
+    TEST_ASSERT_EQUAL(450, p.base(0));
+
+    // Disabled: back to 100 % once, then left alone
+    p.setEnabled(false);
+    TEST_ASSERT_EQUAL_UINT8(100, p.pct());
+    TEST_ASSERT_TRUE(p.evaluate(0, 360, 0, 200, f));
+    TEST_ASSERT_EQUAL(450, f);
+    p.applied(0, f, true);
+    TEST_ASSERT_FALSE(p.evaluate(0, 300, 0, 300, f));
+
+    p.setPct(10);
+    p.setEnabled(true);
+    TEST_ASSERT_EQUAL_UINT8(PROFILE_MIN_PCT, p.pct());
+}
+
+void run_energy_tariff_tests() {
+    RUN_TEST(test_schedule_parse_format_and_lookup);
+    RUN_TEST(test_energy_day_is_consecutive);
+    RUN_TEST(test_meter_integrates_and_skips_gaps);
+    RUN_TEST(test_days_roll_over_into_yesterday);
+    RUN_TEST(test_profile_learns_the_base_and_walks_back);
+}
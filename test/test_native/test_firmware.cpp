@@ -0,0 +1,169 @@
+#include <Arduino.h>
+#include <Preferences.h>
+#include <unity.h>
+#include "FakeAxeOS.h"
+#include "HostHttp.h"
+#include "firmware.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+static std::vector<std::unique_ptr<FakeAxeOS>> miners;
+
+// CoinGecko and mempool.space as host_main answers them
+static HostResponse coinGecko(const HostRequest& req) {
+    HostResponse r;
+    size_t p = req.url.find("ids=");
+    std::string id = p == std::string::npos ? "bitcoin" : req.url.substr(p + 4, req.url.find('&', p) - p - 4);
+    r.code = 200;
+    r.body = "{\"" + id + "\":{\"usd\":97250.5,\"usd_24h_change\":-1.37}}";
+    return r;
+}
+
+static HostResponse mempool(const HostRequest&) {
+    HostResponse r;
+    r.code = 200;
+    r.body = "{\"hashrates\":[],\"difficulty\":[],\"currentHashrate\":8.1e20,\"currentDifficulty\":1.1e14}";
+    return r;
+}
+
+void bootFirmware() {
+    if (!miners.empty()) return;
+    std::string ips;
+    for (int i = 0; i < TEST_MINERS; i++) {
+        miners.emplace_back(new FakeAxeOS(i, i + 1));
+        FakeAxeOS* m = miners.back().get();
+        std::string ip = "10.0.0." + std::to_string(i + 1);
+        HostHttp::route("http://" + ip + "/", [m](const HostRequest& req) { return m->handle(req); });
+        ips += (i ? "," : "") + ip;
+    }
+    HostHttp::route("https://api.coingecko.com/", coinGecko);
+    HostHttp::route("https://mempool.space/", mempool);
+
+    // A configured display: device list saved, touch already calibrated
+    Preferences prefs;
+    prefs.begin("bitaxemon", false);
+    prefs.putString("ips", ips.c_str());
+    uint16_t cal[5] = {642, 2916, 525, 2911, 0};
+    prefs.putBytes("touchCal", cal, sizeof(cal));
+    prefs.end();
+    setup();
+}
+
+void runFor(uint32_t ms) {
+    uint32_t end = millis() + ms;
+    while ((int32_t)(millis() - end) < 0) loop();
+}
+
+static float sumOf(const float* v) {
+    float total = 0;
+    for (int i = 0; i < deviceCount; i++) total += fleet.valid[i] ? v[i] : 0;
+    return total;
+}
+
+static void test_boot_polls_every_miner() {
+    bootFirmware();
+    TEST_ASSERT_EQUAL(TEST_MINERS, deviceCount);
+    for (int i = 0; i < TEST_MINERS; i++) {
+        TEST_ASSERT_TRUE(fleet.valid[i]);
+        TEST_ASSERT_FLOAT_WITHIN(60, 525 * 2.04f, fleet.hashRate[i]);     // FakeAxeOS at 525 MHz
+    }
+    TEST_ASSERT_EQUAL(TEST_MINERS, fleetStats.online());
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, sumOf(fleet.hashRate), fleetStats.totalHashrate());
+    TEST_ASSERT_FLOAT_WITHIN(0.05f, sumOf(fleet.power), fleetStats.totalPower());
+}
+
+static void test_loop_keeps_the_totals_current() {
+    bootFirmware();
+    uint32_t shares = fleetStats.sharesAccepted();
+    runFor(3 * 60000);
+    TEST_ASSERT_EQUAL(TEST_MINERS, fleetStats.online());
+    TEST_ASSERT_GREATER_THAN(shares, fleetStats.sharesAccepted());
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, sumOf(fleet.hashRate), fleetStats.totalHashrate());
+
+    HostWebResponse r = webServer.request(HTTP_GET, "/api/fleet");
+    TEST_ASSERT_EQUAL(200, r.code);
+    TEST_ASSERT_TRUE(r.body.find("\"online\":3") != std::string::npos);
+}
+
+static void test_payload_is_ingested() {
+    bootFirmware();
+    static const char info[] =
+        "{\"hashRate\":1500,\"hashRate_1h\":1480,\"temp\":71.5,\"vrTemp\":80,\"power\":22.5,"
+        "\"voltage\":5100,\"coreVoltage\":1200,\"frequency\":600,\"fanrpm\":4000,\"fanspeed\":75,"
+        "\"sharesAccepted\":100000,\"sharesRejected\":10,\"bestDiff\":1e9,\"bestSessionDiff\":1e8,"
+        "\"hostname\":\"rig-one\",\"deviceModel\":\"Gamma\",\"ASICModel\":\"BM1370\","
+        "\"stratumURL\":\"public-pool.io\",\"stratumPort\":21496,\"stratumUser\":\"bc1qtest.rig\","
+        "\"uptimeSeconds\":3600,\"wifiRSSI\":-60,\"poolDifficulty\":1000}";
+    applyDevicePayload(1, 200, info, sizeof(info) - 1);
+    TEST_ASSERT_EQUAL_FLOAT(1500, fleet.hashRate[1]);
+    TEST_ASSERT_EQUAL_FLOAT(22.5f, fleet.power[1]);
+    TEST_ASSERT_EQUAL_FLOAT(71.5f, fleet.temperature[1]);
+    TEST_ASSERT_EQUAL(100000, fleet.sharesAccepted[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, sumOf(fleet.hashRate), fleetStats.totalHashrate());
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 71.5f, fleetStats.maxTemperature());
+
+    HostWebResponse r = webServer.request(HTTP_GET, "/api/bulk");
+    TEST_ASSERT_TRUE(r.body.find("rig-one") != std::string::npos);
+}
+
+static void test_failed_polls_take_a_miner_offline() {
+    bootFirmware();
+    static const char broken[] = "{\"hashRate\":";
+    applyDevicePayload(2, 200, broken, sizeof(broken) - 1);
+    applyDevicePayload(2, 500, "", 0);
+    TEST_ASSERT_TRUE(fleet.valid[2]);                   // not on the first failures
+    applyDevicePayload(2, -1, "", 0);
+    TEST_ASSERT_FALSE(fleet.valid[2]);
+    TEST_ASSERT_EQUAL(TEST_MINERS - 1, fleetStats.online());
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, sumOf(fleet.hashRate), fleetStats.totalHashrate());
+
+    // Back with the next answer
+    runFor(TEST_MINERS * 5000);
+    TEST_ASSERT_TRUE(fleet.valid[2]);
+    TEST_ASSERT_EQUAL(TEST_MINERS, fleetStats.online());
+}
+
+// Pixels a draw put on the panel, from a clean count
+static uint64_t painted(void (*draw)()) {
+    tft.hostReset();
+    draw();
+    return tft.hostStats().touched;
+}
+
+static void drawDevice0() { drawDeviceScreen(0); }
+static void updateDevice0() { updateDeviceScreen(0); }
+
+static void test_screens_draw_and_update() {
+    bootFirmware();
+    struct Screen {
+        int index;
+        void (*draw)();
+        void (*update)();
+    } screens[] = {
+        {0, drawMainUI, updateDisplay},
+        {1, drawPoolScreen, updatePoolScreen},
+        {2, drawDevice0, updateDevice0},
+        {fleetScreenIndex(), drawFleetScreen, drawFleetTable},
+    };
+    for (const Screen& s : screens) {
+        currentScreen = s.index;
+        uint64_t full = painted(s.draw);
+        TEST_ASSERT_GREATER_THAN(SCR_W * SCR_H / 2, full);
+        runFor(TEST_MINERS * 5000);                    // new values from every miner
+        uint64_t update = painted(s.update);
+        TEST_ASSERT_GREATER_THAN(0, update);
+        TEST_ASSERT_TRUE(update <= full);
+    }
+    currentScreen = 0;
+    drawMainUI();
+}
+
+void run_firmware_tests() {
+    RUN_TEST(test_boot_polls_every_miner);
+    RUN_TEST(test_loop_keeps_the_totals_current);
+    RUN_TEST(test_payload_is_ingested);
+    RUN_TEST(test_failed_polls_take_a_miner_offline);
+    RUN_TEST(test_screens_draw_and_update);
+}
@@ -0,0 +1,93 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <fleet_stats.h>
+
+static FleetSample sample(float hash, float power, float temp, uint32_t acc, uint32_t rej) {
+    FleetSample s = {};
+    s.hashRate = hash;
+    s.power = power;
+    s.temperature = temp;
+    s.sharesAccepted = acc;
+    s.sharesRejected = rej;
+    return s;
+}
+
+static void test_totals_follow_ingest_and_drop() {
+    FleetStats fs;
+    fs.ingest(0, sample(1000, 15, 55, 100, 1), 10);
+    fs.ingest(1, sample(2000, 30, 60, 200, 2), 10);
+    fs.ingest(2, sample(500, 10, 50, 50, 0), 10);
+    TEST_ASSERT_EQUAL(3, fs.online());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 3500, fs.totalHashrate());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 55, fs.totalPower());
+    TEST_ASSERT_EQUAL_UINT32(350, fs.sharesAccepted());
+    TEST_ASSERT_EQUAL_UINT32(3, fs.sharesRejected());
+
+    // A new sample replaces the device's old contribution instead of adding to it
+    fs.ingest(1, sample(2100, 31, 61, 210, 2), 15);
+    TEST_ASSERT_EQUAL(3, fs.online());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 3600, fs.totalHashrate());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 56, fs.totalPower());
+    TEST_ASSERT_EQUAL_UINT32(360, fs.sharesAccepted());
+
+    fs.drop(1, 20);
+    TEST_ASSERT_EQUAL(2, fs.online());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 1500, fs.totalHashrate());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 25, fs.totalPower());
+    TEST_ASSERT_EQUAL_UINT32(150, fs.sharesAccepted());
+    TEST_ASSERT_EQUAL_UINT32(1, fs.sharesRejected());
+
+    fs.drop(1, 21);                // already offline: no change
+    TEST_ASSERT_EQUAL(2, fs.online());
+    fs.drop(0, 22);
+    fs.drop(2, 22);
+    TEST_ASSERT_EQUAL(0, fs.online());
+    TEST_ASSERT_EQUAL_FLOAT(0, fs.totalHashrate());
+    TEST_ASSERT_EQUAL_UINT32(0, fs.sharesAccepted());
+}
+
+static void test_totals_do_not_drift() {
+    FleetStats fs;
+    for (uint32_t k = 0; k < 20000; k++) {
+        fs.ingest(k % 4, sample(1000.1f + (k % 7), 15.3f, 55, k, 0), k / 4);
+    }
+    float expect = 0;
+    for (int i = 0; i < 4; i++) {
+        uint32_t last = 20000 - 4 + i;
+        expect += 1000.1f + (last % 7);
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.01, expect, fs.totalHashrate());
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 4 * 15.3f, fs.totalPower());
+}
+
+static void test_maximum_recomputed_when_leader_drops() {
+    FleetStats fs;
+    fs.ingest(0, sample(1000, 15, 55, 0, 0), 0);
+    fs.ingest(1, sample(1000, 15, 70, 0, 0), 0);
+    fs.ingest(2, sample(1000, 15, 62, 0, 0), 0);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 70, fs.maxTemperature());
+    fs.ingest(1, sample(1000, 15, 58, 0, 0), 5);    // the hottest cooled down
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 62, fs.maxTemperature());
+    fs.drop(2, 10);
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 58, fs.maxTemperature());
+}
+
+static void test_share_windows_survive_counter_reset() {
+    FleetStats fs;
+    fs.ingest(0, sample(1000, 15, 55, 100, 10), 0);
+    fs.ingest(0, sample(1000, 15, 55, 130, 10), 30);
+    TEST_ASSERT_EQUAL_UINT32(30, fs.sharesIn(1));
+    fs.ingest(0, sample(1000, 15, 55, 5, 0), 45);    // miner rebooted: counters start over
+    TEST_ASSERT_EQUAL_UINT32(35, fs.sharesIn(1));
+    fs.ingest(0, sample(1000, 15, 55, 15, 10), 90);  // next minute: 10 accepted, 10 rejected
+    TEST_ASSERT_EQUAL_UINT32(10, fs.sharesIn(1));
+    TEST_ASSERT_EQUAL_UINT32(45, fs.sharesIn(2));
+    TEST_ASSERT_FLOAT_WITHIN(0.01, 50, fs.rejectPct(1));
+}
+
+void run_fleet_stats_tests() {
+    RUN_TEST(test_totals_follow_ingest_and_drop);
+    RUN_TEST(test_totals_do_not_drift);
+    RUN_TEST(test_maximum_recomputed_when_leader_drops);
+    RUN_TEST(test_share_windows_survive_counter_reset);
+}
@@ -0,0 +1,140 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <history_export.h>
+
+#include <string>
+
+static MetricsHistory history;
+static MetricLog flashLog;
+static HistoryExport job;
+static const uint32_t T0 = 1699999200;     // on an hour boundary
+
+// The chunked body of a finished response, unframed
+static std::string body(const std::string& response) {
+    size_t p = response.find("\r\n\r\n");
+    TEST_ASSERT_TRUE(p != std::string::npos);
+    std::string out;
+    for (p += 4;;) {
+        size_t eol = response.find("\r\n", p);
+        TEST_ASSERT_TRUE(eol != std::string::npos);
+        size_t n = strtoul(response.c_str() + p, nullptr, 16);
+        if (n == 0) break;
+        out.append(response, eol + 2, n);
+        p = eol + 2 + n + 2;
+    }
+    return out;
+}
+
+static std::string run(const HistoryQuery& q) {
+    std::string sent;
+    WiFiClient client;
+    client.hostSink = &sent;
+    TEST_ASSERT_TRUE(job.begin(client, q, history, flashLog));
+    TEST_ASSERT_FALSE(job.begin(client, q, history, flashLog));       // one export at a time
+    while (job.active()) job.pump(20);
+    TEST_ASSERT_TRUE(sent.find("Transfer-Encoding: chunked") != std::string::npos);
+    TEST_ASSERT_TRUE(sent.size() >= 5 && sent.compare(sent.size() - 5, 5, "0\r\n\r\n") == 0);
+    return body(sent);
+}
+
+static void fill(uint32_t minutes) {
+    for (uint16_t s = 0; s < HIST_SERIES; s++) history.clear(s);
+    for (uint32_t k = 0; k < minutes; k++) {
+        float dev[HM_COUNT] = {1000.0f + k, 60, 18};
+        float fleet[HM_COUNT] = {2000, 60, 62.5f};       // stored in TH/s and kW: exact as half floats
+        history.add(0, T0 + k * 60, dev);
+        history.add(1, T0 + k * 60, dev);
+        history.add(HIST_FLEET, T0 + k * 60, fleet);
+    }
+}
+
+static void test_csv_from_memory() {
+    fill(10);
+    HistoryQuery q = {0, HIST_FLEET, (1 << HM_HASHRATE) | (1 << HM_POWER), T0, T0 + 180, 60, false};
+    std::string csv = run(q);
+    TEST_ASSERT_EQUAL_STRING("time,device,hashrate,power\n"
+                             "1699999200,0,1000.00,18.00\n"
+                             "1699999200,1,1000.00,18.00\n"
+                             "1699999200,fleet,2000.00,62.50\n"
+                             "1699999260,0,1001.00,18.00\n"
+                             "1699999260,1,1001.00,18.00\n"
+                             "1699999260,fleet,2000.00,62.50\n"
+                             "1699999320,0,1002.00,18.00\n"
+                             "1699999320,1,1002.00,18.00\n"
+                             "1699999320,fleet,2000.00,62.50\n",
+                             csv.c_str());
+    TEST_ASSERT_EQUAL_UINT32(9, job.rowsSent());
+}
+
+static void test_binary_header_and_rows() {
+    fill(10);
+    HistoryQuery q = {1, 1, 1 << HM_TEMP, T0, T0 + 600, 300, true};
+    std::string bin = run(q);
+    TEST_ASSERT_EQUAL(16 + 2 * 10, bin.size());
+    TEST_ASSERT_EQUAL_MEMORY("BXH1", bin.data(), 4);
+    TEST_ASSERT_EQUAL_UINT8(1, bin[4]);
+    TEST_ASSERT_EQUAL_UINT8(1 << HM_TEMP, bin[5]);
+    uint32_t from, step, t;
+    uint16_t series;
+    float temp;
+    memcpy(&from, bin.data() + 8, 4);
+    memcpy(&step, bin.data() + 12, 4);
+    TEST_ASSERT_EQUAL_UINT32(T0, from);
+    TEST_ASSERT_EQUAL_UINT32(300, step);
+    memcpy(&t, bin.data() + 26, 4);
+    memcpy(&series, bin.data() + 30, 2);
+    memcpy(&temp, bin.data() + 32, 4);
+    TEST_ASSERT_EQUAL_UINT32(T0 + 300, t);
+    TEST_ASSERT_EQUAL_UINT16(1, series);
+    TEST_ASSERT_EQUAL_FLOAT(60, temp);
+}
+
+static void test_empty_memory_range_is_header_only() {
+    fill(0);
+    HistoryQuery q = {0, 0, 1 << HM_HASHRATE, T0, T0 + 86400, 60, false};
+    TEST_ASSERT_EQUAL_STRING("time,device,hashrate\n", run(q).c_str());
+}
+
+static void test_raw_and_averaged_rows_from_flash() {
+    TEST_ASSERT_TRUE(flashLog.begin(30));
+    flashLog.wipe();
+    for (uint32_t k = 0; k < 12; k++) {
+        float v[HM_COUNT] = {1000.0f + k, 60, 18};
+        flashLog.append(0, T0 + k * 5, v);
+        flashLog.append(1, T0 + k * 5, v);
+    }
+    flashLog.flush();
+
+    HistoryQuery raw = {0, 0, 1 << HM_HASHRATE, T0, T0 + 60, 0, false};
+    std::string csv = run(raw);
+    TEST_ASSERT_EQUAL_UINT32(12, job.rowsSent());
+    TEST_ASSERT_TRUE(csv.find("1699999205,0,1001.00\n") != std::string::npos);
+    TEST_ASSERT_TRUE(csv.find(",1,") == std::string::npos);
+
+    // Averaged per 30 s: not servable from the (empty) minute tier, so the log answers
+    fill(0);
+    HistoryQuery avg = {0, 1, 1 << HM_HASHRATE, T0, T0 + 60, 30, false};
+    csv = run(avg);
+    TEST_ASSERT_EQUAL_UINT32(4, job.rowsSent());
+    TEST_ASSERT_TRUE(csv.find("1699999200,0,1002.50\n") != std::string::npos);
+    TEST_ASSERT_TRUE(csv.find("1699999230,1,1008.50\n") != std::string::npos);
+    flashLog.wipe();
+}
+
+static void test_gone_client_aborts() {
+    fill(10);
+    WiFiClient client;                 // no sink: not connected
+    HistoryQuery q = {0, 0, 1 << HM_HASHRATE, T0, T0 + 600, 60, false};
+    TEST_ASSERT_TRUE(job.begin(client, q, history, flashLog));
+    job.pump(20);
+    TEST_ASSERT_FALSE(job.active());
+    TEST_ASSERT_EQUAL_UINT32(0, job.rowsSent());
+}
+
+void run_history_export_tests() {
+    RUN_TEST(test_csv_from_memory);
+    RUN_TEST(test_binary_header_and_rows);
+    RUN_TEST(test_empty_memory_range_is_header_only);
+    RUN_TEST(test_raw_and_averaged_rows_from_flash);
+    RUN_TEST(test_gone_client_aborts);
+}
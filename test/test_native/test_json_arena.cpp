@@ -0,0 +1,86 @@
+#include <Arduino.h>
+#include <unity.h>
+#define JSON_ARENA_EXTERN 1         // jsonArena itself is main.cpp's
+#include <json_arena.h>
+
+static uint8_t buf[1024];
+
+static void test_blocks_are_a_stack() {
+    JsonArena a("test", buf, sizeof(buf));
+    uint8_t* p = (uint8_t*)a.allocate(100);
+    uint8_t* q = (uint8_t*)a.allocate(10);
+    TEST_ASSERT_EQUAL_PTR(buf, p);
+    TEST_ASSERT_EQUAL_PTR(buf + 104, q);                     // rounded up to 8
+    TEST_ASSERT_EQUAL(120, a.used());
+
+    a.deallocate(p);                                         // not the top: held until q goes
+    TEST_ASSERT_EQUAL(120, a.used());
+    a.deallocate(q);
+    TEST_ASSERT_EQUAL(0, a.used());
+    TEST_ASSERT_EQUAL(120, a.highWater());
+    TEST_ASSERT_EQUAL_UINT32(0, a.overflows());
+}
+
+static void test_reallocate_in_place_or_moved() {
+    JsonArena a("test", buf, sizeof(buf));
+    uint8_t* p = (uint8_t*)a.allocate(64);
+    memset(p, 0xA5, 64);
+    TEST_ASSERT_EQUAL_PTR(p, a.reallocate(p, 256));          // top block grows in place
+    TEST_ASSERT_EQUAL(256, a.used());
+    TEST_ASSERT_EQUAL_PTR(p, a.reallocate(p, 32));           // and gives the tail back
+    TEST_ASSERT_EQUAL(32, a.used());
+
+    uint8_t* q = (uint8_t*)a.allocate(16);
+    TEST_ASSERT_EQUAL_PTR(p, a.reallocate(p, 16));           // any shrink stays put
+    uint8_t* moved = (uint8_t*)a.reallocate(p, 128);         // a buried block moves
+    TEST_ASSERT_EQUAL_PTR(buf + 48, moved);
+    TEST_ASSERT_EQUAL_HEX32(0xA5A5A5A5, *(uint32_t*)moved);
+    a.deallocate(q);
+    TEST_ASSERT_EQUAL(176, a.used());                        // p's old room goes with q
+    a.deallocate(moved);
+    TEST_ASSERT_EQUAL(0, a.used());
+}
+
+static void test_overflow_falls_back_to_malloc() {
+    JsonArena a("test", buf, sizeof(buf));
+    void* big = a.allocate(2000);
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_TRUE((uint8_t*)big < buf || (uint8_t*)big >= buf + sizeof(buf));
+    TEST_ASSERT_EQUAL(0, a.used());
+    TEST_ASSERT_EQUAL_UINT32(1, a.overflows());
+    TEST_ASSERT_EQUAL(2000, a.largestOverflow());
+    a.deallocate(big);
+
+    void* blocks[JSON_ARENA_BLOCKS];
+    for (int k = 0; k < JSON_ARENA_BLOCKS; k++) blocks[k] = a.allocate(8);
+    void* extra = a.allocate(8);                             // out of blocks, not of room
+    TEST_ASSERT_EQUAL_UINT32(2, a.overflows());
+    TEST_ASSERT_EQUAL(JSON_ARENA_BLOCKS * 8, a.used());
+    a.deallocate(extra);
+    for (int k = JSON_ARENA_BLOCKS - 1; k >= 0; k--) a.deallocate(blocks[k]);
+    TEST_ASSERT_EQUAL(0, a.used());
+}
+
+static void test_document_and_text_share_the_arena() {
+    JsonArena a("test", buf, sizeof(buf));
+    {
+        ScratchJsonDocument doc(512, ArenaAllocator(a));
+        doc["x"] = 1;
+        {
+            ScratchJsonText text(doc, a);
+            TEST_ASSERT_EQUAL_STRING("{\"x\":1}", text.c_str());
+            TEST_ASSERT_EQUAL(7, text.length());
+            TEST_ASSERT_TRUE(a.used() > 0 && a.used() < 512);
+        }
+        TEST_ASSERT_TRUE(a.used() > 0);
+    }
+    TEST_ASSERT_EQUAL(0, a.used());
+    TEST_ASSERT_EQUAL_UINT32(0, a.overflows());
+}
+
+void run_json_arena_tests() {
+    RUN_TEST(test_blocks_are_a_stack);
+    RUN_TEST(test_reallocate_in_place_or_moved);
+    RUN_TEST(test_overflow_falls_back_to_malloc);
+    RUN_TEST(test_document_and_text_share_the_arena);
+}
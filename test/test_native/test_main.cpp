@@ -0,0 +1,69 @@
+/**
+ * Unit tests for the modules in src/ and for main.cpp itself, on the host fakes
+ *
+ *   pio test -e native
+ *
+ * One file per module; each registers its cases through run_<module>_tests().
+ * test_firmware boots main.cpp against simulated miners and drives polling,
+ * ingest and the screens; test_allocations then counts what polling takes
+ * from the heap (env native wraps the allocator).
+ */
+
+#include <Arduino.h>
+#include <unity.h>
+
+void run_fleet_stats_tests();
+void run_metric_log_tests();
+void run_alert_engine_tests();
+void run_miner_watchdog_tests();
+void run_control_queue_tests();
+void run_json_arena_tests();
+void run_settings_store_tests();
+void run_perf_stats_tests();
+void run_metrics_history_tests();
+void run_history_export_tests();
+void run_auto_tuner_tests();
+void run_power_governor_tests();
+void run_thermal_governor_tests();
+void run_benchmark_tests();
+void run_energy_tariff_tests();
+void run_profitability_tests();
+void run_bulk_dispatch_tests();
+void run_string_pool_tests();
+void run_firmware_tests();
+void run_allocations_tests();
+
+void setUp() {
+    Serial.quiet = true;           // the modules log transitions; keep the report readable
+}
+
+void tearDown() {}
+
+int main() {
+    // LittleFS lives in a directory of its own for each run
+    char fsRoot[] = "/tmp/bitaxemon_test_XXXXXX";
+    setenv("HOST_FS_ROOT", mkdtemp(fsRoot), 1);
+
+    UNITY_BEGIN();
+    run_fleet_stats_tests();
+    run_metric_log_tests();
+    run_alert_engine_tests();
+    run_miner_watchdog_tests();
+    run_control_queue_tests();
+    run_json_arena_tests();
+    run_settings_store_tests();
+    run_perf_stats_tests();
+    run_metrics_history_tests();
+    run_history_export_tests();
+    run_auto_tuner_tests();
+    run_power_governor_tests();
+    run_thermal_governor_tests();
+    run_benchmark_tests();
+    run_energy_tariff_tests();
+    run_profitability_tests();
+    run_bulk_dispatch_tests();
+    run_string_pool_tests();
+    run_firmware_tests();
+    run_allocations_tests();
+    return UNITY_END();
+}
@@ -0,0 +1,159 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <metric_log.h>
+
+static MlogEncoder encoder;
+static MlogDecoder decoder;
+
+static MlogRecord record(uint16_t series, uint32_t t, float a, float b, float c) {
+    MlogRecord r;
+    r.series = series;
+    r.t = t;
+    r.v[0] = a;
+    r.v[1] = b;
+    r.v[2] = c;
+    return r;
+}
+
+static void header(const uint8_t* block, MlogBlockHeader& h) {
+    memcpy(&h, block, sizeof(h));
+}
+
+static void test_crc32_matches_the_standard_check_value() {
+    const char* s = "123456789";
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, mlogCrc32(0, (const uint8_t*)s, 9));
+    // Chained over two pieces gives the same as one pass
+    uint32_t crc = mlogCrc32(0, (const uint8_t*)s, 4);
+    TEST_ASSERT_EQUAL_HEX32(0xCBF43926, mlogCrc32(crc, (const uint8_t*)s + 4, 5));
+}
+
+static void test_block_round_trip() {
+    MlogRecord in[40];
+    int n = 0;
+    uint32_t t = 1700000000;
+    for (int k = 0; k < 30; k++) {
+        // Regular spacing, a few odd gaps (every delta-of-delta width) and all the series
+        t += (k == 7) ? 70 : (k == 12) ? 3000 : (k == 20) ? 100000 : 5;
+        in[n++] = record(k % HIST_SERIES, t, 1000.0f + k * 3.7f, 55.0f + (k % 5) * 0.25f, 15.0f - k * 0.01f);
+    }
+    in[n++] = record(0, t + 5, 0, -12.5f, 1e9f);       // zero, negative, large
+    in[n++] = record(0, t + 10, 0, -12.5f, 1e9f);      // unchanged values
+
+    encoder.reset();
+    for (int k = 0; k < n; k++) TEST_ASSERT_TRUE(encoder.add(in[k]));
+    TEST_ASSERT_EQUAL_UINT16(n, encoder.count());
+    size_t bytes;
+    const uint8_t* block = encoder.seal(bytes);
+    MlogBlockHeader h;
+    header(block, h);
+    TEST_ASSERT_EQUAL_UINT16(MLOG_MAGIC, h.magic);
+    TEST_ASSERT_EQUAL(sizeof(h) + h.len, bytes);
+    TEST_ASSERT_EQUAL_UINT32(in[0].t, h.t0);
+    TEST_ASSERT_EQUAL_UINT32(in[n - 1].t, h.t1);
+
+    decoder.begin(h, block + sizeof(h));
+    MlogRecord out;
+    for (int k = 0; k < n; k++) {
+        TEST_ASSERT_TRUE(decoder.next(out));
+        TEST_ASSERT_EQUAL_UINT16(in[k].series, out.series);
+        TEST_ASSERT_EQUAL_UINT32(in[k].t, out.t);
+        for (int m = 0; m < HM_COUNT; m++) {
+            // Values come back exactly as quantized
+            uint32_t bits;
+            memcpy(&bits, &out.v[m], sizeof(bits));
+            TEST_ASSERT_EQUAL_HEX32(mlogQuantize(in[k].v[m]), bits);
+            TEST_ASSERT_FLOAT_WITHIN(fabsf(in[k].v[m]) * 0.0005f, in[k].v[m], out.v[m]);
+        }
+    }
+    TEST_ASSERT_FALSE(decoder.next(out));
+}
+
+static void test_full_block_refuses_and_still_decodes() {
+    encoder.reset();
+    uint32_t t = 1700000000;
+    int n = 0;
+    while (encoder.add(record(n % HIST_SERIES, t, 1000.0f + n * 1.37f, 50.0f + n * 0.11f, 17.0f + n * 0.07f))) {
+        t += 5 + (n % 3);
+        n++;
+    }
+    TEST_ASSERT_GREATER_THAN(20, n);
+    TEST_ASSERT_EQUAL_UINT16(n, encoder.count());
+    size_t bytes;
+    const uint8_t* block = encoder.seal(bytes);
+    TEST_ASSERT_TRUE(bytes <= MLOG_BLOCK_BYTES);
+    MlogBlockHeader h;
+    header(block, h);
+    decoder.begin(h, block + sizeof(h));
+    MlogRecord out;
+    int k = 0;
+    while (decoder.next(out)) k++;
+    TEST_ASSERT_EQUAL(n, k);
+}
+
+static void test_crc_catches_a_flipped_bit() {
+    encoder.reset();
+    for (int k = 0; k < 10; k++) encoder.add(record(k % 2, 1700000000 + k * 5, 1000 + k, 60, 15));
+    size_t bytes;
+    const uint8_t* sealed = encoder.seal(bytes);
+    uint8_t block[MLOG_BLOCK_BYTES];
+    memcpy(block, sealed, bytes);
+    MlogBlockHeader h;
+    header(block, h);
+    const uint8_t* payload = block + sizeof(h);
+    TEST_ASSERT_EQUAL_HEX32(h.crc, mlogBlockCrc(h, payload));
+
+    block[sizeof(h) + h.len / 2] ^= 0x10;
+    TEST_ASSERT_NOT_EQUAL(h.crc, mlogBlockCrc(h, payload));
+    block[sizeof(h) + h.len / 2] ^= 0x10;
+
+    h.t1 += 1;                     // the header fields after crc are covered too
+    TEST_ASSERT_NOT_EQUAL(h.crc, mlogBlockCrc(h, payload));
+}
+
+// Blocks of three samples each, at t0, t0 + 5, t0 + 10
+static void writeBlock(MetricLog& log, uint32_t t0) {
+    for (int k = 0; k < 3; k++) {
+        float v[HM_COUNT] = {1000.0f + k, 55, 15};
+        log.append(0, t0 + k * 5, v);
+    }
+    log.flush();
+}
+
+static int countRecords(MetricLog& log) {
+    MetricLogCursor cursor;
+    TEST_ASSERT_TRUE(cursor.open(log, 0, 0xFFFFFFFF));
+    MlogRecord r;
+    int n = 0;
+    while (cursor.next(r)) n++;
+    return n;
+}
+
+static void test_short_write_loses_only_that_block() {
+    static MetricLog log;
+    TEST_ASSERT_TRUE(log.begin(30));
+    log.wipe();
+    writeBlock(log, 1700000000);
+
+    fs::hostSpaceLeft() = 20;                  // LittleFS fills up mid-block
+    writeBlock(log, 1700000100);
+    fs::hostSpaceLeft() = -1;
+    TEST_ASSERT_EQUAL_UINT32(1, log.tornBlocks());
+
+    writeBlock(log, 1700000200);
+    TEST_ASSERT_EQUAL(6, countRecords(log));
+
+    // After a reboot the scan finds the torn tail and keeps everything behind it
+    static MetricLog rebooted;
+    TEST_ASSERT_TRUE(rebooted.begin(30));
+    TEST_ASSERT_EQUAL_UINT32(1, rebooted.tornBlocks());
+    TEST_ASSERT_EQUAL(6, countRecords(rebooted));
+    rebooted.wipe();
+}
+
+void run_metric_log_tests() {
+    RUN_TEST(test_crc32_matches_the_standard_check_value);
+    RUN_TEST(test_block_round_trip);
+    RUN_TEST(test_full_block_refuses_and_still_decodes);
+    RUN_TEST(test_crc_catches_a_flipped_bit);
+    RUN_TEST(test_short_write_loses_only_that_block);
+}
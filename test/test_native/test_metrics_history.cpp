@@ -0,0 +1,105 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <metrics_history.h>
+
+static MetricsHistory history;
+static const uint32_t T0 = 1699999200;     // on an hour boundary
+
+static void add(uint16_t series, uint32_t t, float hashRate, float temp, float power) {
+    float v[HM_COUNT] = {hashRate, temp, power};
+    history.add(series, t, v);
+}
+
+static void test_bucket_keeps_min_max_mean_last() {
+    history.clear(0);
+    add(0, T0, 1000, 60, 18);
+    add(0, T0 + 20, 1200, 64, 20);
+    add(0, T0 + 40, 1100, 62, 19);
+
+    HistPoint p;
+    TEST_ASSERT_TRUE(history.bucket(0, HM_HASHRATE, 0, 0, p));
+    TEST_ASSERT_EQUAL_FLOAT(1000, p.min);
+    TEST_ASSERT_EQUAL_FLOAT(1200, p.max);
+    TEST_ASSERT_FLOAT_WITHIN(1, 1100, p.mean);
+    TEST_ASSERT_EQUAL_FLOAT(1100, p.last);
+    TEST_ASSERT_TRUE(history.bucket(0, HM_TEMP, 2, 0, p));     // the same samples in the hour tier
+    TEST_ASSERT_EQUAL_FLOAT(60, p.min);
+    TEST_ASSERT_EQUAL_FLOAT(64, p.max);
+    TEST_ASSERT_EQUAL_UINT32(T0, history.newest(0));
+}
+
+static void test_skipped_minutes_are_gaps() {
+    history.clear(0);
+    add(0, T0, 1000, 60, 18);
+    add(0, T0 + 3 * 60, 900, 61, 17);
+
+    HistPoint p;
+    TEST_ASSERT_TRUE(history.bucket(0, HM_HASHRATE, 0, 0, p));
+    TEST_ASSERT_EQUAL_FLOAT(900, p.last);
+    TEST_ASSERT_FALSE(history.bucket(0, HM_HASHRATE, 0, 1, p));
+    TEST_ASSERT_FALSE(history.bucket(0, HM_HASHRATE, 0, 2, p));
+    TEST_ASSERT_TRUE(history.bucket(0, HM_HASHRATE, 0, 3, p));
+    TEST_ASSERT_EQUAL_FLOAT(1000, p.last);
+
+    HistPoint cols[4];
+    TEST_ASSERT_EQUAL(2, history.read(0, HM_HASHRATE, T0, T0 + 4 * 60, 4, cols));
+    TEST_ASSERT_TRUE(cols[0].valid);
+    TEST_ASSERT_FALSE(cols[1].valid);
+    TEST_ASSERT_TRUE(cols[3].valid);
+}
+
+static void test_read_picks_the_tier_for_the_column_width() {
+    history.clear(0);
+    for (uint32_t t = T0; t < T0 + 6 * 3600; t += 60) add(0, t, (t - T0) < 3 * 3600 ? 1000 : 2000, 60, 18);
+    uint32_t now = T0 + 6 * 3600 - 60;
+
+    // The minute tier's 60 slots, open bucket included, at one column a minute
+    TEST_ASSERT_EQUAL(0, history.tierFor(0, now - 59 * 60, 60));
+    TEST_ASSERT_EQUAL(1, history.tierFor(0, now - 60 * 60, 60));
+    // Six hours in 24 columns: 15 minute buckets
+    TEST_ASSERT_EQUAL(1, history.tierFor(0, T0, 900));
+    // Older than the minute tier reaches: a coarser one even for narrow columns
+    TEST_ASSERT_EQUAL(1, history.tierFor(0, T0, 60));
+
+    HistPoint cols[6];
+    TEST_ASSERT_EQUAL(6, history.read(0, HM_HASHRATE, T0, T0 + 6 * 3600, 6, cols));
+    TEST_ASSERT_EQUAL_FLOAT(1000, cols[2].mean);
+    TEST_ASSERT_EQUAL_FLOAT(2000, cols[3].mean);
+    TEST_ASSERT_TRUE(history.canServe(0, T0, 900));
+    TEST_ASSERT_FALSE(history.canServe(0, T0, 60));
+}
+
+static void test_fleet_sums_survive_half_floats() {
+    history.clear(HIST_FLEET);
+    add(HIST_FLEET, T0, 120000, 70, 1500);         // 120 TH/s, past a half float's 65504
+    HistPoint p;
+    TEST_ASSERT_TRUE(history.bucket(HIST_FLEET, HM_HASHRATE, 0, 0, p));
+    TEST_ASSERT_FLOAT_WITHIN(120000 * 0.001f, 120000, p.last);
+    TEST_ASSERT_TRUE(history.bucket(HIST_FLEET, HM_POWER, 0, 0, p));
+    TEST_ASSERT_FLOAT_WITHIN(1.5f, 1500, p.last);
+    TEST_ASSERT_TRUE(history.bucket(HIST_FLEET, HM_TEMP, 0, 0, p));
+    TEST_ASSERT_EQUAL_FLOAT(70, p.last);
+}
+
+static void test_clock_stepping_back_restarts_the_series() {
+    history.clear(0);
+    add(0, T0 + 3600, 1000, 60, 18);
+    add(0, T0, 500, 60, 18);                       // NTP pulled the clock back an hour
+    HistPoint p;
+    TEST_ASSERT_EQUAL_UINT32(T0, history.newest(0));
+    TEST_ASSERT_TRUE(history.bucket(0, HM_HASHRATE, 0, 0, p));
+    TEST_ASSERT_EQUAL_FLOAT(500, p.max);
+    TEST_ASSERT_FALSE(history.bucket(0, HM_HASHRATE, 0, 1, p));
+
+    history.clear(0);
+    TEST_ASSERT_EQUAL_UINT32(0, history.newest(0));
+    TEST_ASSERT_EQUAL_UINT32(0, history.oldest(0));
+}
+
+void run_metrics_history_tests() {
+    RUN_TEST(test_bucket_keeps_min_max_mean_last);
+    RUN_TEST(test_skipped_minutes_are_gaps);
+    RUN_TEST(test_read_picks_the_tier_for_the_column_width);
+    RUN_TEST(test_fleet_sums_survive_half_floats);
+    RUN_TEST(test_clock_stepping_back_restarts_the_series);
+}
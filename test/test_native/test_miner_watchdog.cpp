@@ -0,0 +1,114 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <miner_watchdog.h>
+
+static MinerWatchdog dog;
+static uint32_t uptime, shares;
+
+// Miner 0 answering with hashRate at time now; shares keep moving so only the hashrate matters
+static bool poll(float hashRate, uint32_t now, WatchDecision& d) {
+    WatchSample s = {hashRate, shares++, uptime + now, 500};
+    return dog.evaluate(0, s, now, d);
+}
+
+static void configure() {
+    dog = MinerWatchdog();
+    dog.setEnabled(true);
+    WatchdogConfig& c = dog.config();
+    c.zeroHashSec = 60;
+    c.bootGraceSec = 300;
+    c.minGapSec = 100;
+    c.healthySec = 1000;
+    c.safeLevel = 2;
+    c.maxLevel = 3;
+    c.safeStep = 25;
+    c.minFreq = 400;
+    uptime = 3600;
+    shares = 0;
+}
+
+// Zero hashrate from `from` until the watchdog asks for a restart (or `until` passes)
+static uint32_t stallUntilRestart(uint32_t from, uint32_t until, WatchDecision& d) {
+    for (uint32_t t = from; t <= until; t += 10) {
+        if (poll(0, t, d)) return t;
+    }
+    return 0;
+}
+
+static void test_escalation_backs_off_then_gives_up() {
+    configure();
+    WatchDecision d;
+    TEST_ASSERT_FALSE(poll(1000, 0, d));
+
+    // Level 0: restart once the hashrate has been zero for zeroHashSec
+    uint32_t t = stallUntilRestart(10, 1000, d);
+    TEST_ASSERT_EQUAL_UINT32(70, t);
+    TEST_ASSERT_EQUAL_UINT8(WR_NO_HASH, d.reason);
+    TEST_ASSERT_EQUAL_UINT8(0, d.level);
+    TEST_ASSERT_EQUAL(-1, d.frequency);
+    dog.applied(0, d, false, t);
+    TEST_ASSERT_EQUAL_UINT8(1, dog.level(0));
+
+    // Level 1: not before minGapSec since the last restart
+    TEST_ASSERT_EQUAL_UINT32(100, dog.holdoff(0, t));
+    t = stallUntilRestart(t + 10, 2000, d);
+    TEST_ASSERT_EQUAL_UINT32(170, t);
+    TEST_ASSERT_EQUAL_UINT8(1, d.level);
+    TEST_ASSERT_EQUAL(-1, d.frequency);
+    dog.applied(0, d, false, t);
+
+    // Level 2: the gap doubles, and the frequency steps down first
+    t = stallUntilRestart(t + 10, 2000, d);
+    TEST_ASSERT_EQUAL_UINT32(370, t);
+    TEST_ASSERT_EQUAL_UINT8(2, d.level);
+    TEST_ASSERT_EQUAL(475, d.frequency);
+    dog.applied(0, d, false, t);
+    TEST_ASSERT_EQUAL_UINT8(WE_SAFE_RESTART, dog.logEntry(0).kind);
+
+    // Level 3 = maxLevel: once the gap is over it gives up instead
+    TEST_ASSERT_EQUAL_UINT32(0, stallUntilRestart(t + 10, 2000, d));
+    TEST_ASSERT_TRUE(dog.gaveUp(0));
+    TEST_ASSERT_EQUAL_UINT8(WE_GAVE_UP, dog.logEntry(0).kind);
+    TEST_ASSERT_EQUAL_UINT16(3, dog.restarts(0));
+
+    dog.rearm(0);
+    TEST_ASSERT_FALSE(dog.gaveUp(0));
+    TEST_ASSERT_EQUAL_UINT8(0, dog.level(0));
+    TEST_ASSERT_TRUE(poll(0, 2010, d));
+    TEST_ASSERT_EQUAL_UINT8(0, d.level);
+}
+
+static void test_healthy_period_resets_the_level() {
+    configure();
+    WatchDecision d;
+    poll(1000, 0, d);
+    uint32_t t = stallUntilRestart(10, 1000, d);
+    dog.applied(0, d, true, t);
+    TEST_ASSERT_EQUAL_UINT8(1, dog.level(0));
+
+    for (t += 10; t < 70 + 1000; t += 10) TEST_ASSERT_FALSE(poll(1000, t, d));
+    TEST_ASSERT_EQUAL_UINT8(1, dog.level(0));
+    poll(1000, t, d);
+    TEST_ASSERT_EQUAL_UINT8(0, dog.level(0));
+}
+
+static void test_boot_grace_and_unplanned_reboot() {
+    configure();
+    WatchDecision d;
+    poll(1000, 0, d);
+    uptime = 0;                    // rebooted without being asked: uptime went backwards
+    TEST_ASSERT_FALSE(poll(1000, 10, d));
+    TEST_ASSERT_EQUAL_UINT16(1, dog.reboots(0));
+    TEST_ASSERT_EQUAL_UINT8(WE_REBOOT, dog.logEntry(0).kind);
+
+    // Still inside bootGraceSec of its own uptime: nothing is judged
+    TEST_ASSERT_EQUAL_UINT32(0, stallUntilRestart(20, 290, d));
+    TEST_ASSERT_EQUAL_UINT8(WR_NONE, dog.stuck(0));
+    TEST_ASSERT_EQUAL_UINT32(300, stallUntilRestart(300, 1000, d));
+}
+
+void run_miner_watchdog_tests() {
+    RUN_TEST(test_escalation_backs_off_then_gives_up);
+    RUN_TEST(test_healthy_period_resets_the_level);
+    RUN_TEST(test_boot_grace_and_unplanned_reboot);
+}
@@ -0,0 +1,52 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <perf_stats.h>
+
+static PerfStats perf;
+
+static void addUs(uint8_t stage, uint32_t us) {
+    perf.add(stage, us * perf.cyclesPerUs());
+}
+
+static void test_buckets_are_half_octaves() {
+    const uint32_t tops[] = {1, 2, 2, 3, 4, 6, 8, 12, 16, 24};     // bucket 2 stays empty
+    for (uint8_t b = 0; b < 10; b++) TEST_ASSERT_EQUAL_UINT32(tops[b], PerfStats::bucketTop(b));
+    TEST_ASSERT_EQUAL_UINT8(0, PerfStats::bucketOf(0));
+    // Every bucket holds exactly [bucketTop(b - 1), bucketTop(b))
+    for (uint8_t b = 3; b < PERF_BUCKETS; b++) {
+        TEST_ASSERT_EQUAL_UINT8(b, PerfStats::bucketOf(PerfStats::bucketTop(b - 1)));
+        TEST_ASSERT_EQUAL_UINT8(b, PerfStats::bucketOf(PerfStats::bucketTop(b) - 1));
+    }
+    // Up to ~16.8 s before anything is clamped
+    TEST_ASSERT_GREATER_THAN(16700000, PerfStats::bucketTop(PERF_BUCKETS - 1));
+    TEST_ASSERT_EQUAL_UINT8(PERF_BUCKETS - 1, PerfStats::bucketOf(0xFFFFFFFF));
+}
+
+static void test_percentiles() {
+    perf.reset();
+    for (int k = 0; k < 90; k++) addUs(PS_DEV_PARSE, 100);
+    for (int k = 0; k < 10; k++) addUs(PS_DEV_PARSE, 5000);
+    TEST_ASSERT_EQUAL_UINT32(100, perf.count(PS_DEV_PARSE));
+    TEST_ASSERT_EQUAL_UINT32(5000, perf.maxUs(PS_DEV_PARSE));
+    TEST_ASSERT_EQUAL_UINT32(590, perf.meanUs(PS_DEV_PARSE));
+    uint32_t p50 = perf.percentile(PS_DEV_PARSE, 50);
+    TEST_ASSERT_TRUE(p50 >= 96 && p50 < 128);              // inside 100's bucket
+    TEST_ASSERT_EQUAL_UINT32(5000, perf.percentile(PS_DEV_PARSE, 99));
+    TEST_ASSERT_EQUAL_UINT32(0, perf.percentile(PS_DEV_TTFB, 50));
+}
+
+static void test_slow_stage_is_not_under_reported() {
+    perf.reset();
+    addUs(PS_DEV_CONNECT, 15000000);                      // inside the last bucket
+    TEST_ASSERT_EQUAL_UINT32(15000000, perf.percentile(PS_DEV_CONNECT, 99));
+    perf.reset();
+    addUs(PS_DEV_CONNECT, 17000000);                      // past it: clamped, still reads as itself
+    TEST_ASSERT_EQUAL_UINT32(1, perf.bucket(PS_DEV_CONNECT, PERF_BUCKETS - 1));
+    TEST_ASSERT_EQUAL_UINT32(17000000, perf.percentile(PS_DEV_CONNECT, 50));
+}
+
+void run_perf_stats_tests() {
+    RUN_TEST(test_buckets_are_half_octaves);
+    RUN_TEST(test_percentiles);
+    RUN_TEST(test_slow_stage_is_not_under_reported);
+}
@@ -0,0 +1,133 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <power_governor.h>
+
+static PowerGovernor gov;
+static GovDevice devs[3];
+
+// Power scales with frequency; device 1 is the least efficient
+static void fleet() {
+    devs[0] = {true, false, 500, 1000, 15};        // 15 J/TH
+    devs[1] = {true, false, 500, 1000, 25};        // 25 J/TH
+    devs[2] = {true, false, 500, 1000, 20};        // 20 J/TH
+}
+
+static float total() {
+    float w = 0;
+    for (const GovDevice& d : devs) w += d.online ? d.power : 0;
+    return w;
+}
+
+// PATCH an action and report a fresh sample, power following frequency
+static void apply(const GovAction& a, uint32_t now) {
+    GovDevice& d = devs[a.device];
+    d.power = d.power * a.frequency / d.frequency;
+    d.hashRate = d.hashRate * a.frequency / d.frequency;
+    d.frequency = a.frequency;
+    gov.applied(a, true, now);
+    gov.sampled(a.device);
+}
+
+static void test_cuts_the_worst_device_first() {
+    gov = PowerGovernor();
+    gov.configure(55, 5, 25, 400, 30);
+    fleet();
+    GovAction a;
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 100, a));
+    TEST_ASSERT_EQUAL_UINT8(1, a.device);
+    TEST_ASSERT_EQUAL(-25, a.deltaMHz);
+    TEST_ASSERT_EQUAL(475, a.frequency);
+    TEST_ASSERT_EQUAL_STRING("over cap", gov.lastReason());
+    gov.applied(a, true, 100);
+    TEST_ASSERT_EQUAL(25, gov.cutMHz(1));
+
+    // Rate limited, and device 1 waits for a sample that shows the change
+    TEST_ASSERT_FALSE(gov.evaluate(devs, 3, total(), 110, a));
+    devs[1].frequency = 475;
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 130, a));
+    TEST_ASSERT_EQUAL_UINT8(2, a.device);
+}
+
+static void test_converges_under_the_cap_and_stops_at_min_freq() {
+    gov = PowerGovernor();
+    gov.configure(50, 5, 50, 400, 30);             // 48 W with everyone at 400 MHz
+    fleet();
+    GovAction a;
+    uint32_t now = 0;
+    for (int k = 0; k < 20 && total() > 50; k++, now += 30) {
+        TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), now, a));
+        TEST_ASSERT_TRUE(a.deltaMHz < 0);
+        apply(a, now);
+    }
+    TEST_ASSERT_TRUE(total() <= 50);
+    TEST_ASSERT_EQUAL(450, devs[0].frequency);        // the most efficient kept the most
+    for (const GovDevice& d : devs) TEST_ASSERT_TRUE(d.frequency >= 400);
+    TEST_ASSERT_EQUAL(gov.totalCutMHz(), 3 * 500 - devs[0].frequency - devs[1].frequency - devs[2].frequency);
+
+    // A cap nothing can meet: everyone ends at minFreq, then it gives up
+    gov.configure(10, 5, 50, 400, 30);
+    for (int k = 0; k < 20 && gov.evaluate(devs, 3, total(), now, a); k++, now += 30) apply(a, now);
+    for (const GovDevice& d : devs) TEST_ASSERT_EQUAL(400, d.frequency);
+    TEST_ASSERT_EQUAL_STRING("over cap, nothing left to cut", gov.lastReason());
+}
+
+static void test_busy_devices_are_cut_last() {
+    gov = PowerGovernor();
+    gov.configure(55, 5, 25, 400, 30);
+    fleet();
+    devs[1].busy = true;
+    GovAction a;
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 0, a));
+    TEST_ASSERT_EQUAL_UINT8(2, a.device);
+
+    devs[0].frequency = devs[2].frequency = 400;
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 0, a));
+    TEST_ASSERT_EQUAL_UINT8(1, a.device);
+}
+
+static void test_restores_only_its_own_cuts_outside_the_band() {
+    gov = PowerGovernor();
+    gov.configure(55, 5, 25, 400, 30);
+    fleet();
+    GovAction a;
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 0, a));
+    apply(a, 0);                                  // device 1: 500 -> 475, 23.75 W, total 58.75
+
+    // Over the cap is still over; inside cap - hyst nothing moves
+    gov.configure(60, 5, 25, 400, 30);            // 58.75 + 1.25 > 55
+    TEST_ASSERT_FALSE(gov.evaluate(devs, 3, total(), 30, a));
+    TEST_ASSERT_EQUAL_STRING("holding (inside hysteresis band)", gov.lastReason());
+
+    gov.configure(80, 5, 25, 400, 30);
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 60, a));
+    TEST_ASSERT_EQUAL_UINT8(1, a.device);
+    TEST_ASSERT_EQUAL(25, a.deltaMHz);
+    apply(a, 60);
+    TEST_ASSERT_EQUAL(0, gov.totalCutMHz());
+    TEST_ASSERT_FALSE(gov.evaluate(devs, 3, total(), 90, a));     // never above what it took
+    TEST_ASSERT_EQUAL_STRING("within cap", gov.lastReason());
+
+    // A manual setting takes the device out of the governor's hands
+    gov.configure(55, 5, 25, 400, 30);
+    TEST_ASSERT_TRUE(gov.evaluate(devs, 3, total(), 120, a));
+    apply(a, 120);
+    gov.forget(a.device);
+    TEST_ASSERT_EQUAL(0, gov.totalCutMHz());
+}
+
+static void test_disabled_does_nothing() {
+    gov = PowerGovernor();
+    fleet();
+    GovAction a;
+    TEST_ASSERT_FALSE(gov.enabled());
+    TEST_ASSERT_FALSE(gov.evaluate(devs, 3, 1e6f, 0, a));
+    TEST_ASSERT_EQUAL_STRING("disabled", gov.lastReason());
+}
+
+void run_power_governor_tests() {
+    RUN_TEST(test_cuts_the_worst_device_first);
+    RUN_TEST(test_converges_under_the_cap_and_stops_at_min_freq);
+    RUN_TEST(test_busy_devices_are_cut_last);
+    RUN_TEST(test_restores_only_its_own_cuts_outside_the_band);
+    RUN_TEST(test_disabled_does_nothing);
+}
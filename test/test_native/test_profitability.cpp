@@ -0,0 +1,77 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <profitability.h>
+
+static Profitability profit;
+
+// The difficulty at which 1000 GH/s finds one block a day
+static const double ONE_A_DAY = 1e12 * 86400.0 / PROFIT_TWO_32;
+
+static void test_device_figures() {
+    profit = Profitability();
+    profit.setNetwork(ONE_A_DAY, 50000, 3.125f);
+    profit.setRateHours(0.2f * 24);                    // 0.20 / kWh all day
+    profit.setDevice(0, 1000, 20, 1e12 * 3600.0 / PROFIT_TWO_32 / 100);
+
+    const ProfitFigures& f = profit.device(0);
+    TEST_ASSERT_TRUE(profit.ready());
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0, f.blocksPerDay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 24.0, f.hoursToBlock);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 100, f.sharesPerHour);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 156250, f.revenuePerDay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-4f, 0.096f, f.costPerDay);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 156250 - 0.096f, f.profitPerDay);
+
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0 - exp(-1.0), profit.blockProbability(1000, 24));
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0 - exp(-0.5), profit.blockProbability(500, 24));
+    TEST_ASSERT_EQUAL_FLOAT(0, profit.blockProbability(0, 24));
+}
+
+static void test_fleet_sums_follow_updates_and_drops() {
+    profit = Profitability();
+    profit.setNetwork(ONE_A_DAY, 1, 1);
+    profit.setRateHours(24);
+    profit.setDevice(0, 1000, 20, 0);
+    profit.setDevice(1, 500, 10, 0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.5, profit.fleet().blocksPerDay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.72f, profit.fleet().costPerDay);
+    TEST_ASSERT_EQUAL_FLOAT(0, profit.fleet().sharesPerHour);       // no share difficulty known
+
+    profit.setDevice(1, 2000, 30, 0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 3.0, profit.fleet().blocksPerDay);
+    profit.dropDevice(0);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0, profit.fleet().blocksPerDay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 1.0 - exp(-2.0), profit.fleetBlockProbability(24));
+    TEST_ASSERT_EQUAL_FLOAT(0, profit.device(0).blocksPerDay);
+
+    // Many updates later the sums have not drifted
+    for (int k = 0; k < 100000; k++) profit.setDevice(2, 1000.0f + (k % 97) * 0.37f, 15.0f + (k % 13) * 0.11f, 0);
+    profit.dropDevice(2);
+    TEST_ASSERT_FLOAT_WITHIN(1e-6f, 2.0, profit.fleet().blocksPerDay);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.72f, profit.fleet().costPerDay);
+
+    profit.reset();
+    TEST_ASSERT_EQUAL_FLOAT(0, profit.fleet().blocksPerDay);
+}
+
+static void test_network_changes_reach_every_figure() {
+    profit = Profitability();
+    profit.setDevice(0, 1000, 20, 0);
+    TEST_ASSERT_FALSE(profit.ready());
+    TEST_ASSERT_EQUAL_FLOAT(0, profit.device(0).hoursToBlock);     // no difficulty yet
+    TEST_ASSERT_EQUAL_FLOAT(0, profit.blockProbability(1000, 24));
+
+    profit.setNetwork(ONE_A_DAY, 100, 3.125f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 312.5f, profit.device(0).revenuePerDay);
+    profit.setNetwork(ONE_A_DAY * 2, 100, 3.125f);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 156.25f, profit.device(0).revenuePerDay);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 156.25f, profit.fleet().revenuePerDay);
+    profit.setRateHours(48);
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.96f, profit.device(0).costPerDay);
+}
+
+void run_profitability_tests() {
+    RUN_TEST(test_device_figures);
+    RUN_TEST(test_fleet_sums_follow_updates_and_drops);
+    RUN_TEST(test_network_changes_reach_every_figure);
+}
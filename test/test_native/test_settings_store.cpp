@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <settings_store.h>
+
+static Preferences prefs;
+
+static void test_get_reads_flash_once() {
+    prefs.begin("t_get");
+    prefs.putInt("rate", 30);
+    SettingsStore store(prefs);
+    TEST_ASSERT_EQUAL(30, store.getInt("rate", 10));
+    prefs.putInt("rate", 40);                                // behind the store's back
+    TEST_ASSERT_EQUAL(30, store.getInt("rate", 10));
+    TEST_ASSERT_EQUAL(7, store.getInt("missing", 7));
+    TEST_ASSERT_TRUE(store.getBool("flag", true));
+    prefs.end();
+}
+
+static void test_set_waits_for_quiet() {
+    prefs.begin("t_quiet");
+    SettingsStore store(prefs);
+    store.getInt("rate", 10);
+    uint32_t before = Preferences::writes();
+    for (int k = 0; k < 20; k++) store.setInt("rate", 11 + k, 1000 + k * 100);
+    store.setFloat("gain", 1.5f, 2900);
+    TEST_ASSERT_EQUAL(2, store.pending());
+    TEST_ASSERT_EQUAL_UINT32(before, Preferences::writes());
+
+    TEST_ASSERT_FALSE(store.loop(2900 + SETTINGS_QUIET_MS - 1));
+    TEST_ASSERT_FALSE(store.loop(2800));                     // taken before the last set()
+    TEST_ASSERT_TRUE(store.loop(2900 + SETTINGS_QUIET_MS));
+    TEST_ASSERT_EQUAL_UINT32(before + 2, Preferences::writes());
+    TEST_ASSERT_EQUAL(0, store.pending());
+    TEST_ASSERT_EQUAL_UINT32(2, store.writes());
+    TEST_ASSERT_EQUAL_UINT32(1, store.flushes());
+    TEST_ASSERT_EQUAL(30, prefs.getInt("rate", 0));
+    TEST_ASSERT_FALSE(store.loop(60000));
+    prefs.end();
+}
+
+static void test_set_back_to_saved_is_clean() {
+    prefs.begin("t_back");
+    prefs.putInt("rate", 30);
+    SettingsStore store(prefs);
+    TEST_ASSERT_EQUAL(30, store.getInt("rate", 10));
+    store.setInt("rate", 35, 100);
+    TEST_ASSERT_EQUAL(1, store.pending());
+    store.setInt("rate", 30, 200);
+    TEST_ASSERT_EQUAL(0, store.pending());
+    TEST_ASSERT_EQUAL(0, store.flush());
+    TEST_ASSERT_EQUAL_UINT32(0, store.flushes());
+
+    store.setBool("auto", true, 300);                        // never read: dirty whatever it is
+    TEST_ASSERT_EQUAL(1, store.flush());
+    TEST_ASSERT_TRUE(prefs.getBool("auto", false));
+    prefs.end();
+}
+
+static void test_full_table_writes_through() {
+    static const char* keys[SETTINGS_MAX + 1] = {
+        "k0", "k1", "k2", "k3", "k4", "k5", "k6", "k7", "k8", "k9", "k10", "k11", "k12",
+        "k13", "k14", "k15", "k16", "k17", "k18", "k19", "k20", "k21", "k22", "k23", "k24",
+    };
+    prefs.begin("t_full");
+    SettingsStore store(prefs);
+    for (int k = 0; k < SETTINGS_MAX; k++) store.setInt(keys[k], k, 0);
+    TEST_ASSERT_EQUAL(SETTINGS_MAX, store.pending());
+    uint32_t before = Preferences::writes();
+    store.setInt(keys[SETTINGS_MAX], 99, 0);
+    TEST_ASSERT_EQUAL_UINT32(before + 1, Preferences::writes());
+    TEST_ASSERT_EQUAL(99, store.getInt(keys[SETTINGS_MAX], 0));
+    TEST_ASSERT_EQUAL(SETTINGS_MAX, store.flush());
+    prefs.end();
+}
+
+void run_settings_store_tests() {
+    RUN_TEST(test_get_reads_flash_once);
+    RUN_TEST(test_set_waits_for_quiet);
+    RUN_TEST(test_set_back_to_saved_is_clean);
+    RUN_TEST(test_full_table_writes_through);
+}
@@ -0,0 +1,70 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <string_pool.h>
+
+static void test_equal_values_share_a_slot() {
+    StringPool<4, 16> pool;
+    const char* a = nullptr;
+    const char* b = nullptr;
+    TEST_ASSERT_TRUE(pool.assign(a, "Gamma"));
+    TEST_ASSERT_TRUE(pool.assign(b, "Gamma"));
+    TEST_ASSERT_EQUAL_PTR(a, b);
+    TEST_ASSERT_EQUAL(1, pool.used());
+    TEST_ASSERT_FALSE(pool.assign(a, "Gamma"));                  // unchanged: the pool is not touched
+
+    TEST_ASSERT_TRUE(pool.assign(a, "Supra"));
+    TEST_ASSERT_EQUAL_STRING("Supra", a);
+    TEST_ASSERT_EQUAL_STRING("Gamma", b);
+    TEST_ASSERT_EQUAL(2, pool.used());
+    pool.release(b);
+    TEST_ASSERT_EQUAL_STRING("", b);
+    TEST_ASSERT_EQUAL(1, pool.used());
+}
+
+static void test_empty_and_long_values() {
+    StringPool<2, 8> pool;
+    const char* a = nullptr;
+    TEST_ASSERT_TRUE(pool.assign(a, ""));
+    TEST_ASSERT_EQUAL_STRING("", a);
+    TEST_ASSERT_EQUAL(0, pool.used());
+    TEST_ASSERT_FALSE(pool.assign(a, nullptr));                 // null reads as ""
+
+    TEST_ASSERT_TRUE(pool.assign(a, "stratum+tcp://pool"));
+    TEST_ASSERT_EQUAL_STRING("stratum", a);                     // LEN - 1 characters
+    TEST_ASSERT_FALSE(pool.assign(a, "stratum+tcp://other"));  // same once truncated
+    TEST_ASSERT_TRUE(pool.assign(a, ""));
+    TEST_ASSERT_EQUAL(0, pool.used());
+}
+
+static void test_fields_times_devices_plus_one_never_runs_out() {
+    // Two fields on three devices, every value distinct and changed over and over
+    StringPool<2 * 3 + 1, 16> pool;
+    const char* refs[6] = {};
+    char value[16];
+    for (int round = 0; round < 50; round++) {
+        for (int r = 0; r < 6; r++) {
+            snprintf(value, sizeof(value), "v%d-%d", r, round);
+            TEST_ASSERT_TRUE(pool.assign(refs[r], value));
+            TEST_ASSERT_EQUAL_STRING(value, refs[r]);
+        }
+        TEST_ASSERT_EQUAL(6, pool.used());
+    }
+
+    // Past its size a full pool refuses and the field keeps its old value
+    StringPool<2, 16> small;
+    const char* x = nullptr;
+    const char* y = nullptr;
+    const char* z = nullptr;
+    small.assign(x, "one");
+    small.assign(y, "two");
+    TEST_ASSERT_FALSE(small.assign(z, "three"));
+    TEST_ASSERT_NULL(z);
+    TEST_ASSERT_FALSE(small.assign(x, "three"));
+    TEST_ASSERT_EQUAL_STRING("one", x);
+}
+
+void run_string_pool_tests() {
+    RUN_TEST(test_equal_values_share_a_slot);
+    RUN_TEST(test_empty_and_long_values);
+    RUN_TEST(test_fields_times_devices_plus_one_never_runs_out);
+}
@@ -0,0 +1,125 @@
+#include <Arduino.h>
+#include <unity.h>
+#include <thermal_governor.h>
+
+static ThermalGovernor gov;
+
+static void reset() {
+    gov = ThermalGovernor();
+    gov.setEnabled(true);
+    TEST_ASSERT_TRUE(gov.curve(0).parse("40:30,50:50,60:100"));
+    ThermalConfig& c = gov.config();
+    c.hystC = 2;
+    c.throttleTemp = 68;
+    c.releaseHyst = 3;
+    c.freqStep = 25;
+    c.minFreq = 400;
+    c.intervalSec = 60;
+}
+
+// Evaluate and acknowledge whatever was asked for
+static bool step(float temp, int fan, int freq, uint32_t now, ThermalAction& a) {
+    bool any = gov.evaluate(0, {temp, fan, freq}, now, a);
+    if (a.fan >= 0) gov.appliedFan(0, a.fan, true);
+    if (a.frequency >= 0) gov.appliedFreq(0, a.deltaMHz, true, now);
+    return any;
+}
+
+static void test_curve_parse_eval_and_format() {
+    FanCurve c;
+    TEST_ASSERT_TRUE(c.parse("40:30, 50:50,60:100"));
+    TEST_ASSERT_EQUAL_FLOAT(30, c.eval(20));
+    TEST_ASSERT_EQUAL_FLOAT(40, c.eval(45));
+    TEST_ASSERT_EQUAL_FLOAT(100, c.eval(90));
+    char text[64];
+    c.format(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("40:30,50:50,60:100", text);
+
+    const char* bad[] = {"", "40", "40:101", "50:30,40:50", "40:30;50:50", "a:b"};
+    for (const char* b : bad) TEST_ASSERT_FALSE(c.parse(b));
+    c.format(text, sizeof(text));
+    TEST_ASSERT_EQUAL_STRING("40:30,50:50,60:100", text);    // unchanged by a bad parse
+}
+
+static void test_fan_rises_at_once_and_falls_past_the_hysteresis() {
+    reset();
+    ThermalAction a;
+    TEST_ASSERT_TRUE(step(45, 0, 500, 0, a));
+    TEST_ASSERT_EQUAL(40, a.fan);
+    TEST_ASSERT_TRUE(step(50, 40, 500, 10, a));
+    TEST_ASSERT_EQUAL(50, a.fan);
+    TEST_ASSERT_FALSE(step(49, 50, 500, 20, a));      // 49 + 2 still asks for 50+
+    TEST_ASSERT_FALSE(step(48, 50, 500, 30, a));
+    TEST_ASSERT_TRUE(step(47, 50, 500, 40, a));
+    TEST_ASSERT_EQUAL(48, a.fan);
+    TEST_ASSERT_EQUAL(48, gov.fanTarget(0));
+}
+
+static void test_frequency_is_cut_only_at_full_fan() {
+    reset();
+    ThermalAction a;
+    step(70, 0, 500, 0, a);
+    TEST_ASSERT_EQUAL(100, a.fan);
+    TEST_ASSERT_EQUAL(-1, a.frequency);               // the fan goes first
+
+    TEST_ASSERT_TRUE(step(70, 100, 500, 10, a));
+    TEST_ASSERT_EQUAL(475, a.frequency);
+    TEST_ASSERT_EQUAL(25, gov.cutMHz(0));
+    TEST_ASSERT_FALSE(step(70, 100, 475, 30, a));     // one change per intervalSec
+    TEST_ASSERT_TRUE(step(70, 100, 475, 70, a));
+    TEST_ASSERT_EQUAL(450, a.frequency);
+
+    // Given back one step at a time below throttleTemp - releaseHyst, never more than was cut
+    TEST_ASSERT_FALSE(step(66, 100, 450, 130, a));
+    TEST_ASSERT_TRUE(step(64, 100, 450, 130, a));
+    TEST_ASSERT_EQUAL(475, a.frequency);
+    step(60, 100, 475, 190, a);
+    TEST_ASSERT_EQUAL(500, a.frequency);
+    TEST_ASSERT_EQUAL(0, gov.cutMHz(0));
+    step(60, 100, 500, 250, a);
+    TEST_ASSERT_EQUAL(-1, a.frequency);
+}
+
+static void test_ignored_fan_target_is_retried_a_few_times() {
+    reset();
+    ThermalAction a;
+    step(45, 40, 500, 0, a);
+    TEST_ASSERT_EQUAL(40, gov.fanTarget(0));
+
+    // The device keeps its own floor of 60 %
+    for (int k = 0; k < THERMAL_DRIFT_RETRIES; k++) {
+        TEST_ASSERT_TRUE(step(45, 60, 500, 10 + k * 10, a));
+        TEST_ASSERT_EQUAL(40, a.fan);
+    }
+    for (int k = 0; k < 5; k++) TEST_ASSERT_FALSE(step(45, 60, 500, 100 + k * 10, a));
+
+    // Once it reports what was sent, a later drift (a reboot) is fixed again
+    TEST_ASSERT_FALSE(step(45, 40, 500, 200, a));
+    TEST_ASSERT_TRUE(step(45, 100, 500, 210, a));
+    TEST_ASSERT_EQUAL(40, a.fan);
+}
+
+static void test_pause_disable_and_forget() {
+    reset();
+    ThermalAction a;
+    gov.pause(0, 100);
+    TEST_ASSERT_TRUE(gov.paused(0, 50));
+    TEST_ASSERT_FALSE(step(70, 0, 500, 50, a));
+    TEST_ASSERT_TRUE(step(70, 0, 500, 100, a));
+
+    step(70, 100, 500, 110, a);
+    TEST_ASSERT_EQUAL(25, gov.cutMHz(0));
+    gov.forget(0);
+    TEST_ASSERT_EQUAL(0, gov.cutMHz(0));
+
+    gov.setEnabled(false);
+    TEST_ASSERT_FALSE(step(90, 0, 500, 1000, a));
+}
+
+void run_thermal_governor_tests() {
+    RUN_TEST(test_curve_parse_eval_and_format);
+    RUN_TEST(test_fan_rises_at_once_and_falls_past_the_hysteresis);
+    RUN_TEST(test_frequency_is_cut_only_at_full_fan);
+    RUN_TEST(test_ignored_fan_target_is_retried_a_few_times);
+    RUN_TEST(test_pause_disable_and_forget);
+}